@@ -76,9 +76,10 @@ Str_init_from_trusted_utf8(String *self, const char *utf8, size_t size) {
     ptr[size] = '\0'; // Null terminate.
 
     // Assign.
-    self->ptr    = ptr;
-    self->size   = size;
-    self->origin = self;
+    self->ptr      = ptr;
+    self->size     = size;
+    self->origin   = self;
+    self->hash_sum = 0;
 
     return self;
 }
@@ -100,9 +101,10 @@ Str_new_steal_trusted_utf8(char *utf8, size_t size) {
 
 String*
 Str_init_steal_trusted_utf8(String *self, char *utf8, size_t size) {
-    self->ptr    = utf8;
-    self->size   = size;
-    self->origin = self;
+    self->ptr      = utf8;
+    self->size     = size;
+    self->origin   = self;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -129,9 +131,10 @@ Str_init_stack_string(void *allocation, const char *utf8, size_t size) {
 
 String*
 Str_init_wrap_trusted_utf8(String *self, const char *ptr, size_t size) {
-    self->ptr    = ptr;
-    self->size   = size;
-    self->origin = NULL;
+    self->ptr      = ptr;
+    self->size     = size;
+    self->origin   = NULL;
+    self->hash_sum = 0;
     return self;
 }
 
@@ -194,18 +197,107 @@ Str_Destroy_IMP(String *self) {
     SUPER_DESTROY(self, STRING);
 }
 
-size_t
-Str_Hash_Sum_IMP(String *self) {
+#ifdef CFISH_STR_HASH_DJB
+
+static size_t
+S_hash_bytes(const char *ptr, size_t size) {
     size_t hashvalue = 5381;
-    StringIterator *iter = STACK_ITER(self, 0);
+    for (size_t i = 0; i < size; i++) {
+        hashvalue = ((hashvalue << 5) + hashvalue) ^ (uint8_t)ptr[i];
+    }
+    return hashvalue;
+}
 
-    const StrIter_Next_t next = METHOD_PTR(STRINGITERATOR, CFISH_StrIter_Next);
-    int32_t code_point;
-    while (STR_OOB != (code_point = next(iter))) {
-        hashvalue = ((hashvalue << 5) + hashvalue) ^ code_point;
+#else // Multiply/fold hash in the style of wyhash.
+
+static const uint64_t HASH_P0 = UINT64_C(0xa0761d6478bd642f);
+static const uint64_t HASH_P1 = UINT64_C(0xe7037ed1a0b428db);
+static const uint64_t HASH_P2 = UINT64_C(0x8ebc6af09c88c6e3);
+
+// Multiply two 64-bit values and fold the 128-bit product.
+static CFISH_INLINE uint64_t
+SI_mix(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a;
+    uint64_t hb = b >> 32, lb = (uint32_t)b;
+    uint64_t hi = ha * hb, lo = la * lb;
+    uint64_t mid1 = ha * lb, mid2 = la * hb;
+    uint64_t carry = ((lo >> 32) + (uint32_t)mid1 + (uint32_t)mid2) >> 32;
+    lo += (mid1 << 32) + (mid2 << 32);
+    hi += (mid1 >> 32) + (mid2 >> 32) + carry;
+    return lo ^ hi;
+#endif
+}
+
+// Unaligned native-endian loads.  The hash only has to be stable within a
+// process, so byte order doesn't matter.
+static CFISH_INLINE uint64_t
+SI_load64(const char *ptr) {
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static CFISH_INLINE uint64_t
+SI_load32(const char *ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static size_t
+S_hash_bytes(const char *ptr, size_t size) {
+    uint64_t seed = HASH_P0 ^ (uint64_t)size;
+    size_t   len  = size;
+    uint64_t a, b;
+
+    while (len > 16) {
+        seed = SI_mix(SI_load64(ptr) ^ HASH_P1, SI_load64(ptr + 8) ^ seed);
+        ptr += 16;
+        len -= 16;
+    }
+    if (len >= 8) {
+        a = SI_load64(ptr);
+        b = SI_load64(ptr + len - 8);
+    }
+    else if (len >= 4) {
+        a = SI_load32(ptr);
+        b = SI_load32(ptr + len - 4);
+    }
+    else if (len > 0) {
+        const uint8_t *bytes = (const uint8_t*)ptr;
+        a = ((uint64_t)bytes[0] << 16)
+            | ((uint64_t)bytes[len >> 1] << 8)
+            | bytes[len - 1];
+        b = 0;
+    }
+    else {
+        a = b = 0;
     }
+    uint64_t hash = SI_mix(HASH_P1 ^ (uint64_t)size,
+                           SI_mix(a ^ HASH_P1, b ^ seed) ^ HASH_P2);
+    return (size_t)hash;
+}
 
-    return hashvalue;
+#endif // CFISH_STR_HASH_DJB
+
+size_t
+Str_Hash_Sum_IMP(String *self) {
+    if (self->hash_sum) { return self->hash_sum; }
+
+    size_t hash_sum = S_hash_bytes(self->ptr, self->size);
+    // Zero marks the cache as empty.
+    if (hash_sum == 0) { hash_sum = 1; }
+
+    // Wrapped strings point at memory which they don't control, so only
+    // cache the hash for strings which own or share their character data.
+    if (self->origin != NULL) {
+        self->hash_sum = hash_sum;
+    }
+    return hash_sum;
 }
 
 static void
@@ -470,6 +470,45 @@ test_Get_Ptr8(TestBatchRunner *runner) {
     DECREF(string);
 }
 
+static void
+test_Hash_Sum(TestBatchRunner *runner) {
+    static const char text[] = "a fairly long field name " SMILEY;
+    String *string  = Str_newf("%s", text);
+    String *wrapped = SSTR_WRAP_C(text);
+    String *longer  = Str_newf("xx%sxx", text);
+    String *sub     = Str_SubString(longer, 2, Str_Length(string));
+
+    size_t hash_sum = Str_Hash_Sum(string);
+    TEST_TRUE(runner, Str_Hash_Sum(string) == hash_sum,
+              "Hash_Sum is repeatable");
+    TEST_TRUE(runner, Str_Hash_Sum(wrapped) == hash_sum,
+              "Hash_Sum of wrapped string matches");
+    TEST_TRUE(runner, Str_Hash_Sum(sub) == hash_sum,
+              "Hash_Sum of substring matches");
+    TEST_TRUE(runner, Str_Hash_Sum(longer) != hash_sum,
+              "Hash_Sum differs for different content");
+
+    // Strings of every length up to a few words hash consistently.
+    bool consistent = true;
+    bool distinct   = true;
+    for (size_t len = 0; len < sizeof(text) - 1; len++) {
+        String *head = Str_new_from_trusted_utf8(text, len);
+        String *copy = Str_new_wrap_trusted_utf8(text, len);
+        if (Str_Hash_Sum(head) != Str_Hash_Sum(copy)) { consistent = false; }
+        if (len && Str_Hash_Sum(head) == Str_Hash_Sum(string)) {
+            distinct = false;
+        }
+        DECREF(copy);
+        DECREF(head);
+    }
+    TEST_TRUE(runner, consistent, "Hash_Sum consistent for all lengths");
+    TEST_TRUE(runner, distinct, "Hash_Sum distinguishes prefixes");
+
+    DECREF(sub);
+    DECREF(longer);
+    DECREF(string);
+}
+
 static void
 test_iterator(TestBatchRunner *runner) {
     static const int32_t code_points[] = {
@@ -703,7 +742,7 @@ test_iterator_substring(TestBatchRunner *runner) {
 
 void
 TestStr_Run_IMP(TestString *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 139);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 145);
     test_new(runner);
     test_Cat(runner);
     test_Clone(runner);
@@ -720,6 +759,7 @@ TestStr_Run_IMP(TestString *self, TestBatchRunner *runner) {
     test_Compare_To(runner);
     test_Starts_Ends_With(runner);
     test_Get_Ptr8(runner);
+    test_Hash_Sum(runner);
     test_iterator(runner);
     test_iterator_whitespace(runner);
     test_iterator_substring(runner);
@@ -0,0 +1,883 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * lucy-bench: indexing and search benchmarks for the Lucy C library.
+ *
+ * Generates a reproducible synthetic corpus -- a Zipfian vocabulary of
+ * made-up words, plain-text articles and HTML-like pages with a mix of
+ * fields -- indexes it, then times a series of query types against the
+ * result.  A JSON report goes to stdout (or the file named by --output) and
+ * progress goes to stderr.
+ *
+ * Build with "make bench" in the c/ directory and run from there:
+ *
+ *     bench/lucy-bench --docs=20000 --reps=3 --increment=5000 > run.json
+ *
+ * Run "bench/lucy-bench --help" for the full list of options.  Every
+ * option has a default, and the same options and seed always produce the
+ * same corpus and the same queries.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define LUCY_USE_SHORT_NAMES
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Lucy/Analysis/Analyzer.h"
+#include "Lucy/Analysis/EasyAnalyzer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/DocBuilder.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Highlight/Highlighter.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/ANDQuery.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/ORQuery.h"
+#include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Search/RangeQuery.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Clock.h"
+#include "Lucy/Util/Json.h"
+
+#define BENCH_FORMAT       1
+#define NUM_CATEGORIES     24
+#define NUM_HITS           10
+#define EXCERPT_LENGTH     200
+#define MAX_PHRASE_WORDS   3
+
+typedef struct {
+    const char *name;
+    const char *help;
+    double      value;
+} BenchOption;
+
+static BenchOption options[] = {
+    { "docs",       "number of documents in the corpus",           10000 },
+    { "reps",       "number of times to build the index",          1     },
+    { "increment",  "docs per Indexer session, 0 for all",         0     },
+    { "vocab",      "number of distinct words",                    50000 },
+    { "zipf",       "Zipf exponent of the word distribution",      1.0   },
+    { "min-words",  "minimum words in a body",                     50    },
+    { "max-words",  "maximum words in a body",                     1000  },
+    { "html",       "fraction of docs that are HTML-like pages",   0.25  },
+    { "queries",    "queries timed per query type",                500   },
+    { "seed",       "random seed",                                 1     },
+    { "ram",        "1 to index into a RAMFolder",                 0     },
+    { "builder",    "1 to add docs through a DocBuilder",          0     },
+    { NULL, NULL, 0 }
+};
+
+static const char *index_path  = "_lucy_bench_index";
+static const char *output_path = NULL;
+
+static const char *const syllables[32] = {
+    "ka", "lo", "mi", "ne", "ru", "ta", "ve", "zo",
+    "bi", "da", "fe", "gu", "ho", "ji", "ku", "la",
+    "ma", "no", "pa", "qui", "re", "sa", "ti", "vu",
+    "wa", "xe", "yo", "zu", "bra", "cle", "dri", "sto"
+};
+
+typedef struct {
+    String   *id;
+    String   *title;
+    String   *body;
+    String   *category;
+    String   *date;
+    String   *url;      // NULL unless the doc is an HTML-like page.
+    uint32_t *words;    // Vocabulary ids of the body's words.
+    uint32_t  num_words;
+} BenchDoc;
+
+typedef struct {
+    char    **vocab;
+    double   *cdf;
+    uint32_t  vocab_size;
+    BenchDoc *docs;
+    uint32_t  num_docs;
+    uint64_t  num_bytes;
+    uint64_t  rng;
+} Corpus;
+
+/******************************* Utilities *******************************/
+
+static double
+S_opt(const char *name) {
+    for (BenchOption *opt = options; opt->name; opt++) {
+        if (strcmp(opt->name, name) == 0) { return opt->value; }
+    }
+    fprintf(stderr, "Unknown option '%s'\n", name);
+    exit(EXIT_FAILURE);
+}
+
+static void
+S_usage(FILE *stream) {
+    fprintf(stream, "Usage: lucy-bench [--option=value ...]\n\n");
+    for (BenchOption *opt = options; opt->name; opt++) {
+        fprintf(stream, "  --%-11s %s (default %g)\n", opt->name, opt->help,
+                opt->value);
+    }
+    fprintf(stream, "  --%-11s %s (default %s)\n", "index",
+            "index directory, unless --ram=1", index_path);
+    fprintf(stream, "  --%-11s %s\n", "output",
+            "write the JSON report to a file instead of stdout");
+}
+
+static void
+S_parse_args(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *eq  = strchr(arg, '=');
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            S_usage(stdout);
+            exit(EXIT_SUCCESS);
+        }
+        if (strncmp(arg, "--", 2) != 0 || !eq) {
+            S_usage(stderr);
+            exit(EXIT_FAILURE);
+        }
+        size_t name_len = (size_t)(eq - arg) - 2;
+        const char *value = eq + 1;
+        if (name_len == 5 && strncmp(arg + 2, "index", 5) == 0) {
+            index_path = value;
+            continue;
+        }
+        if (name_len == 6 && strncmp(arg + 2, "output", 6) == 0) {
+            output_path = value;
+            continue;
+        }
+        BenchOption *opt = options;
+        while (opt->name && (strlen(opt->name) != name_len
+                             || strncmp(opt->name, arg + 2, name_len) != 0)) {
+            opt++;
+        }
+        if (!opt->name) {
+            fprintf(stderr, "Unknown option '%s'\n", arg);
+            S_usage(stderr);
+            exit(EXIT_FAILURE);
+        }
+        opt->value = atof(value);
+    }
+    if (S_opt("docs") < 1 || S_opt("reps") < 1 || S_opt("vocab") < 1
+        || S_opt("min-words") < MAX_PHRASE_WORDS
+        || S_opt("max-words") < S_opt("min-words")
+        || S_opt("queries") < 1
+       ) {
+        fprintf(stderr, "Invalid option values\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// SplitMix64: small, fast, and the same on every platform.
+static uint64_t
+S_rand(uint64_t *state) {
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+static double
+S_rand_double(uint64_t *state) {
+    return (double)(S_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint32_t
+S_rand_below(uint64_t *state, uint32_t limit) {
+    return (uint32_t)(S_rand_double(state) * limit);
+}
+
+// Draw a vocabulary id; low ids are the frequent words.
+static uint32_t
+S_zipf_word(Corpus *corpus, uint64_t *state) {
+    double target = S_rand_double(state);
+    uint32_t lo = 0;
+    uint32_t hi = corpus->vocab_size - 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (corpus->cdf[mid] < target) { lo = mid + 1; }
+        else                           { hi = mid; }
+    }
+    return lo;
+}
+
+/*************************** Corpus generation ***************************/
+
+// Spell out `num` in base 32 using syllables.  Every syllable is a run of
+// consonants followed by vowels, so distinct numbers yield distinct words.
+static char*
+S_make_word(uint32_t num) {
+    char buf[64];
+    size_t len = 0;
+    num += 32; // At least two syllables.
+    do {
+        const char *syl = syllables[num % 32];
+        size_t syl_len = strlen(syl);
+        memcpy(buf + len, syl, syl_len);
+        len += syl_len;
+        num /= 32;
+    } while (num);
+    buf[len] = '\0';
+    char *word = (char*)malloc(len + 1);
+    memcpy(word, buf, len + 1);
+    return word;
+}
+
+typedef struct {
+    char   *ptr;
+    size_t  len;
+    size_t  cap;
+} CharBuf;
+
+static void
+S_cat(CharBuf *buf, const char *text) {
+    size_t text_len = strlen(text);
+    if (buf->len + text_len + 1 > buf->cap) {
+        buf->cap = (buf->len + text_len + 1) * 2;
+        buf->ptr = (char*)realloc(buf->ptr, buf->cap);
+    }
+    memcpy(buf->ptr + buf->len, text, text_len + 1);
+    buf->len += text_len;
+}
+
+static String*
+S_take_string(CharBuf *buf) {
+    String *string = Str_new_from_trusted_utf8(buf->ptr, buf->len);
+    buf->len = 0;
+    if (buf->ptr) { buf->ptr[0] = '\0'; }
+    return string;
+}
+
+static void
+S_cat_words(CharBuf *buf, Corpus *corpus, const uint32_t *words,
+            uint32_t num_words) {
+    for (uint32_t i = 0; i < num_words; i++) {
+        if (i) { S_cat(buf, (i % 13 == 0) ? ". " : " "); }
+        S_cat(buf, corpus->vocab[words[i]]);
+    }
+}
+
+static void
+S_generate_doc(Corpus *corpus, uint32_t doc_num, CharBuf *buf) {
+    BenchDoc *doc = corpus->docs + doc_num;
+    uint64_t *rng = &corpus->rng;
+    char scratch[128];
+
+    uint32_t min_words = (uint32_t)S_opt("min-words");
+    uint32_t max_words = (uint32_t)S_opt("max-words");
+    bool is_html = S_rand_double(rng) < S_opt("html");
+
+    // Skew body lengths toward the short end, as real collections are.
+    double skew = S_rand_double(rng);
+    doc->num_words = min_words
+                     + (uint32_t)((max_words - min_words) * skew * skew);
+    doc->words = (uint32_t*)malloc(doc->num_words * sizeof(uint32_t));
+    for (uint32_t i = 0; i < doc->num_words; i++) {
+        doc->words[i] = S_zipf_word(corpus, rng);
+    }
+
+    uint32_t title_words[8];
+    uint32_t num_title_words = 3 + S_rand_below(rng, 6);
+    for (uint32_t i = 0; i < num_title_words; i++) {
+        title_words[i] = S_zipf_word(corpus, rng);
+    }
+    S_cat_words(buf, corpus, title_words, num_title_words);
+    doc->title = S_take_string(buf);
+
+    // Category popularity is Zipfian too: cat00 is the most common.
+    double cat_target = S_rand_double(rng) * log((double)NUM_CATEGORIES + 1);
+    uint32_t category = (uint32_t)(exp(cat_target) - 1.0);
+    if (category >= NUM_CATEGORIES) { category = NUM_CATEGORIES - 1; }
+    sprintf(scratch, "cat%02u", (unsigned)category);
+    doc->category = Str_newf("%s", scratch);
+
+    sprintf(scratch, "%04u-%02u-%02u",
+            (unsigned)(2000 + S_rand_below(rng, 20)),
+            (unsigned)(1 + S_rand_below(rng, 12)),
+            (unsigned)(1 + S_rand_below(rng, 28)));
+    doc->date = Str_newf("%s", scratch);
+    doc->id   = Str_newf("doc%u32", doc_num);
+
+    if (is_html) {
+        sprintf(scratch, "http://www.example.com/cat%02u/page%u.html",
+                (unsigned)category, (unsigned)doc_num);
+        doc->url = Str_newf("%s", scratch);
+
+        S_cat(buf, "<!DOCTYPE html>\n<html><head><title>");
+        S_cat_words(buf, corpus, title_words, num_title_words);
+        S_cat(buf, "</title></head>\n<body><div class=\"nav\">");
+        for (uint32_t i = 0; i < 4; i++) {
+            sprintf(scratch, "<a href=\"/cat%02u/\">%s</a> ", (unsigned)i,
+                    corpus->vocab[i]);
+            S_cat(buf, scratch);
+        }
+        S_cat(buf, "</div>\n<h1>");
+        S_cat_words(buf, corpus, title_words, num_title_words);
+        S_cat(buf, "</h1>\n");
+        for (uint32_t i = 0; i < doc->num_words; i += 60) {
+            uint32_t chunk = doc->num_words - i < 60 ? doc->num_words - i : 60;
+            S_cat(buf, "<p>");
+            S_cat_words(buf, corpus, doc->words + i, chunk);
+            S_cat(buf, "</p>\n");
+        }
+        S_cat(buf, "<div class=\"footer\">Copyright example.com</div>"
+              "</body></html>\n");
+    }
+    else {
+        doc->url = NULL;
+        S_cat_words(buf, corpus, doc->words, doc->num_words);
+        S_cat(buf, ".");
+    }
+    doc->body = S_take_string(buf);
+
+    corpus->num_bytes += Str_Get_Size(doc->title) + Str_Get_Size(doc->body)
+                         + Str_Get_Size(doc->category)
+                         + Str_Get_Size(doc->date) + Str_Get_Size(doc->id)
+                         + (doc->url ? Str_Get_Size(doc->url) : 0);
+}
+
+static Corpus*
+S_generate_corpus() {
+    Corpus *corpus = (Corpus*)calloc(1, sizeof(Corpus));
+    corpus->vocab_size = (uint32_t)S_opt("vocab");
+    corpus->num_docs   = (uint32_t)S_opt("docs");
+    corpus->rng        = (uint64_t)S_opt("seed");
+
+    corpus->vocab = (char**)malloc(corpus->vocab_size * sizeof(char*));
+    corpus->cdf   = (double*)malloc(corpus->vocab_size * sizeof(double));
+    double exponent = S_opt("zipf");
+    double total = 0.0;
+    for (uint32_t i = 0; i < corpus->vocab_size; i++) {
+        corpus->vocab[i] = S_make_word(i);
+        total += 1.0 / pow((double)i + 1.0, exponent);
+        corpus->cdf[i] = total;
+    }
+    for (uint32_t i = 0; i < corpus->vocab_size; i++) {
+        corpus->cdf[i] /= total;
+    }
+
+    CharBuf buf = { NULL, 0, 0 };
+    corpus->docs = (BenchDoc*)calloc(corpus->num_docs, sizeof(BenchDoc));
+    for (uint32_t i = 0; i < corpus->num_docs; i++) {
+        S_generate_doc(corpus, i, &buf);
+    }
+    free(buf.ptr);
+
+    return corpus;
+}
+
+static void
+S_destroy_corpus(Corpus *corpus) {
+    for (uint32_t i = 0; i < corpus->num_docs; i++) {
+        BenchDoc *doc = corpus->docs + i;
+        DECREF(doc->id);
+        DECREF(doc->title);
+        DECREF(doc->body);
+        DECREF(doc->category);
+        DECREF(doc->date);
+        DECREF(doc->url);
+        free(doc->words);
+    }
+    for (uint32_t i = 0; i < corpus->vocab_size; i++) {
+        free(corpus->vocab[i]);
+    }
+    free(corpus->docs);
+    free(corpus->vocab);
+    free(corpus->cdf);
+    free(corpus);
+}
+
+/******************************** Indexing *******************************/
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+
+    EasyAnalyzer *analyzer = EasyAnalyzer_new(SSTR_WRAP_C("en"));
+    FullTextType *title_type = FullTextType_new((Analyzer*)analyzer);
+    FullTextType *body_type  = FullTextType_new((Analyzer*)analyzer);
+    FullTextType_Set_Highlightable(body_type, true);
+    StringType *id_type = StringType_new();
+    StringType *sortable_type = StringType_new();
+    StringType_Set_Sortable(sortable_type, true);
+
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)id_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("url"), (FieldType*)id_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("title"), (FieldType*)title_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("body"), (FieldType*)body_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("category"),
+                      (FieldType*)sortable_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("date"), (FieldType*)sortable_type);
+
+    DECREF(sortable_type);
+    DECREF(id_type);
+    DECREF(body_type);
+    DECREF(title_type);
+    DECREF(analyzer);
+    return schema;
+}
+
+static Obj*
+S_open_folder() {
+    if (S_opt("ram")) {
+        return (Obj*)RAMFolder_new(NULL);
+    }
+    String *path = Str_newf("%s", index_path);
+    FSFolder *folder = FSFolder_new(path);
+    DECREF(path);
+    return (Obj*)folder;
+}
+
+static void
+S_add_docs(Indexer *indexer, Corpus *corpus, uint32_t start,
+           uint32_t end) {
+    if (S_opt("builder")) {
+        DocBuilder *builder = Indexer_Make_Doc_Builder(indexer);
+        uint32_t id_slot    = DocBuilder_Add_Field(builder, SSTR_WRAP_C("id"));
+        uint32_t url_slot   = DocBuilder_Add_Field(builder, SSTR_WRAP_C("url"));
+        uint32_t title_slot = DocBuilder_Add_Field(builder,
+                                                   SSTR_WRAP_C("title"));
+        uint32_t body_slot  = DocBuilder_Add_Field(builder,
+                                                   SSTR_WRAP_C("body"));
+        uint32_t cat_slot   = DocBuilder_Add_Field(builder,
+                                                   SSTR_WRAP_C("category"));
+        uint32_t date_slot  = DocBuilder_Add_Field(builder,
+                                                   SSTR_WRAP_C("date"));
+        for (uint32_t i = start; i < end; i++) {
+            BenchDoc *doc = corpus->docs + i;
+            DocBuilder_Set_Value(builder, id_slot, (Obj*)doc->id);
+            DocBuilder_Set_Value(builder, url_slot, (Obj*)doc->url);
+            DocBuilder_Set_Value(builder, title_slot, (Obj*)doc->title);
+            DocBuilder_Set_Value(builder, body_slot, (Obj*)doc->body);
+            DocBuilder_Set_Value(builder, cat_slot, (Obj*)doc->category);
+            DocBuilder_Set_Value(builder, date_slot, (Obj*)doc->date);
+            Indexer_Add_Built_Doc(indexer, builder, 1.0f);
+        }
+        DECREF(builder);
+        return;
+    }
+
+    for (uint32_t i = start; i < end; i++) {
+        BenchDoc *doc = corpus->docs + i;
+        Doc *lucy_doc = Doc_new(NULL, 0);
+        Doc_Store(lucy_doc, SSTR_WRAP_C("id"), (Obj*)doc->id);
+        if (doc->url) {
+            Doc_Store(lucy_doc, SSTR_WRAP_C("url"), (Obj*)doc->url);
+        }
+        Doc_Store(lucy_doc, SSTR_WRAP_C("title"), (Obj*)doc->title);
+        Doc_Store(lucy_doc, SSTR_WRAP_C("body"), (Obj*)doc->body);
+        Doc_Store(lucy_doc, SSTR_WRAP_C("category"), (Obj*)doc->category);
+        Doc_Store(lucy_doc, SSTR_WRAP_C("date"), (Obj*)doc->date);
+        Indexer_Add_Doc(indexer, lucy_doc, 1.0f);
+        DECREF(lucy_doc);
+    }
+}
+
+static double
+S_secs(uint64_t usecs) {
+    return (double)usecs / 1000000.0;
+}
+
+static void
+S_store_f64(Hash *hash, const char *key, double value) {
+    Hash_Store_Utf8(hash, key, strlen(key), (Obj*)Float_new(value));
+}
+
+static void
+S_store_i64(Hash *hash, const char *key, int64_t value) {
+    Hash_Store_Utf8(hash, key, strlen(key), (Obj*)Int_new(value));
+}
+
+// Build the index once; returns a report and leaves the folder in *folder.
+static Hash*
+S_index_rep(Schema *schema, Corpus *corpus, Obj **folder) {
+    uint32_t increment = (uint32_t)S_opt("increment");
+    if (increment == 0 || increment > corpus->num_docs) {
+        increment = corpus->num_docs;
+    }
+
+    uint64_t add_usecs    = 0;
+    uint64_t commit_usecs = 0;
+    int64_t  sessions     = 0;
+    *folder = S_open_folder();
+
+    for (uint32_t start = 0; start < corpus->num_docs; start += increment) {
+        uint32_t end = start + increment < corpus->num_docs
+                       ? start + increment
+                       : corpus->num_docs;
+        // The first session truncates anything left by an earlier run.
+        int32_t flags = start ? Indexer_CREATE
+                              : Indexer_CREATE | Indexer_TRUNCATE;
+        uint64_t t0 = Clock_microseconds();
+        Indexer *indexer = Indexer_new(schema, *folder, NULL, flags);
+        S_add_docs(indexer, corpus, start, end);
+        uint64_t t1 = Clock_microseconds();
+        Indexer_Commit(indexer);
+        uint64_t t2 = Clock_microseconds();
+        DECREF(indexer);
+        add_usecs    += t1 - t0;
+        commit_usecs += t2 - t1;
+        sessions++;
+    }
+
+    uint64_t t0 = Clock_microseconds();
+    Indexer *indexer = Indexer_new(schema, *folder, NULL, 0);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    uint64_t merge_usecs = Clock_microseconds() - t0;
+
+    double total_secs = S_secs(add_usecs + commit_usecs);
+    Hash *report = Hash_new(0);
+    S_store_i64(report, "sessions", sessions);
+    S_store_f64(report, "add_secs", S_secs(add_usecs));
+    S_store_f64(report, "commit_secs", S_secs(commit_usecs));
+    S_store_f64(report, "merge_secs", S_secs(merge_usecs));
+    S_store_f64(report, "docs_per_sec", corpus->num_docs / total_secs);
+    S_store_f64(report, "mb_per_sec",
+                corpus->num_bytes / (1024.0 * 1024.0) / total_secs);
+    return report;
+}
+
+/******************************** Queries ********************************/
+
+typedef struct {
+    Obj      *query;
+    SortSpec *sort_spec;
+} BenchQuery;
+
+// Run a vocabulary word through the field's analyzer so the query matches
+// what was indexed.
+static String*
+S_term(Corpus *corpus, Analyzer *analyzer, uint32_t word) {
+    const char *text = corpus->vocab[word];
+    String *input = Str_new_from_trusted_utf8(text, strlen(text));
+    Vector *tokens = Analyzer_Split(analyzer, input);
+    String *term = Vec_Get_Size(tokens)
+                   ? (String*)INCREF(Vec_Fetch(tokens, 0))
+                   : (String*)INCREF(input);
+    DECREF(tokens);
+    DECREF(input);
+    return term;
+}
+
+static Obj*
+S_term_query(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    String *term = S_term(corpus, analyzer, S_zipf_word(corpus, rng));
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C("body"), (Obj*)term);
+    DECREF(term);
+    return (Obj*)query;
+}
+
+// Phrases are lifted from generated bodies so that most of them match.
+static Obj*
+S_phrase_query(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    BenchDoc *doc = corpus->docs + S_rand_below(rng, corpus->num_docs);
+    uint32_t num_words = 2 + S_rand_below(rng, MAX_PHRASE_WORDS - 1);
+    uint32_t start = S_rand_below(rng, doc->num_words - num_words + 1);
+    Vector *terms = Vec_new(num_words);
+    for (uint32_t i = 0; i < num_words; i++) {
+        Vec_Push(terms, (Obj*)S_term(corpus, analyzer,
+                                     doc->words[start + i]));
+    }
+    PhraseQuery *query = PhraseQuery_new(SSTR_WRAP_C("body"), terms);
+    DECREF(terms);
+    return (Obj*)query;
+}
+
+static Vector*
+S_term_queries(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    uint32_t num_children = 2 + S_rand_below(rng, 2);
+    Vector *children = Vec_new(num_children);
+    for (uint32_t i = 0; i < num_children; i++) {
+        Vec_Push(children, S_term_query(corpus, analyzer, rng));
+    }
+    return children;
+}
+
+static Obj*
+S_and_query(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    Vector *children = S_term_queries(corpus, analyzer, rng);
+    ANDQuery *query = ANDQuery_new(children);
+    DECREF(children);
+    return (Obj*)query;
+}
+
+static Obj*
+S_or_query(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    Vector *children = S_term_queries(corpus, analyzer, rng);
+    ORQuery *query = ORQuery_new(children);
+    DECREF(children);
+    return (Obj*)query;
+}
+
+static Obj*
+S_range_query(Corpus *corpus, Analyzer *analyzer, uint64_t *rng) {
+    (void)corpus;
+    (void)analyzer;
+    char scratch[16];
+    uint32_t first = S_rand_below(rng, 20 * 12);
+    uint32_t last  = first + 1 + S_rand_below(rng, 24);
+    sprintf(scratch, "%04u-%02u", (unsigned)(2000 + first / 12),
+            (unsigned)(first % 12 + 1));
+    String *lower = Str_newf("%s", scratch);
+    sprintf(scratch, "%04u-%02u", (unsigned)(2000 + last / 12),
+            (unsigned)(last % 12 + 1));
+    String *upper = Str_newf("%s", scratch);
+    RangeQuery *query = RangeQuery_new(SSTR_WRAP_C("date"), (Obj*)lower,
+                                       (Obj*)upper, true, false);
+    DECREF(upper);
+    DECREF(lower);
+    return (Obj*)query;
+}
+
+typedef Obj*
+(*QueryMaker)(Corpus *corpus, Analyzer *analyzer, uint64_t *rng);
+
+typedef struct {
+    const char *name;
+    QueryMaker  make;
+    bool        sorted;
+    bool        highlight;
+} QueryType;
+
+static const QueryType query_types[] = {
+    { "term",      S_term_query,   false, false },
+    { "phrase",    S_phrase_query, false, false },
+    { "and",       S_and_query,    false, false },
+    { "or",        S_or_query,     false, false },
+    { "range",     S_range_query,  false, false },
+    { "sorted",    S_term_query,   true,  false },
+    { "highlight", S_term_query,   false, true  },
+    { NULL, NULL, false, false }
+};
+
+static SortSpec*
+S_date_sort_spec() {
+    Vector *rules = Vec_new(2);
+    Vec_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, SSTR_WRAP_C("date"),
+                                       true));
+    Vec_Push(rules, (Obj*)SortRule_new(SortRule_DOC_ID, NULL, false));
+    SortSpec *sort_spec = SortSpec_new(rules);
+    DECREF(rules);
+    return sort_spec;
+}
+
+static int
+S_compare_u64(const void *va, const void *vb) {
+    uint64_t a = *(const uint64_t*)va;
+    uint64_t b = *(const uint64_t*)vb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+// Nearest-rank percentile of sorted latencies, in milliseconds.
+static double
+S_percentile(const uint64_t *sorted, uint32_t count, double pct) {
+    uint32_t rank = (uint32_t)ceil(pct / 100.0 * count);
+    if (rank < 1) { rank = 1; }
+    return (double)sorted[rank - 1] / 1000.0;
+}
+
+// Run one query and return the number of microseconds it took.  For the
+// "highlight" type only the excerpt creation for the top hits is timed.
+static uint64_t
+S_run_query(IndexSearcher *searcher, const QueryType *type, Obj *query,
+            SortSpec *sort_spec, uint32_t *total_hits) {
+    uint64_t t0 = Clock_microseconds();
+    Hits *hits = IxSearcher_Hits(searcher, query, 0, NUM_HITS, sort_spec);
+    *total_hits = Hits_Total_Hits(hits);
+    if (type->highlight) {
+        Highlighter *highlighter
+            = Highlighter_new((Searcher*)searcher, query,
+                              SSTR_WRAP_C("body"), EXCERPT_LENGTH);
+        HitDoc *hit;
+        t0 = Clock_microseconds();
+        while (NULL != (hit = Hits_Next(hits))) {
+            String *excerpt = Highlighter_Create_Excerpt(highlighter, hit);
+            DECREF(excerpt);
+            DECREF(hit);
+        }
+        uint64_t elapsed = Clock_microseconds() - t0;
+        DECREF(highlighter);
+        DECREF(hits);
+        return elapsed;
+    }
+    uint64_t elapsed = Clock_microseconds() - t0;
+    DECREF(hits);
+    return elapsed;
+}
+
+static Hash*
+S_query_bench(Obj *folder, Schema *schema, Corpus *corpus) {
+    uint32_t num_queries = (uint32_t)S_opt("queries");
+    Analyzer *analyzer = Schema_Fetch_Analyzer(schema, SSTR_WRAP_C("body"));
+    IndexSearcher *searcher = IxSearcher_new(folder);
+    SortSpec *date_sort = S_date_sort_spec();
+    uint64_t *latencies = (uint64_t*)malloc(num_queries * sizeof(uint64_t));
+    Obj **queries = (Obj**)malloc(num_queries * sizeof(Obj*));
+    Hash *report = Hash_new(0);
+
+    for (const QueryType *type = query_types; type->name; type++) {
+        // Each type gets its own stream so that adding a type doesn't
+        // change the queries of the others.
+        uint64_t rng = (uint64_t)S_opt("seed") * 1000003
+                       + (uint64_t)(type - query_types);
+        SortSpec *sort_spec = type->sorted ? date_sort : NULL;
+        for (uint32_t i = 0; i < num_queries; i++) {
+            queries[i] = type->make(corpus, analyzer, &rng);
+        }
+
+        // Warm up the caches once before timing.
+        uint32_t total_hits;
+        uint64_t hit_sum = 0;
+        for (uint32_t i = 0; i < num_queries; i++) {
+            S_run_query(searcher, type, queries[i], sort_spec, &total_hits);
+        }
+        uint64_t usec_sum = 0;
+        for (uint32_t i = 0; i < num_queries; i++) {
+            latencies[i] = S_run_query(searcher, type, queries[i],
+                                       sort_spec, &total_hits);
+            usec_sum += latencies[i];
+            hit_sum  += total_hits;
+        }
+        qsort(latencies, num_queries, sizeof(uint64_t), S_compare_u64);
+
+        Hash *stats = Hash_new(0);
+        S_store_i64(stats, "queries", num_queries);
+        S_store_f64(stats, "mean_ms", usec_sum / 1000.0 / num_queries);
+        S_store_f64(stats, "p50_ms",
+                    S_percentile(latencies, num_queries, 50.0));
+        S_store_f64(stats, "p90_ms",
+                    S_percentile(latencies, num_queries, 90.0));
+        S_store_f64(stats, "p99_ms",
+                    S_percentile(latencies, num_queries, 99.0));
+        S_store_f64(stats, "max_ms", latencies[num_queries - 1] / 1000.0);
+        S_store_f64(stats, "mean_hits", (double)hit_sum / num_queries);
+        Hash_Store_Utf8(report, type->name, strlen(type->name),
+                        (Obj*)stats);
+        fprintf(stderr, "  %-9s p50 %8.3f ms  p99 %8.3f ms\n", type->name,
+                S_percentile(latencies, num_queries, 50.0),
+                S_percentile(latencies, num_queries, 99.0));
+
+        for (uint32_t i = 0; i < num_queries; i++) {
+            DECREF(queries[i]);
+        }
+    }
+
+    free(queries);
+    free(latencies);
+    DECREF(date_sort);
+    DECREF(searcher);
+    return report;
+}
+
+/********************************* Main **********************************/
+
+static int
+S_compare_f64(const void *va, const void *vb) {
+    double a = *(const double*)va;
+    double b = *(const double*)vb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static Hash*
+S_config() {
+    Hash *config = Hash_new(0);
+    for (BenchOption *opt = options; opt->name; opt++) {
+        S_store_f64(config, opt->name, opt->value);
+    }
+    Hash_Store_Utf8(config, "index", 5,
+                    S_opt("ram") ? (Obj*)Str_newf("RAMFolder")
+                                 : (Obj*)Str_newf("%s", index_path));
+    return config;
+}
+
+int
+main(int argc, char **argv) {
+    S_parse_args(argc, argv);
+    lucy_bootstrap_parcel();
+
+    Hash *report = Hash_new(0);
+    S_store_i64(report, "format", BENCH_FORMAT);
+    Hash_Store_Utf8(report, "config", 6, (Obj*)S_config());
+
+    fprintf(stderr, "Generating %u docs...\n", (unsigned)S_opt("docs"));
+    uint64_t t0 = Clock_microseconds();
+    Corpus *corpus = S_generate_corpus();
+    Hash *corpus_report = Hash_new(0);
+    S_store_i64(corpus_report, "docs", corpus->num_docs);
+    S_store_i64(corpus_report, "bytes", (int64_t)corpus->num_bytes);
+    S_store_f64(corpus_report, "generate_secs",
+                S_secs(Clock_microseconds() - t0));
+    Hash_Store_Utf8(report, "corpus", 6, (Obj*)corpus_report);
+
+    Schema *schema = S_create_schema();
+    uint32_t num_reps = (uint32_t)S_opt("reps");
+    Vector *reps = Vec_new(num_reps);
+    double *rates = (double*)malloc(num_reps * sizeof(double));
+    Obj *folder = NULL;
+    for (uint32_t rep = 0; rep < num_reps; rep++) {
+        DECREF(folder);
+        Hash *rep_report = S_index_rep(schema, corpus, &folder);
+        Float *rate = (Float*)Hash_Fetch_Utf8(rep_report, "docs_per_sec", 12);
+        rates[rep] = Float_Get_Value(rate);
+        fprintf(stderr, "Rep %u: %.1f docs/sec\n", (unsigned)rep + 1,
+                rates[rep]);
+        Vec_Push(reps, (Obj*)rep_report);
+    }
+    qsort(rates, num_reps, sizeof(double), S_compare_f64);
+    Hash *indexing = Hash_new(0);
+    S_store_f64(indexing, "median_docs_per_sec", rates[num_reps / 2]);
+    S_store_f64(indexing, "best_docs_per_sec", rates[num_reps - 1]);
+    Hash_Store_Utf8(indexing, "reps", 4, (Obj*)reps);
+    Hash_Store_Utf8(report, "indexing", 8, (Obj*)indexing);
+    free(rates);
+
+    fprintf(stderr, "Running queries...\n");
+    Hash *queries = S_query_bench(folder, schema, corpus);
+    Hash_Store_Utf8(report, "queries", 7, (Obj*)queries);
+
+    String *json = Json_to_json((Obj*)report);
+    FILE *out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Can't open '%s'\n", output_path);
+        return EXIT_FAILURE;
+    }
+    fwrite(Str_Get_Ptr8(json), 1, Str_Get_Size(json), out);
+    if (out != stdout) { fclose(out); }
+
+    DECREF(json);
+    DECREF(folder);
+    DECREF(schema);
+    DECREF(report);
+    S_destroy_corpus(corpus);
+    return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,238 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * lucy-stats: report index-wide statistics for capacity planning.
+ *
+ * Opens an index read-only and prints the output of IndexReader_Stats():
+ * document and deletion counts, disk usage, the estimated memory needed to
+ * serve searches, and per-field and per-segment breakdowns.  Only segment
+ * metadata and file lengths are consulted, so it is cheap to run against a
+ * live index.
+ *
+ * The "warm" figure is the fraction of the lexicon indexes, skip data, sort
+ * caches and document indexes currently held in the OS page cache.  With
+ * --warm, those files are loaded first.
+ *
+ * Build with "make tools" in the c/ directory:
+ *
+ *     tools/lucy-stats /path/to/index
+ *     tools/lucy-stats --json /path/to/index > stats.json
+ *     tools/lucy-stats --warm /path/to/index
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define LUCY_USE_SHORT_NAMES
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/IndexWarmer.h"
+#include "Lucy/Util/Json.h"
+
+typedef struct {
+    const char *index_path;
+    int         warm;
+    Hash       *stats;
+} StatsContext;
+
+static void
+S_usage(FILE *stream) {
+    fprintf(stream, "Usage: lucy-stats [--json] [--warm] INDEX_DIR\n\n");
+    fprintf(stream, "  --json   print the full statistics as JSON\n");
+    fprintf(stream, "  --warm   load the index's hot files into memory first\n");
+}
+
+static void
+S_gather(void *context) {
+    StatsContext *ctx = (StatsContext*)context;
+    String *path = Str_newf("%s", ctx->index_path);
+    IndexReader *reader = IxReader_open((Obj*)path, NULL, NULL);
+    ctx->stats = IxReader_Stats(reader);
+
+    IndexWarmer *warmer = IxWarmer_new();
+    if (ctx->warm) { IxWarmer_Warm(warmer, reader); }
+    double warmth = IxWarmer_Measure(warmer, reader);
+    if (warmth >= 0.0) {
+        Hash_Store_Utf8(ctx->stats, "warm", 4, (Obj*)Float_new(warmth));
+    }
+    DECREF(warmer);
+
+    IxReader_Close(reader);
+    DECREF(reader);
+    DECREF(path);
+}
+
+static int64_t
+S_i64(Hash *hash, const char *key) {
+    Obj *value = hash ? Hash_Fetch_Utf8(hash, key, strlen(key)) : NULL;
+    return value ? Json_obj_to_i64(value) : 0;
+}
+
+static double
+S_f64(Hash *hash, const char *key) {
+    Obj *value = hash ? Hash_Fetch_Utf8(hash, key, strlen(key)) : NULL;
+    return value ? Json_obj_to_f64(value) : 0.0;
+}
+
+// Format a byte count for humans, e.g. "12.3 MiB".
+static const char*
+S_human(char *buf, size_t size, int64_t bytes) {
+    static const char *units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    double value = (double)bytes;
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        unit++;
+    }
+    if (unit == 0) { snprintf(buf, size, "%lld B", (long long)bytes); }
+    else           { snprintf(buf, size, "%.1f %s", value, units[unit]); }
+    return buf;
+}
+
+static void
+S_print_fields(Hash *fields) {
+    char posting_buf[32], lexicon_buf[32], index_buf[32], sort_buf[32];
+    printf("\n%-20s %12s %12s %9s %11s %11s %11s %11s\n", "field", "terms",
+           "postings", "avg/doc", "postings", "lexicon", "lex index",
+           "sort");
+    HashIterator *iter = HashIter_new(fields);
+    while (HashIter_Next(iter)) {
+        String *field = HashIter_Get_Key(iter);
+        Hash   *field_stats = (Hash*)HashIter_Get_Value(iter);
+        char   *name = Str_To_Utf8(field);
+        printf("%-20s %12lld %12lld %9.1f %11s %11s %11s %11s\n", name,
+               (long long)S_i64(field_stats, "terms"),
+               (long long)S_i64(field_stats, "postings"),
+               S_f64(field_stats, "avg_doc_terms"),
+               S_human(posting_buf, sizeof(posting_buf),
+                       S_i64(field_stats, "posting_bytes")),
+               S_human(lexicon_buf, sizeof(lexicon_buf),
+                       S_i64(field_stats, "lexicon_bytes")),
+               S_human(index_buf, sizeof(index_buf),
+                       S_i64(field_stats, "lexicon_index_bytes")),
+               S_human(sort_buf, sizeof(sort_buf),
+                       S_i64(field_stats, "sort_bytes")));
+        free(name);
+    }
+    DECREF(iter);
+}
+
+static void
+S_print_segments(Vector *segments) {
+    char disk_buf[32], resident_buf[32];
+    printf("\n%-20s %12s %12s %9s %11s %11s\n", "segment", "docs",
+           "deleted", "del %", "disk", "resident");
+    for (uint32_t i = 0, max = Vec_Get_Size(segments); i < max; i++) {
+        Hash *seg_stats = (Hash*)Vec_Fetch(segments, i);
+        Obj  *name_obj  = Hash_Fetch_Utf8(seg_stats, "name", 4);
+        char *name      = name_obj ? Str_To_Utf8((String*)name_obj) : NULL;
+        printf("%-20s %12lld %12lld %8.1f%% %11s %11s\n",
+               name ? name : "?",
+               (long long)S_i64(seg_stats, "doc_max"),
+               (long long)S_i64(seg_stats, "del_count"),
+               100.0 * S_f64(seg_stats, "deletion_ratio"),
+               S_human(disk_buf, sizeof(disk_buf),
+                       S_i64(seg_stats, "bytes")),
+               S_human(resident_buf, sizeof(resident_buf),
+                       S_i64(seg_stats, "resident_bytes")));
+        free(name);
+    }
+}
+
+static void
+S_print_report(const char *index_path, Hash *stats) {
+    char disk_buf[32], resident_buf[32];
+    printf("Index:     %s\n", index_path);
+    printf("Segments:  %lld\n", (long long)S_i64(stats, "num_segments"));
+    printf("Docs:      %lld live, %lld deleted (%.1f%%)\n",
+           (long long)S_i64(stats, "doc_count"),
+           (long long)S_i64(stats, "del_count"),
+           100.0 * S_f64(stats, "deletion_ratio"));
+    printf("Disk:      %s\n",
+           S_human(disk_buf, sizeof(disk_buf), S_i64(stats, "bytes")));
+    printf("Resident:  %s (estimated memory to serve searches)\n",
+           S_human(resident_buf, sizeof(resident_buf),
+                   S_i64(stats, "resident_bytes")));
+    if (Hash_Fetch_Utf8(stats, "warm", 4)) {
+        printf("Warm:      %.1f%% of hot files in memory\n",
+               100.0 * S_f64(stats, "warm"));
+    }
+
+    Hash *fields = (Hash*)Hash_Fetch_Utf8(stats, "fields", 6);
+    if (fields && Hash_Get_Size(fields)) { S_print_fields(fields); }
+    Vector *segments = (Vector*)Hash_Fetch_Utf8(stats, "segments", 8);
+    if (segments && Vec_Get_Size(segments)) { S_print_segments(segments); }
+}
+
+int
+main(int argc, char **argv) {
+    StatsContext ctx = { NULL, 0, NULL };
+    int json = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            S_usage(stdout);
+            return EXIT_SUCCESS;
+        }
+        else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        }
+        else if (strcmp(argv[i], "--warm") == 0) {
+            ctx.warm = 1;
+        }
+        else if (argv[i][0] != '-' && !ctx.index_path) {
+            ctx.index_path = argv[i];
+        }
+        else {
+            S_usage(stderr);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!ctx.index_path) {
+        S_usage(stderr);
+        return EXIT_FAILURE;
+    }
+
+    lucy_bootstrap_parcel();
+    Err *error = Err_trap(S_gather, &ctx);
+    if (error) {
+        char *message = Str_To_Utf8(Err_Get_Mess(error));
+        fprintf(stderr, "Can't read index '%s': %s\n", ctx.index_path,
+                message);
+        free(message);
+        DECREF(error);
+        return EXIT_FAILURE;
+    }
+
+    if (json) {
+        String *text = Json_to_json((Obj*)ctx.stats);
+        fwrite(Str_Get_Ptr8(text), 1, Str_Get_Size(text), stdout);
+        DECREF(text);
+    }
+    else {
+        S_print_report(ctx.index_path, ctx.stats);
+    }
+
+    DECREF(ctx.stats);
+    return EXIT_SUCCESS;
+}
@@ -7991,6 +7991,10 @@ lucy_MakeFile_write_c_cfc_rules(lucy_MakeFile *self);
 static void
 lucy_MakeFile_write_c_test_rules(lucy_MakeFile *self);
 
+static void
+lucy_MakeFile_write_c_program_rules(lucy_MakeFile *self, const char *dir,
+                                    const char *name, const char *target);
+
 static void
 S_c_file_callback(const char *dir, char *file, void *context);
 
@@ -8383,6 +8387,8 @@ lucy_MakeFile_write(lucy_MakeFile *self) {
 
     if (!chaz_CLI_defined(self->cli, "enable-perl")) {
         lucy_MakeFile_write_c_test_rules(self);
+        lucy_MakeFile_write_c_program_rules(self, "bench", "bench", "bench");
+        lucy_MakeFile_write_c_program_rules(self, "tools", "stats", "tools");
     }
 
     clean_rule = chaz_MakeFile_clean_rule(self->makefile);
@@ -8527,6 +8533,62 @@ lucy_MakeFile_write_c_test_rules(lucy_MakeFile *self) {
     free(test_lucy_obj);
 }
 
+/* Build the standalone program dir/lucy-name from dir/lucy_name.c, and
+ * make it a prerequisite of the phony target `target`.
+ */
+static void
+lucy_MakeFile_write_c_program_rules(lucy_MakeFile *self, const char *dir,
+                                    const char *name, const char *target) {
+    const char *dir_sep  = chaz_OS_dir_sep();
+    const char *exe_ext  = chaz_OS_exe_ext();
+    const char *obj_ext  = chaz_CC_obj_ext();
+    const char *math_lib = chaz_Floats_math_library();
+
+    chaz_CFlags   *cflags;
+    chaz_CFlags   *link_flags;
+    chaz_MakeRule *rule;
+    chaz_MakeRule *clean_rule;
+
+    char *prog_exe;
+    char *prog_obj;
+
+    clean_rule = chaz_MakeFile_clean_rule(self->makefile);
+
+    prog_exe = chaz_Util_join("", dir, dir_sep, "lucy-", name, exe_ext,
+                              NULL);
+    prog_obj = chaz_Util_join("", dir, dir_sep, "lucy_", name, obj_ext,
+                              NULL);
+
+    chaz_MakeFile_add_rule(self->makefile, prog_obj, self->autogen_target);
+
+    cflags = chaz_CC_new_cflags();
+    chaz_CFlags_enable_optimization(cflags);
+    chaz_CFlags_add_include_dir(cflags, self->autogen_inc_dir);
+    chaz_MakeFile_override_cflags(self->makefile, prog_obj, cflags);
+    chaz_CFlags_destroy(cflags);
+
+    link_flags = chaz_CC_new_cflags();
+    chaz_CFlags_add_library(link_flags, self->shared_lib);
+    if (self->cfish_lib_dir) {
+        chaz_CFlags_add_library_path(link_flags, self->cfish_lib_dir);
+    }
+    chaz_CFlags_add_external_library(link_flags, self->cfish_lib_name);
+    if (math_lib) {
+        chaz_CFlags_add_external_library(link_flags, math_lib);
+    }
+    rule = chaz_MakeFile_add_exe(self->makefile, prog_exe, prog_obj,
+                                 link_flags);
+    chaz_MakeRule_add_prereq(rule, self->shared_lib_filename);
+    chaz_CFlags_destroy(link_flags);
+
+    chaz_MakeFile_add_rule(self->makefile, target, prog_exe);
+
+    chaz_MakeRule_add_rm_command(clean_rule, prog_obj);
+
+    free(prog_exe);
+    free(prog_obj);
+}
+
 static void
 S_c_file_callback(const char *dir, char *file, void *context) {
     SourceFileContext *sfc = (SourceFileContext*)context;
@@ -0,0 +1,108 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_SHINGLEFILTER
+#define C_LUCY_TOKEN
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Analysis/ShingleFilter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/Token.h"
+
+ShingleFilter*
+ShingleFilter_new() {
+    ShingleFilter *self = (ShingleFilter*)Class_Make_Obj(SHINGLEFILTER);
+    return ShingleFilter_init(self);
+}
+
+ShingleFilter*
+ShingleFilter_init(ShingleFilter *self) {
+    Analyzer_init((Analyzer*)self);
+    return self;
+}
+
+Inversion*
+ShingleFilter_Transform_IMP(ShingleFilter *self, Inversion *inversion) {
+    Inversion *new_inversion = Inversion_new(NULL);
+    Token     *prev          = NULL;
+    Token     *last_shingle  = NULL;
+    int32_t    pos           = 0;
+    int32_t    prev_pos      = 0;
+    int32_t    shingle_pos   = 0;
+    size_t     cap           = 0;
+    char      *buf           = NULL;
+    Token     *token;
+    UNUSED_VAR(self);
+
+    while (NULL != (token = Inversion_Next(inversion))) {
+        TokenIVARS *const token_ivars = Token_IVARS(token);
+
+        if (prev && Token_IVARS(prev)->pos_inc == 1) {
+            TokenIVARS *const prev_ivars = Token_IVARS(prev);
+            size_t len = prev_ivars->len + 1 + token_ivars->len;
+            if (len > cap) {
+                cap = len;
+                buf = (char*)REALLOCATE(buf, cap);
+            }
+            memcpy(buf, prev_ivars->text, prev_ivars->len);
+            buf[prev_ivars->len] = ' ';
+            memcpy(buf + prev_ivars->len + 1, token_ivars->text,
+                   token_ivars->len);
+
+            // The distance between shingles is the distance between their
+            // first tokens, so the previous shingle's increment is known
+            // only now.
+            if (last_shingle) {
+                Token_IVARS(last_shingle)->pos_inc = prev_pos - shingle_pos;
+            }
+            last_shingle = Token_new(buf, len, prev_ivars->start_offset,
+                                     token_ivars->end_offset,
+                                     prev_ivars->boost, 1);
+            shingle_pos = prev_pos;
+            Inversion_Append(new_inversion, last_shingle);
+        }
+
+        prev     = token;
+        prev_pos = pos;
+        pos      = (int32_t)((uint32_t)pos + (uint32_t)token_ivars->pos_inc);
+    }
+
+    FREEMEM(buf);
+    return new_inversion;
+}
+
+bool
+ShingleFilter_Equals_IMP(ShingleFilter *self, Obj *other) {
+    if ((ShingleFilter*)other == self)   { return true; }
+    if (!Obj_is_a(other, SHINGLEFILTER)) { return false; }
+    return true;
+}
+
+Hash*
+ShingleFilter_Dump_IMP(ShingleFilter *self) {
+    ShingleFilter_Dump_t super_dump
+        = SUPER_METHOD_PTR(SHINGLEFILTER, LUCY_ShingleFilter_Dump);
+    return super_dump(self);
+}
+
+ShingleFilter*
+ShingleFilter_Load_IMP(ShingleFilter *self, Obj *dump) {
+    ShingleFilter_Load_t super_load
+        = SUPER_METHOD_PTR(SHINGLEFILTER, LUCY_ShingleFilter_Load);
+    ShingleFilter *loaded = super_load(self, dump);
+    return ShingleFilter_init(loaded);
+}
+
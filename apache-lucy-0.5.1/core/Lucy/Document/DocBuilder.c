@@ -0,0 +1,185 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_DOCBUILDER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Document/DocBuilder.h"
+#include "Clownfish/Blob.h"
+#include "Clownfish/Num.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+
+DocBuilder*
+DocBuilder_new(Schema *schema, Segment *segment) {
+    DocBuilder *self = (DocBuilder*)Class_Make_Obj(DOCBUILDER);
+    return DocBuilder_init(self, schema, segment);
+}
+
+DocBuilder*
+DocBuilder_init(DocBuilder *self, Schema *schema, Segment *segment) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    ivars->schema     = (Schema*)INCREF(schema);
+    ivars->segment    = (Segment*)INCREF(segment);
+    ivars->slot_map   = Hash_new(0);
+    ivars->fields     = Vec_new(0);
+    ivars->field_nums = NULL;
+    ivars->prim_ids   = NULL;
+    ivars->values     = NULL;
+    ivars->num_slots  = 0;
+    ivars->cap        = 0;
+    return self;
+}
+
+void
+DocBuilder_Destroy_IMP(DocBuilder *self) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    DocBuilder_Clear(self);
+    DECREF(ivars->schema);
+    DECREF(ivars->segment);
+    DECREF(ivars->slot_map);
+    DECREF(ivars->fields);
+    FREEMEM(ivars->field_nums);
+    FREEMEM(ivars->prim_ids);
+    FREEMEM(ivars->values);
+    SUPER_DESTROY(self, DOCBUILDER);
+}
+
+static void
+S_grow(DocBuilderIVARS *ivars) {
+    uint32_t cap = ivars->cap ? ivars->cap * 2 : 8;
+    ivars->field_nums = (int32_t*)REALLOCATE(ivars->field_nums,
+                                             cap * sizeof(int32_t));
+    ivars->prim_ids   = (int32_t*)REALLOCATE(ivars->prim_ids,
+                                             cap * sizeof(int32_t));
+    ivars->values     = (Obj**)REALLOCATE(ivars->values, cap * sizeof(Obj*));
+    ivars->cap        = cap;
+}
+
+uint32_t
+DocBuilder_Add_Field_IMP(DocBuilder *self, String *field) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    Integer *existing = (Integer*)Hash_Fetch(ivars->slot_map, field);
+    if (existing) { return (uint32_t)Int_Get_Value(existing); }
+
+    FieldType *type = Schema_Fetch_Type(ivars->schema, field);
+    if (!type) {
+        THROW(ERR, "Unknown field name: '%o'", field);
+    }
+    int32_t field_num = Seg_Field_Num(ivars->segment, field);
+    if (!field_num) { field_num = Seg_Add_Field(ivars->segment, field); }
+
+    if (ivars->num_slots == ivars->cap) { S_grow(ivars); }
+    uint32_t slot = ivars->num_slots++;
+    ivars->field_nums[slot] = field_num;
+    ivars->prim_ids[slot]
+        = FType_Primitive_ID(type) & FType_PRIMITIVE_ID_MASK;
+    ivars->values[slot] = NULL;
+    Vec_Push(ivars->fields, (Obj*)Str_Clone(field));
+    Hash_Store(ivars->slot_map, field, (Obj*)Int_new(slot));
+    return slot;
+}
+
+int32_t
+DocBuilder_Find_Slot_IMP(DocBuilder *self, String *field) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    Integer *slot = (Integer*)Hash_Fetch(ivars->slot_map, field);
+    return slot ? (int32_t)Int_Get_Value(slot) : -1;
+}
+
+static void
+S_check_slot(DocBuilderIVARS *ivars, uint32_t slot) {
+    if (slot >= ivars->num_slots) {
+        THROW(ERR, "Slot %u32 out of range (%u32 slots)", slot,
+              ivars->num_slots);
+    }
+}
+
+void
+DocBuilder_Set_Value_IMP(DocBuilder *self, uint32_t slot, Obj *value) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    S_check_slot(ivars, slot);
+
+    if (value) {
+        switch (ivars->prim_ids[slot]) {
+            case FType_TEXT:
+                CERTIFY(value, STRING);
+                break;
+            case FType_BLOB:
+                CERTIFY(value, BLOB);
+                break;
+            case FType_INT32:
+            case FType_INT64:
+                CERTIFY(value, INTEGER);
+                break;
+            case FType_FLOAT32:
+            case FType_FLOAT64:
+                CERTIFY(value, FLOAT);
+                break;
+            default:
+                THROW(ERR, "Unrecognized type for field '%o'",
+                      Vec_Fetch(ivars->fields, slot));
+        }
+    }
+
+    if (ivars->values[slot] != value) {
+        DECREF(ivars->values[slot]);
+        ivars->values[slot] = value ? INCREF(value) : NULL;
+    }
+}
+
+Obj*
+DocBuilder_Get_Value_IMP(DocBuilder *self, uint32_t slot) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    S_check_slot(ivars, slot);
+    return ivars->values[slot];
+}
+
+String*
+DocBuilder_Get_Field_Name_IMP(DocBuilder *self, uint32_t slot) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    S_check_slot(ivars, slot);
+    return (String*)Vec_Fetch(ivars->fields, slot);
+}
+
+int32_t
+DocBuilder_Get_Field_Num_IMP(DocBuilder *self, uint32_t slot) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    S_check_slot(ivars, slot);
+    return ivars->field_nums[slot];
+}
+
+uint32_t
+DocBuilder_Num_Slots_IMP(DocBuilder *self) {
+    return DocBuilder_IVARS(self)->num_slots;
+}
+
+Segment*
+DocBuilder_Get_Segment_IMP(DocBuilder *self) {
+    return DocBuilder_IVARS(self)->segment;
+}
+
+void
+DocBuilder_Clear_IMP(DocBuilder *self) {
+    DocBuilderIVARS *const ivars = DocBuilder_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_slots; i++) {
+        DECREF(ivars->values[i]);
+        ivars->values[i] = NULL;
+    }
+}
+
@@ -16,6 +16,7 @@
 
 #define C_LUCY_HIGHLIGHTER
 #include <ctype.h>
+#include <stdlib.h>
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Highlight/Highlighter.h"
@@ -44,6 +45,34 @@ S_do_encode(Highlighter *self, String *text, CharBuf **encode_buf);
 static String*
 S_encode_entities(String *text, CharBuf *encoded);
 
+// A document awaiting an excerpt from Create_Excerpts.
+typedef struct ExcerptJob {
+    size_t   tick;
+    int32_t  doc_id;
+    String  *field_val;
+} ExcerptJob;
+
+// Build an excerpt for a non-empty field value.
+static String*
+S_excerpt_from_doc_vec(Highlighter *self, String *field_val,
+                       DocVector *doc_vec);
+
+static int
+S_compare_doc_id(const void *va, const void *vb);
+
+// State for Create_Excerpts, kept outside the trapped routine so that the
+// jobs can be released if an excerpt fails.
+struct excerpts_context {
+    Highlighter *highlighter;
+    Vector      *hit_docs;
+    Vector      *excerpts;
+    ExcerptJob  *jobs;
+    size_t       num_jobs;
+};
+
+static void
+S_create_excerpts(void *context);
+
 Highlighter*
 Highlighter_new(Searcher *searcher, Obj *query, String *field,
                 uint32_t excerpt_length) {
@@ -168,33 +197,114 @@ Highlighter_Create_Excerpt_IMP(Highlighter *self, HitDoc *hit_doc) {
         DocVector *doc_vec
             = Searcher_Fetch_Doc_Vec(ivars->searcher,
                                      HitDoc_Get_Doc_ID(hit_doc));
-        Vector *maybe_spans
-            = Compiler_Highlight_Spans(ivars->compiler, ivars->searcher,
-                                       doc_vec, ivars->field);
-        Vector *score_spans = maybe_spans ? maybe_spans : Vec_new(0);
-        Vec_Sort(score_spans);
-        HeatMap *heat_map
-            = HeatMap_new(score_spans, (ivars->excerpt_length * 2) / 3);
-
-        int32_t top;
-        String *raw_excerpt
-            = Highlighter_Raw_Excerpt(self, field_val, &top, heat_map);
-        String *highlighted
-            = Highlighter_Highlight_Excerpt(self, score_spans, raw_excerpt,
-                                            top);
-
-        DECREF(raw_excerpt);
-        DECREF(heat_map);
-        DECREF(score_spans);
+        retval = S_excerpt_from_doc_vec(self, field_val, doc_vec);
         DECREF(doc_vec);
-
-        retval = highlighted;
     }
 
     DECREF(field_val);
     return retval;
 }
 
+Vector*
+Highlighter_Create_Excerpts_IMP(Highlighter *self, Vector *hit_docs) {
+    size_t num_docs = Vec_Get_Size(hit_docs);
+    struct excerpts_context context;
+    context.highlighter = self;
+    context.hit_docs    = hit_docs;
+    context.excerpts    = Vec_new(num_docs);
+    context.jobs        = (ExcerptJob*)MALLOCATE(num_docs * sizeof(ExcerptJob));
+    context.num_jobs    = 0;
+
+    Err *error = Err_trap(S_create_excerpts, &context);
+    for (size_t i = 0; i < context.num_jobs; i++) {
+        DECREF(context.jobs[i].field_val);
+    }
+    FREEMEM(context.jobs);
+    if (error) {
+        DECREF(context.excerpts);
+        RETHROW(error);
+    }
+
+    // Pad the result so that it lines up with `hit_docs`.
+    if (Vec_Get_Size(context.excerpts) < num_docs) {
+        Vec_Resize(context.excerpts, num_docs);
+    }
+    return context.excerpts;
+}
+
+static void
+S_create_excerpts(void *context) {
+    struct excerpts_context *args = (struct excerpts_context*)context;
+    Highlighter *self = args->highlighter;
+    HighlighterIVARS *const ivars = Highlighter_IVARS(self);
+    ExcerptJob *jobs = args->jobs;
+
+    // Only documents with a non-empty value need term vectors.
+    for (size_t i = 0, max = Vec_Get_Size(args->hit_docs); i < max; i++) {
+        HitDoc *hit_doc
+            = (HitDoc*)CERTIFY(Vec_Fetch(args->hit_docs, i), HITDOC);
+        String *field_val = (String*)HitDoc_Extract(hit_doc, ivars->field);
+        if (!field_val || !Obj_is_a((Obj*)field_val, STRING)) {
+            DECREF(field_val);
+        }
+        else if (!Str_Get_Size(field_val)) {
+            Vec_Store(args->excerpts, i, (Obj*)field_val);
+        }
+        else {
+            jobs[args->num_jobs].tick      = i;
+            jobs[args->num_jobs].doc_id    = HitDoc_Get_Doc_ID(hit_doc);
+            jobs[args->num_jobs].field_val = field_val;
+            args->num_jobs++;
+        }
+    }
+
+    // Fetch term vectors in doc id order so that reads are sequential.
+    qsort(jobs, args->num_jobs, sizeof(ExcerptJob), S_compare_doc_id);
+    for (size_t i = 0; i < args->num_jobs; i++) {
+        ExcerptJob *job = &jobs[i];
+        DocVector *doc_vec = Searcher_Fetch_Doc_Vec(ivars->searcher,
+                                                    job->doc_id);
+        String *excerpt = S_excerpt_from_doc_vec(self, job->field_val,
+                                                 doc_vec);
+        Vec_Store(args->excerpts, job->tick, (Obj*)excerpt);
+        DECREF(doc_vec);
+        DECREF(job->field_val);
+        job->field_val = NULL;
+    }
+}
+
+static String*
+S_excerpt_from_doc_vec(Highlighter *self, String *field_val,
+                       DocVector *doc_vec) {
+    HighlighterIVARS *const ivars = Highlighter_IVARS(self);
+    Vector *maybe_spans
+        = Compiler_Highlight_Spans(ivars->compiler, ivars->searcher,
+                                   doc_vec, ivars->field);
+    Vector *score_spans = maybe_spans ? maybe_spans : Vec_new(0);
+    Vec_Sort(score_spans);
+    HeatMap *heat_map
+        = HeatMap_new(score_spans, (ivars->excerpt_length * 2) / 3);
+
+    int32_t top;
+    String *raw_excerpt
+        = Highlighter_Raw_Excerpt(self, field_val, &top, heat_map);
+    String *highlighted
+        = Highlighter_Highlight_Excerpt(self, score_spans, raw_excerpt,
+                                        top);
+
+    DECREF(raw_excerpt);
+    DECREF(heat_map);
+    DECREF(score_spans);
+    return highlighted;
+}
+
+static int
+S_compare_doc_id(const void *va, const void *vb) {
+    const ExcerptJob *a = (const ExcerptJob*)va;
+    const ExcerptJob *b = (const ExcerptJob*)vb;
+    return a->doc_id < b->doc_id ? -1 : a->doc_id > b->doc_id ? 1 : 0;
+}
+
 static int32_t
 S_hottest(HeatMap *heat_map) {
     float max_score = 0.0f;
@@ -34,6 +34,7 @@
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/FSFolder.h"
 #include "Lucy/Store/Lock.h"
+#include "Lucy/Util/Clock.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
@@ -58,6 +59,11 @@ S_release_write_lock(BackgroundMerger *self);
 static void
 S_release_merge_lock(BackgroundMerger *self);
 
+// Make a snapshot rename durable, if commits are synced.  Return the
+// microseconds spent.
+static uint64_t
+S_sync_index_dir(BackgroundMerger *self);
+
 BackgroundMerger*
 BGMerger_new(Obj *index, IndexManager *manager) {
     BackgroundMerger *self
@@ -75,6 +81,8 @@ BGMerger_init(BackgroundMerger *self, Obj *index, IndexManager *manager) {
     ivars->prepared      = false;
     ivars->needs_commit  = false;
     ivars->snapfile      = NULL;
+    ivars->commit_usec   = 0;
+    ivars->sync_usec     = 0;
     ivars->doc_maps      = Hash_new(0);
 
     // Assign.
@@ -310,6 +318,8 @@ S_merge_updated_deletions(BackgroundMerger *self) {
         int64_t new_seg_num
             = IxManager_Highest_Seg_Num(ivars->manager, latest_snapshot) + 1;
         Segment   *new_segment = Seg_new(new_seg_num);
+        Seg_Set_Binary_Metadata(new_segment,
+                                IxManager_Get_Binary_Metadata(ivars->manager));
         SegWriter *seg_writer  = SegWriter_new(ivars->schema, ivars->snapshot,
                                                new_segment, merge_polyreader);
         DeletionsWriter *del_writer = SegWriter_Get_Del_Writer(seg_writer);
@@ -374,6 +384,7 @@ BGMerger_Prepare_Commit_IMP(BackgroundMerger *self) {
     Vector   *seg_readers     = PolyReader_Get_Seg_Readers(ivars->polyreader);
     uint32_t  num_seg_readers = Vec_Get_Size(seg_readers);
     uint32_t  segs_merged     = 0;
+    uint64_t  start           = Clock_microseconds();
 
     if (ivars->prepared) {
         THROW(ERR, "Can't call Prepare_Commit() more than once");
@@ -403,6 +414,9 @@ BGMerger_Prepare_Commit_IMP(BackgroundMerger *self) {
         }
 
         // Finish the segment.
+        bool binary = IxManager_Get_Binary_Metadata(ivars->manager);
+        Seg_Set_Binary_Metadata(ivars->segment, binary);
+        Snapshot_Set_Binary_Metadata(snapshot, binary);
         SegWriter_Finish(ivars->seg_writer);
 
         // Grab the write lock.
@@ -461,6 +475,18 @@ BGMerger_Prepare_Commit_IMP(BackgroundMerger *self) {
 
         DECREF(latest_snapshot);
 
+        // Make the merged segment and the snapshot durable before the
+        // snapshot is published.
+        Vector *new_files = Vec_new(2);
+        String *seg_name  = Seg_Get_Name(ivars->segment);
+        if (Folder_Exists(folder, seg_name)) {
+            Vec_Push(new_files, INCREF(seg_name));
+        }
+        Vec_Push(new_files, INCREF(ivars->snapfile));
+        ivars->sync_usec += IxManager_Sync_Files(ivars->manager, folder,
+                                                 new_files);
+        DECREF(new_files);
+
         ivars->needs_commit = true;
     }
 
@@ -468,6 +494,7 @@ BGMerger_Prepare_Commit_IMP(BackgroundMerger *self) {
     PolyReader_Close(ivars->polyreader);
 
     ivars->prepared = true;
+    ivars->commit_usec += Clock_microseconds() - start;
 }
 
 void
@@ -483,6 +510,7 @@ BGMerger_Commit_IMP(BackgroundMerger *self) {
         BGMerger_Prepare_Commit(self);
     }
 
+    uint64_t start = Clock_microseconds();
     if (ivars->needs_commit) {
         bool success = false;
         String *temp_snapfile = ivars->snapfile;
@@ -510,6 +538,7 @@ BGMerger_Commit_IMP(BackgroundMerger *self) {
             Err_throw_mess(ERR, mess);
         }
         DECREF(temp_snapfile);
+        ivars->sync_usec += S_sync_index_dir(self);
     }
 
     // Release the merge lock and remove the merge data file.
@@ -523,6 +552,23 @@ BGMerger_Commit_IMP(BackgroundMerger *self) {
 
     // Release the write lock.
     S_release_write_lock(self);
+
+    if (ivars->needs_commit) {
+        ivars->commit_usec += Clock_microseconds() - start;
+        IxManager_Report_Commit(ivars->manager, ivars->commit_usec,
+                                ivars->sync_usec);
+    }
+}
+
+static uint64_t
+S_sync_index_dir(BackgroundMerger *self) {
+    BackgroundMergerIVARS *const ivars = BGMerger_IVARS(self);
+    Vector *paths = Vec_new(1);
+    Vec_Push(paths, (Obj*)Str_new_from_trusted_utf8("", 0));
+    uint64_t usec = IxManager_Sync_Files(ivars->manager, ivars->folder,
+                                         paths);
+    DECREF(paths);
+    return usec;
 }
 
 static void
@@ -0,0 +1,653 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_COMMITGROUP
+#include "Lucy/Util/ToolSet.h"
+
+#include "charmony.h"
+
+#include "Lucy/Index/CommitGroup.h"
+#include "Clownfish/Blob.h"
+#include "Clownfish/Num.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/Schema.h"
+
+/* The changes carried by one commit.  Callers waiting on it hold a
+ * reference, so a batch outlives the group's interest in it until every
+ * waiter has seen the outcome.
+ */
+typedef struct CommitBatch {
+    int32_t  refs;
+    bool     done;
+    char    *error;
+} CommitBatch;
+
+/* The batch holding a thread's latest changes since its last Commit, so
+ * that Commit can report that batch's outcome rather than whichever batch
+ * is current by then, plus the error from any earlier batch of the
+ * thread's which failed in the meantime.
+ */
+typedef struct CallerBatch {
+    uint64_t     thread_id;
+    CommitBatch *batch;
+    char        *error;
+} CallerBatch;
+
+// Mutex plus condition variable, per thread API.
+typedef struct GroupSync GroupSync;
+
+static GroupSync*
+S_sync_new(void);
+
+static void
+S_sync_destroy(GroupSync *sync);
+
+static void
+S_lock(GroupSync *sync);
+
+static void
+S_unlock(GroupSync *sync);
+
+// Release the mutex and wait until another thread calls S_broadcast().
+static void
+S_wait(GroupSync *sync);
+
+static void
+S_broadcast(GroupSync *sync);
+
+// Identify the calling thread.
+static uint64_t
+S_thread_id(void);
+
+static CommitBatch*
+S_batch_new(void);
+
+static void
+S_batch_release(CommitBatch *batch);
+
+// Record that the calling thread has changes in `batch`.
+static void
+S_note_caller(CommitGroup *self, CommitBatch *batch);
+
+// Forget the calling thread's batch, returning it along with the reference
+// the record held, or NULL if the thread has no changes pending.  Any
+// earlier error is handed over in `error`.
+static CommitBatch*
+S_take_caller(CommitGroup *self, char **error);
+
+// Run `routine` with the mutex held, once any commit under way has
+// finished.  On success, the open batch is marked as holding changes.
+static void
+S_change(CommitGroup *self, Err_Attempt_t routine, void *context);
+
+// Commit the open batch.  Called with the mutex held; releases it while
+// the Indexer commits.
+static void
+S_lead(CommitGroup *self);
+
+CommitGroup*
+CommitGroup_new(Schema *schema, Obj *index, IndexManager *manager,
+                int32_t flags) {
+    CommitGroup *self = (CommitGroup*)Class_Make_Obj(COMMITGROUP);
+    return CommitGroup_init(self, schema, index, manager, flags);
+}
+
+CommitGroup*
+CommitGroup_init(CommitGroup *self, Schema *schema, Obj *index,
+                 IndexManager *manager, int32_t flags) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    ivars->schema        = (Schema*)INCREF(schema);
+    ivars->index         = INCREF(index);
+    ivars->manager       = (IndexManager*)INCREF(manager);
+    ivars->indexer       = NULL;
+    ivars->flags         = flags;
+    ivars->dirty         = false;
+    ivars->committing    = false;
+    ivars->commit_count  = 0;
+    ivars->request_count = 0;
+    ivars->open_batch    = NULL;
+    ivars->last_batch    = NULL;
+    ivars->callers       = NULL;
+    ivars->num_callers   = 0;
+    ivars->sync          = S_sync_new();
+    if (!ivars->sync) {
+        DECREF(self);
+        THROW(ERR, "Failed to initialize CommitGroup mutex");
+    }
+    return self;
+}
+
+void
+CommitGroup_Destroy_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    DECREF(ivars->schema);
+    DECREF(ivars->index);
+    DECREF(ivars->manager);
+    DECREF(ivars->indexer);
+    if (ivars->open_batch) { S_batch_release((CommitBatch*)ivars->open_batch); }
+    if (ivars->last_batch) { S_batch_release((CommitBatch*)ivars->last_batch); }
+    CallerBatch *callers = (CallerBatch*)ivars->callers;
+    for (uint32_t i = 0; i < ivars->num_callers; i++) {
+        S_batch_release(callers[i].batch);
+        FREEMEM(callers[i].error);
+    }
+    FREEMEM(callers);
+    if (ivars->sync)       { S_sync_destroy((GroupSync*)ivars->sync); }
+    SUPER_DESTROY(self, COMMITGROUP);
+}
+
+struct change_context {
+    CommitGroup *group;
+    Doc         *doc;
+    float        boost;
+    String      *field;
+    Obj         *term;
+};
+
+static Indexer*
+S_indexer(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    if (!ivars->indexer) {
+        ivars->indexer = Indexer_new(ivars->schema, ivars->index,
+                                     ivars->manager, ivars->flags);
+    }
+    return ivars->indexer;
+}
+
+// The Indexer keeps references to what it's given -- the Inverter holds
+// the last doc and its values, sort writers hold field values until they
+// flush -- and drops them later, on whichever thread holds the mutex then.
+// Since Clownfish refcounts aren't atomic, it only ever gets private copies
+// of the caller's objects.  Obj_Clone() won't do, since immutable types
+// such as String return themselves.
+static Obj*
+S_copy_value(Obj *value) {
+    if (value == NULL) {
+        return NULL;
+    }
+    else if (Obj_is_a(value, STRING)) {
+        String *string = (String*)value;
+        return (Obj*)Str_new_from_trusted_utf8(Str_Get_Ptr8(string),
+                                               Str_Get_Size(string));
+    }
+    else if (Obj_is_a(value, BLOB)) {
+        Blob *blob = (Blob*)value;
+        return (Obj*)Blob_new(Blob_Get_Buf(blob), Blob_Get_Size(blob));
+    }
+    else if (Obj_is_a(value, FLOAT)) {
+        return (Obj*)Float_new(Float_Get_Value((Float*)value));
+    }
+    else if (Obj_is_a(value, INTEGER)) {
+        return (Obj*)Int_new(Int_Get_Value((Integer*)value));
+    }
+    else {
+        return Obj_Clone(value);
+    }
+}
+
+static Doc*
+S_copy_doc(Doc *doc) {
+    Doc    *copy  = Doc_new(NULL, Doc_Get_Doc_ID(doc));
+    Vector *names = Doc_Field_Names(doc);
+    for (uint32_t i = 0, max = Vec_Get_Size(names); i < max; i++) {
+        String *name  = (String*)Vec_Fetch(names, i);
+        Obj    *value = Doc_Extract(doc, name);
+        String *name_copy  = (String*)S_copy_value((Obj*)name);
+        Obj    *value_copy = S_copy_value(value);
+        Doc_Store(copy, name_copy, value_copy);
+        DECREF(value_copy);
+        DECREF(name_copy);
+        DECREF(value);
+    }
+    DECREF(names);
+    return copy;
+}
+
+static void
+S_add_doc(void *context) {
+    struct change_context *args = (struct change_context*)context;
+    Doc *doc = S_copy_doc(args->doc);
+    Indexer_Add_Doc(S_indexer(args->group), doc, args->boost);
+    DECREF(doc);
+}
+
+static void
+S_delete_by_term(void *context) {
+    struct change_context *args = (struct change_context*)context;
+    String *field = (String*)S_copy_value((Obj*)args->field);
+    Obj    *term  = S_copy_value(args->term);
+    Indexer_Delete_By_Term(S_indexer(args->group), field, term);
+    DECREF(term);
+    DECREF(field);
+}
+
+static void
+S_update_doc(void *context) {
+    struct change_context *args = (struct change_context*)context;
+    String *field = (String*)S_copy_value((Obj*)args->field);
+    Obj    *term  = S_copy_value(args->term);
+    Doc    *doc   = S_copy_doc(args->doc);
+    Indexer_Update_Doc(S_indexer(args->group), field, term, doc,
+                       args->boost);
+    DECREF(doc);
+    DECREF(term);
+    DECREF(field);
+}
+
+void
+CommitGroup_Add_Doc_IMP(CommitGroup *self, Doc *doc, float boost) {
+    struct change_context args;
+    args.group = self;
+    args.doc   = doc;
+    args.boost = boost;
+    args.field = NULL;
+    args.term  = NULL;
+    S_change(self, S_add_doc, &args);
+}
+
+void
+CommitGroup_Delete_By_Term_IMP(CommitGroup *self, String *field,
+                               Obj *term) {
+    struct change_context args;
+    args.group = self;
+    args.doc   = NULL;
+    args.boost = 0.0f;
+    args.field = field;
+    args.term  = term;
+    S_change(self, S_delete_by_term, &args);
+}
+
+void
+CommitGroup_Update_Doc_IMP(CommitGroup *self, String *field, Obj *term,
+                           Doc *doc, float boost) {
+    struct change_context args;
+    args.group = self;
+    args.doc   = doc;
+    args.boost = boost;
+    args.field = field;
+    args.term  = term;
+    S_change(self, S_update_doc, &args);
+}
+
+static void
+S_change(CommitGroup *self, Err_Attempt_t routine, void *context) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    GroupSync *sync = (GroupSync*)ivars->sync;
+
+    S_lock(sync);
+    while (ivars->committing) { S_wait(sync); }
+    Err *error = Err_trap(routine, context);
+    if (!error) {
+        if (!ivars->open_batch) { ivars->open_batch = S_batch_new(); }
+        ivars->dirty = true;
+        S_note_caller(self, (CommitBatch*)ivars->open_batch);
+    }
+    else {
+        // An Indexer can be left inconsistent by a failed change, so the
+        // changes pending in it are abandoned, and whoever made them learns
+        // why from Commit.
+        CommitBatch *batch = (CommitBatch*)ivars->open_batch;
+        if (batch) {
+            batch->error = Str_To_Utf8(Err_Get_Mess(error));
+            batch->done  = true;
+            if (ivars->last_batch) {
+                S_batch_release((CommitBatch*)ivars->last_batch);
+            }
+            ivars->last_batch = batch;
+            ivars->open_batch = NULL;
+            ivars->dirty      = false;
+            S_broadcast(sync);
+        }
+        DECREF(ivars->indexer);
+        ivars->indexer = NULL;
+    }
+    S_unlock(sync);
+
+    if (error) { RETHROW(error); }
+}
+
+void
+CommitGroup_Commit_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    GroupSync *sync = (GroupSync*)ivars->sync;
+
+    S_lock(sync);
+    ivars->request_count++;
+
+    // The caller's own changes went into the batch recorded for its
+    // thread, which may have finished -- or been abandoned -- since.  A
+    // caller without changes of its own waits for whatever is pending: the
+    // open batch or, if that holds nothing, the batch being committed.
+    char        *earlier_error = NULL;
+    CommitBatch *batch = S_take_caller(self, &earlier_error);
+    if (!batch) {
+        batch = (CommitBatch*)(ivars->dirty
+                               ? ivars->open_batch
+                               : ivars->last_batch);
+        if (!batch || batch->done) {
+            S_unlock(sync);
+            return;
+        }
+        batch->refs++;
+    }
+    while (!batch->done) {
+        if (!ivars->committing && batch == ivars->open_batch) {
+            S_lead(self);
+        }
+        else {
+            S_wait(sync);
+        }
+    }
+    const char *error = earlier_error ? earlier_error : batch->error;
+    String *mess = error
+                   ? Str_newf("Group commit failed: %s", error)
+                   : NULL;
+    FREEMEM(earlier_error);
+    S_batch_release(batch);
+    S_unlock(sync);
+
+    if (mess) { Err_throw_mess(ERR, mess); }
+}
+
+static void
+S_commit_indexer(void *context) {
+    Indexer_Commit((Indexer*)context);
+}
+
+static void
+S_lead(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    GroupSync   *sync    = (GroupSync*)ivars->sync;
+    CommitBatch *batch   = (CommitBatch*)ivars->open_batch;
+    Indexer     *indexer = ivars->indexer;
+
+    // Close the batch.  Changes arriving from here on wait for the commit
+    // to finish, then start the next batch.
+    if (ivars->last_batch) {
+        S_batch_release((CommitBatch*)ivars->last_batch);
+    }
+    ivars->last_batch = batch;
+    ivars->open_batch = NULL;
+    ivars->indexer    = NULL;
+    ivars->dirty      = false;
+    ivars->committing = true;
+    S_unlock(sync);
+
+    Err *error = indexer ? Err_trap(S_commit_indexer, indexer) : NULL;
+    DECREF(indexer);
+
+    S_lock(sync);
+    ivars->committing = false;
+    if (error) {
+        batch->error = Str_To_Utf8(Err_Get_Mess(error));
+        DECREF(error);
+    }
+    else {
+        ivars->commit_count++;
+    }
+    batch->done = true;
+    S_broadcast(sync);
+}
+
+uint32_t
+CommitGroup_Get_Commit_Count_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    GroupSync *sync = (GroupSync*)ivars->sync;
+    S_lock(sync);
+    uint32_t count = ivars->commit_count;
+    S_unlock(sync);
+    return count;
+}
+
+uint32_t
+CommitGroup_Get_Request_Count_IMP(CommitGroup *self) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    GroupSync *sync = (GroupSync*)ivars->sync;
+    S_lock(sync);
+    uint32_t count = ivars->request_count;
+    S_unlock(sync);
+    return count;
+}
+
+static CommitBatch*
+S_batch_new() {
+    CommitBatch *batch = (CommitBatch*)MALLOCATE(sizeof(CommitBatch));
+    batch->refs  = 1;
+    batch->done  = false;
+    batch->error = NULL;
+    return batch;
+}
+
+static void
+S_batch_release(CommitBatch *batch) {
+    if (--batch->refs == 0) {
+        FREEMEM(batch->error);
+        FREEMEM(batch);
+    }
+}
+
+static void
+S_note_caller(CommitGroup *self, CommitBatch *batch) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    CallerBatch *callers   = (CallerBatch*)ivars->callers;
+    uint64_t     thread_id = S_thread_id();
+    for (uint32_t i = 0; i < ivars->num_callers; i++) {
+        if (callers[i].thread_id == thread_id) {
+            if (callers[i].batch != batch) {
+                // Changes wait out any commit under way, so the earlier
+                // batch has finished.  Keep its error for Commit to report.
+                CommitBatch *earlier = callers[i].batch;
+                if (earlier->error && !callers[i].error) {
+                    size_t len = strlen(earlier->error);
+                    callers[i].error = (char*)MALLOCATE(len + 1);
+                    memcpy(callers[i].error, earlier->error, len + 1);
+                }
+                S_batch_release(earlier);
+                callers[i].batch = batch;
+                batch->refs++;
+            }
+            return;
+        }
+    }
+    callers = (CallerBatch*)REALLOCATE(callers, (ivars->num_callers + 1)
+                                                * sizeof(CallerBatch));
+    callers[ivars->num_callers].thread_id = thread_id;
+    callers[ivars->num_callers].batch     = batch;
+    callers[ivars->num_callers].error     = NULL;
+    batch->refs++;
+    ivars->callers = callers;
+    ivars->num_callers++;
+}
+
+static CommitBatch*
+S_take_caller(CommitGroup *self, char **error) {
+    CommitGroupIVARS *const ivars = CommitGroup_IVARS(self);
+    CallerBatch *callers   = (CallerBatch*)ivars->callers;
+    uint64_t     thread_id = S_thread_id();
+    for (uint32_t i = 0; i < ivars->num_callers; i++) {
+        if (callers[i].thread_id == thread_id) {
+            CommitBatch *batch = callers[i].batch;
+            *error = callers[i].error;
+            callers[i] = callers[--ivars->num_callers];
+            return batch;
+        }
+    }
+    *error = NULL;
+    return NULL;
+}
+
+/***************************************************************************/
+
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
+
+// Windows.h defines INCREF and DECREF, so we include it only at the end of
+// this file and undef those symbols.
+#undef INCREF
+#undef DECREF
+
+#include <windows.h>
+
+struct GroupSync {
+    CRITICAL_SECTION   mutex;
+    CONDITION_VARIABLE cond;
+};
+
+static GroupSync*
+S_sync_new() {
+    GroupSync *sync = (GroupSync*)MALLOCATE(sizeof(GroupSync));
+    InitializeCriticalSection(&sync->mutex);
+    InitializeConditionVariable(&sync->cond);
+    return sync;
+}
+
+static void
+S_sync_destroy(GroupSync *sync) {
+    DeleteCriticalSection(&sync->mutex);
+    FREEMEM(sync);
+}
+
+static void
+S_lock(GroupSync *sync) {
+    EnterCriticalSection(&sync->mutex);
+}
+
+static void
+S_unlock(GroupSync *sync) {
+    LeaveCriticalSection(&sync->mutex);
+}
+
+static void
+S_wait(GroupSync *sync) {
+    SleepConditionVariableCS(&sync->cond, &sync->mutex, INFINITE);
+}
+
+static void
+S_broadcast(GroupSync *sync) {
+    WakeAllConditionVariable(&sync->cond);
+}
+
+static uint64_t
+S_thread_id() {
+    return (uint64_t)GetCurrentThreadId();
+}
+
+#elif !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+
+#include <pthread.h>
+
+struct GroupSync {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+};
+
+static GroupSync*
+S_sync_new() {
+    GroupSync *sync = (GroupSync*)MALLOCATE(sizeof(GroupSync));
+    if (pthread_mutex_init(&sync->mutex, NULL) != 0) {
+        FREEMEM(sync);
+        return NULL;
+    }
+    if (pthread_cond_init(&sync->cond, NULL) != 0) {
+        pthread_mutex_destroy(&sync->mutex);
+        FREEMEM(sync);
+        return NULL;
+    }
+    return sync;
+}
+
+static void
+S_sync_destroy(GroupSync *sync) {
+    pthread_cond_destroy(&sync->cond);
+    pthread_mutex_destroy(&sync->mutex);
+    FREEMEM(sync);
+}
+
+static void
+S_lock(GroupSync *sync) {
+    pthread_mutex_lock(&sync->mutex);
+}
+
+static void
+S_unlock(GroupSync *sync) {
+    pthread_mutex_unlock(&sync->mutex);
+}
+
+static void
+S_wait(GroupSync *sync) {
+    pthread_cond_wait(&sync->cond, &sync->mutex);
+}
+
+static void
+S_broadcast(GroupSync *sync) {
+    pthread_cond_broadcast(&sync->cond);
+}
+
+static uint64_t
+S_thread_id() {
+    // pthread_t is opaque, but a scalar on the platforms we support.
+    pthread_t self = pthread_self();
+    uint64_t  id   = 0;
+    memcpy(&id, &self, sizeof(self) < sizeof(id) ? sizeof(self) : sizeof(id));
+    return id;
+}
+
+#else
+
+struct GroupSync {
+    int dummy;
+};
+
+static GroupSync*
+S_sync_new() {
+    return (GroupSync*)MALLOCATE(sizeof(GroupSync));
+}
+
+static void
+S_sync_destroy(GroupSync *sync) {
+    FREEMEM(sync);
+}
+
+static void
+S_lock(GroupSync *sync) {
+    UNUSED_VAR(sync);
+}
+
+static void
+S_unlock(GroupSync *sync) {
+    UNUSED_VAR(sync);
+}
+
+static void
+S_wait(GroupSync *sync) {
+    // Without threads, only a reentrant call could find a commit under way.
+    UNUSED_VAR(sync);
+    THROW(ERR, "CommitGroup called reentrantly during a commit");
+}
+
+static void
+S_broadcast(GroupSync *sync) {
+    UNUSED_VAR(sync);
+}
+
+static uint64_t
+S_thread_id() {
+    return 0;
+}
+
+#endif // Thread API switch.
+
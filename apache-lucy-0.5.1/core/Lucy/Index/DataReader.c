@@ -94,4 +94,10 @@ DataReader_Get_Segment_IMP(DataReader *self) {
     return DataReader_IVARS(self)->segment;
 }
 
+Hash*
+DataReader_Stats_IMP(DataReader *self) {
+    UNUSED_VAR(self);
+    return NULL;
+}
+
 
@@ -97,3 +97,20 @@ DataWriter_Metadata_IMP(DataWriter *self) {
 }
 
 
+
+uint64_t
+DataWriter_Mem_Consumed_IMP(DataWriter *self) {
+    UNUSED_VAR(self);
+    return 0;
+}
+
+uint64_t
+DataWriter_Largest_Buffer_IMP(DataWriter *self) {
+    UNUSED_VAR(self);
+    return 0;
+}
+
+void
+DataWriter_Flush_Largest_IMP(DataWriter *self) {
+    UNUSED_VAR(self);
+}
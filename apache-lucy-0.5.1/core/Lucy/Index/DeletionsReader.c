@@ -20,6 +20,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/DeletionsReader.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/BitVecDelDocs.h"
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/Segment.h"
@@ -32,6 +33,10 @@
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
 
+// Set the doc ids listed in a sparse deletions file.
+static void
+S_apply_delta(Folder *folder, String *filename, BitVector *deldocs);
+
 DeletionsReader*
 DelReader_init(DeletionsReader *self, Schema *schema, Folder *folder,
                Snapshot *snapshot, Vector *segments, int32_t seg_tick) {
@@ -160,9 +165,53 @@ DefDelReader_Read_Deletions_IMP(DefaultDeletionsReader *self) {
     Vector  *segments    = DefDelReader_Get_Segments(self);
     Segment *segment     = DefDelReader_Get_Segment(self);
     String  *my_seg_name = Seg_Get_Name(segment);
-    String  *del_file    = NULL;
-    int32_t  del_count   = 0;
+    Hash    *seg_files_data
+        = DefDelReader_find_files_data(segments, my_seg_name);
+
+    DECREF(ivars->deldocs);
+    ivars->deldocs   = NULL;
+    ivars->del_count = 0;
+
+    if (seg_files_data) {
+        Obj *count = (Obj*)CERTIFY(
+                         Hash_Fetch_Utf8(seg_files_data, "count", 5), OBJ);
+        String *del_file
+            = (String*)Hash_Fetch_Utf8(seg_files_data, "filename", 8);
+        Vector *deltas
+            = (Vector*)Hash_Fetch_Utf8(seg_files_data, "deltas", 6);
+
+        if (!deltas) {
+            CERTIFY(del_file, STRING);
+            ivars->deldocs
+                = (BitVector*)BitVecDelDocs_new(ivars->folder, del_file);
+        }
+        else {
+            // Overlay the sparse deltas on a copy of the base BitVector.
+            CERTIFY(deltas, VECTOR);
+            uint32_t   doc_max = (uint32_t)Seg_Get_Count(segment);
+            BitVector *deldocs = BitVec_new(doc_max + 1);
+            if (del_file) {
+                BitVecDelDocs *base = BitVecDelDocs_new(
+                                          ivars->folder,
+                                          (String*)CERTIFY(del_file, STRING));
+                BitVec_Or(deldocs, (BitVector*)base);
+                DECREF(base);
+            }
+            for (uint32_t i = 0, max = Vec_Get_Size(deltas); i < max; i++) {
+                String *delta_file
+                    = (String*)CERTIFY(Vec_Fetch(deltas, i), STRING);
+                S_apply_delta(ivars->folder, delta_file, deldocs);
+            }
+            ivars->deldocs = deldocs;
+        }
+        ivars->del_count = (int32_t)Json_obj_to_i64(count);
+    }
+
+    return ivars->deldocs;
+}
 
+Hash*
+DefDelReader_find_files_data(Vector *segments, String *seg_name) {
     // Start with deletions files in the most recently added segments and work
     // backwards.  The first one we find which addresses our segment is the
     // one we need.
@@ -173,31 +222,27 @@ DefDelReader_Read_Deletions_IMP(DefaultDeletionsReader *self) {
         if (metadata) {
             Hash *files = (Hash*)CERTIFY(
                               Hash_Fetch_Utf8(metadata, "files", 5), HASH);
-            Hash *seg_files_data = (Hash*)Hash_Fetch(files, my_seg_name);
+            Hash *seg_files_data = (Hash*)Hash_Fetch(files, seg_name);
             if (seg_files_data) {
-                Obj *count = (Obj*)CERTIFY(
-                                 Hash_Fetch_Utf8(seg_files_data, "count", 5),
-                                 OBJ);
-                del_count = (int32_t)Json_obj_to_i64(count);
-                del_file  = (String*)CERTIFY(
-                                Hash_Fetch_Utf8(seg_files_data, "filename", 8),
-                                STRING);
-                break;
+                return (Hash*)CERTIFY(seg_files_data, HASH);
             }
         }
     }
+    return NULL;
+}
 
-    DECREF(ivars->deldocs);
-    if (del_file) {
-        ivars->deldocs = (BitVector*)BitVecDelDocs_new(ivars->folder, del_file);
-        ivars->del_count = del_count;
-    }
-    else {
-        ivars->deldocs = NULL;
-        ivars->del_count = 0;
+static void
+S_apply_delta(Folder *folder, String *filename, BitVector *deldocs) {
+    InStream *instream = Folder_Open_In(folder, filename);
+    if (!instream) { RETHROW(INCREF(Err_get_error())); }
+    uint32_t num_deletions = InStream_Read_C32(instream);
+    uint32_t doc_id = 0;
+    while (num_deletions--) {
+        doc_id += InStream_Read_C32(instream);
+        BitVec_Set(deldocs, doc_id);
     }
-
-    return ivars->deldocs;
+    InStream_Close(instream);
+    DECREF(instream);
 }
 
 Matcher*
@@ -211,4 +256,38 @@ DefDelReader_Del_Count_IMP(DefaultDeletionsReader *self) {
     return DefDelReader_IVARS(self)->del_count;
 }
 
+Hash*
+DefDelReader_Stats_IMP(DefaultDeletionsReader *self) {
+    DefaultDeletionsReaderIVARS *const ivars = DefDelReader_IVARS(self);
+    Hash    *stats = Hash_new(0);
+    int64_t  bytes = 0;
+    Hash    *seg_files_data
+        = DefDelReader_find_files_data(ivars->segments,
+                                       Seg_Get_Name(ivars->segment));
+
+    if (seg_files_data) {
+        Obj    *del_file = Hash_Fetch_Utf8(seg_files_data, "filename", 8);
+        Vector *deltas
+            = (Vector*)Hash_Fetch_Utf8(seg_files_data, "deltas", 6);
+        if (del_file && Obj_is_a(del_file, STRING)) {
+            bytes += Folder_File_Length(ivars->folder, (String*)del_file);
+        }
+        if (deltas && Obj_is_a((Obj*)deltas, VECTOR)) {
+            for (uint32_t i = 0, max = Vec_Get_Size(deltas); i < max; i++) {
+                Obj *delta_file = Vec_Fetch(deltas, i);
+                if (!delta_file || !Obj_is_a(delta_file, STRING)) { continue; }
+                bytes += Folder_File_Length(ivars->folder,
+                                            (String*)delta_file);
+            }
+        }
+    }
+
+    int64_t resident = ivars->deldocs
+                       ? (BitVec_Get_Capacity(ivars->deldocs) + 7) / 8
+                       : 0;
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(resident));
+    Hash_Store_Utf8(stats, "del_count", 9, (Obj*)Int_new(ivars->del_count));
+    return stats;
+}
 
@@ -25,6 +25,8 @@
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/DeletionsReader.h"
 #include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/PostingList.h"
 #include "Lucy/Index/PostingListReader.h"
@@ -49,6 +51,14 @@ DelWriter_init(DeletionsWriter *self, Schema *schema, Snapshot *snapshot,
     return self;
 }
 
+void
+DelWriter_Delete_By_Terms_IMP(DeletionsWriter *self, String *field,
+                              Vector *terms) {
+    for (uint32_t i = 0, max = Vec_Get_Size(terms); i < max; i++) {
+        DelWriter_Delete_By_Term(self, field, Vec_Fetch(terms, i));
+    }
+}
+
 I32Array*
 DelWriter_Generate_Doc_Map_IMP(DeletionsWriter *self, Matcher *deletions,
                                int32_t doc_max, int32_t offset) {
@@ -69,7 +79,20 @@ DelWriter_Generate_Doc_Map_IMP(DeletionsWriter *self, Matcher *deletions,
     return I32Arr_new_steal(doc_map, doc_max + 1);
 }
 
-int32_t DefDelWriter_current_file_format = 1;
+int32_t DefDelWriter_current_file_format = 2;
+
+// Compact a segment's deletions into a new BitVector once it has this many
+// delta files.
+static const uint32_t MAX_DELTAS = 8;
+
+// Write the deletions for one segment, returning its metadata.
+static Hash*
+S_write_seg_deletions(DefaultDeletionsWriter *self, uint32_t tick);
+
+// Return the doc ids deleted during this session, in ascending order.
+static int32_t*
+S_new_deletions(SegReader *seg_reader, BitVector *deldocs,
+                int32_t *num_deletions_ptr);
 
 DefaultDeletionsWriter*
 DefDelWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -90,6 +113,10 @@ DefDelWriter_init(DefaultDeletionsWriter *self, Schema *schema,
     uint32_t num_seg_readers    = Vec_Get_Size(ivars->seg_readers);
     ivars->seg_starts           = PolyReader_Offsets(polyreader);
     ivars->bit_vecs             = Vec_new(num_seg_readers);
+    ivars->seg_entries          = Vec_new(num_seg_readers);
+    ivars->new_entries          = Vec_new(num_seg_readers);
+    ivars->added_dels           = Hash_new(0);
+    ivars->added_entry          = NULL;
     ivars->updated              = (bool*)CALLOCATE(num_seg_readers, sizeof(bool));
     ivars->searcher             = IxSearcher_new((Obj*)polyreader);
     ivars->name_to_tick         = Hash_new(num_seg_readers);
@@ -113,6 +140,12 @@ DefDelWriter_init(DefaultDeletionsWriter *self, Schema *schema,
             DECREF(seg_dels);
         }
         Vec_Store(ivars->bit_vecs, i, (Obj*)bit_vec);
+        Hash *seg_files_data = DefDelReader_find_files_data(
+                                   SegReader_Get_Segments(seg_reader),
+                                   SegReader_Get_Seg_Name(seg_reader));
+        if (seg_files_data) {
+            Vec_Store(ivars->seg_entries, i, INCREF(seg_files_data));
+        }
         Hash_Store(ivars->name_to_tick,
                    SegReader_Get_Seg_Name(seg_reader),
                    (Obj*)Int_new(i));
@@ -127,6 +160,10 @@ DefDelWriter_Destroy_IMP(DefaultDeletionsWriter *self) {
     DECREF(ivars->seg_readers);
     DECREF(ivars->seg_starts);
     DECREF(ivars->bit_vecs);
+    DECREF(ivars->seg_entries);
+    DECREF(ivars->new_entries);
+    DECREF(ivars->added_dels);
+    DECREF(ivars->added_entry);
     DECREF(ivars->searcher);
     DECREF(ivars->name_to_tick);
     FREEMEM(ivars->updated);
@@ -134,40 +171,51 @@ DefDelWriter_Destroy_IMP(DefaultDeletionsWriter *self) {
 }
 
 static String*
-S_del_filename(DefaultDeletionsWriter *self, SegReader *target_reader) {
+S_del_filename(DefaultDeletionsWriter *self, SegReader *target_reader,
+               const char *ext) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
     Segment *target_seg = SegReader_Get_Segment(target_reader);
-    return Str_newf("%o/deletions-%o.bv", Seg_Get_Name(ivars->segment),
-                    Seg_Get_Name(target_seg));
+    return Str_newf("%o/deletions-%o.%s", Seg_Get_Name(target_seg),
+                    Seg_Get_Name(ivars->segment), ext);
+}
+
+static OutStream*
+S_open_out(Folder *folder, String *filename) {
+    // A file by this name can only be left over from a failed session.
+    if (Folder_Exists(folder, filename)) {
+        Folder_Delete(folder, filename);
+    }
+    OutStream *outstream = Folder_Open_Out(folder, filename);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+    return outstream;
+}
+
+// Write out a BitVector with one bit for each doc in a segment.
+static void
+S_write_bit_vec(Folder *folder, String *filename, BitVector *deldocs,
+                int32_t doc_max) {
+    uint32_t   byte_size = (uint32_t)ceil((doc_max + 1) / 8.0);
+    uint32_t   new_max   = byte_size * 8 - 1;
+    OutStream *outstream = S_open_out(folder, filename);
+
+    // Ensure that we have 1 bit for each doc in segment.
+    BitVec_Grow(deldocs, new_max);
+
+    // Write deletions data and clean up.
+    OutStream_Write_Bytes(outstream, (char*)BitVec_Get_Raw_Bits(deldocs),
+                          byte_size);
+    OutStream_Close(outstream);
+    DECREF(outstream);
 }
 
 void
 DefDelWriter_Finish_IMP(DefaultDeletionsWriter *self) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
-    Folder *const folder = ivars->folder;
 
     for (uint32_t i = 0, max = Vec_Get_Size(ivars->seg_readers); i < max; i++) {
-        SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->seg_readers, i);
         if (ivars->updated[i]) {
-            BitVector *deldocs   = (BitVector*)Vec_Fetch(ivars->bit_vecs, i);
-            int32_t    doc_max   = SegReader_Doc_Max(seg_reader);
-            double     used      = (doc_max + 1) / 8.0;
-            uint32_t   byte_size = (uint32_t)ceil(used);
-            uint32_t   new_max   = byte_size * 8 - 1;
-            String    *filename  = S_del_filename(self, seg_reader);
-            OutStream *outstream = Folder_Open_Out(folder, filename);
-            if (!outstream) { RETHROW(INCREF(Err_get_error())); }
-
-            // Ensure that we have 1 bit for each doc in segment.
-            BitVec_Grow(deldocs, new_max);
-
-            // Write deletions data and clean up.
-            OutStream_Write_Bytes(outstream,
-                                  (char*)BitVec_Get_Raw_Bits(deldocs),
-                                  byte_size);
-            OutStream_Close(outstream);
-            DECREF(outstream);
-            DECREF(filename);
+            Vec_Store(ivars->new_entries, i,
+                      (Obj*)S_write_seg_deletions(self, i));
         }
     }
 
@@ -175,6 +223,120 @@ DefDelWriter_Finish_IMP(DefaultDeletionsWriter *self) {
                             (Obj*)DefDelWriter_Metadata(self));
 }
 
+static Hash*
+S_write_seg_deletions(DefaultDeletionsWriter *self, uint32_t tick) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    Folder    *const folder = ivars->folder;
+    SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->seg_readers, tick);
+    BitVector *deldocs    = (BitVector*)Vec_Fetch(ivars->bit_vecs, tick);
+    Hash      *prev       = (Hash*)Vec_Fetch(ivars->seg_entries, tick);
+    String    *seg_name   = SegReader_Get_Seg_Name(seg_reader);
+    int32_t    doc_max    = SegReader_Doc_Max(seg_reader);
+    uint32_t   byte_size  = (uint32_t)ceil((doc_max + 1) / 8.0);
+    String    *base       = NULL;
+    Vector    *deltas     = NULL;
+    int64_t    delta_count = 0;
+
+    if (prev) {
+        Obj *delta_count_obj = Hash_Fetch_Utf8(prev, "delta_count", 11);
+        base   = (String*)Hash_Fetch_Utf8(prev, "filename", 8);
+        deltas = (Vector*)Hash_Fetch_Utf8(prev, "deltas", 6);
+        delta_count = delta_count_obj ? Json_obj_to_i64(delta_count_obj) : 0;
+    }
+
+    int32_t  num_new  = 0;
+    int32_t *new_dels = S_new_deletions(seg_reader, deldocs, &num_new);
+    uint32_t num_deltas = deltas ? Vec_Get_Size(deltas) : 0;
+    delta_count += num_new;
+
+    // Files written before deletions moved into the target segment's
+    // directory may vanish along with the segment that wrote them, so they
+    // can't anchor a chain of deltas.
+    bool base_is_local
+        = !base
+          || (Str_Starts_With(base, seg_name)
+              && Str_Code_Point_At(base, Str_Length(seg_name)) == '/');
+    bool compact = !base_is_local
+                   || (num_new && num_deltas + 1 > MAX_DELTAS)
+                   // A sparse entry costs up to 4 bytes per doc.
+                   || (uint64_t)delta_count * 4 >= byte_size;
+
+    Hash *mini_meta = Hash_new(4);
+    Hash_Store_Utf8(mini_meta, "count", 5,
+                    (Obj*)Str_newf("%u32", (uint32_t)BitVec_Count(deldocs)));
+
+    if (compact) {
+        String *filename = S_del_filename(self, seg_reader, "bv");
+        S_write_bit_vec(folder, filename, deldocs, doc_max);
+        Hash_Store_Utf8(mini_meta, "filename", 8, (Obj*)filename);
+    }
+    else {
+        // Keep the existing chain, adding a delta for the new deletions.
+        Vector *new_deltas = deltas ? Vec_Clone(deltas) : Vec_new(1);
+        if (num_new) {
+            String    *filename  = S_del_filename(self, seg_reader, "dd");
+            OutStream *outstream = S_open_out(folder, filename);
+            int32_t    last      = 0;
+            OutStream_Write_C32(outstream, (uint32_t)num_new);
+            for (int32_t i = 0; i < num_new; i++) {
+                OutStream_Write_C32(outstream, (uint32_t)(new_dels[i] - last));
+                last = new_dels[i];
+            }
+            OutStream_Close(outstream);
+            DECREF(outstream);
+            Vec_Push(new_deltas, (Obj*)filename);
+        }
+        if (base) {
+            Hash_Store_Utf8(mini_meta, "filename", 8, INCREF(base));
+        }
+        if (Vec_Get_Size(new_deltas)) {
+            Hash_Store_Utf8(mini_meta, "deltas", 6, (Obj*)new_deltas);
+            Hash_Store_Utf8(mini_meta, "delta_count", 11,
+                            (Obj*)Str_newf("%i64", delta_count));
+        }
+        else {
+            DECREF(new_deltas);
+        }
+    }
+
+    FREEMEM(new_dels);
+    return mini_meta;
+}
+
+static int32_t*
+S_new_deletions(SegReader *seg_reader, BitVector *deldocs,
+                int32_t *num_deletions_ptr) {
+    DeletionsReader *del_reader
+        = (DeletionsReader*)SegReader_Fetch(
+              seg_reader, Class_Get_Name(DELETIONSREADER));
+    Matcher *old_dels = del_reader && DelReader_Del_Count(del_reader)
+                        ? DelReader_Iterator(del_reader)
+                        : NULL;
+    int32_t  old_count = del_reader ? DelReader_Del_Count(del_reader) : 0;
+    int32_t  max       = (int32_t)BitVec_Count(deldocs) - old_count;
+    int32_t *new_dels
+        = (int32_t*)MALLOCATE((max > 0 ? max : 1) * sizeof(int32_t));
+    int32_t  num_new   = 0;
+    int32_t  next_old  = old_dels ? Matcher_Next(old_dels) : 0;
+    int32_t  doc_id    = BitVec_Next_Hit(deldocs, 1);
+
+    // Deletions are only ever added, so every doc that was deleted before
+    // is also set in `deldocs`.
+    while (doc_id != -1) {
+        while (next_old && next_old < doc_id) {
+            next_old = Matcher_Next(old_dels);
+        }
+        if (doc_id != next_old && num_new < max) {
+            new_dels[num_new++] = doc_id;
+        }
+        doc_id = BitVec_Next_Hit(deldocs, (uint32_t)doc_id + 1);
+    }
+
+    DECREF(old_dels);
+    *num_deletions_ptr = num_new;
+    return new_dels;
+}
+
 Hash*
 DefDelWriter_Metadata_IMP(DefaultDeletionsWriter *self) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
@@ -186,17 +348,16 @@ DefDelWriter_Metadata_IMP(DefaultDeletionsWriter *self) {
 
     for (uint32_t i = 0, max = Vec_Get_Size(ivars->seg_readers); i < max; i++) {
         SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->seg_readers, i);
-        if (ivars->updated[i]) {
-            BitVector *deldocs   = (BitVector*)Vec_Fetch(ivars->bit_vecs, i);
-            Segment   *segment   = SegReader_Get_Segment(seg_reader);
-            Hash      *mini_meta = Hash_new(2);
-            Hash_Store_Utf8(mini_meta, "count", 5,
-                            (Obj*)Str_newf("%u32", (uint32_t)BitVec_Count(deldocs)));
-            Hash_Store_Utf8(mini_meta, "filename", 8,
-                            (Obj*)S_del_filename(self, seg_reader));
-            Hash_Store(files, Seg_Get_Name(segment), (Obj*)mini_meta);
+        Hash *mini_meta = (Hash*)Vec_Fetch(ivars->new_entries, i);
+        if (ivars->updated[i] && mini_meta) {
+            Segment *segment = SegReader_Get_Segment(seg_reader);
+            Hash_Store(files, Seg_Get_Name(segment), INCREF(mini_meta));
         }
     }
+    if (ivars->added_entry) {
+        Hash_Store(files, Seg_Get_Name(ivars->segment),
+                   INCREF(ivars->added_entry));
+    }
     Hash_Store_Utf8(metadata, "files", 5, (Obj*)files);
 
     return metadata;
@@ -255,9 +416,18 @@ DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
     for (uint32_t i = 0, max = Vec_Get_Size(ivars->seg_readers); i < max; i++) {
         SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->seg_readers, i);
+        LexiconReader *lex_reader
+            = (LexiconReader*)SegReader_Fetch(
+                  seg_reader, Class_Get_Name(LEXICONREADER));
         PostingListReader *plist_reader
             = (PostingListReader*)SegReader_Fetch(
                   seg_reader, Class_Get_Name(POSTINGLISTREADER));
+
+        // Skip segments which can't contain the term.
+        if (lex_reader && !LexReader_Might_Contain(lex_reader, field, term)) {
+            continue;
+        }
+
         BitVector *bit_vec = (BitVector*)Vec_Fetch(ivars->bit_vecs, i);
         PostingList *plist = plist_reader
                              ? PListReader_Posting_List(plist_reader, field, term)
@@ -277,6 +447,60 @@ DefDelWriter_Delete_By_Term_IMP(DefaultDeletionsWriter *self,
     }
 }
 
+void
+DefDelWriter_Delete_By_Terms_IMP(DefaultDeletionsWriter *self,
+                                 String *field, Vector *terms) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    uint32_t num_terms = Vec_Get_Size(terms);
+    if (!num_terms) { return; }
+
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->seg_readers, i);
+        LexiconReader *lex_reader
+            = (LexiconReader*)SegReader_Fetch(
+                  seg_reader, Class_Get_Name(LEXICONREADER));
+        PostingListReader *plist_reader
+            = (PostingListReader*)SegReader_Fetch(
+                  seg_reader, Class_Get_Name(POSTINGLISTREADER));
+        if (!lex_reader || !plist_reader) { continue; }
+
+        // Open the Lexicon and PostingList lazily, so that segments whose
+        // bloom filters rule out every term are never touched.
+        Lexicon     *lexicon = NULL;
+        PostingList *plist   = NULL;
+        BitVector   *bit_vec = (BitVector*)Vec_Fetch(ivars->bit_vecs, i);
+        int32_t num_zapped = 0;
+
+        for (uint32_t j = 0; j < num_terms; j++) {
+            Obj *term = Vec_Fetch(terms, j);
+            if (!LexReader_Might_Contain(lex_reader, field, term)) {
+                continue;
+            }
+            if (!lexicon) {
+                lexicon = LexReader_Lexicon(lex_reader, field, NULL);
+                if (!lexicon) { break; }
+                plist = PListReader_Posting_List(plist_reader, field, NULL);
+                if (!plist) { break; }
+            }
+            Lex_Seek(lexicon, term);
+            Obj *found = Lex_Get_Term(lexicon);
+            if (!found || !Obj_Equals(found, term)) { continue; }
+
+            // Iterate through postings, marking each doc as deleted.
+            int32_t doc_id;
+            PList_Seek_Lex(plist, lexicon);
+            while (0 != (doc_id = PList_Next(plist))) {
+                num_zapped += !BitVec_Get(bit_vec, doc_id);
+                BitVec_Set(bit_vec, doc_id);
+            }
+        }
+        if (num_zapped) { ivars->updated[i] = true; }
+
+        DECREF(plist);
+        DECREF(lexicon);
+    }
+}
+
 void
 DefDelWriter_Delete_By_Query_IMP(DefaultDeletionsWriter *self, Query *query) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
@@ -306,6 +530,95 @@ DefDelWriter_Delete_By_Query_IMP(DefaultDeletionsWriter *self, Query *query) {
     DECREF(compiler);
 }
 
+void
+DefDelWriter_Delete_Added_By_Term_IMP(DefaultDeletionsWriter *self,
+                                      String *field, Obj *term,
+                                      int32_t doc_id) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    Hash *terms = (Hash*)Hash_Fetch(ivars->added_dels, field);
+    if (!terms) {
+        terms = Hash_new(0);
+        Hash_Store(ivars->added_dels, field, (Obj*)terms);
+    }
+
+    // A later request covers every doc an earlier one did.
+    String  *key  = (String*)CERTIFY(term, STRING);
+    Integer *prev = (Integer*)Hash_Fetch(terms, key);
+    if (!prev || Int_Get_Value(prev) < doc_id) {
+        Hash_Store(terms, key, (Obj*)Int_new(doc_id));
+    }
+}
+
+void
+DefDelWriter_Finish_Added_IMP(DefaultDeletionsWriter *self) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    Segment *segment = ivars->segment;
+    String  *seg_name = Seg_Get_Name(segment);
+    int32_t  doc_max  = (int32_t)Seg_Get_Count(segment);
+    if (!doc_max || !Hash_Get_Size(ivars->added_dels)) { return; }
+
+    // Read back the postings which were just written for the new segment.
+    Vector *segments = Vec_new(1);
+    Vec_Push(segments, INCREF(segment));
+    SegReader *reader = SegReader_new(ivars->schema, ivars->folder,
+                                      ivars->snapshot, segments, 0);
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              reader, Class_Get_Name(POSTINGLISTREADER));
+    BitVector *deldocs = BitVec_new((uint32_t)doc_max + 1);
+
+    HashIterator *iter = HashIter_new(ivars->added_dels);
+    while (plist_reader && HashIter_Next(iter)) {
+        String       *field     = HashIter_Get_Key(iter);
+        Hash         *terms     = (Hash*)HashIter_Get_Value(iter);
+        HashIterator *term_iter = HashIter_new(terms);
+        while (HashIter_Next(term_iter)) {
+            String  *term  = HashIter_Get_Key(term_iter);
+            Integer *limit = (Integer*)HashIter_Get_Value(term_iter);
+            PostingList *plist
+                = PListReader_Posting_List(plist_reader, field, (Obj*)term);
+            if (plist) {
+                int32_t doc_id;
+                while (0 != (doc_id = PList_Next(plist))
+                       && doc_id < Int_Get_Value(limit)
+                      ) {
+                    BitVec_Set(deldocs, (uint32_t)doc_id);
+                }
+                DECREF(plist);
+            }
+        }
+        DECREF(term_iter);
+    }
+    DECREF(iter);
+
+    if (BitVec_Count(deldocs)) {
+        String *filename = Str_newf("%o/deletions-%o.bv", seg_name, seg_name);
+        S_write_bit_vec(ivars->folder, filename, deldocs, doc_max);
+        DECREF(ivars->added_entry);
+        ivars->added_entry = Hash_new(2);
+        Hash_Store_Utf8(ivars->added_entry, "count", 5,
+                        (Obj*)Str_newf("%u32", BitVec_Count(deldocs)));
+        Hash_Store_Utf8(ivars->added_entry, "filename", 8, (Obj*)filename);
+
+        // Finish() may already have recorded deletions for other segments.
+        Hash *metadata
+            = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "deletions", 9);
+        if (metadata) {
+            Hash *files = (Hash*)CERTIFY(
+                              Hash_Fetch_Utf8(metadata, "files", 5), HASH);
+            Hash_Store(files, seg_name, INCREF(ivars->added_entry));
+        }
+        else {
+            Seg_Store_Metadata_Utf8(segment, "deletions", 9,
+                                    (Obj*)DefDelWriter_Metadata(self));
+        }
+    }
+
+    DECREF(deldocs);
+    DECREF(reader);
+    DECREF(segments);
+}
+
 void
 DefDelWriter_Delete_By_Doc_ID_IMP(DefaultDeletionsWriter *self, int32_t doc_id) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
@@ -20,12 +20,14 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/DocReader.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Document/HitDoc.h"
 #include "Lucy/Index/DocWriter.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/FileHandle.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Util/Json.h"
@@ -179,6 +181,8 @@ DefDocReader_init(DefaultDocReader *self, Schema *schema, Folder *folder,
                 DECREF(self);
                 RETHROW(error);
             }
+            // Stored documents are fetched by doc ID, so readahead is wasted.
+            InStream_Advise(ivars->dat_in, 0, -1, FH_ADVISE_RANDOM);
         }
         DECREF(ix_file);
         DECREF(dat_file);
@@ -205,4 +209,17 @@ DefDocReader_Read_Record_IMP(DefaultDocReader *self, ByteBuf *buffer,
     BB_Set_Size(buffer, size);
 }
 
+Hash*
+DefDocReader_Stats_IMP(DefaultDocReader *self) {
+    DefaultDocReaderIVARS *const ivars = DefDocReader_IVARS(self);
+    Hash    *stats     = Hash_new(0);
+    int64_t  doc_max   = Seg_Get_Count(ivars->segment);
+    int64_t  ix_bytes  = ivars->ix_in  ? InStream_Length(ivars->ix_in)  : 0;
+    int64_t  dat_bytes = ivars->dat_in ? InStream_Length(ivars->dat_in) : 0;
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(ix_bytes + dat_bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(ix_bytes));
+    Hash_Store_Utf8(stats, "avg_doc_bytes", 13,
+                    (Obj*)Int_new(doc_max ? dat_bytes / doc_max : 0));
+    return stats;
+}
 
@@ -27,14 +27,15 @@
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/NumberUtils.h"
 
-// Extract a document's compressed TermVector data into (term_text =>
-// compressed positional data) pairs.
-static Hash*
-S_extract_tv_cache(Blob *field_buf);
+// Find the positional data for `term_text` in a field buf.  Return NULL if
+// the term isn't there.
+static const char*
+S_find_posdata(Blob *field_buf, String *term_text, size_t *size_ptr);
 
 // Pull a TermVector object out from compressed positional data.
 static TermVector*
-S_extract_tv_from_tv_buf(String *field, String *term_text, Blob *tv_buf);
+S_extract_tv_from_tv_buf(String *field, String *term_text,
+                         const char *posdata, size_t size);
 
 DocVector*
 DocVec_new() {
@@ -45,8 +46,7 @@ DocVec_new() {
 DocVector*
 DocVec_init(DocVector *self) {
     DocVectorIVARS *const ivars = DocVec_IVARS(self);
-    ivars->field_bufs    = Hash_new(0);
-    ivars->field_vectors = Hash_new(0);
+    ivars->field_bufs = Hash_new(0);
     return self;
 }
 
@@ -54,14 +54,12 @@ void
 DocVec_Serialize_IMP(DocVector *self, OutStream *outstream) {
     DocVectorIVARS *const ivars = DocVec_IVARS(self);
     Freezer_serialize_hash(ivars->field_bufs, outstream);
-    Freezer_serialize_hash(ivars->field_vectors, outstream);
 }
 
 DocVector*
 DocVec_Deserialize_IMP(DocVector *self, InStream *instream) {
     DocVectorIVARS *const ivars = DocVec_IVARS(self);
-    ivars->field_bufs    = Freezer_read_hash(instream);
-    ivars->field_vectors = Freezer_read_hash(instream);
+    ivars->field_bufs = Freezer_read_hash(instream);
     return self;
 }
 
@@ -69,7 +67,6 @@ void
 DocVec_Destroy_IMP(DocVector *self) {
     DocVectorIVARS *const ivars = DocVec_IVARS(self);
     DECREF(ivars->field_bufs);
-    DECREF(ivars->field_vectors);
     SUPER_DESTROY(self, DOCVECTOR);
 }
 
@@ -96,71 +93,125 @@ TermVector*
 DocVec_Term_Vector_IMP(DocVector *self, String *field,
                        String *term_text) {
     DocVectorIVARS *const ivars = DocVec_IVARS(self);
-    Hash *field_vector = (Hash*)Hash_Fetch(ivars->field_vectors, field);
+    Blob *field_buf = (Blob*)Hash_Fetch(ivars->field_bufs, field);
 
-    // If no cache hit, try to fill cache.
-    if (field_vector == NULL) {
-        Blob *field_buf = (Blob*)Hash_Fetch(ivars->field_bufs, field);
+    // Bail if there's no content or the field isn't highlightable.
+    if (field_buf == NULL) { return NULL; }
 
-        // Bail if there's no content or the field isn't highlightable.
-        if (field_buf == NULL) { return NULL; }
-
-        field_vector = S_extract_tv_cache(field_buf);
-        Hash_Store(ivars->field_vectors, field, (Obj*)field_vector);
+    // Get the positional data for the term text or bail.
+    size_t size = 0;
+    const char *posdata = S_find_posdata(field_buf, term_text, &size);
+    if (posdata == NULL) {
+        return NULL;
     }
 
-    // Get a buf for the term text or bail.
-    Blob *tv_buf = (Blob*)Hash_Fetch(field_vector, term_text);
-    if (tv_buf == NULL) {
-        return NULL;
+    return S_extract_tv_from_tv_buf(field, term_text, posdata, size);
+}
+
+static const char*
+S_find_posdata(Blob *field_buf, String *term_text, size_t *size_ptr) {
+    const char   *ptr        = Blob_Get_Buf(field_buf);
+    const char   *target     = Str_Get_Ptr8(term_text);
+    const size_t  target_len = Str_Get_Size(term_text);
+    uint32_t      num_terms  = NumUtil_decode_c32(&ptr);
+    size_t        dir_size   = NumUtil_decode_c32(&ptr);
+    const char   *posdata    = ptr + dir_size;
+
+    /* Terms are sorted and front-coded.  `matched` is how many leading bytes
+     * the previous term shares with the target.  Since the previous term
+     * sorts before the target, a term which shares fewer bytes with its
+     * predecessor than that sorts after the target, and one which shares
+     * more sorts before it -- so only terms which share exactly `matched`
+     * bytes need their text compared.
+     */
+    size_t matched = 0;
+    for (uint32_t i = 0; i < num_terms; i++) {
+        size_t      overlap = NumUtil_decode_c32(&ptr);
+        size_t      len     = NumUtil_decode_c32(&ptr);
+        const char *diff    = ptr;
+        ptr += len;
+        size_t      size    = NumUtil_decode_c32(&ptr);
+
+        if (overlap < matched) { return NULL; }
+        if (overlap == matched) {
+            const size_t term_len = overlap + len;
+            while (matched < term_len && matched < target_len
+                   && diff[matched - overlap] == target[matched]
+                  ) {
+                matched++;
+            }
+            if (matched == term_len) {
+                if (matched == target_len) {
+                    *size_ptr = size;
+                    return posdata;
+                }
+                // This term is a prefix of the target; keep going.
+            }
+            else if (matched == target_len
+                     || (uint8_t)diff[matched - overlap]
+                        > (uint8_t)target[matched]
+                    ) {
+                return NULL;
+            }
+        }
+        posdata += size;
     }
 
-    return S_extract_tv_from_tv_buf(field, term_text, tv_buf);
+    return NULL;
 }
 
-static Hash*
-S_extract_tv_cache(Blob *field_buf) {
-    Hash       *tv_cache  = Hash_new(0);
-    const char *tv_string = Blob_Get_Buf(field_buf);
-    int32_t     num_terms = NumUtil_decode_c32(&tv_string);
-    ByteBuf    *text_buf  = BB_new(0);
-
-    // Read the number of highlightable terms in the field.
-    for (int32_t i = 0; i < num_terms; i++) {
-        size_t   overlap = NumUtil_decode_c32(&tv_string);
-        size_t   len     = NumUtil_decode_c32(&tv_string);
-
-        // Decompress the term text.
-        BB_Set_Size(text_buf, overlap);
-        BB_Cat_Bytes(text_buf, tv_string, len);
-        tv_string += len;
-
-        // Get positions & offsets string.
-        const char *bookmark_ptr  = tv_string;
-        int32_t     num_positions = NumUtil_decode_c32(&tv_string);
+Blob*
+DocVec_upgrade_field_buf(Blob *field_buf) {
+    const char *ptr       = Blob_Get_Buf(field_buf);
+    uint32_t    num_terms = NumUtil_decode_c32(&ptr);
+    ByteBuf    *dir       = BB_new(num_terms * 8);
+    ByteBuf    *posdata   = BB_new(Blob_Get_Size(field_buf));
+    char        c32_buf[C32_MAX_BYTES];
+    char       *c32_ptr;
+
+    for (uint32_t i = 0; i < num_terms; i++) {
+        // Copy the front-coded term text into the directory.
+        const char *entry = ptr;
+        NumUtil_skip_cint(&ptr);
+        size_t len = NumUtil_decode_c32(&ptr);
+        ptr += len;
+        BB_Cat_Bytes(dir, entry, ptr - entry);
+
+        // Move the positional data, leaving its size in the directory.
+        const char *bookmark_ptr  = ptr;
+        int32_t     num_positions = NumUtil_decode_c32(&ptr);
         while (num_positions--) {
-            // Leave nums compressed to save a little mem.
-            NumUtil_skip_cint(&tv_string);
-            NumUtil_skip_cint(&tv_string);
-            NumUtil_skip_cint(&tv_string);
+            NumUtil_skip_cint(&ptr);
+            NumUtil_skip_cint(&ptr);
+            NumUtil_skip_cint(&ptr);
         }
-        len = tv_string - bookmark_ptr;
-
-        // Store the $text => $posdata pair in the output hash.
-        String *text = BB_Trusted_Utf8_To_String(text_buf);
-        Hash_Store(tv_cache, text, (Obj*)Blob_new(bookmark_ptr, len));
-        DECREF(text);
+        c32_ptr = c32_buf;
+        NumUtil_encode_c32((uint32_t)(ptr - bookmark_ptr), &c32_ptr);
+        BB_Cat_Bytes(dir, c32_buf, c32_ptr - c32_buf);
+        BB_Cat_Bytes(posdata, bookmark_ptr, ptr - bookmark_ptr);
     }
-    DECREF(text_buf);
 
-    return tv_cache;
+    ByteBuf *upgraded = BB_new(2 * C32_MAX_BYTES + BB_Get_Size(dir)
+                               + BB_Get_Size(posdata));
+    c32_ptr = c32_buf;
+    NumUtil_encode_c32(num_terms, &c32_ptr);
+    NumUtil_encode_c32((uint32_t)BB_Get_Size(dir), &c32_ptr);
+    BB_Cat_Bytes(upgraded, c32_buf, c32_ptr - c32_buf);
+    BB_Cat_Bytes(upgraded, BB_Get_Buf(dir), BB_Get_Size(dir));
+    BB_Cat_Bytes(upgraded, BB_Get_Buf(posdata), BB_Get_Size(posdata));
+
+    Blob *blob = BB_Yield_Blob(upgraded);
+    DECREF(upgraded);
+    DECREF(posdata);
+    DECREF(dir);
+    return blob;
 }
 
 static TermVector*
-S_extract_tv_from_tv_buf(String *field, String *term_text, Blob *tv_buf) {
+S_extract_tv_from_tv_buf(String *field, String *term_text,
+                         const char *posdata, size_t size) {
     TermVector *retval      = NULL;
-    const char *posdata     = Blob_Get_Buf(tv_buf);
-    const char *posdata_end = posdata + Blob_Get_Size(tv_buf);
+    const char *posdata_end = posdata + size;
     int32_t    *positions   = NULL;
     int32_t    *starts      = NULL;
     int32_t    *ends        = NULL;
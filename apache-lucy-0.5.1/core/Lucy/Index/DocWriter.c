@@ -76,6 +76,7 @@ S_lazy_init(DocWriter *self) {
         ivars->dat_out = Folder_Open_Out(folder, dat_file);
         DECREF(dat_file);
         if (!ivars->dat_out) { RETHROW(INCREF(Err_get_error())); }
+        OutStream_Set_Buf_Size(ivars->dat_out, OUTSTREAM_BULK_BUF_SIZE);
 
         // Go past non-doc #0.
         OutStream_Write_I64(ivars->ix_out, 0);
@@ -20,6 +20,9 @@
 
 #include "Lucy/Index/FilePurger.h"
 #include "Clownfish/Boolean.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
+#include "Lucy/Index/DeletionsReader.h"
 #include "Lucy/Index/IndexManager.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
@@ -27,18 +30,68 @@
 #include "Lucy/Store/DirHandle.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/Lock.h"
+#include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
 
+static int32_t FilePurger_refs_format = 2;
+
 // Place unused files into purgables array and obsolete Snapshots into
-// snapshots array.
+// snapshots array.  Snapshots which must be kept, mapped to their entries,
+// go into the live hash.
+static void
+S_discover_unused(FilePurger *self, Vector **purgables, Vector **snapshots,
+                  Hash *live);
+
+// Purge by scanning every snapshot file in the index directory, then record
+// the surviving snapshots in a new reference table.
 static void
-S_discover_unused(FilePurger *self, Vector **purgables, Vector **snapshots);
+S_purge_all(FilePurger *self);
+
+// Purge by diffing the current snapshot against those recorded in the
+// reference table, then update the table.  `prev_snapfile` names the
+// snapshot which was current when the table was written.
+static void
+S_purge_incremental(FilePurger *self, Hash *snapshots,
+                    String *prev_snapfile);
+
+// Return the snapshots recorded in the reference table, or NULL if the table
+// is missing, unreadable, or doesn't lead up to the current snapshot.  The
+// snapshot which was current when it was written goes in `prev_snapfile`.
+static Hash*
+S_read_refs(FilePurger *self, String **prev_snapfile);
+
+// Persist the reference table.
+static void
+S_write_refs(FilePurger *self, Hash *snapshots);
 
 // Clean up after a failed background merge session, adding all dead files to
 // the list of candidates to be zapped.
 static void
 S_zap_dead_merge(FilePurger *self, Hash *candidates);
 
+// Return a snapshot's entries, plus the deletions files which its segments
+// reference from within other segments' directories.
+static Vector*
+S_snapshot_entries(FilePurger *self, Snapshot *snapshot);
+
+// Return the current snapshot's entries, as S_snapshot_entries() would, by
+// updating those of the previous snapshot with the deletions files of the
+// segments added since.
+static Vector*
+S_current_entries(FilePurger *self, Vector *prev_entries);
+
+// Add to `dirs` the directories of the segments in `entries` whose
+// deletions files differ from those in `prev_entries` -- all of them if
+// `prev_entries` is NULL.
+static void
+S_add_deletions_dirs(Hash *dirs, Vector *prev_entries, Vector *entries);
+
+// Add deletions files which were written into `dirs` but which no live
+// snapshot references any more.
+static void
+S_find_stale_deletions(FilePurger *self, Hash *live, Hash *dirs,
+                       Vector *purgables);
+
 // Return an array of recursively expanded filepath entries.
 static Vector*
 S_find_all_referenced(Folder *folder, Vector *entries);
@@ -85,52 +138,16 @@ FilePurger_Purge_IMP(FilePurger *self) {
     // Obtain deletion lock, purge files, release deletion lock.
     Lock_Clear_Stale(deletion_lock);
     if (Lock_Obtain(deletion_lock)) {
-        Folder *folder   = ivars->folder;
-        Hash   *failures = Hash_new(0);
-        Vector *purgables;
-        Vector *snapshots;
-
-        S_discover_unused(self, &purgables, &snapshots);
-
-        // Attempt to delete entries -- if failure, no big deal, just try
-        // again later.  Proceed in reverse lexical order so that directories
-        // get deleted after they've been emptied.
-        Vec_Sort(purgables);
-        for (uint32_t i = Vec_Get_Size(purgables); i--;) {
-            String *entry = (String*)Vec_Fetch(purgables, i);
-            if (Hash_Fetch(ivars->disallowed, entry)) { continue; }
-            if (!Folder_Delete(folder, entry)) {
-                if (Folder_Exists(folder, entry)) {
-                    Hash_Store(failures, entry, (Obj*)CFISH_TRUE);
-                }
-            }
+        String *prev_snapfile = NULL;
+        Hash   *snapshots     = S_read_refs(self, &prev_snapfile);
+        if (snapshots) {
+            S_purge_incremental(self, snapshots, prev_snapfile);
+            DECREF(snapshots);
+            DECREF(prev_snapfile);
         }
-
-        for (uint32_t i = 0, max = Vec_Get_Size(snapshots); i < max; i++) {
-            Snapshot *snapshot = (Snapshot*)Vec_Fetch(snapshots, i);
-            bool snapshot_has_failures = false;
-            if (Hash_Get_Size(failures)) {
-                // Only delete snapshot files if all of their entries were
-                // successfully deleted.
-                Vector *entries = Snapshot_List(snapshot);
-                for (uint32_t j = Vec_Get_Size(entries); j--;) {
-                    String *entry = (String*)Vec_Fetch(entries, j);
-                    if (Hash_Fetch(failures, entry)) {
-                        snapshot_has_failures = true;
-                        break;
-                    }
-                }
-                DECREF(entries);
-            }
-            if (!snapshot_has_failures) {
-                String *snapfile = Snapshot_Get_Path(snapshot);
-                Folder_Delete(folder, snapfile);
-            }
+        else {
+            S_purge_all(self);
         }
-
-        DECREF(failures);
-        DECREF(purgables);
-        DECREF(snapshots);
         Lock_Release(deletion_lock);
     }
     else {
@@ -141,6 +158,305 @@ FilePurger_Purge_IMP(FilePurger *self) {
     DECREF(deletion_lock);
 }
 
+// Return the first component of a path within the index.
+static String*
+S_top_entry(String *path) {
+    StringIterator *iter = Str_Top(path);
+    size_t tick = 0;
+    int32_t code_point;
+    while (STR_OOB != (code_point = StrIter_Next(iter))) {
+        if (code_point == '/') {
+            DECREF(iter);
+            return Str_SubString(path, 0, tick);
+        }
+        tick++;
+    }
+    DECREF(iter);
+    return Str_Clone(path);
+}
+
+// Attempt to delete entries -- if failure, no big deal, just try again
+// later.  Proceed in reverse lexical order so that directories get deleted
+// after they've been emptied.  Returns a hash of the paths which couldn't be
+// deleted.
+static Hash*
+S_delete_entries(FilePurger *self, Vector *purgables) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Folder *folder   = ivars->folder;
+    Hash   *failures = Hash_new(0);
+    Vec_Sort(purgables);
+    for (uint32_t i = Vec_Get_Size(purgables); i--;) {
+        String *entry = (String*)Vec_Fetch(purgables, i);
+        if (Hash_Fetch(ivars->disallowed, entry)) { continue; }
+        if (!Folder_Delete(folder, entry)) {
+            if (Folder_Exists(folder, entry)) {
+                Hash_Store(failures, entry, (Obj*)CFISH_TRUE);
+            }
+        }
+    }
+    return failures;
+}
+
+// Indicate whether any of a snapshot's entries, or the files within them,
+// couldn't be deleted.
+static bool
+S_has_failures(Vector *entries, Hash *failed_tops) {
+    if (!Hash_Get_Size(failed_tops)) { return false; }
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        if (Hash_Fetch(failed_tops, (String*)Vec_Fetch(entries, i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static Hash*
+S_failed_tops(Hash *failures) {
+    Hash *failed_tops = Hash_new(0);
+    HashIterator *iter = HashIter_new(failures);
+    while (HashIter_Next(iter)) {
+        String *top = S_top_entry(HashIter_Get_Key(iter));
+        Hash_Store(failed_tops, top, (Obj*)CFISH_TRUE);
+        DECREF(top);
+    }
+    DECREF(iter);
+    return failed_tops;
+}
+
+static void
+S_purge_all(FilePurger *self) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Folder *folder = ivars->folder;
+    Hash   *live   = Hash_new(0);
+    Vector *purgables;
+    Vector *snapshots;
+
+    S_discover_unused(self, &purgables, &snapshots, live);
+    Hash *seg_dirs = Hash_new(0);
+    HashIterator *iter = HashIter_new(live);
+    while (HashIter_Next(iter)) {
+        Vector *entries = (Vector*)HashIter_Get_Value(iter);
+        S_add_deletions_dirs(seg_dirs, NULL, entries);
+    }
+    DECREF(iter);
+    S_find_stale_deletions(self, live, seg_dirs, purgables);
+    DECREF(seg_dirs);
+    Hash *failures    = S_delete_entries(self, purgables);
+    Hash *failed_tops = S_failed_tops(failures);
+
+    for (uint32_t i = 0, max = Vec_Get_Size(snapshots); i < max; i++) {
+        Snapshot *snapshot = (Snapshot*)Vec_Fetch(snapshots, i);
+        String   *snapfile = Snapshot_Get_Path(snapshot);
+        Vector   *entries  = Snapshot_List(snapshot);
+        if (S_has_failures(entries, failed_tops)) {
+            // Only delete snapshot files if all of their entries were
+            // successfully deleted.  Keep track of the rest, so that the
+            // next purge tries again.
+            Hash_Store(live, snapfile, INCREF(entries));
+        }
+        else {
+            Folder_Delete(folder, snapfile);
+        }
+        DECREF(entries);
+    }
+
+    if (ivars->snapshot && Snapshot_Get_Path(ivars->snapshot)) {
+        S_write_refs(self, live);
+    }
+
+    DECREF(failed_tops);
+    DECREF(failures);
+    DECREF(purgables);
+    DECREF(snapshots);
+    DECREF(live);
+}
+
+static void
+S_purge_incremental(FilePurger *self, Hash *snapshots,
+                    String *prev_snapfile) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Folder *folder   = ivars->folder;
+    String *snapfile = Snapshot_Get_Path(ivars->snapshot);
+
+    // Add the current snapshot, then count references to each entry.  Only
+    // the directories whose deletions files changed with it can hold new
+    // leftovers.
+    Vector *prev_entries = (Vector*)Hash_Fetch(snapshots, prev_snapfile);
+    Vector *entries      = S_current_entries(self, prev_entries);
+    Hash   *changed_dirs = Hash_new(0);
+    S_add_deletions_dirs(changed_dirs, prev_entries, entries);
+    Hash_Store(snapshots, snapfile, (Obj*)entries);
+    Hash *counts = Hash_new(0);
+    HashIterator *iter = HashIter_new(snapshots);
+    while (HashIter_Next(iter)) {
+        Vector *entries = (Vector*)HashIter_Get_Value(iter);
+        for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+            String  *entry = (String*)Vec_Fetch(entries, i);
+            Integer *count = (Integer*)Hash_Fetch(counts, entry);
+            int64_t  value = count ? Int_Get_Value(count) : 0;
+            Hash_Store(counts, entry, (Obj*)Int_new(value + 1));
+        }
+    }
+    DECREF(iter);
+
+    // Release the references held by old snapshots which no one has locked.
+    Vector *obsolete   = Vec_new(0);
+    Hash   *candidates = Hash_new(0);
+    Vector *names      = Hash_Keys(snapshots);
+    for (uint32_t i = 0, max = Vec_Get_Size(names); i < max; i++) {
+        String *name = (String*)Vec_Fetch(names, i);
+        if (Str_Equals(name, (Obj*)snapfile)) { continue; }
+        Lock *lock = IxManager_Make_Snapshot_Read_Lock(ivars->manager, name);
+        bool  locked = false;
+        if (lock) {
+            Lock_Clear_Stale(lock);
+            locked = Lock_Is_Locked(lock);
+            DECREF(lock);
+        }
+        if (locked) { continue; }
+
+        Vector *entries = (Vector*)Hash_Delete(snapshots, name);
+        for (uint32_t j = 0, jmax = Vec_Get_Size(entries); j < jmax; j++) {
+            String  *entry = (String*)Vec_Fetch(entries, j);
+            Integer *count = (Integer*)Hash_Fetch(counts, entry);
+            int64_t  value = Int_Get_Value(count) - 1;
+            Hash_Store(counts, entry, (Obj*)Int_new(value));
+            if (value == 0) {
+                Hash_Store(candidates, entry, (Obj*)CFISH_TRUE);
+            }
+        }
+        Vector *pair = Vec_new(2);
+        Vec_Push(pair, INCREF(name));
+        Vec_Push(pair, (Obj*)entries);
+        Vec_Push(obsolete, (Obj*)pair);
+    }
+    DECREF(names);
+
+    // Clean up after a dead segment consolidation, then spare anything
+    // still referenced.  Deletions files are referenced on their own, so
+    // they go once no snapshot names them, even if their directory stays.
+    S_zap_dead_merge(self, candidates);
+    Vector *purgables = Vec_new(Hash_Get_Size(candidates));
+    Vector *paths     = Hash_Keys(candidates);
+    for (uint32_t i = 0, max = Vec_Get_Size(paths); i < max; i++) {
+        String  *path  = (String*)Vec_Fetch(paths, i);
+        String  *top   = S_top_entry(path);
+        Integer *count = (Integer*)Hash_Fetch(counts, path);
+        if (!count) { count = (Integer*)Hash_Fetch(counts, top); }
+        if (!count || Int_Get_Value(count) == 0) {
+            Vec_Push(purgables, INCREF(path));
+            if (Str_Equals(top, (Obj*)path)
+                && Folder_Is_Directory(folder, path)
+               ) {
+                Vector *contents = Folder_List_R(folder, path);
+                Vec_Push_All(purgables, contents);
+                DECREF(contents);
+            }
+        }
+        DECREF(top);
+    }
+    DECREF(paths);
+    S_find_stale_deletions(self, snapshots, changed_dirs, purgables);
+
+    Hash *failures    = S_delete_entries(self, purgables);
+    Hash *failed_tops = S_failed_tops(failures);
+    for (uint32_t i = 0, max = Vec_Get_Size(obsolete); i < max; i++) {
+        Vector *pair    = (Vector*)Vec_Fetch(obsolete, i);
+        String *name    = (String*)Vec_Fetch(pair, 0);
+        Vector *entries = (Vector*)Vec_Fetch(pair, 1);
+        if (S_has_failures(entries, failed_tops)) {
+            Hash_Store(snapshots, name, INCREF(entries));
+        }
+        else {
+            Folder_Delete(folder, name);
+        }
+    }
+
+    S_write_refs(self, snapshots);
+
+    DECREF(failed_tops);
+    DECREF(failures);
+    DECREF(purgables);
+    DECREF(candidates);
+    DECREF(obsolete);
+    DECREF(counts);
+    DECREF(changed_dirs);
+}
+
+static Hash*
+S_read_refs(FilePurger *self, String **prev_snapfile) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    String *refs_file = SSTR_WRAP_C("refcounts.json");
+    String *snapfile  = ivars->snapshot
+                        ? Snapshot_Get_Path(ivars->snapshot)
+                        : NULL;
+    *prev_snapfile = NULL;
+    if (!snapfile || !Folder_Exists(ivars->folder, refs_file)) {
+        return NULL;
+    }
+
+    Hash *dump = (Hash*)Json_slurp_json(ivars->folder, refs_file);
+    if (!dump || !Obj_is_a((Obj*)dump, HASH)) {
+        DECREF(dump);
+        return NULL;
+    }
+    Obj    *format    = Hash_Fetch_Utf8(dump, "format", 6);
+    String *current   = (String*)Hash_Fetch_Utf8(dump, "current", 7);
+    Hash   *snapshots = (Hash*)Hash_Fetch_Utf8(dump, "snapshots", 9);
+    bool    valid     = format
+                        && Json_obj_to_i64(format) == FilePurger_refs_format
+                        && current && Obj_is_a((Obj*)current, STRING)
+                        && snapshots && Obj_is_a((Obj*)snapshots, HASH);
+
+    // The table is only good if no snapshot has been written since it was
+    // last updated, other than the current one.
+    if (valid) {
+        uint64_t old_gen = IxFileNames_extract_gen(current);
+        uint64_t new_gen = IxFileNames_extract_gen(snapfile);
+        valid = new_gen == old_gen || new_gen == old_gen + 1;
+    }
+    if (valid) {
+        HashIterator *iter = HashIter_new(snapshots);
+        while (valid && HashIter_Next(iter)) {
+            Vector *entries = (Vector*)HashIter_Get_Value(iter);
+            if (!Obj_is_a((Obj*)entries, VECTOR)) { valid = false; }
+        }
+        DECREF(iter);
+    }
+
+    Hash *retval = valid ? (Hash*)INCREF(snapshots) : NULL;
+    *prev_snapfile = valid ? (String*)INCREF(current) : NULL;
+    DECREF(dump);
+    return retval;
+}
+
+static void
+S_write_refs(FilePurger *self, Hash *snapshots) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Folder *folder    = ivars->folder;
+    String *refs_file = SSTR_WRAP_C("refcounts.json");
+    String *temp_file = SSTR_WRAP_C("refcounts.json.temp");
+    Hash   *dump      = Hash_new(3);
+    Hash_Store_Utf8(dump, "format", 6,
+                    (Obj*)Str_newf("%i32", FilePurger_refs_format));
+    Hash_Store_Utf8(dump, "current", 7,
+                    (Obj*)Str_Clone(Snapshot_Get_Path(ivars->snapshot)));
+    Hash_Store_Utf8(dump, "snapshots", 9, INCREF(snapshots));
+
+    // Write to a temp file and rename it into place.  If anything goes
+    // wrong, remove the table so that the next purge rebuilds it.
+    if (Folder_Exists(folder, temp_file)) {
+        Folder_Delete(folder, temp_file);
+    }
+    if (!Json_spew_json((Obj*)dump, folder, temp_file)
+        || !Folder_Rename(folder, temp_file, refs_file)
+       ) {
+        Folder_Delete(folder, temp_file);
+        Folder_Delete(folder, refs_file);
+    }
+    DECREF(dump);
+}
+
 static void
 S_zap_dead_merge(FilePurger *self, Hash *candidates) {
     FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
@@ -188,7 +504,7 @@ S_zap_dead_merge(FilePurger *self, Hash *candidates) {
 
 static void
 S_discover_unused(FilePurger *self, Vector **purgables_ptr,
-                  Vector **snapshots_ptr) {
+                  Vector **snapshots_ptr, Hash *live) {
     FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
     Folder      *folder       = ivars->folder;
     DirHandle   *dh           = Folder_Open_Dir(folder, NULL);
@@ -199,13 +515,16 @@ S_discover_unused(FilePurger *self, Vector **purgables_ptr,
 
     // Start off with the list of files in the current snapshot.
     if (ivars->snapshot) {
-        Vector *entries    = Snapshot_List(ivars->snapshot);
+        Vector *entries    = S_snapshot_entries(self, ivars->snapshot);
         Vector *referenced = S_find_all_referenced(folder, entries);
         Vec_Push_All(spared, referenced);
-        DECREF(entries);
         DECREF(referenced);
         snapfile = Snapshot_Get_Path(ivars->snapshot);
-        if (snapfile) { Vec_Push(spared, INCREF(snapfile)); }
+        if (snapfile) {
+            Vec_Push(spared, INCREF(snapfile));
+            Hash_Store(live, snapfile, INCREF(entries));
+        }
+        DECREF(entries);
     }
 
     Hash *candidates = Hash_new(64);
@@ -236,6 +555,8 @@ S_discover_unused(FilePurger *self, Vector **purgables_ptr,
                 Vec_Grow(spared, new_size);
                 Vec_Push(spared, (Obj*)Str_Clone(entry));
                 Vec_Push_All(spared, referenced);
+                Hash_Store(live, entry,
+                           (Obj*)S_snapshot_entries(self, snapshot));
             }
             else {
                 // No one's using this snapshot, so all of its entries are
@@ -273,6 +594,277 @@ S_discover_unused(FilePurger *self, Vector **purgables_ptr,
     DECREF(spared);
 }
 
+static Vector*
+S_snapshot_entries(FilePurger *self, Snapshot *snapshot) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Vector *entries  = Snapshot_List(snapshot);
+    Vector *segments = Vec_new(Vec_Get_Size(entries));
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        String *entry = (String*)Vec_Fetch(entries, i);
+        if (Seg_valid_seg_name(entry)) {
+            Segment *segment = Seg_new((int64_t)IxFileNames_extract_gen(entry));
+            if (Seg_Read_File(segment, ivars->folder)) {
+                Vec_Push(segments, (Obj*)segment);
+            }
+            else {
+                DECREF(segment);
+            }
+        }
+    }
+    Vec_Sort(segments);
+
+    // Only the latest entry for each segment counts.
+    for (uint32_t i = 0, max = Vec_Get_Size(segments); i < max; i++) {
+        Segment *segment = (Segment*)Vec_Fetch(segments, i);
+        Hash *seg_files_data
+            = DefDelReader_find_files_data(segments, Seg_Get_Name(segment));
+        if (seg_files_data) {
+            Obj *filename = Hash_Fetch_Utf8(seg_files_data, "filename", 8);
+            Vector *deltas
+                = (Vector*)Hash_Fetch_Utf8(seg_files_data, "deltas", 6);
+            if (filename) { Vec_Push(entries, INCREF(filename)); }
+            if (deltas)   { Vec_Push_All(entries, deltas); }
+        }
+    }
+
+    DECREF(segments);
+    return entries;
+}
+
+// Return the segment whose deletions a file records, or NULL if `path`
+// isn't a deletions file.  Deletions files live in the target segment's
+// directory and are named after the segment which wrote them, except for
+// those written in the old format, which are the other way round.  Either
+// way, the writer is never older than the target.
+static String*
+S_deletions_target(String *path) {
+    String *dir    = S_top_entry(path);
+    String *name   = IxFileNames_local_part(path);
+    String *target = NULL;
+    if (!Str_Equals(dir, (Obj*)path)
+        && Seg_valid_seg_name(dir)
+        && Str_Starts_With_Utf8(name, "deletions-", 10)
+       ) {
+        uint64_t dir_gen  = IxFileNames_extract_gen(dir);
+        uint64_t name_gen = IxFileNames_extract_gen(name);
+        target = name_gen < dir_gen
+                 ? Seg_num_to_name((int64_t)name_gen)
+                 : (String*)INCREF(dir);
+    }
+    DECREF(name);
+    DECREF(dir);
+    return target;
+}
+
+static Vector*
+S_current_entries(FilePurger *self, Vector *prev_entries) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Snapshot *snapshot = ivars->snapshot;
+    if (!prev_entries) {
+        return S_snapshot_entries(self, snapshot);
+    }
+
+    Vector *entries = Snapshot_List(snapshot);
+    Hash   *listed  = Hash_new(Vec_Get_Size(entries));
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        Hash_Store(listed, (String*)Vec_Fetch(entries, i),
+                   (Obj*)CFISH_TRUE);
+    }
+
+    // A segment which went away may have carried the latest deletions of
+    // segments which stayed, so only additions can be applied as a diff.
+    Hash *prev_segs = Hash_new(0);
+    bool  removed   = false;
+    for (uint32_t i = 0, max = Vec_Get_Size(prev_entries); i < max; i++) {
+        String *entry = (String*)Vec_Fetch(prev_entries, i);
+        if (!Seg_valid_seg_name(entry)) { continue; }
+        if (!Hash_Fetch(listed, entry)) { removed = true; }
+        Hash_Store(prev_segs, entry, (Obj*)CFISH_TRUE);
+    }
+    if (removed) {
+        DECREF(prev_segs);
+        DECREF(listed);
+        DECREF(entries);
+        return S_snapshot_entries(self, snapshot);
+    }
+
+    // Read only the added segments.  The latest of them to record
+    // deletions for a segment supersedes whatever was recorded before.
+    Vector *added = Vec_new(0);
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        String *entry = (String*)Vec_Fetch(entries, i);
+        if (Seg_valid_seg_name(entry) && !Hash_Fetch(prev_segs, entry)) {
+            Segment *segment = Seg_new((int64_t)IxFileNames_extract_gen(entry));
+            if (Seg_Read_File(segment, ivars->folder)) {
+                Vec_Push(added, (Obj*)segment);
+            }
+            else {
+                DECREF(segment);
+            }
+        }
+    }
+    Vec_Sort(added);
+    Hash *updated = Hash_new(0);
+    for (uint32_t i = 0, max = Vec_Get_Size(added); i < max; i++) {
+        Segment *segment = (Segment*)Vec_Fetch(added, i);
+        Hash *metadata
+            = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "deletions", 9);
+        Hash *files = metadata
+                      ? (Hash*)Hash_Fetch_Utf8(metadata, "files", 5)
+                      : NULL;
+        if (!files || !Obj_is_a((Obj*)files, HASH)) { continue; }
+        HashIterator *iter = HashIter_new(files);
+        while (HashIter_Next(iter)) {
+            String *target = HashIter_Get_Key(iter);
+            if (!Hash_Fetch(listed, target)) { continue; }
+            Hash *seg_files_data = DefDelReader_find_files_data(added, target);
+            Hash_Store(updated, target, INCREF(seg_files_data));
+        }
+        DECREF(iter);
+    }
+
+    // Carry over the rest.
+    for (uint32_t i = 0, max = Vec_Get_Size(prev_entries); i < max; i++) {
+        String *entry  = (String*)Vec_Fetch(prev_entries, i);
+        String *target = S_deletions_target(entry);
+        if (target && !Hash_Fetch(updated, target)) {
+            Vec_Push(entries, INCREF(entry));
+        }
+        DECREF(target);
+    }
+    HashIterator *iter = HashIter_new(updated);
+    while (HashIter_Next(iter)) {
+        Hash *seg_files_data = (Hash*)HashIter_Get_Value(iter);
+        Obj *filename = Hash_Fetch_Utf8(seg_files_data, "filename", 8);
+        Vector *deltas
+            = (Vector*)Hash_Fetch_Utf8(seg_files_data, "deltas", 6);
+        if (filename) { Vec_Push(entries, INCREF(filename)); }
+        if (deltas)   { Vec_Push_All(entries, deltas); }
+    }
+    DECREF(iter);
+
+    DECREF(updated);
+    DECREF(added);
+    DECREF(prev_segs);
+    DECREF(listed);
+    return entries;
+}
+
+static void
+S_add_deletions_dirs(Hash *dirs, Vector *prev_entries, Vector *entries) {
+    Hash *segs = Hash_new(0);
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        String *entry = (String*)Vec_Fetch(entries, i);
+        if (Seg_valid_seg_name(entry)) {
+            Hash_Store(segs, entry, (Obj*)CFISH_TRUE);
+            if (!prev_entries) { Hash_Store(dirs, entry, (Obj*)CFISH_TRUE); }
+        }
+    }
+
+    if (prev_entries) {
+        // Keep the entries which are in only one of the lists.
+        Hash   *diff  = Hash_new(0);
+        Vector *lists[2] = { prev_entries, entries };
+        for (int i = 0; i < 2; i++) {
+            for (uint32_t j = 0, max = Vec_Get_Size(lists[i]); j < max; j++) {
+                String *entry = (String*)Vec_Fetch(lists[i], j);
+                Obj    *seen  = Hash_Delete(diff, entry);
+                if (seen) { DECREF(seen); }
+                else      { Hash_Store(diff, entry, (Obj*)CFISH_TRUE); }
+            }
+        }
+        Vector *changed = Hash_Keys(diff);
+        for (uint32_t i = 0, max = Vec_Get_Size(changed); i < max; i++) {
+            String *entry = (String*)Vec_Fetch(changed, i);
+            String *dir   = S_top_entry(entry);
+            if (!Str_Equals(dir, (Obj*)entry) && Hash_Fetch(segs, dir)) {
+                Hash_Store(dirs, dir, (Obj*)CFISH_TRUE);
+            }
+            DECREF(dir);
+        }
+        DECREF(changed);
+        DECREF(diff);
+    }
+
+    DECREF(segs);
+}
+
+// Return the name of the segment which a running background merge is
+// writing, or NULL.
+static String*
+S_merge_in_progress(FilePurger *self) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Lock   *merge_lock = IxManager_Make_Merge_Lock(ivars->manager);
+    String *retval     = NULL;
+
+    Lock_Clear_Stale(merge_lock);
+    if (Lock_Is_Locked(merge_lock)) {
+        Hash *merge_data = IxManager_Read_Merge_Data(ivars->manager);
+        Obj  *cutoff = merge_data
+                       ? Hash_Fetch_Utf8(merge_data, "cutoff", 6)
+                       : NULL;
+        if (cutoff) { retval = Seg_num_to_name(Json_obj_to_i64(cutoff)); }
+        DECREF(merge_data);
+    }
+
+    DECREF(merge_lock);
+    return retval;
+}
+
+static void
+S_find_stale_deletions(FilePurger *self, Hash *live, Hash *dirs,
+                       Vector *purgables) {
+    FilePurgerIVARS *const ivars = FilePurger_IVARS(self);
+    Folder *folder     = ivars->folder;
+    Hash   *referenced = Hash_new(0);
+
+    HashIterator *iter = HashIter_new(live);
+    while (HashIter_Next(iter)) {
+        Vector *entries = (Vector*)HashIter_Get_Value(iter);
+        for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+            Hash_Store(referenced, (String*)Vec_Fetch(entries, i),
+                       (Obj*)CFISH_TRUE);
+        }
+    }
+    DECREF(iter);
+
+    // The merge writes its deletions files before it holds the write lock,
+    // so they aren't in any snapshot yet.
+    String *merge_seg = S_merge_in_progress(self);
+    String *in_flight = merge_seg
+                        ? Str_newf("deletions-%o.", merge_seg)
+                        : NULL;
+
+    // Any deletions file which no live snapshot names is stale, whichever
+    // segment wrote it -- including a segment's own, once superseded.
+    Vector *dir_names = Hash_Keys(dirs);
+    for (uint32_t i = 0, max = Vec_Get_Size(dir_names); i < max; i++) {
+        String *dir = (String*)Vec_Fetch(dir_names, i);
+        if (!Folder_Is_Directory(folder, dir)) { continue; }
+        Vector *names = Folder_List(folder, dir);
+        if (!names) { continue; }
+        for (uint32_t j = 0, jmax = Vec_Get_Size(names); j < jmax; j++) {
+            String *name = (String*)Vec_Fetch(names, j);
+            if (!Str_Starts_With_Utf8(name, "deletions-", 10)
+                || (in_flight && Str_Starts_With(name, in_flight))
+               ) {
+                continue;
+            }
+            String *path = Str_newf("%o/%o", dir, name);
+            if (!Hash_Fetch(referenced, path)) {
+                Vec_Push(purgables, INCREF(path));
+            }
+            DECREF(path);
+        }
+        DECREF(names);
+    }
+
+    DECREF(dir_names);
+    DECREF(in_flight);
+    DECREF(merge_seg);
+    DECREF(referenced);
+}
+
 static Vector*
 S_find_all_referenced(Folder *folder, Vector *entries) {
     Hash *uniqued = Hash_new(Vec_Get_Size(entries));
@@ -293,4 +885,3 @@ S_find_all_referenced(Folder *folder, Vector *entries) {
     return referenced;
 }
 
-
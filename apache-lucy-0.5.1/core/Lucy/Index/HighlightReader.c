@@ -20,6 +20,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Clownfish/Blob.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/HighlightReader.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/HighlightWriter.h"
@@ -27,11 +28,13 @@
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/FileHandle.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/NumberUtils.h"
 
 HighlightReader*
 HLReader_init(HighlightReader *self, Schema *schema, Folder *folder,
@@ -126,15 +129,21 @@ DefHLReader_init(DefaultHighlightReader *self, Schema *schema,
         metadata = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "term_vectors", 12);
     }
 
-    // Check format.
+    // Check format.  Format 1 lacks the term directory; its field bufs get
+    // upgraded as they are read.
+    ivars->format = HLWriter_current_file_format;
     if (metadata) {
         Obj *format = Hash_Fetch_Utf8(metadata, "format", 6);
         if (!format) { THROW(ERR, "Missing 'format' var"); }
         else {
-            if (Json_obj_to_i64(format) != HLWriter_current_file_format) {
+            int64_t format_val = Json_obj_to_i64(format);
+            if (format_val < 1
+                || format_val > HLWriter_current_file_format
+               ) {
                 THROW(ERR, "Unsupported highlight data format: %i64",
-                      Json_obj_to_i64(format));
+                      format_val);
             }
+            ivars->format = (int32_t)format_val;
         }
     }
 
@@ -159,6 +168,8 @@ DefHLReader_init(DefaultHighlightReader *self, Schema *schema,
             DECREF(self);
             RETHROW(error);
         }
+        // Doc vectors are read one hit at a time; skip kernel readahead.
+        InStream_Advise(ivars->dat_in, 0, -1, FH_ADVISE_RANDOM);
     }
     DECREF(ix_file);
     DECREF(dat_file);
@@ -204,6 +215,11 @@ DefHLReader_Fetch_Doc_Vec_IMP(DefaultHighlightReader *self, int32_t doc_id) {
     while (num_fields--) {
         String *field = Freezer_read_string(dat_in);
         Blob *field_buf = Freezer_read_blob(dat_in);
+        if (ivars->format < 2) {
+            Blob *upgraded = DocVec_upgrade_field_buf(field_buf);
+            DECREF(field_buf);
+            field_buf = upgraded;
+        }
         DocVec_Add_Field_Buf(doc_vec, field, field_buf);
         DECREF(field_buf);
         DECREF(field);
@@ -221,6 +237,36 @@ DefHLReader_Read_Record_IMP(DefaultHighlightReader *self, int32_t doc_id,
 
     InStream_Seek(ix_in, doc_id * 8);
 
+    if (ivars->format < 2) {
+        // Re-encode the record with upgraded field bufs.
+        char  c32_buf[C32_MAX_BYTES];
+        char *ptr = c32_buf;
+        InStream_Seek(dat_in, InStream_Read_I64(ix_in));
+        uint32_t num_fields = InStream_Read_C32(dat_in);
+        BB_Set_Size(target, 0);
+        NumUtil_encode_c32(num_fields, &ptr);
+        BB_Cat_Bytes(target, c32_buf, ptr - c32_buf);
+        while (num_fields--) {
+            String *field     = Freezer_read_string(dat_in);
+            Blob   *old_buf   = Freezer_read_blob(dat_in);
+            Blob   *field_buf = DocVec_upgrade_field_buf(old_buf);
+            size_t  field_len = Str_Get_Size(field);
+            size_t  buf_len   = Blob_Get_Size(field_buf);
+            ptr = c32_buf;
+            NumUtil_encode_c32((uint32_t)field_len, &ptr);
+            BB_Cat_Bytes(target, c32_buf, ptr - c32_buf);
+            BB_Cat_Bytes(target, Str_Get_Ptr8(field), field_len);
+            ptr = c32_buf;
+            NumUtil_encode_c32((uint32_t)buf_len, &ptr);
+            BB_Cat_Bytes(target, c32_buf, ptr - c32_buf);
+            BB_Cat_Bytes(target, Blob_Get_Buf(field_buf), buf_len);
+            DECREF(field_buf);
+            DECREF(old_buf);
+            DECREF(field);
+        }
+        return;
+    }
+
     // Copy the whole record.
     int64_t  filepos = InStream_Read_I64(ix_in);
     int64_t  end     = InStream_Read_I64(ix_in);
@@ -231,4 +277,14 @@ DefHLReader_Read_Record_IMP(DefaultHighlightReader *self, int32_t doc_id,
     BB_Set_Size(target, size);
 }
 
+Hash*
+DefHLReader_Stats_IMP(DefaultHighlightReader *self) {
+    DefaultHighlightReaderIVARS *const ivars = DefHLReader_IVARS(self);
+    Hash    *stats     = Hash_new(0);
+    int64_t  ix_bytes  = ivars->ix_in  ? InStream_Length(ivars->ix_in)  : 0;
+    int64_t  dat_bytes = ivars->dat_in ? InStream_Length(ivars->dat_in) : 0;
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(ix_bytes + dat_bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(ix_bytes));
+    return stats;
+}
 
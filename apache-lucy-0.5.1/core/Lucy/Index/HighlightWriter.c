@@ -42,7 +42,7 @@
 static OutStream*
 S_lazy_init(HighlightWriter *self);
 
-int32_t HLWriter_current_file_format = 1;
+int32_t HLWriter_current_file_format = 2;
 
 HighlightWriter*
 HLWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -85,6 +85,7 @@ S_lazy_init(HighlightWriter *self) {
         ivars->dat_out = Folder_Open_Out(folder, dat_file);
         DECREF(dat_file);
         if (!ivars->dat_out) { RETHROW(INCREF(Err_get_error())); }
+        OutStream_Set_Buf_Size(ivars->dat_out, OUTSTREAM_BULK_BUF_SIZE);
 
         // Go past invalid doc 0.
         OutStream_Write_I64(ivars->ix_out, 0);
@@ -143,15 +144,13 @@ Blob*
 HLWriter_TV_Buf_IMP(HighlightWriter *self, Inversion *inversion) {
     const char *last_text = "";
     size_t      last_len = 0;
-    ByteBuf    *tv_buf = BB_new(20 + Inversion_Get_Size(inversion) * 8);
+    ByteBuf    *dir = BB_new(20 + Inversion_Get_Size(inversion) * 4);
+    ByteBuf    *posdata = BB_new(20 + Inversion_Get_Size(inversion) * 6);
     uint32_t    num_postings = 0;
     Token     **tokens;
     uint32_t    freq;
     UNUSED_VAR(self);
 
-    // Leave space for a c32 indicating the number of postings.
-    BB_Set_Size(tv_buf, C32_MAX_BYTES);
-
     Inversion_Reset(inversion);
     while ((tokens = Inversion_Next_Cluster(inversion, &freq)) != NULL) {
         Token *token = *tokens;
@@ -162,52 +161,69 @@ HLWriter_TV_Buf_IMP(HighlightWriter *self, Inversion *inversion) {
                                           last_len, token_len);
         char *ptr;
         char *orig;
-        size_t old_size = BB_Get_Size(tv_buf);
-        size_t new_size = old_size
-                          + C32_MAX_BYTES      // overlap
-                          + C32_MAX_BYTES      // length of string diff
-                          + (token_len - overlap)        // diff char data
-                          + C32_MAX_BYTES                // num prox
-                          + (C32_MAX_BYTES * freq * 3);  // pos data
-
-        // Allocate for worst-case scenario.
-        ptr  = BB_Grow(tv_buf, new_size);
+        size_t old_posdata_size = BB_Get_Size(posdata);
+        size_t old_dir_size     = BB_Get_Size(dir);
+
+        // Allocate positional data for worst-case scenario.
+        ptr  = BB_Grow(posdata, old_posdata_size
+                                + C32_MAX_BYTES                 // num prox
+                                + (C32_MAX_BYTES * freq * 3));  // pos data
         orig = ptr;
-        ptr += old_size;
+        ptr += old_posdata_size;
 
         // Track number of postings.
         num_postings += 1;
 
-        // Append the string diff to the tv_buf.
-        NumUtil_encode_c32(overlap, &ptr);
-        NumUtil_encode_c32((token_len - overlap), &ptr);
-        memcpy(ptr, (token_text + overlap), (token_len - overlap));
-        ptr += token_len - overlap;
-
-        // Save text and text_len for comparison next loop.
-        last_text = token_text;
-        last_len  = token_len;
-
         // Append the number of positions for this term.
         NumUtil_encode_c32(freq, &ptr);
 
         do {
-            // Add position, start_offset, and end_offset to tv_buf.
+            // Add position, start_offset, and end_offset to posdata.
             NumUtil_encode_c32(Token_Get_Pos(token), &ptr);
             NumUtil_encode_c32(Token_Get_Start_Offset(token), &ptr);
             NumUtil_encode_c32(Token_Get_End_Offset(token), &ptr);
         } while (--freq && (token = *++tokens));
 
-        // Set new byte length.
-        BB_Set_Size(tv_buf, ptr - orig);
+        size_t term_posdata_size = (ptr - orig) - old_posdata_size;
+        BB_Set_Size(posdata, ptr - orig);
+
+        // Append the string diff and the size of the positional data to
+        // the directory.
+        ptr  = BB_Grow(dir, old_dir_size
+                            + C32_MAX_BYTES              // overlap
+                            + C32_MAX_BYTES              // length of diff
+                            + (token_len - overlap)      // diff char data
+                            + C32_MAX_BYTES);            // posdata size
+        orig = ptr;
+        ptr += old_dir_size;
+        NumUtil_encode_c32(overlap, &ptr);
+        NumUtil_encode_c32((token_len - overlap), &ptr);
+        memcpy(ptr, (token_text + overlap), (token_len - overlap));
+        ptr += token_len - overlap;
+        NumUtil_encode_c32((uint32_t)term_posdata_size, &ptr);
+        BB_Set_Size(dir, ptr - orig);
+
+        // Save text and text_len for comparison next loop.
+        last_text = token_text;
+        last_len  = token_len;
     }
 
-    // Go back and start the term vector string with the posting count.
-    char *dest = BB_Get_Buf(tv_buf);
-    NumUtil_encode_padded_c32(num_postings, &dest);
+    // Start the term vector string with the posting count and the size of
+    // the directory, then follow with the directory and the posdata.
+    size_t  dir_size = BB_Get_Size(dir);
+    ByteBuf *tv_buf  = BB_new(2 * C32_MAX_BYTES + dir_size
+                              + BB_Get_Size(posdata));
+    char    *dest    = BB_Get_Buf(tv_buf);
+    NumUtil_encode_c32(num_postings, &dest);
+    NumUtil_encode_c32((uint32_t)dir_size, &dest);
+    BB_Set_Size(tv_buf, dest - BB_Get_Buf(tv_buf));
+    BB_Cat_Bytes(tv_buf, BB_Get_Buf(dir), dir_size);
+    BB_Cat_Bytes(tv_buf, BB_Get_Buf(posdata), BB_Get_Size(posdata));
 
     Blob *blob = BB_Yield_Blob(tv_buf);
     DECREF(tv_buf);
+    DECREF(posdata);
+    DECREF(dir);
     return blob;
 }
 
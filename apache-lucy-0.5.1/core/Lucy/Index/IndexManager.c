@@ -19,14 +19,17 @@
 
 #include "Lucy/Index/IndexManager.h"
 #include "Lucy/Index/DeletionsWriter.h"
+#include "Lucy/Index/MergePolicy.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/TieredMergePolicy.h"
 #include "Lucy/Store/DirHandle.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/Lock.h"
 #include "Lucy/Store/LockFactory.h"
+#include "Lucy/Util/Clock.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
 #include "Clownfish/Util/StringHelper.h"
@@ -54,6 +57,13 @@ IxManager_init(IndexManager *self, String *host,
     ivars->merge_lock_interval = 1000;
     ivars->deletion_lock_timeout  = 1000;
     ivars->deletion_lock_interval = 100;
+    ivars->mem_budget             = 0;
+    ivars->defer_merges           = false;
+    ivars->sync_commits           = false;
+    ivars->binary_metadata        = false;
+    ivars->last_commit_usec       = 0;
+    ivars->last_sync_usec         = 0;
+    ivars->merge_policy           = (MergePolicy*)TieredMP_new();
 
     return self;
 }
@@ -64,6 +74,7 @@ IxManager_Destroy_IMP(IndexManager *self) {
     DECREF(ivars->host);
     DECREF(ivars->folder);
     DECREF(ivars->lock_factory);
+    DECREF(ivars->merge_policy);
     SUPER_DESTROY(self, INDEXMANAGER);
 }
 
@@ -109,28 +120,6 @@ IxManager_Make_Snapshot_Filename_IMP(IndexManager *self) {
     return Str_newf("snapshot_%s.json", &base36);
 }
 
-static int
-S_compare_doc_count(const void *va, const void *vb) {
-    SegReader *a = *(SegReader**)va;
-    SegReader *b = *(SegReader**)vb;
-    return SegReader_Doc_Count(a) - SegReader_Doc_Count(b);
-}
-
-static uint32_t
-S_fibonacci(uint32_t n) {
-    uint32_t result = 0;
-    if (n > 46) {
-        THROW(ERR, "input %u32 too high", n);
-    }
-    else if (n < 2) {
-        result = n;
-    }
-    else {
-        result = S_fibonacci(n - 1) + S_fibonacci(n - 2);
-    }
-    return result;
-}
-
 Vector*
 IxManager_Recycle_IMP(IndexManager *self, PolyReader *reader,
                       DeletionsWriter *del_writer, int64_t cutoff,
@@ -157,66 +146,40 @@ IxManager_Recycle_IMP(IndexManager *self, PolyReader *reader,
         return recyclables;
     }
 
-    // Sort by ascending size in docs, choose sparsely populated segments.
-    qsort(candidates, num_candidates, sizeof(SegReader*), S_compare_doc_count);
-    int32_t *counts = (int32_t*)MALLOCATE(num_candidates * sizeof(int32_t));
-    for (uint32_t i = 0; i < num_candidates; i++) {
-        counts[i] = SegReader_Doc_Count(candidates[i]);
-    }
-    I32Array *doc_counts = I32Arr_new_steal(counts, num_candidates);
-    uint32_t threshold = IxManager_Choose_Sparse(self, doc_counts);
-    DECREF(doc_counts);
-
-    // Move SegReaders to be recycled.
-    for (uint32_t i = 0; i < threshold; i++) {
-        Vec_Store(recyclables, i, INCREF(candidates[i]));
-    }
-
-    // Find segments where at least 10% of all docs have been deleted.
-    for (uint32_t i = threshold; i < num_candidates; i++) {
+    // Describe each candidate's size and deletions, then let the merge
+    // policy choose.
+    Vector *stats = Vec_new(num_candidates);
+    for (size_t i = 0; i < num_candidates; i++) {
         SegReader *seg_reader = candidates[i];
         String    *seg_name   = SegReader_Get_Seg_Name(seg_reader);
-        double doc_max = SegReader_Doc_Max(seg_reader);
-        double num_deletions = DelWriter_Seg_Del_Count(del_writer, seg_name);
-        double del_proportion = num_deletions / doc_max;
-        if (del_proportion >= 0.1) {
-            Vec_Push(recyclables, INCREF(seg_reader));
+        Segment   *segment    = SegReader_Get_Segment(seg_reader);
+        int64_t    size       = Seg_Get_Size(segment);
+        if (!size) {
+            size = Seg_Measure_Size(segment, SegReader_Get_Folder(seg_reader));
         }
+        int64_t del_count = DelWriter_Seg_Del_Count(del_writer, seg_name);
+        Vec_Push(stats, (Obj*)MergeCand_new(size,
+                                            SegReader_Doc_Max(seg_reader),
+                                            del_count));
     }
-
-    FREEMEM(candidates);
-    return recyclables;
-}
-
-uint32_t
-IxManager_Choose_Sparse_IMP(IndexManager *self, I32Array *doc_counts) {
-    UNUSED_VAR(self);
-    uint32_t threshold  = 0;
-    uint32_t total_docs = 0;
-    const uint32_t num_candidates = I32Arr_Get_Size(doc_counts);
-
-    // Find sparsely populated segments.
-    for (uint32_t i = 0; i < num_candidates; i++) {
-        uint32_t num_segs_when_done = num_candidates - threshold + 1;
-        total_docs += I32Arr_Get(doc_counts, i);
-        if (total_docs < S_fibonacci(num_segs_when_done + 5)) {
-            threshold = i + 1;
+    MergePolicy *policy = IxManager_Get_Merge_Policy(self);
+    I32Array *picks = MergePolicy_Find_Merge(policy, stats);
+    for (uint32_t i = 0, max = I32Arr_Get_Size(picks); i < max; i++) {
+        int32_t tick = I32Arr_Get(picks, i);
+        if (tick < 0 || (size_t)tick >= num_candidates) {
+            DECREF(picks);
+            DECREF(stats);
+            DECREF(recyclables);
+            FREEMEM(candidates);
+            THROW(ERR, "Merge policy chose invalid candidate %i32", tick);
         }
+        Vec_Push(recyclables, INCREF(candidates[tick]));
     }
+    DECREF(picks);
+    DECREF(stats);
 
-    // If recycling, try not to get stuck merging the same big segment over
-    // and over on small commits.
-    if (threshold == 1 && num_candidates > 2) {
-        int32_t this_seg_doc_count = I32Arr_Get(doc_counts, 0);
-        int32_t next_seg_doc_count = I32Arr_Get(doc_counts, 1);
-        // Try to merge 2 segments worth of stuff, so long as the next segment
-        // is less than double the size.
-        if (next_seg_doc_count / 2 < this_seg_doc_count) {
-            threshold = 2;
-        }
-    }
-
-    return threshold;
+    FREEMEM(candidates);
+    return recyclables;
 }
 
 static LockFactory*
@@ -340,6 +303,11 @@ IxManager_Get_Host_IMP(IndexManager *self) {
     return IxManager_IVARS(self)->host;
 }
 
+LockFactory*
+IxManager_Get_Lock_Factory_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->lock_factory;
+}
+
 uint32_t
 IxManager_Get_Write_Lock_Timeout_IMP(IndexManager *self) {
     return IxManager_IVARS(self)->write_lock_timeout;
@@ -402,4 +370,113 @@ IxManager_Set_Deletion_Lock_Interval_IMP(IndexManager *self,
     IxManager_IVARS(self)->deletion_lock_interval = interval;
 }
 
+void
+IxManager_Set_Mem_Budget_IMP(IndexManager *self, uint64_t mem_budget) {
+    IxManager_IVARS(self)->mem_budget = mem_budget;
+}
+
+uint64_t
+IxManager_Get_Mem_Budget_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->mem_budget;
+}
+
+void
+IxManager_Set_Defer_Merges_IMP(IndexManager *self, bool defer_merges) {
+    IxManager_IVARS(self)->defer_merges = defer_merges;
+}
+
+bool
+IxManager_Get_Defer_Merges_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->defer_merges;
+}
+
+void
+IxManager_Set_Sync_Commits_IMP(IndexManager *self, bool sync_commits) {
+    IxManager_IVARS(self)->sync_commits = sync_commits;
+}
+
+bool
+IxManager_Get_Sync_Commits_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->sync_commits;
+}
 
+void
+IxManager_Set_Binary_Metadata_IMP(IndexManager *self, bool binary_metadata) {
+    IxManager_IVARS(self)->binary_metadata = binary_metadata;
+}
+
+bool
+IxManager_Get_Binary_Metadata_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->binary_metadata;
+}
+
+uint64_t
+IxManager_Sync_Files_IMP(IndexManager *self, Folder *folder, Vector *paths) {
+    IndexManagerIVARS *const ivars = IxManager_IVARS(self);
+    if (!ivars->sync_commits) { return 0; }
+
+    uint64_t start     = Clock_microseconds();
+    Vector  *files     = Vec_new(Vec_Get_Size(paths));
+    bool     sync_root = false;
+    for (size_t i = 0, max = Vec_Get_Size(paths); i < max; i++) {
+        String *path = (String*)CERTIFY(Vec_Fetch(paths, i), STRING);
+        if (!Str_Get_Size(path)) {
+            sync_root = true;
+        }
+        else if (Folder_Is_Directory(folder, path)) {
+            Vector *entries = Folder_List(folder, path);
+            if (!entries) { RETHROW(INCREF(Err_get_error())); }
+            for (size_t j = 0, num = Vec_Get_Size(entries); j < num; j++) {
+                String *entry = (String*)Vec_Fetch(entries, j);
+                Vec_Push(files, (Obj*)Str_newf("%o/%o", path, entry));
+            }
+            DECREF(entries);
+            // A new directory's own entry lives in its parent.
+            Vec_Push(files, INCREF(path));
+        }
+        else {
+            Vec_Push(files, INCREF(path));
+        }
+    }
+
+    bool success = Folder_Sync(folder, files);
+    if (success && sync_root) {
+        success = Folder_Local_Sync(folder, NULL);
+    }
+    DECREF(files);
+    if (!success) { RETHROW(INCREF(Err_get_error())); }
+
+    return Clock_microseconds() - start;
+}
+
+void
+IxManager_Report_Commit_IMP(IndexManager *self, uint64_t commit_usec,
+                            uint64_t sync_usec) {
+    IndexManagerIVARS *const ivars = IxManager_IVARS(self);
+    ivars->last_commit_usec = commit_usec;
+    ivars->last_sync_usec   = sync_usec;
+}
+
+uint64_t
+IxManager_Get_Last_Commit_Micros_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->last_commit_usec;
+}
+
+uint64_t
+IxManager_Get_Last_Sync_Micros_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->last_sync_usec;
+}
+
+void
+IxManager_Set_Merge_Policy_IMP(IndexManager *self, MergePolicy *policy) {
+    IndexManagerIVARS *const ivars = IxManager_IVARS(self);
+    MergePolicy *temp = ivars->merge_policy;
+    ivars->merge_policy
+        = (MergePolicy*)INCREF(CERTIFY(policy, MERGEPOLICY));
+    DECREF(temp);
+}
+
+MergePolicy*
+IxManager_Get_Merge_Policy_IMP(IndexManager *self) {
+    return IxManager_IVARS(self)->merge_policy;
+}
@@ -18,6 +18,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/IndexReader.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/IndexManager.h"
@@ -122,4 +123,37 @@ IxReader_Fetch_IMP(IndexReader *self, String *api) {
     return (DataReader*)Hash_Fetch(ivars->components, api);
 }
 
+void
+IxReader_add_stats(Hash *totals, Hash *stats) {
+    HashIterator *iter = HashIter_new(stats);
+    while (HashIter_Next(iter)) {
+        String *key   = HashIter_Get_Key(iter);
+        Obj    *value = HashIter_Get_Value(iter);
+        if (Obj_is_a(value, INTEGER)) {
+            Obj *total = Hash_Fetch(totals, key);
+            int64_t sum = Int_Get_Value((Integer*)value);
+            if (total && Obj_is_a(total, INTEGER)) {
+                sum += Int_Get_Value((Integer*)total);
+            }
+            Hash_Store(totals, key, (Obj*)Int_new(sum));
+        }
+        else if (Obj_is_a(value, HASH)) {
+            Hash *sub_totals = (Hash*)Hash_Fetch(totals, key);
+            if (!sub_totals || !Obj_is_a((Obj*)sub_totals, HASH)) {
+                sub_totals = Hash_new(0);
+                Hash_Store(totals, key, (Obj*)sub_totals);
+            }
+            IxReader_add_stats(sub_totals, (Hash*)value);
+        }
+    }
+    DECREF(iter);
+}
+
+int64_t
+IxReader_fetch_stat(Hash *stats, const char *key, size_t key_len) {
+    Obj *value = Hash_Fetch_Utf8(stats, key, key_len);
+    return value && Obj_is_a(value, INTEGER)
+           ? Int_Get_Value((Integer*)value)
+           : 0;
+}
 
@@ -0,0 +1,420 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_INDEXWARMER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/HashIterator.h"
+#include "Lucy/Index/IndexWarmer.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/SegLexicon.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/TermInfo.h"
+#include "Lucy/Store/FileHandle.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Util/Clock.h"
+#include "Lucy/Util/WorkerThread.h"
+
+// A run of bytes to warm, relative to the top of `instream`.
+typedef struct WarmRange {
+    InStream *instream;
+    int64_t   offset;
+    int64_t   len;
+} WarmRange;
+
+/* Everything a worker thread needs, as plain C data.  The ranges' InStreams
+ * are kept alive by the warmer; the worker only reads through them and must
+ * not touch their refcounts.
+ */
+typedef struct WarmTask {
+    WarmRange *ranges;
+    uint32_t   num_ranges;
+    int64_t    touched;
+    int64_t    micros;
+    void      *thread;
+} WarmTask;
+
+// Touch every range of a WarmTask, recording the byte count and elapsed
+// time.
+static void
+S_touch_ranges(void *context);
+
+// Reap the background task, if any, once it has finished.  If `block` is
+// true, wait for it first.
+static void
+S_reap(IndexWarmer *self, bool block);
+
+// Drop the ranges and the InStreams backing them.
+static void
+S_clear_ranges(IndexWarmer *self);
+
+// Gather the ranges selected for warming from every segment of `reader`.
+// If `advise` is true, flag posting files for random access and tell the OS
+// that each range will be needed soon.
+static void
+S_collect(IndexWarmer *self, IndexReader *reader, bool advise);
+
+IndexWarmer*
+IxWarmer_new() {
+    IndexWarmer *self = (IndexWarmer*)Class_Make_Obj(INDEXWARMER);
+    return IxWarmer_init(self);
+}
+
+IndexWarmer*
+IxWarmer_init(IndexWarmer *self) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    ivars->kinds           = IXWARMER_ALL;
+    ivars->random_postings = true;
+    ivars->hot_terms       = Hash_new(0);
+    ivars->streams         = Vec_new(0);
+    ivars->ranges          = NULL;
+    ivars->num_ranges      = 0;
+    ivars->cap             = 0;
+    ivars->bytes           = 0;
+    ivars->touched         = 0;
+    ivars->micros          = 0;
+    ivars->task            = NULL;
+    return self;
+}
+
+void
+IxWarmer_Destroy_IMP(IndexWarmer *self) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    S_reap(self, true);
+    S_clear_ranges(self);
+    FREEMEM(ivars->ranges);
+    DECREF(ivars->streams);
+    DECREF(ivars->hot_terms);
+    SUPER_DESTROY(self, INDEXWARMER);
+}
+
+void
+IxWarmer_Set_Kinds_IMP(IndexWarmer *self, uint32_t kinds) {
+    IxWarmer_IVARS(self)->kinds = kinds;
+}
+
+uint32_t
+IxWarmer_Get_Kinds_IMP(IndexWarmer *self) {
+    return IxWarmer_IVARS(self)->kinds;
+}
+
+void
+IxWarmer_Set_Random_Postings_IMP(IndexWarmer *self, bool random_postings) {
+    IxWarmer_IVARS(self)->random_postings = random_postings;
+}
+
+bool
+IxWarmer_Get_Random_Postings_IMP(IndexWarmer *self) {
+    return IxWarmer_IVARS(self)->random_postings;
+}
+
+void
+IxWarmer_Add_Hot_Term_IMP(IndexWarmer *self, String *field, Obj *term) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    Vector *terms = (Vector*)Hash_Fetch(ivars->hot_terms, field);
+    if (!terms) {
+        terms = Vec_new(1);
+        Hash_Store(ivars->hot_terms, field, (Obj*)terms);
+    }
+    Vec_Push(terms, Obj_Clone(term));
+}
+
+int64_t
+IxWarmer_Warm_IMP(IndexWarmer *self, IndexReader *reader) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    S_reap(self, true);
+    S_collect(self, reader, true);
+
+    WarmTask task;
+    memset(&task, 0, sizeof(WarmTask));
+    task.ranges     = (WarmRange*)ivars->ranges;
+    task.num_ranges = ivars->num_ranges;
+    S_touch_ranges(&task);
+    ivars->touched = task.touched;
+    ivars->micros  = task.micros;
+    S_clear_ranges(self);
+
+    return ivars->touched;
+}
+
+bool
+IxWarmer_Start_IMP(IndexWarmer *self, IndexReader *reader) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    S_reap(self, true);
+    S_collect(self, reader, true);
+
+    WarmTask *task = (WarmTask*)CALLOCATE(1, sizeof(WarmTask));
+    task->ranges     = (WarmRange*)ivars->ranges;
+    task->num_ranges = ivars->num_ranges;
+    task->thread = WorkerThread_start(S_touch_ranges, task);
+    if (!task->thread) {
+        S_touch_ranges(task);
+        ivars->touched = task->touched;
+        ivars->micros  = task->micros;
+        FREEMEM(task);
+        S_clear_ranges(self);
+        return false;
+    }
+    ivars->task = task;
+    return true;
+}
+
+bool
+IxWarmer_Is_Running_IMP(IndexWarmer *self) {
+    S_reap(self, false);
+    return IxWarmer_IVARS(self)->task != NULL;
+}
+
+void
+IxWarmer_Wait_IMP(IndexWarmer *self) {
+    S_reap(self, true);
+}
+
+double
+IxWarmer_Measure_IMP(IndexWarmer *self, IndexReader *reader) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    S_reap(self, true);
+    S_collect(self, reader, false);
+
+    WarmRange *ranges   = (WarmRange*)ivars->ranges;
+    int64_t    known    = 0;
+    int64_t    resident = 0;
+    for (uint32_t i = 0; i < ivars->num_ranges; i++) {
+        int64_t count = InStream_Resident_Bytes(ranges[i].instream,
+                                                ranges[i].offset,
+                                                ranges[i].len);
+        if (count < 0) { continue; }
+        known    += ranges[i].len;
+        resident += count;
+    }
+    S_clear_ranges(self);
+
+    if (ivars->bytes == 0) { return 1.0; }
+    if (known == 0)        { return -1.0; }
+    return (double)resident / (double)known;
+}
+
+int64_t
+IxWarmer_Get_Bytes_IMP(IndexWarmer *self) {
+    return IxWarmer_IVARS(self)->bytes;
+}
+
+int64_t
+IxWarmer_Get_Touched_Bytes_IMP(IndexWarmer *self) {
+    S_reap(self, false);
+    return IxWarmer_IVARS(self)->touched;
+}
+
+int64_t
+IxWarmer_Get_Micros_IMP(IndexWarmer *self) {
+    S_reap(self, false);
+    return IxWarmer_IVARS(self)->micros;
+}
+
+static void
+S_touch_ranges(void *context) {
+    WarmTask *task = (WarmTask*)context;
+    uint64_t start = Clock_microseconds();
+    int64_t  touched = 0;
+    for (uint32_t i = 0; i < task->num_ranges; i++) {
+        WarmRange *range = task->ranges + i;
+        int64_t count = InStream_Touch(range->instream, range->offset,
+                                       range->len);
+        if (count > 0) { touched += count; }
+    }
+    task->touched = touched;
+    task->micros  = (int64_t)(Clock_microseconds() - start);
+}
+
+static void
+S_reap(IndexWarmer *self, bool block) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    WarmTask *task = (WarmTask*)ivars->task;
+    if (!task) { return; }
+
+    if (!block && !WorkerThread_done(task->thread)) { return; }
+    WorkerThread_join(task->thread);
+
+    ivars->touched = task->touched;
+    ivars->micros  = task->micros;
+    FREEMEM(task);
+    ivars->task = NULL;
+    S_clear_ranges(self);
+}
+
+static void
+S_clear_ranges(IndexWarmer *self) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    ivars->num_ranges = 0;
+    Vec_Clear(ivars->streams);
+}
+
+static void
+S_add_range(IndexWarmer *self, InStream *instream, int64_t offset,
+            int64_t len, bool advise) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    if (len <= 0) { return; }
+    if (ivars->num_ranges == ivars->cap) {
+        ivars->cap = ivars->cap ? ivars->cap * 2 : 16;
+        ivars->ranges = REALLOCATE(ivars->ranges,
+                                   ivars->cap * sizeof(WarmRange));
+    }
+    WarmRange *range = (WarmRange*)ivars->ranges + ivars->num_ranges++;
+    range->instream = instream;
+    range->offset   = offset;
+    range->len      = len;
+    ivars->bytes   += len;
+    if (advise) {
+        InStream_Advise(instream, offset, len, FH_ADVISE_WILLNEED);
+    }
+}
+
+// Open `path` if it exists, holding on to the InStream for the lifetime of
+// the ranges.  Takes ownership of `path`.
+static InStream*
+S_open(IndexWarmer *self, Folder *folder, String *path) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    InStream *instream = NULL;
+    if (Folder_Exists(folder, path)) {
+        instream = Folder_Open_In(folder, path);
+        if (!instream) {
+            DECREF(path);
+            RETHROW((Err*)INCREF(Err_get_error()));
+        }
+        Vec_Push(ivars->streams, (Obj*)instream);
+    }
+    DECREF(path);
+    return instream;
+}
+
+static void
+S_add_file(IndexWarmer *self, Folder *folder, String *path, bool advise) {
+    InStream *instream = S_open(self, folder, path);
+    if (instream) {
+        S_add_range(self, instream, 0, InStream_Length(instream), advise);
+    }
+}
+
+static void
+S_add_hot_postings(IndexWarmer *self, SegReader *seg_reader,
+                   InStream *post_in, String *field, Vector *terms,
+                   bool advise) {
+    LexiconReader *lex_reader = (LexiconReader*)SegReader_Fetch(
+                                    seg_reader, Class_Get_Name(LEXICONREADER));
+    if (!lex_reader) { return; }
+
+    for (size_t i = 0, max = Vec_Get_Size(terms); i < max; i++) {
+        Obj *term = Vec_Fetch(terms, i);
+        Lexicon *lexicon = LexReader_Lexicon(lex_reader, field, term);
+        if (!lexicon) { continue; }
+        if (Obj_is_a((Obj*)lexicon, SEGLEXICON)) {
+            SegLexicon *seg_lex = (SegLexicon*)lexicon;
+            Obj *found = SegLex_Get_Term(seg_lex);
+            if (found && Obj_Equals(found, term)) {
+                // Postings are written in term order, so the run for this
+                // term ends where the next term's begins.
+                int64_t start
+                    = TInfo_Get_Post_FilePos(SegLex_Get_Term_Info(seg_lex));
+                int64_t end = SegLex_Next(seg_lex)
+                    ? TInfo_Get_Post_FilePos(SegLex_Get_Term_Info(seg_lex))
+                    : InStream_Length(post_in);
+                S_add_range(self, post_in, start, end - start, advise);
+            }
+        }
+        DECREF(lexicon);
+    }
+}
+
+static void
+S_collect_segment(IndexWarmer *self, SegReader *seg_reader, bool advise) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    Folder   *folder   = SegReader_Get_Folder(seg_reader);
+    Segment  *segment  = SegReader_Get_Segment(seg_reader);
+    String   *seg_name = Seg_Get_Name(segment);
+    uint32_t  kinds    = ivars->kinds;
+
+    if (kinds & IXWARMER_SKIP_DATA) {
+        S_add_file(self, folder, Str_newf("%o/postings.skip", seg_name),
+                   advise);
+    }
+    if (kinds & IXWARMER_DOC_INDEX) {
+        S_add_file(self, folder, Str_newf("%o/documents.ix", seg_name),
+                   advise);
+        S_add_file(self, folder, Str_newf("%o/highlight.ix", seg_name),
+                   advise);
+    }
+
+    for (int32_t field_num = 1; ; field_num++) {
+        String *field = Seg_Field_Name(segment, field_num);
+        if (!field) { break; }
+
+        if (kinds & IXWARMER_LEXICON_INDEX) {
+            S_add_file(self, folder,
+                       Str_newf("%o/lexicon-%i32.ixix", seg_name, field_num),
+                       advise);
+            S_add_file(self, folder,
+                       Str_newf("%o/lexicon-%i32.ix", seg_name, field_num),
+                       advise);
+        }
+        if (kinds & IXWARMER_SORT_CACHES) {
+            S_add_file(self, folder,
+                       Str_newf("%o/sort-%i32.ord", seg_name, field_num),
+                       advise);
+            S_add_file(self, folder,
+                       Str_newf("%o/sort-%i32.ix", seg_name, field_num),
+                       advise);
+            S_add_file(self, folder,
+                       Str_newf("%o/sort-%i32.dat", seg_name, field_num),
+                       advise);
+        }
+
+        Vector *terms = (kinds & IXWARMER_HOT_POSTINGS)
+                        ? (Vector*)Hash_Fetch(ivars->hot_terms, field)
+                        : NULL;
+        if ((advise && ivars->random_postings) || terms) {
+            InStream *post_in
+                = S_open(self, folder, Str_newf("%o/postings-%i32.dat",
+                                                seg_name, field_num));
+            if (!post_in) { continue; }
+            if (advise && ivars->random_postings) {
+                InStream_Advise(post_in, 0, -1, FH_ADVISE_RANDOM);
+            }
+            if (terms) {
+                S_add_hot_postings(self, seg_reader, post_in, field, terms,
+                                   advise);
+            }
+        }
+    }
+}
+
+static void
+S_collect(IndexWarmer *self, IndexReader *reader, bool advise) {
+    IndexWarmerIVARS *const ivars = IxWarmer_IVARS(self);
+    S_clear_ranges(self);
+    ivars->bytes = 0;
+
+    Vector *seg_readers = IxReader_Seg_Readers(reader);
+    for (size_t i = 0, max = Vec_Get_Size(seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(seg_readers, i);
+        S_collect_segment(self, seg_reader, advise);
+    }
+    DECREF(seg_readers);
+}
+
+
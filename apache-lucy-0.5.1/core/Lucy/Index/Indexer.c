@@ -19,8 +19,10 @@
 
 #include "Lucy/Index/Indexer.h"
 #include "Clownfish/Boolean.h"
+#include "Clownfish/HashIterator.h"
 #include "Lucy/Analysis/Analyzer.h"
 #include "Lucy/Document/Doc.h"
+#include "Lucy/Document/DocBuilder.h"
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Schema.h"
@@ -28,6 +30,7 @@
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/FilePurger.h"
 #include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/MemoryBudget.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
@@ -39,9 +42,11 @@
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/FSFolder.h"
 #include "Lucy/Store/Lock.h"
+#include "Lucy/Util/Clock.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 int32_t Indexer_CREATE   = 0x00000001;
 int32_t Indexer_TRUNCATE = 0x00000002;
@@ -63,6 +68,21 @@ S_init_folder(Obj *index, bool create);
 static String*
 S_find_schema_file(Snapshot *snapshot);
 
+// Make a snapshot rename durable, if commits are synced.  Return the
+// microseconds spent.
+static uint64_t
+S_sync_index_dir(Indexer *self);
+
+// Validate that `field` is indexed and run `term` through its Analyzer if it
+// has one.  Return the analyzed term, or NULL if analysis produced nothing.
+static Obj*
+S_analyze_term(Indexer *self, String *field, Obj *term);
+
+// Delete the documents in existing segments which were replaced by buffered
+// updates.
+static void
+S_flush_pending_updates(Indexer *self);
+
 Indexer*
 Indexer_new(Schema *schema, Obj *index, IndexManager *manager, int32_t flags) {
     Indexer *self = (Indexer*)Class_Make_Obj(INDEXER);
@@ -80,10 +100,13 @@ Indexer_init(Indexer *self, Schema *schema, Obj *index,
 
     // Init.
     ivars->stock_doc     = Doc_new(NULL, 0);
+    ivars->pending_updates = Hash_new(0);
     ivars->truncate      = false;
     ivars->optimize      = false;
     ivars->prepared      = false;
     ivars->needs_commit  = false;
+    ivars->commit_usec   = 0;
+    ivars->sync_usec     = 0;
     ivars->snapfile      = NULL;
     ivars->merge_lock    = NULL;
 
@@ -124,7 +147,7 @@ Indexer_init(Indexer *self, Schema *schema, Obj *index,
         }
         else {
             String *schema_file = S_find_schema_file(latest_snapshot);
-            Obj *dump = Json_slurp_json(folder, schema_file);
+            Obj *dump = MetaFile_slurp(folder, schema_file);
             if (dump) { // read file successfully
                 ivars->schema = (Schema*)CERTIFY(Freezer_load(dump), SCHEMA);
                 schema = ivars->schema;
@@ -209,6 +232,8 @@ Indexer_init(Indexer *self, Schema *schema, Obj *index,
     ivars->seg_writer = SegWriter_new(ivars->schema, ivars->snapshot,
                                      ivars->segment, ivars->polyreader);
     SegWriter_Prep_Seg_Dir(ivars->seg_writer);
+    MemBudget_Set_Limit(SegWriter_Get_Mem_Budget(ivars->seg_writer),
+                        IxManager_Get_Mem_Budget(ivars->manager));
 
     // Grab a local ref to the DeletionsWriter.
     ivars->del_writer = (DeletionsWriter*)INCREF(
@@ -230,6 +255,7 @@ Indexer_Destroy_IMP(Indexer *self) {
     DECREF(ivars->segment);
     DECREF(ivars->manager);
     DECREF(ivars->stock_doc);
+    DECREF(ivars->pending_updates);
     DECREF(ivars->polyreader);
     DECREF(ivars->del_writer);
     DECREF(ivars->snapshot);
@@ -274,8 +300,23 @@ Indexer_Add_Doc_IMP(Indexer *self, Doc *doc, float boost) {
     SegWriter_Add_Doc(ivars->seg_writer, doc, boost);
 }
 
+DocBuilder*
+Indexer_Make_Doc_Builder_IMP(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    return DocBuilder_new(ivars->schema, ivars->segment);
+}
+
 void
-Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
+Indexer_Add_Built_Doc_IMP(Indexer *self, DocBuilder *builder, float boost) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    if (DocBuilder_Get_Segment(builder) != ivars->segment) {
+        THROW(ERR, "DocBuilder was not created by this Indexer");
+    }
+    SegWriter_Add_Built_Doc(ivars->seg_writer, builder, boost);
+}
+
+static Obj*
+S_analyze_term(Indexer *self, String *field, Obj *term) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
     Schema    *schema = ivars->schema;
     FieldType *type   = Schema_Fetch_Type(schema, field);
@@ -285,23 +326,92 @@ Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
         THROW(ERR, "%o is not an indexed field", field);
     }
 
-    // Analyze term if appropriate, then zap.
+    // Analyze term if appropriate.
     if (FType_is_a(type, FULLTEXTTYPE)) {
         CERTIFY(term, STRING);
         Analyzer *analyzer = Schema_Fetch_Analyzer(schema, field);
         Vector *terms = Analyzer_Split(analyzer, (String*)term);
-        Obj *analyzed_term = Vec_Fetch(terms, 0);
-        if (analyzed_term) {
-            DelWriter_Delete_By_Term(ivars->del_writer, field,
-                                     analyzed_term);
-        }
+        Obj *analyzed_term = INCREF(Vec_Fetch(terms, 0));
         DECREF(terms);
+        return analyzed_term;
     }
     else {
-        DelWriter_Delete_By_Term(ivars->del_writer, field, term);
+        return INCREF(term);
     }
 }
 
+void
+Indexer_Delete_By_Term_IMP(Indexer *self, String *field, Obj *term) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    Obj *analyzed_term = S_analyze_term(self, field, term);
+    if (analyzed_term) {
+        DelWriter_Delete_By_Term(ivars->del_writer, field, analyzed_term);
+
+        // Catch docs added earlier in this session, too.
+        int32_t doc_max = (int32_t)Seg_Get_Count(ivars->segment);
+        if (doc_max && Obj_is_a(analyzed_term, STRING)) {
+            DelWriter_Delete_Added_By_Term(ivars->del_writer, field,
+                                           analyzed_term, doc_max + 1);
+        }
+        DECREF(analyzed_term);
+    }
+}
+
+void
+Indexer_Update_Doc_IMP(Indexer *self, String *field, Obj *term, Doc *doc,
+                       float boost) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+
+    // Settle the key before adding anything, so that a bad one doesn't
+    // leave `doc` alongside the docs it was meant to replace.
+    Obj *analyzed_term = S_analyze_term(self, field, term);
+    if (analyzed_term && !Obj_is_a(analyzed_term, STRING)) {
+        String *class_name = Obj_get_class_name(analyzed_term);
+        DECREF(analyzed_term);
+        THROW(ERR, "Update_Doc needs a String key for %o, not %o", field,
+              class_name);
+    }
+
+    if (analyzed_term) {
+        Hash *updates = (Hash*)Hash_Fetch(ivars->pending_updates, field);
+        if (!updates) {
+            updates = Hash_new(0);
+            Hash_Store(ivars->pending_updates, field, (Obj*)updates);
+        }
+        Hash_Store(updates, (String*)analyzed_term, (Obj*)CFISH_TRUE);
+
+        // Replace docs added earlier in this session, but not `doc` itself,
+        // which gets the next doc id.
+        int32_t doc_id = (int32_t)Seg_Get_Count(ivars->segment) + 1;
+        if (doc_id > 1) {
+            DelWriter_Delete_Added_By_Term(ivars->del_writer, field,
+                                           analyzed_term, doc_id);
+        }
+        DECREF(analyzed_term);
+    }
+
+    SegWriter_Add_Doc(ivars->seg_writer, doc, boost);
+}
+
+static void
+S_flush_pending_updates(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+
+    // Resolve each field's update terms in a single sorted pass.
+    HashIterator *iter = HashIter_new(ivars->pending_updates);
+    while (HashIter_Next(iter)) {
+        String *field   = HashIter_Get_Key(iter);
+        Hash   *updates = (Hash*)HashIter_Get_Value(iter);
+        Vector *terms   = Hash_Keys(updates);
+        Vec_Sort(terms);
+        DelWriter_Delete_By_Terms(ivars->del_writer, field, terms);
+        DECREF(terms);
+    }
+    DECREF(iter);
+
+    Hash_Clear(ivars->pending_updates);
+}
+
 void
 Indexer_Delete_By_Query_IMP(Indexer *self, Query *query) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
@@ -401,10 +511,21 @@ S_maybe_merge(Indexer *self, Vector *seg_readers) {
     IndexerIVARS *const ivars = Indexer_IVARS(self);
     bool      merge_happened  = false;
     uint32_t  num_seg_readers = Vec_Get_Size(seg_readers);
-    Lock     *merge_lock      = IxManager_Make_Merge_Lock(ivars->manager);
-    bool      got_merge_lock  = Lock_Obtain(merge_lock);
+    Lock     *merge_lock;
+    bool      got_merge_lock;
     int64_t   cutoff;
 
+    // When merging has been handed off to a background merger, leave the
+    // merge lock alone and only write out deletions.
+    if (IxManager_Get_Defer_Merges(ivars->manager) && !ivars->optimize) {
+        if (DelWriter_Updated(ivars->del_writer)) {
+            DelWriter_Finish(ivars->del_writer);
+        }
+        return false;
+    }
+
+    merge_lock     = IxManager_Make_Merge_Lock(ivars->manager);
+    got_merge_lock = Lock_Obtain(merge_lock);
     if (got_merge_lock) {
         ivars->merge_lock = merge_lock;
         cutoff = 0;
@@ -486,11 +607,16 @@ Indexer_Prepare_Commit_IMP(Indexer *self) {
     Vector   *seg_readers     = PolyReader_Get_Seg_Readers(ivars->polyreader);
     uint32_t  num_seg_readers = Vec_Get_Size(seg_readers);
     bool      merge_happened  = false;
+    uint64_t  start           = Clock_microseconds();
 
     if (!ivars->write_lock || ivars->prepared) {
         THROW(ERR, "Can't call Prepare_Commit() more than once");
     }
 
+    // Apply buffered updates before merging, so that merges see their
+    // deletions.
+    S_flush_pending_updates(self);
+
     // Merge existing index data.
     if (num_seg_readers) {
         merge_happened = S_maybe_merge(self, seg_readers);
@@ -517,19 +643,35 @@ Indexer_Prepare_Commit_IMP(Indexer *self) {
         String *new_schema_name = Str_newf("schema_%s.json", base36);
 
         // Finish the segment, write schema file.
+        bool binary = IxManager_Get_Binary_Metadata(ivars->manager);
+        Seg_Set_Binary_Metadata(ivars->segment, binary);
+        Snapshot_Set_Binary_Metadata(snapshot, binary);
         SegWriter_Finish(ivars->seg_writer);
-        Schema_Write(schema, folder, new_schema_name);
+        Schema_Write(schema, folder, new_schema_name, binary);
         String *old_schema_name = S_find_schema_file(snapshot);
         if (old_schema_name) {
             Snapshot_Delete_Entry(snapshot, old_schema_name);
         }
         Snapshot_Add_Entry(snapshot, new_schema_name);
-        DECREF(new_schema_name);
 
         // Write temporary snapshot file.
         Folder_Delete(folder, ivars->snapfile);
         Snapshot_Write_File(snapshot, folder, ivars->snapfile);
 
+        // Make everything the snapshot will publish durable before the
+        // rename publishes it.
+        Vector *new_files = Vec_new(3);
+        String *seg_name  = Seg_Get_Name(ivars->segment);
+        if (Folder_Exists(folder, seg_name)) {
+            Vec_Push(new_files, INCREF(seg_name));
+        }
+        Vec_Push(new_files, INCREF(new_schema_name));
+        Vec_Push(new_files, INCREF(ivars->snapfile));
+        ivars->sync_usec += IxManager_Sync_Files(ivars->manager, folder,
+                                                 new_files);
+        DECREF(new_files);
+        DECREF(new_schema_name);
+
         ivars->needs_commit = true;
     }
 
@@ -537,6 +679,7 @@ Indexer_Prepare_Commit_IMP(Indexer *self) {
     PolyReader_Close(ivars->polyreader);
 
     ivars->prepared = true;
+    ivars->commit_usec += Clock_microseconds() - start;
 }
 
 void
@@ -552,6 +695,7 @@ Indexer_Commit_IMP(Indexer *self) {
         Indexer_Prepare_Commit(self);
     }
 
+    uint64_t start = Clock_microseconds();
     if (ivars->needs_commit) {
         bool success;
 
@@ -568,6 +712,7 @@ Indexer_Commit_IMP(Indexer *self) {
         success = Folder_Rename(ivars->folder, temp_snapfile, ivars->snapfile);
         DECREF(temp_snapfile);
         if (!success) { RETHROW(INCREF(Err_get_error())); }
+        ivars->sync_usec += S_sync_index_dir(self);
 
         // Purge obsolete files.
         FilePurger_Purge(ivars->file_purger);
@@ -576,6 +721,23 @@ Indexer_Commit_IMP(Indexer *self) {
     // Release locks, invalidating the Indexer.
     S_release_merge_lock(self);
     S_release_write_lock(self);
+
+    if (ivars->needs_commit) {
+        ivars->commit_usec += Clock_microseconds() - start;
+        IxManager_Report_Commit(ivars->manager, ivars->commit_usec,
+                                ivars->sync_usec);
+    }
+}
+
+static uint64_t
+S_sync_index_dir(Indexer *self) {
+    IndexerIVARS *const ivars = Indexer_IVARS(self);
+    Vector *paths = Vec_new(1);
+    Vec_Push(paths, (Obj*)Str_new_from_trusted_utf8("", 0));
+    uint64_t usec = IxManager_Sync_Files(ivars->manager, ivars->folder,
+                                         paths);
+    DECREF(paths);
+    return usec;
 }
 
 Schema*
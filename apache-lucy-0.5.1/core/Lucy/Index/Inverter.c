@@ -16,13 +16,17 @@
 
 #define C_LUCY_INVERTER
 #define C_LUCY_INVERTERENTRY
+#define C_LUCY_DOCBUILDER
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/Inverter.h"
 #include "Lucy/Analysis/Analyzer.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
+#include "Lucy/Analysis/ShingleFilter.h"
 #include "Lucy/Analysis/Token.h"
 #include "Lucy/Analysis/Inversion.h"
 #include "Lucy/Document/Doc.h"
+#include "Lucy/Document/DocBuilder.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Plan/FieldType.h"
@@ -98,6 +102,41 @@ Inverter_Set_Doc_IMP(Inverter *self, Doc *doc) {
     ivars->doc = (Doc*)INCREF(doc);
 }
 
+void
+Inverter_Invert_Built_IMP(Inverter *self, DocBuilder *builder) {
+    InverterIVARS *const ivars = Inverter_IVARS(self);
+    DocBuilderIVARS *const builder_ivars = DocBuilder_IVARS(builder);
+    if (builder_ivars->segment != ivars->segment) {
+        THROW(ERR, "DocBuilder belongs to a different Segment");
+    }
+
+    // Prepare for the new doc.
+    Inverter_Clear(self);
+
+    // The builder has already resolved field numbers and checked value
+    // types, so go straight to the cached entries.
+    for (uint32_t slot = 0; slot < builder_ivars->num_slots; slot++) {
+        Obj *value = builder_ivars->values[slot];
+        if (!value) { continue; }
+
+        int32_t field_num = builder_ivars->field_nums[slot];
+        InverterEntry *entry
+            = (InverterEntry*)Vec_Fetch(ivars->entry_pool, field_num);
+        if (!entry) {
+            String *field = (String*)Vec_Fetch(builder_ivars->fields, slot);
+            entry = InvEntry_new(ivars->schema, field, field_num);
+            Vec_Store(ivars->entry_pool, field_num, (Obj*)entry);
+        }
+        InverterEntryIVARS *const entry_ivars = InvEntry_IVARS(entry);
+        if (entry_ivars->value != value) {
+            DECREF(entry_ivars->value);
+            entry_ivars->value = INCREF(value);
+        }
+
+        Inverter_Add_Field(self, entry);
+    }
+}
+
 void
 Inverter_Set_Boost_IMP(Inverter *self, float boost) {
     Inverter_IVARS(self)->boost = boost;
@@ -110,7 +149,18 @@ Inverter_Get_Boost_IMP(Inverter *self) {
 
 Doc*
 Inverter_Get_Doc_IMP(Inverter *self) {
-    return Inverter_IVARS(self)->doc;
+    InverterIVARS *const ivars = Inverter_IVARS(self);
+
+    // Docs inverted from a DocBuilder only get a Doc if someone asks.
+    if (!ivars->doc && Vec_Get_Size(ivars->entries)) {
+        ivars->doc = Doc_new(NULL, 0);
+        for (uint32_t i = 0, max = Vec_Get_Size(ivars->entries); i < max; i++) {
+            InverterEntryIVARS *const entry_ivars
+                = InvEntry_IVARS((InverterEntry*)Vec_Fetch(ivars->entries, i));
+            Doc_Store(ivars->doc, entry_ivars->field, entry_ivars->value);
+        }
+    }
+    return ivars->doc;
 }
 
 String*
@@ -150,6 +200,52 @@ Inverter_Get_Inversion_IMP(Inverter *self) {
 }
 
 
+static bool
+S_ends_in_shingle_filter(Analyzer *analyzer) {
+    if (Analyzer_is_a(analyzer, POLYANALYZER)) {
+        Vector *analyzers = PolyAnalyzer_Get_Analyzers((PolyAnalyzer*)analyzer);
+        uint32_t size = Vec_Get_Size(analyzers);
+        analyzer = size ? (Analyzer*)Vec_Fetch(analyzers, size - 1) : NULL;
+    }
+    return analyzer && Analyzer_is_a(analyzer, SHINGLEFILTER);
+}
+
+// Fetch the entry for a FullTextType's shingle field, which the Doc won't
+// have supplied.  The shingle field's spec is checked the first time it's
+// needed, since a companion field without a ShingleFilter would silently
+// index single words.
+static InverterEntry*
+S_fetch_shingle_entry(InverterIVARS *ivars, String *field) {
+    int32_t field_num = Seg_Field_Num(ivars->segment, field);
+    InverterEntry *entry = field_num
+                           ? (InverterEntry*)Vec_Fetch(ivars->entry_pool,
+                                                       field_num)
+                           : NULL;
+    if (entry) { return entry; }
+
+    FieldType *type = Schema_Fetch_Type(ivars->schema, field);
+    if (!type) {
+        THROW(ERR, "Unknown shingle field: '%o'", field);
+    }
+    if (!FType_is_a(type, FULLTEXTTYPE) || !FType_Indexed(type)
+        || FType_Stored(type)
+        || FullTextType_Get_Shingle_Field((FullTextType*)type)
+       ) {
+        THROW(ERR, "Shingle field '%o' must be an indexed, unstored "
+              "FullTextType without a shingle field of its own", field);
+    }
+    Analyzer *analyzer = FullTextType_Get_Analyzer((FullTextType*)type);
+    if (!S_ends_in_shingle_filter(analyzer)) {
+        THROW(ERR, "Shingle field '%o' must have an analyzer ending in a "
+              "ShingleFilter", field);
+    }
+
+    if (!field_num) { field_num = Seg_Add_Field(ivars->segment, field); }
+    entry = InvEntry_new(ivars->schema, field, field_num);
+    Vec_Store(ivars->entry_pool, field_num, (Obj*)entry);
+    return entry;
+}
+
 void
 Inverter_Add_Field_IMP(Inverter *self, InverterEntry *entry) {
     InverterIVARS *const ivars = Inverter_IVARS(self);
@@ -177,6 +273,23 @@ Inverter_Add_Field_IMP(Inverter *self, InverterEntry *entry) {
     // Prime the iterator.
     Vec_Push(ivars->entries, INCREF(entry));
     ivars->sorted = false;
+
+    // Index the same value as shingles, if the field type asks for it.
+    if (FType_is_a(entry_ivars->type, FULLTEXTTYPE)) {
+        String *shingle_field = FullTextType_Get_Shingle_Field(
+                                    (FullTextType*)entry_ivars->type);
+        if (shingle_field) {
+            InverterEntry *shingle_entry
+                = S_fetch_shingle_entry(ivars, shingle_field);
+            InverterEntryIVARS *const shingle_ivars
+                = InvEntry_IVARS(shingle_entry);
+            if (shingle_ivars->value != entry_ivars->value) {
+                DECREF(shingle_ivars->value);
+                shingle_ivars->value = INCREF(entry_ivars->value);
+            }
+            Inverter_Add_Field(self, shingle_entry);
+        }
+    }
 }
 
 void
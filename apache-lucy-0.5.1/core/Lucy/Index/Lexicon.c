@@ -36,7 +36,66 @@ void
 Lex_Destroy_IMP(Lexicon *self) {
     LexiconIVARS *const ivars = Lex_IVARS(self);
     DECREF(ivars->field);
+    DECREF(ivars->prefix);
+    DECREF(ivars->upper);
     SUPER_DESTROY(self, LEXICON);
 }
 
+// If the term we landed on is already out of bounds, so is every term after
+// it; a single call to Next() lets the subclass exhaust itself.
+static void
+S_enforce_bounds(Lexicon *self) {
+    Obj *term = Lex_Get_Term(self);
+    if (term && Lex_Past_Bounds(self, term)) {
+        Lex_Next(self);
+    }
+}
+
+void
+Lex_Seek_Prefix_IMP(Lexicon *self, String *prefix) {
+    Lex_Seek(self, (Obj*)prefix); // lifts any earlier bounds
+    LexiconIVARS *const ivars = Lex_IVARS(self);
+    ivars->prefix = (String*)INCREF(prefix);
+    S_enforce_bounds(self);
+}
+
+void
+Lex_Seek_Range_IMP(Lexicon *self, Obj *lower, Obj *upper,
+                   bool include_upper) {
+    Lex_Seek(self, lower); // lifts any earlier bounds
+    LexiconIVARS *const ivars = Lex_IVARS(self);
+    ivars->upper         = upper ? INCREF(upper) : NULL;
+    ivars->include_upper = include_upper;
+    S_enforce_bounds(self);
+}
+
+bool
+Lex_Past_Bounds_IMP(Lexicon *self, Obj *term) {
+    LexiconIVARS *const ivars = Lex_IVARS(self);
+    if (term == NULL) { return false; }
+    if (ivars->prefix) {
+        if (!Obj_is_a(term, STRING)
+            || !Str_Starts_With((String*)term, ivars->prefix)
+           ) {
+            return true;
+        }
+    }
+    if (ivars->upper) {
+        int32_t comparison = Obj_Compare_To(term, ivars->upper);
+        if (comparison > 0 || (comparison == 0 && !ivars->include_upper)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+Lex_Clear_Bounds_IMP(Lexicon *self) {
+    LexiconIVARS *const ivars = Lex_IVARS(self);
+    DECREF(ivars->prefix);
+    DECREF(ivars->upper);
+    ivars->prefix = NULL;
+    ivars->upper  = NULL;
+}
+
 
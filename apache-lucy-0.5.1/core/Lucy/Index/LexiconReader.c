@@ -20,14 +20,20 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/LexiconReader.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
 #include "Lucy/Index/PolyLexicon.h"
 #include "Lucy/Index/SegLexicon.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/TermIndex.h"
 #include "Lucy/Index/TermInfo.h"
 #include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Util/BloomFilter.h"
+#include "Lucy/Util/Json.h"
 
 LexiconReader*
 LexReader_init(LexiconReader *self, Schema *schema, Folder *folder,
@@ -45,6 +51,14 @@ LexReader_Aggregator_IMP(LexiconReader *self, Vector *readers,
     return (LexiconReader*)PolyLexReader_new(readers, offsets);
 }
 
+bool
+LexReader_Might_Contain_IMP(LexiconReader *self, String *field, Obj *term) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(field);
+    UNUSED_VAR(term);
+    return true;
+}
+
 PolyLexiconReader*
 PolyLexReader_new(Vector *readers, I32Array *offsets) {
     PolyLexiconReader *self
@@ -125,6 +139,19 @@ PolyLexReader_Doc_Freq_IMP(PolyLexiconReader *self, String *field,
     return doc_freq;
 }
 
+bool
+PolyLexReader_Might_Contain_IMP(PolyLexiconReader *self, String *field,
+                                Obj *term) {
+    PolyLexiconReaderIVARS *const ivars = PolyLexReader_IVARS(self);
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->readers); i < max; i++) {
+        LexiconReader *reader = (LexiconReader*)Vec_Fetch(ivars->readers, i);
+        if (reader && LexReader_Might_Contain(reader, field, term)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 DefaultLexiconReader*
 DefLexReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
                  Vector *segments, int32_t seg_tick) {
@@ -156,6 +183,37 @@ S_has_data(Schema *schema, Folder *folder, Segment *segment, String *field) {
     }
 }
 
+// Load the bloom filter for a primary key field, if the segment has one.
+// Segments written before the field was marked as a primary key won't.
+static BloomFilter*
+S_load_bloom(Schema *schema, Folder *folder, Segment *segment,
+             String *field) {
+    FieldType *type = Schema_Fetch_Type(schema, field);
+    if (!Obj_is_a((Obj*)type, STRINGTYPE)
+        || !StringType_Primary_Key((StringType*)type)
+       ) {
+        return NULL;
+    }
+
+    int32_t  field_num = Seg_Field_Num(segment, field);
+    String  *seg_name  = Seg_Get_Name(segment);
+    String  *file = Str_newf("%o/lexicon-%i32.bloom", seg_name, field_num);
+    BloomFilter *bloom = NULL;
+    if (Folder_Exists(folder, file)) {
+        InStream *instream = Folder_Open_In(folder, file);
+        if (!instream) {
+            DECREF(file);
+            RETHROW(INCREF(Err_get_error()));
+        }
+        bloom = Bloom_Deserialize((BloomFilter*)Class_Make_Obj(BLOOMFILTER),
+                                  instream);
+        InStream_Close(instream);
+        DECREF(instream);
+    }
+    DECREF(file);
+    return bloom;
+}
+
 DefaultLexiconReader*
 DefLexReader_init(DefaultLexiconReader *self, Schema *schema, Folder *folder,
                   Snapshot *snapshot, Vector *segments, int32_t seg_tick) {
@@ -166,13 +224,22 @@ DefLexReader_init(DefaultLexiconReader *self, Schema *schema, Folder *folder,
     DefaultLexiconReaderIVARS *const ivars = DefLexReader_IVARS(self);
     Segment *segment = DefLexReader_Get_Segment(self);
 
-    // Build an array of SegLexicon objects.
-    ivars->lexicons = Vec_new(Schema_Num_Fields(schema));
+    // Build an array of SegLexicon objects sharing one in-memory TermIndex
+    // per field, plus bloom filters for primary key fields.
+    ivars->lexicons     = Vec_new(Schema_Num_Fields(schema));
+    ivars->term_indexes = Vec_new(Schema_Num_Fields(schema));
+    ivars->blooms       = Vec_new(0);
     for (uint32_t i = 1, max = Schema_Num_Fields(schema) + 1; i < max; i++) {
         String *field = Seg_Field_Name(segment, i);
         if (field && S_has_data(schema, folder, segment, field)) {
-            SegLexicon *lexicon = SegLex_new(schema, folder, segment, field);
+            TermIndex *term_index
+                = TermIx_new(schema, folder, segment, field);
+            Vec_Store(ivars->term_indexes, i, (Obj*)term_index);
+            SegLexicon *lexicon
+                = SegLex_new(schema, folder, segment, field, term_index);
             Vec_Store(ivars->lexicons, i, (Obj*)lexicon);
+            BloomFilter *bloom = S_load_bloom(schema, folder, segment, field);
+            if (bloom) { Vec_Store(ivars->blooms, i, (Obj*)bloom); }
         }
     }
 
@@ -183,13 +250,19 @@ void
 DefLexReader_Close_IMP(DefaultLexiconReader *self) {
     DefaultLexiconReaderIVARS *const ivars = DefLexReader_IVARS(self);
     DECREF(ivars->lexicons);
-    ivars->lexicons = NULL;
+    DECREF(ivars->term_indexes);
+    DECREF(ivars->blooms);
+    ivars->lexicons     = NULL;
+    ivars->term_indexes = NULL;
+    ivars->blooms       = NULL;
 }
 
 void
 DefLexReader_Destroy_IMP(DefaultLexiconReader *self) {
     DefaultLexiconReaderIVARS *const ivars = DefLexReader_IVARS(self);
     DECREF(ivars->lexicons);
+    DECREF(ivars->term_indexes);
+    DECREF(ivars->blooms);
     SUPER_DESTROY(self, DEFAULTLEXICONREADER);
 }
 
@@ -202,8 +275,10 @@ DefLexReader_Lexicon_IMP(DefaultLexiconReader *self, String *field,
     SegLexicon *lexicon   = NULL;
 
     if (orig) { // i.e. has data
-        lexicon
-            = SegLex_new(ivars->schema, ivars->folder, ivars->segment, field);
+        TermIndex *term_index
+            = (TermIndex*)Vec_Fetch(ivars->term_indexes, field_num);
+        lexicon = SegLex_new(ivars->schema, ivars->folder, ivars->segment,
+                             field, term_index);
         SegLex_Seek(lexicon, term);
     }
 
@@ -217,8 +292,10 @@ S_find_tinfo(DefaultLexiconReader *self, String *field, Obj *target) {
         int32_t field_num = Seg_Field_Num(ivars->segment, field);
         SegLexicon *lexicon
             = (SegLexicon*)Vec_Fetch(ivars->lexicons, field_num);
+        BloomFilter *bloom
+            = (BloomFilter*)Vec_Fetch(ivars->blooms, field_num);
 
-        if (lexicon) {
+        if (lexicon && (!bloom || Bloom_Might_Contain(bloom, target))) {
             // Iterate until the result is ge the term.
             SegLex_Seek(lexicon, target);
 
@@ -246,4 +323,100 @@ DefLexReader_Doc_Freq_IMP(DefaultLexiconReader *self, String *field,
     return tinfo ? TInfo_Get_Doc_Freq(tinfo) : 0;
 }
 
+bool
+DefLexReader_Might_Contain_IMP(DefaultLexiconReader *self, String *field,
+                               Obj *term) {
+    DefaultLexiconReaderIVARS *const ivars = DefLexReader_IVARS(self);
+    if (field == NULL || term == NULL) { return true; }
+    int32_t field_num = Seg_Field_Num(ivars->segment, field);
+    if (!field_num || !Vec_Fetch(ivars->lexicons, field_num)) {
+        // No terms at all for this field in this segment.
+        return false;
+    }
+    BloomFilter *bloom = (BloomFilter*)Vec_Fetch(ivars->blooms, field_num);
+    return bloom ? Bloom_Might_Contain(bloom, term) : true;
+}
+
+static int64_t
+S_fetch_count(Hash *counts, String *field) {
+    Obj *count = counts ? Hash_Fetch(counts, field) : NULL;
+    return count ? Json_obj_to_i64(count) : 0;
+}
+
+Hash*
+DefLexReader_Stats_IMP(DefaultLexiconReader *self) {
+    DefaultLexiconReaderIVARS *const ivars = DefLexReader_IVARS(self);
+    Folder  *folder   = ivars->folder;
+    String  *seg_name = Seg_Get_Name(ivars->segment);
+    Hash    *metadata
+        = (Hash*)Seg_Fetch_Metadata_Utf8(ivars->segment, "lexicon", 7);
+    Hash    *counts = NULL;
+    Hash    *ix_counts = NULL;
+    Hash    *posting_counts = NULL;
+    Hash    *fields   = Hash_new(0);
+    Hash    *stats    = Hash_new(0);
+    int64_t  bytes    = 0;
+    int64_t  resident = 0;
+
+    if (metadata && Obj_is_a((Obj*)metadata, HASH)) {
+        counts         = (Hash*)Hash_Fetch_Utf8(metadata, "counts", 6);
+        ix_counts      = (Hash*)Hash_Fetch_Utf8(metadata, "index_counts", 12);
+        posting_counts = (Hash*)Hash_Fetch_Utf8(metadata, "posting_counts",
+                                                14);
+    }
+
+    uint32_t num_lexicons = ivars->lexicons ? Vec_Get_Size(ivars->lexicons) : 0;
+    for (uint32_t i = 1; i < num_lexicons; i++) {
+        if (!Vec_Fetch(ivars->lexicons, i)) { continue; }
+        String *field = Seg_Field_Name(ivars->segment, (int32_t)i);
+        Hash   *field_stats = Hash_new(0);
+        int32_t field_num = (int32_t)i;
+        String *path = Str_newf("%o/lexicon-%i32.dat", seg_name, field_num);
+        int64_t dat_bytes = Folder_File_Length(folder, path);
+        DECREF(path);
+        path = Str_newf("%o/lexicon-%i32.ix", seg_name, field_num);
+        int64_t ix_bytes = Folder_File_Length(folder, path);
+        DECREF(path);
+        path = Str_newf("%o/lexicon-%i32.ixix", seg_name, field_num);
+        ix_bytes += Folder_File_Length(folder, path);
+        DECREF(path);
+        TermIndex *term_index
+            = (TermIndex*)Vec_Fetch(ivars->term_indexes, i);
+        int64_t term_index_bytes = TermIx_Get_Bytes(term_index);
+        int64_t bloom_bytes = 0;
+        if (Vec_Fetch(ivars->blooms, i)) {
+            path = Str_newf("%o/lexicon-%i32.bloom", seg_name, field_num);
+            bloom_bytes = Folder_File_Length(folder, path);
+            DECREF(path);
+        }
+
+        Hash_Store_Utf8(field_stats, "terms", 5,
+                        (Obj*)Int_new(S_fetch_count(counts, field)));
+        Hash_Store_Utf8(field_stats, "index_terms", 11,
+                        (Obj*)Int_new(S_fetch_count(ix_counts, field)));
+        if (posting_counts) {
+            // Older segments don't record postings counts.
+            Hash_Store_Utf8(field_stats, "postings", 8,
+                            (Obj*)Int_new(S_fetch_count(posting_counts,
+                                                        field)));
+        }
+        Hash_Store_Utf8(field_stats, "lexicon_bytes", 13,
+                        (Obj*)Int_new(dat_bytes + ix_bytes + bloom_bytes));
+        Hash_Store_Utf8(field_stats, "lexicon_index_bytes", 19,
+                        (Obj*)Int_new(ix_bytes));
+        Hash_Store_Utf8(field_stats, "term_index_bytes", 16,
+                        (Obj*)Int_new(term_index_bytes));
+        Hash_Store_Utf8(field_stats, "bloom_bytes", 11,
+                        (Obj*)Int_new(bloom_bytes));
+        Hash_Store(fields, field, (Obj*)field_stats);
+
+        bytes    += dat_bytes + ix_bytes + bloom_bytes;
+        resident += term_index_bytes + bloom_bytes;
+    }
+
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(resident));
+    Hash_Store_Utf8(stats, "fields", 6, (Obj*)fields);
+    return stats;
+}
 
@@ -21,6 +21,7 @@
 #include "Clownfish/CharBuf.h"
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Posting/MatchPosting.h"
 #include "Lucy/Index/Segment.h"
@@ -31,6 +32,7 @@
 #include "Lucy/Plan/Architecture.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/BloomFilter.h"
 
 int32_t LexWriter_current_file_format = 3;
 
@@ -64,7 +66,13 @@ LexWriter_init(LexiconWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->ixix_file          = NULL;
     ivars->counts             = Hash_new(0);
     ivars->ix_counts          = Hash_new(0);
+    ivars->posting_counts     = Hash_new(0);
+    ivars->posting_count      = 0;
+    ivars->key_hashes         = NULL;
+    ivars->num_key_hashes     = 0;
+    ivars->key_hashes_cap     = 0;
     ivars->temp_mode          = false;
+    ivars->primary_key        = false;
     ivars->term_stepper       = NULL;
     ivars->tinfo_stepper      = (TermStepper*)MatchTInfoStepper_new(schema);
 
@@ -84,6 +92,8 @@ LexWriter_Destroy_IMP(LexiconWriter *self) {
     DECREF(ivars->ixix_out);
     DECREF(ivars->counts);
     DECREF(ivars->ix_counts);
+    DECREF(ivars->posting_counts);
+    FREEMEM(ivars->key_hashes);
     SUPER_DESTROY(self, LEXICONWRITER);
 }
 
@@ -119,8 +129,23 @@ LexWriter_Add_Term_IMP(LexiconWriter* self, Obj* term_text, TermInfo* tinfo) {
     TermStepper_Write_Delta(ivars->term_stepper, dat_out, term_text);
     TermStepper_Write_Delta(ivars->tinfo_stepper, dat_out, (Obj*)tinfo);
 
-    // Track number of terms.
+    // Hash primary keys for the field's bloom filter.
+    if (ivars->primary_key) {
+        if (ivars->num_key_hashes == ivars->key_hashes_cap) {
+            size_t amount = ivars->key_hashes_cap < 64
+                            ? 64
+                            : ivars->key_hashes_cap * 2;
+            ivars->key_hashes = (uint64_t*)REALLOCATE(
+                                    ivars->key_hashes, amount * sizeof(uint64_t));
+            ivars->key_hashes_cap = amount;
+        }
+        ivars->key_hashes[ivars->num_key_hashes++]
+            = Bloom_hash_term(term_text);
+    }
+
+    // Track number of terms and postings.
     ivars->count++;
+    ivars->posting_count += TInfo_Get_Doc_Freq(tinfo);
 }
 
 void
@@ -147,11 +172,36 @@ LexWriter_Start_Field_IMP(LexiconWriter *self, int32_t field_num) {
     ivars->ixix_out = Folder_Open_Out(folder, ivars->ixix_file);
     if (!ivars->ixix_out) { RETHROW(INCREF(Err_get_error())); }
 
-    // Initialize count and ix_count, term stepper and term info stepper.
-    ivars->count    = 0;
-    ivars->ix_count = 0;
+    // Initialize counts, term stepper and term info stepper.
+    ivars->count         = 0;
+    ivars->ix_count      = 0;
+    ivars->posting_count = 0;
     ivars->term_stepper = FType_Make_Term_Stepper(type);
     TermStepper_Reset(ivars->tinfo_stepper);
+
+    // Primary keys get a bloom filter.
+    ivars->num_key_hashes = 0;
+    ivars->primary_key = Obj_is_a((Obj*)type, STRINGTYPE)
+                         && StringType_Primary_Key((StringType*)type);
+}
+
+static void
+S_write_bloom(LexiconWriter *self, int32_t field_num) {
+    LexiconWriterIVARS *const ivars = LexWriter_IVARS(self);
+    Folder *folder   = LexWriter_Get_Folder(self);
+    String *seg_name = Seg_Get_Name(ivars->segment);
+    String *filename = Str_newf("%o/lexicon-%i32.bloom", seg_name, field_num);
+    BloomFilter *bloom = Bloom_new((uint32_t)ivars->num_key_hashes, 10);
+    for (size_t i = 0; i < ivars->num_key_hashes; i++) {
+        Bloom_Add_Hash(bloom, ivars->key_hashes[i]);
+    }
+    OutStream *outstream = Folder_Open_Out(folder, filename);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+    Bloom_Serialize(bloom, outstream);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    DECREF(bloom);
+    DECREF(filename);
 }
 
 void
@@ -163,6 +213,8 @@ LexWriter_Finish_Field_IMP(LexiconWriter *self, int32_t field_num) {
     Hash_Store(ivars->counts, field, (Obj*)Str_newf("%i32", ivars->count));
     Hash_Store(ivars->ix_counts, field,
                (Obj*)Str_newf("%i32", ivars->ix_count));
+    Hash_Store(ivars->posting_counts, field,
+               (Obj*)Str_newf("%i64", ivars->posting_count));
 
     // Close streams.
     OutStream_Close(ivars->dat_out);
@@ -178,6 +230,12 @@ LexWriter_Finish_Field_IMP(LexiconWriter *self, int32_t field_num) {
     // Close term stepper.
     DECREF(ivars->term_stepper);
     ivars->term_stepper = NULL;
+
+    if (ivars->primary_key) {
+        S_write_bloom(self, field_num);
+        ivars->num_key_hashes = 0;
+        ivars->primary_key    = false;
+    }
 }
 
 void
@@ -253,6 +311,8 @@ LexWriter_Metadata_IMP(LexiconWriter *self) {
 
     Hash_Store_Utf8(metadata, "counts", 6, (Obj*)counts);
     Hash_Store_Utf8(metadata, "index_counts", 12, (Obj*)ix_counts);
+    Hash_Store_Utf8(metadata, "posting_counts", 14,
+                    INCREF(ivars->posting_counts));
 
     return metadata;
 }
@@ -0,0 +1,121 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_MEMORYBUDGET
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/MemoryBudget.h"
+#include "Lucy/Index/DataWriter.h"
+
+static uint64_t default_limit = 0x1400000; // 20 MiB
+
+static uint64_t
+S_total_consumed(Vector *writers);
+
+MemoryBudget*
+MemBudget_new(uint64_t limit) {
+    MemoryBudget *self = (MemoryBudget*)Class_Make_Obj(MEMORYBUDGET);
+    return MemBudget_init(self, limit);
+}
+
+MemoryBudget*
+MemBudget_init(MemoryBudget *self, uint64_t limit) {
+    MemoryBudgetIVARS *const ivars = MemBudget_IVARS(self);
+    ivars->limit       = limit ? limit : default_limit;
+    ivars->usage       = 0;
+    ivars->peak_usage  = 0;
+    ivars->flush_count = 0;
+    return self;
+}
+
+void
+MemBudget_set_default_limit(uint64_t limit) {
+    default_limit = limit;
+}
+
+static uint64_t
+S_total_consumed(Vector *writers) {
+    uint64_t total = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(writers); i < max; i++) {
+        DataWriter *writer = (DataWriter*)Vec_Fetch(writers, i);
+        total += DataWriter_Mem_Consumed(writer);
+    }
+    return total;
+}
+
+uint32_t
+MemBudget_Balance_IMP(MemoryBudget *self, Vector *writers) {
+    MemoryBudgetIVARS *const ivars = MemBudget_IVARS(self);
+    uint64_t usage = S_total_consumed(writers);
+    uint32_t num_flushes = 0;
+
+    if (usage > ivars->peak_usage) { ivars->peak_usage = usage; }
+
+    while (usage > ivars->limit) {
+        // Find the single largest buffer among all writers.
+        DataWriter *biggest = NULL;
+        uint64_t    biggest_size = 0;
+        for (uint32_t i = 0, max = Vec_Get_Size(writers); i < max; i++) {
+            DataWriter *writer = (DataWriter*)Vec_Fetch(writers, i);
+            uint64_t size = DataWriter_Largest_Buffer(writer);
+            if (size > biggest_size) {
+                biggest      = writer;
+                biggest_size = size;
+            }
+        }
+        if (!biggest) { break; } // Nothing left which can be flushed.
+
+        DataWriter_Flush_Largest(biggest);
+        ivars->flush_count++;
+        num_flushes++;
+
+        // Measure again rather than trusting biggest_size, since a flush may
+        // release more or less than its buffer reported.
+        uint64_t new_usage = S_total_consumed(writers);
+        if (new_usage >= usage) { break; } // Guard against livelock.
+        usage = new_usage;
+    }
+
+    ivars->usage = usage;
+    return num_flushes;
+}
+
+void
+MemBudget_Set_Limit_IMP(MemoryBudget *self, uint64_t limit) {
+    MemBudget_IVARS(self)->limit = limit ? limit : default_limit;
+}
+
+uint64_t
+MemBudget_Get_Limit_IMP(MemoryBudget *self) {
+    return MemBudget_IVARS(self)->limit;
+}
+
+uint64_t
+MemBudget_Get_Usage_IMP(MemoryBudget *self) {
+    return MemBudget_IVARS(self)->usage;
+}
+
+uint64_t
+MemBudget_Get_Peak_Usage_IMP(MemoryBudget *self) {
+    return MemBudget_IVARS(self)->peak_usage;
+}
+
+uint64_t
+MemBudget_Get_Flush_Count_IMP(MemoryBudget *self) {
+    return MemBudget_IVARS(self)->flush_count;
+}
+
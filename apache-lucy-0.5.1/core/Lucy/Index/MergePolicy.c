@@ -0,0 +1,77 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_MERGEPOLICY
+#define C_LUCY_MERGECANDIDATE
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/MergePolicy.h"
+
+MergePolicy*
+MergePolicy_init(MergePolicy *self) {
+    ABSTRACT_CLASS_CHECK(self, MERGEPOLICY);
+    return self;
+}
+
+MergeCandidate*
+MergeCand_new(int64_t size, int64_t doc_max, int64_t del_count) {
+    MergeCandidate *self = (MergeCandidate*)Class_Make_Obj(MERGECANDIDATE);
+    return MergeCand_init(self, size, doc_max, del_count);
+}
+
+MergeCandidate*
+MergeCand_init(MergeCandidate *self, int64_t size, int64_t doc_max,
+               int64_t del_count) {
+    MergeCandidateIVARS *const ivars = MergeCand_IVARS(self);
+    ivars->size      = size < 0 ? 0 : size;
+    ivars->doc_max   = doc_max < 0 ? 0 : doc_max;
+    ivars->del_count = del_count < 0
+                       ? 0
+                       : del_count > ivars->doc_max
+                       ? ivars->doc_max
+                       : del_count;
+    return self;
+}
+
+int64_t
+MergeCand_Get_Size_IMP(MergeCandidate *self) {
+    return MergeCand_IVARS(self)->size;
+}
+
+int64_t
+MergeCand_Get_Doc_Max_IMP(MergeCandidate *self) {
+    return MergeCand_IVARS(self)->doc_max;
+}
+
+int64_t
+MergeCand_Get_Del_Count_IMP(MergeCandidate *self) {
+    return MergeCand_IVARS(self)->del_count;
+}
+
+double
+MergeCand_Del_Ratio_IMP(MergeCandidate *self) {
+    MergeCandidateIVARS *const ivars = MergeCand_IVARS(self);
+    if (!ivars->doc_max) { return 0.0; }
+    return (double)ivars->del_count / (double)ivars->doc_max;
+}
+
+double
+MergeCand_Live_Size_IMP(MergeCandidate *self) {
+    MergeCandidateIVARS *const ivars = MergeCand_IVARS(self);
+    return (double)ivars->size * (1.0 - MergeCand_Del_Ratio(self));
+}
+
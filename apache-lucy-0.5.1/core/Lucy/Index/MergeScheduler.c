@@ -0,0 +1,317 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_MERGESCHEDULER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/MergeScheduler.h"
+#include "Lucy/Index/BackgroundMerger.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Store/FcntlLockFactory.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/LockFactory.h"
+#include "Lucy/Store/RateLimiter.h"
+#include "Lucy/Util/WorkerThread.h"
+
+// The settings of a TieredMergePolicy.
+typedef struct PolicySettings {
+    bool     copied;
+    uint32_t segs_per_tier;
+    uint32_t max_merge_at_once;
+    int64_t  max_merged_size;
+    int64_t  floor_size;
+    double   deletes_pct_allowed;
+    double   reclaim_deletes_weight;
+} PolicySettings;
+
+/* Everything a worker thread needs, as plain C data.  Clownfish refcounts
+ * aren't thread-safe, so the worker must not touch any object owned by the
+ * scheduler.
+ */
+typedef struct MergeTask {
+    char          *path;
+    size_t         path_len;
+    char          *host;
+    size_t         host_len;
+    double         mb_per_sec;
+    uint32_t       write_lock_timeout;
+    bool           sync_commits;
+    bool           binary_metadata;
+    bool           fcntl_locks;
+    PolicySettings policy;
+    char          *error;
+    void          *thread;
+} MergeTask;
+
+// Body of the worker: build a Folder, IndexManager and BackgroundMerger for
+// a MergeTask and commit.  Runs on the worker thread.
+static void
+S_run_task(void *context);
+
+// Reap the task if it has finished, recording its outcome.  If `block` is
+// true, wait for it first.
+static void
+S_reap(MergeScheduler *self, bool block);
+
+MergeScheduler*
+MergeSched_new(String *path, IndexManager *manager) {
+    MergeScheduler *self = (MergeScheduler*)Class_Make_Obj(MERGESCHEDULER);
+    return MergeSched_init(self, path, manager);
+}
+
+MergeScheduler*
+MergeSched_init(MergeScheduler *self, String *path, IndexManager *manager) {
+    MergeSchedulerIVARS *const ivars = MergeSched_IVARS(self);
+    String *host = manager ? IxManager_Get_Host(manager) : NULL;
+    ivars->path               = Str_Clone(path);
+    ivars->host               = host
+                                ? Str_Clone(host)
+                                : Str_new_from_trusted_utf8("", 0);
+    ivars->write_lock_timeout = manager
+                                ? IxManager_Get_Write_Lock_Timeout(manager)
+                                : 10000;
+    ivars->sync_commits       = manager
+                                ? IxManager_Get_Sync_Commits(manager)
+                                : false;
+    ivars->binary_metadata    = manager
+                                ? IxManager_Get_Binary_Metadata(manager)
+                                : false;
+    MergePolicy *policy       = manager
+                                ? IxManager_Get_Merge_Policy(manager)
+                                : NULL;
+    ivars->merge_policy       = (MergePolicy*)INCREF(policy);
+    LockFactory *lock_factory = manager
+                                ? IxManager_Get_Lock_Factory(manager)
+                                : NULL;
+    ivars->fcntl_locks        = lock_factory
+                                && LockFact_is_a(lock_factory,
+                                                 FCNTLLOCKFACTORY);
+    ivars->mb_per_sec         = 0.0;
+    ivars->merge_count        = 0;
+    ivars->failure_count      = 0;
+    ivars->last_error         = NULL;
+    ivars->task               = NULL;
+    if (policy && !MergePolicy_is_a(policy, TIEREDMERGEPOLICY)) {
+        String *class_name = MergePolicy_get_class_name(policy);
+        DECREF(self);
+        THROW(ERR, "MergeScheduler can't carry a %o to its worker",
+              class_name);
+    }
+    return self;
+}
+
+void
+MergeSched_Destroy_IMP(MergeScheduler *self) {
+    MergeSchedulerIVARS *const ivars = MergeSched_IVARS(self);
+    S_reap(self, true);
+    DECREF(ivars->path);
+    DECREF(ivars->host);
+    DECREF(ivars->last_error);
+    DECREF(ivars->merge_policy);
+    SUPER_DESTROY(self, MERGESCHEDULER);
+}
+
+void
+MergeSched_Set_MB_Per_Sec_IMP(MergeScheduler *self, double mb_per_sec) {
+    MergeSched_IVARS(self)->mb_per_sec = mb_per_sec > 0.0 ? mb_per_sec : 0.0;
+}
+
+double
+MergeSched_Get_MB_Per_Sec_IMP(MergeScheduler *self) {
+    return MergeSched_IVARS(self)->mb_per_sec;
+}
+
+bool
+MergeSched_Schedule_IMP(MergeScheduler *self) {
+    MergeSchedulerIVARS *const ivars = MergeSched_IVARS(self);
+    S_reap(self, false);
+    if (ivars->task) { return false; }
+
+    // Host must differ from that of foreground lock holders in this process,
+    // since lock files are claimed through a temp file named after host and
+    // pid.
+    String *host = Str_Get_Size(ivars->host)
+                   ? Str_newf("%o-bgmerge", ivars->host)
+                   : Str_newf("bgmerge");
+
+    MergeTask *task = (MergeTask*)CALLOCATE(1, sizeof(MergeTask));
+    task->path               = Str_To_Utf8(ivars->path);
+    task->path_len           = Str_Get_Size(ivars->path);
+    task->host               = Str_To_Utf8(host);
+    task->host_len           = Str_Get_Size(host);
+    task->mb_per_sec         = ivars->mb_per_sec;
+    task->write_lock_timeout = ivars->write_lock_timeout;
+    task->sync_commits       = ivars->sync_commits;
+    task->binary_metadata    = ivars->binary_metadata;
+    task->fcntl_locks        = ivars->fcntl_locks;
+    if (ivars->merge_policy) {
+        TieredMergePolicy *policy = (TieredMergePolicy*)ivars->merge_policy;
+        task->policy.copied            = true;
+        task->policy.segs_per_tier     = TieredMP_Get_Segs_Per_Tier(policy);
+        task->policy.max_merge_at_once
+            = TieredMP_Get_Max_Merge_At_Once(policy);
+        task->policy.max_merged_size   = TieredMP_Get_Max_Merged_Size(policy);
+        task->policy.floor_size        = TieredMP_Get_Floor_Size(policy);
+        task->policy.deletes_pct_allowed
+            = TieredMP_Get_Deletes_Pct_Allowed(policy);
+        task->policy.reclaim_deletes_weight
+            = TieredMP_Get_Reclaim_Deletes_Weight(policy);
+    }
+    task->error              = NULL;
+    DECREF(host);
+
+    task->thread = WorkerThread_start(S_run_task, task);
+    if (!task->thread && WorkerThread_enabled()) {
+        FREEMEM(task->path);
+        FREEMEM(task->host);
+        FREEMEM(task);
+        THROW(ERR, "Failed to start merge thread for '%o'", ivars->path);
+    }
+    if (!task->thread) {
+        // No threads on this platform: merge synchronously.
+        S_run_task(task);
+    }
+    ivars->task = task;
+    return true;
+}
+
+bool
+MergeSched_Is_Running_IMP(MergeScheduler *self) {
+    S_reap(self, false);
+    return MergeSched_IVARS(self)->task != NULL;
+}
+
+void
+MergeSched_Wait_IMP(MergeScheduler *self) {
+    S_reap(self, true);
+}
+
+uint32_t
+MergeSched_Get_Merge_Count_IMP(MergeScheduler *self) {
+    S_reap(self, false);
+    return MergeSched_IVARS(self)->merge_count;
+}
+
+uint32_t
+MergeSched_Get_Failure_Count_IMP(MergeScheduler *self) {
+    S_reap(self, false);
+    return MergeSched_IVARS(self)->failure_count;
+}
+
+String*
+MergeSched_Get_Last_Error_IMP(MergeScheduler *self) {
+    S_reap(self, false);
+    return MergeSched_IVARS(self)->last_error;
+}
+
+static void
+S_reap(MergeScheduler *self, bool block) {
+    MergeSchedulerIVARS *const ivars = MergeSched_IVARS(self);
+    MergeTask *task = (MergeTask*)ivars->task;
+    if (!task) { return; }
+
+    if (task->thread) {
+        if (!block && !WorkerThread_done(task->thread)) { return; }
+        WorkerThread_join(task->thread);
+    }
+
+    if (task->error) {
+        DECREF(ivars->last_error);
+        ivars->last_error = Str_new_from_utf8(task->error,
+                                              strlen(task->error));
+        ivars->failure_count++;
+        FREEMEM(task->error);
+    }
+    else {
+        ivars->merge_count++;
+    }
+    FREEMEM(task->path);
+    FREEMEM(task->host);
+    FREEMEM(task);
+    ivars->task = NULL;
+}
+
+struct merge_context {
+    MergeTask        *task;
+    FSFolder         *folder;
+    IndexManager     *manager;
+    BackgroundMerger *merger;
+};
+
+static void
+S_merge(void *context) {
+    struct merge_context *args = (struct merge_context*)context;
+    MergeTask *task = args->task;
+    String *path = SSTR_WRAP_UTF8(task->path, task->path_len);
+    String *host = SSTR_WRAP_UTF8(task->host, task->host_len);
+
+    args->folder = FSFolder_new(path);
+    if (task->mb_per_sec > 0.0) {
+        RateLimiter *limiter = RateLimiter_new(task->mb_per_sec);
+        FSFolder_Set_Rate_Limiter(args->folder, limiter);
+        DECREF(limiter);
+    }
+    if (task->fcntl_locks) {
+        FcntlLockFactory *lock_factory
+            = FcntlLockFact_new((Folder*)args->folder, host);
+        args->manager = IxManager_new(host, (LockFactory*)lock_factory);
+        DECREF(lock_factory);
+    }
+    else {
+        args->manager = IxManager_new(host, NULL);
+    }
+    IxManager_Set_Write_Lock_Timeout(args->manager, task->write_lock_timeout);
+    IxManager_Set_Sync_Commits(args->manager, task->sync_commits);
+    IxManager_Set_Binary_Metadata(args->manager, task->binary_metadata);
+    if (task->policy.copied) {
+        const PolicySettings *settings = &task->policy;
+        TieredMergePolicy *policy = TieredMP_new();
+        TieredMP_Set_Segs_Per_Tier(policy, settings->segs_per_tier);
+        TieredMP_Set_Max_Merge_At_Once(policy, settings->max_merge_at_once);
+        TieredMP_Set_Max_Merged_Size(policy, settings->max_merged_size);
+        TieredMP_Set_Floor_Size(policy, settings->floor_size);
+        TieredMP_Set_Deletes_Pct_Allowed(policy,
+                                         settings->deletes_pct_allowed);
+        TieredMP_Set_Reclaim_Deletes_Weight(policy,
+                                            settings->reclaim_deletes_weight);
+        IxManager_Set_Merge_Policy(args->manager, (MergePolicy*)policy);
+        DECREF(policy);
+    }
+    args->merger = BGMerger_new((Obj*)args->folder, args->manager);
+    BGMerger_Commit(args->merger);
+}
+
+static void
+S_run_task(void *context) {
+    MergeTask *task = (MergeTask*)context;
+    struct merge_context args;
+    args.task    = task;
+    args.folder  = NULL;
+    args.manager = NULL;
+    args.merger  = NULL;
+
+    Err *error = Err_trap(S_merge, &args);
+    DECREF(args.merger);
+    DECREF(args.manager);
+    DECREF(args.folder);
+    if (error) {
+        task->error = Str_To_Utf8(Err_Get_Mess(error));
+        DECREF(error);
+    }
+}
+
@@ -0,0 +1,259 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_MERGESIMULATOR
+#include "Lucy/Util/ToolSet.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "Lucy/Index/MergeSimulator.h"
+#include "Lucy/Index/MergePolicy.h"
+#include "Lucy/Object/I32Array.h"
+
+// Spread `del_count` deletions across the live documents of all segments.
+static void
+S_apply_deletions(MergeSimulatorIVARS *ivars, int64_t del_count);
+
+// Replace the segment at `tick` with one carrying `extra` more deletions.
+static void
+S_add_deletions(Vector *segments, uint32_t tick, int64_t extra);
+
+MergeSimulator*
+MergeSim_new(MergePolicy *policy) {
+    MergeSimulator *self = (MergeSimulator*)Class_Make_Obj(MERGESIMULATOR);
+    return MergeSim_init(self, policy);
+}
+
+MergeSimulator*
+MergeSim_init(MergeSimulator *self, MergePolicy *policy) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    ivars->policy        = (MergePolicy*)INCREF(CERTIFY(policy, MERGEPOLICY));
+    ivars->segments      = Vec_new(0);
+    ivars->bytes_added   = 0;
+    ivars->bytes_written = 0;
+    ivars->num_commits   = 0;
+    ivars->num_merges    = 0;
+    ivars->max_seg_count = 0;
+    ivars->seg_count_sum = 0;
+    return self;
+}
+
+void
+MergeSim_Destroy_IMP(MergeSimulator *self) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    DECREF(ivars->policy);
+    DECREF(ivars->segments);
+    SUPER_DESTROY(self, MERGESIMULATOR);
+}
+
+void
+MergeSim_Commit_IMP(MergeSimulator *self, int64_t doc_count, int64_t size,
+                    int64_t del_count) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    if (doc_count < 0 || size < 0 || del_count < 0) {
+        THROW(ERR, "Negative commit: %i64 docs, %i64 bytes, %i64 deletions",
+              doc_count, size, del_count);
+    }
+    if (del_count) { S_apply_deletions(ivars, del_count); }
+
+    // Merge the chosen segments into the new one, as Indexer would.
+    uint32_t  num_segs  = Vec_Get_Size(ivars->segments);
+    I32Array *picks     = MergePolicy_Find_Merge(ivars->policy,
+                                                 ivars->segments);
+    uint32_t  num_picks = I32Arr_Get_Size(picks);
+    bool     *picked    = (bool*)CALLOCATE(num_segs + 1, sizeof(bool));
+    int64_t   new_docs  = doc_count;
+    double    new_size  = (double)size;
+    for (uint32_t i = 0; i < num_picks; i++) {
+        int32_t tick = I32Arr_Get(picks, i);
+        if (tick < 0 || (uint32_t)tick >= num_segs || picked[tick]) {
+            FREEMEM(picked);
+            DECREF(picks);
+            THROW(ERR, "Merge policy chose invalid candidate %i32", tick);
+        }
+        MergeCandidate *seg
+            = (MergeCandidate*)Vec_Fetch(ivars->segments, (size_t)tick);
+        picked[tick] = true;
+        new_docs += MergeCand_Get_Doc_Max(seg) - MergeCand_Get_Del_Count(seg);
+        new_size += MergeCand_Live_Size(seg);
+    }
+    DECREF(picks);
+
+    Vector *survivors = Vec_new(num_segs + 1);
+    for (uint32_t i = 0; i < num_segs; i++) {
+        if (!picked[i]) {
+            Vec_Push(survivors, INCREF(Vec_Fetch(ivars->segments, i)));
+        }
+    }
+    FREEMEM(picked);
+    if (new_docs > 0) {
+        Vec_Push(survivors,
+                 (Obj*)MergeCand_new((int64_t)new_size, new_docs, 0));
+        ivars->bytes_written += (int64_t)new_size;
+    }
+    DECREF(ivars->segments);
+    ivars->segments = survivors;
+
+    // Update statistics.
+    uint32_t seg_count = Vec_Get_Size(survivors);
+    ivars->bytes_added   += size;
+    ivars->num_commits   += 1;
+    ivars->seg_count_sum += seg_count;
+    if (num_picks) { ivars->num_merges++; }
+    if (seg_count > ivars->max_seg_count) {
+        ivars->max_seg_count = seg_count;
+    }
+}
+
+void
+MergeSim_Replay_IMP(MergeSimulator *self, String *log) {
+    char *text = Str_To_Utf8(log);
+    char *ptr  = text;
+    while (*ptr) {
+        char *line_end = strchr(ptr, '\n');
+        if (line_end) { *line_end = '\0'; }
+
+        while (isspace((unsigned char)*ptr)) { ptr++; }
+        if (*ptr && *ptr != '#') {
+            char    *line = ptr;
+            char    *end;
+            int64_t  values[3] = { 0, 0, 0 };
+            int      num_values = 0;
+            while (num_values < 3) {
+                values[num_values] = (int64_t)strtoll(ptr, &end, 10);
+                if (end == ptr) { break; }
+                num_values++;
+                ptr = end;
+            }
+            while (isspace((unsigned char)*ptr)) { ptr++; }
+            if (num_values < 2 || *ptr) {
+                String *mess = MAKE_MESS("Malformed commit log line: '%s'",
+                                         line);
+                FREEMEM(text);
+                Err_throw_mess(ERR, mess);
+            }
+            MergeSim_Commit(self, values[0], values[1], values[2]);
+        }
+
+        if (!line_end) { break; }
+        ptr = line_end + 1;
+    }
+    FREEMEM(text);
+}
+
+static void
+S_apply_deletions(MergeSimulatorIVARS *ivars, int64_t del_count) {
+    Vector   *segments   = ivars->segments;
+    uint32_t  num_segs   = Vec_Get_Size(segments);
+    int64_t   total_live = 0;
+    for (uint32_t i = 0; i < num_segs; i++) {
+        MergeCandidate *seg = (MergeCandidate*)Vec_Fetch(segments, i);
+        total_live += MergeCand_Get_Doc_Max(seg) - MergeCand_Get_Del_Count(seg);
+    }
+    if (total_live == 0) { return; }
+    if (del_count > total_live) { del_count = total_live; }
+
+    // Proportional shares, then hand out the remainder one at a time.
+    int64_t remaining = del_count;
+    for (uint32_t i = 0; i < num_segs; i++) {
+        MergeCandidate *seg = (MergeCandidate*)Vec_Fetch(segments, i);
+        int64_t live  = MergeCand_Get_Doc_Max(seg)
+                        - MergeCand_Get_Del_Count(seg);
+        int64_t share = (int64_t)((double)del_count * (double)live
+                                  / (double)total_live);
+        if (share > live)      { share = live; }
+        if (share > remaining) { share = remaining; }
+        if (share) {
+            S_add_deletions(segments, i, share);
+            remaining -= share;
+        }
+    }
+    for (uint32_t i = 0; i < num_segs && remaining > 0; i++) {
+        MergeCandidate *seg = (MergeCandidate*)Vec_Fetch(segments, i);
+        if (MergeCand_Get_Del_Count(seg) < MergeCand_Get_Doc_Max(seg)) {
+            S_add_deletions(segments, i, 1);
+            remaining--;
+        }
+    }
+}
+
+static void
+S_add_deletions(Vector *segments, uint32_t tick, int64_t extra) {
+    MergeCandidate *seg = (MergeCandidate*)Vec_Fetch(segments, tick);
+    MergeCandidate *replacement
+        = MergeCand_new(MergeCand_Get_Size(seg), MergeCand_Get_Doc_Max(seg),
+                        MergeCand_Get_Del_Count(seg) + extra);
+    Vec_Store(segments, tick, (Obj*)replacement);
+}
+
+uint32_t
+MergeSim_Get_Seg_Count_IMP(MergeSimulator *self) {
+    return Vec_Get_Size(MergeSim_IVARS(self)->segments);
+}
+
+uint32_t
+MergeSim_Get_Max_Seg_Count_IMP(MergeSimulator *self) {
+    return MergeSim_IVARS(self)->max_seg_count;
+}
+
+double
+MergeSim_Get_Mean_Seg_Count_IMP(MergeSimulator *self) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    if (!ivars->num_commits) { return 0.0; }
+    return (double)ivars->seg_count_sum / (double)ivars->num_commits;
+}
+
+uint32_t
+MergeSim_Get_Num_Commits_IMP(MergeSimulator *self) {
+    return MergeSim_IVARS(self)->num_commits;
+}
+
+uint32_t
+MergeSim_Get_Num_Merges_IMP(MergeSimulator *self) {
+    return MergeSim_IVARS(self)->num_merges;
+}
+
+int64_t
+MergeSim_Get_Bytes_Added_IMP(MergeSimulator *self) {
+    return MergeSim_IVARS(self)->bytes_added;
+}
+
+int64_t
+MergeSim_Get_Bytes_Written_IMP(MergeSimulator *self) {
+    return MergeSim_IVARS(self)->bytes_written;
+}
+
+double
+MergeSim_Write_Amplification_IMP(MergeSimulator *self) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    if (!ivars->bytes_added) { return 0.0; }
+    return (double)ivars->bytes_written / (double)ivars->bytes_added;
+}
+
+String*
+MergeSim_Report_IMP(MergeSimulator *self) {
+    MergeSimulatorIVARS *const ivars = MergeSim_IVARS(self);
+    return Str_newf("commits: %u32, merges: %u32, segments: %u32 "
+                    "(max %u32, mean %f64), bytes added: %i64, "
+                    "bytes written: %i64, write amplification: %f64",
+                    ivars->num_commits, ivars->num_merges,
+                    MergeSim_Get_Seg_Count(self), ivars->max_seg_count,
+                    MergeSim_Get_Mean_Seg_Count(self), ivars->bytes_added,
+                    ivars->bytes_written, MergeSim_Write_Amplification(self));
+}
+
@@ -98,6 +98,8 @@ PolyLex_Reset_IMP(PolyLexicon *self) {
     uint32_t num_segs = Vec_Get_Size(seg_lexicons);
     SegLexQueue *lex_q = ivars->lex_q;
 
+    PolyLex_Clear_Bounds(self);
+
     // Empty out the queue.
     while (1) {
         SegLexicon *seg_lex = (SegLexicon*)SegLexQ_Pop(lex_q);
@@ -133,7 +135,10 @@ PolyLex_Next_IMP(PolyLexicon *self) {
         if ((candidate && !ivars->term)
             || Obj_Compare_To(ivars->term, candidate) != 0
            ) {
-            // Succeed if the next item in the queue has a different term.
+            // Succeed if the next item in the queue has a different term,
+            // unless it lies beyond the bounds set by Seek_Prefix() or
+            // Seek_Range().
+            if (PolyLex_Past_Bounds(self, candidate)) { break; }
             Obj *temp = ivars->term;
             ivars->term = Obj_Clone(candidate);
             DECREF(temp);
@@ -149,7 +154,7 @@ PolyLex_Next_IMP(PolyLexicon *self) {
         }
     }
 
-    // If queue is empty, iterator is finished.
+    // If queue is empty or out of bounds, iterator is finished.
     DECREF(ivars->term);
     ivars->term = NULL;
     return false;
@@ -165,6 +170,7 @@ PolyLex_Seek_IMP(PolyLexicon *self, Obj *target) {
         PolyLex_Reset(self);
         return;
     }
+    PolyLex_Clear_Bounds(self);
 
     // Refresh the queue, set vars.
     S_refresh_lex_q(lex_q, seg_lexicons, target);
@@ -18,6 +18,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Document/HitDoc.h"
 #include "Lucy/Index/DeletionsReader.h"
@@ -31,6 +32,7 @@
 #include "Lucy/Store/FSFolder.h"
 #include "Lucy/Store/Lock.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Clownfish/Util/StringHelper.h"
@@ -257,7 +259,7 @@ S_try_open_elements(void *context) {
         THROW(ERR, "Can't find a schema file.");
     }
     else {
-        Obj *dump = Json_slurp_json(folder, schema_file);
+        Obj *dump = MetaFile_slurp(folder, schema_file);
         if (dump) { // read file successfully
             DECREF(ivars->schema);
             ivars->schema = (Schema*)CERTIFY(Freezer_load(dump), SCHEMA);
@@ -584,4 +586,52 @@ PolyReader_sub_tick(I32Array *offsets, int32_t doc_id) {
     return hi;
 }
 
+Hash*
+PolyReader_Stats_IMP(PolyReader *self) {
+    PolyReaderIVARS *const ivars = PolyReader_IVARS(self);
+    Hash    *stats    = Hash_new(0);
+    Hash    *fields   = Hash_new(0);
+    Vector  *segments = Vec_new(Vec_Get_Size(ivars->sub_readers));
+    int64_t  bytes    = 0;
+    int64_t  resident = 0;
+
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->sub_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(ivars->sub_readers, i);
+        Hash *seg_stats = SegReader_Stats(seg_reader);
+        Hash *seg_fields = (Hash*)Hash_Fetch_Utf8(seg_stats, "fields", 6);
+        if (seg_fields) { IxReader_add_stats(fields, seg_fields); }
+        bytes    += IxReader_fetch_stat(seg_stats, "bytes", 5);
+        resident += IxReader_fetch_stat(seg_stats, "resident_bytes", 14);
+        Vec_Push(segments, (Obj*)seg_stats);
+    }
+
+    // Derive average document length, in unique terms, for each field.
+    HashIterator *iter = HashIter_new(fields);
+    while (HashIter_Next(iter)) {
+        Hash    *field_stats = (Hash*)HashIter_Get_Value(iter);
+        int64_t  postings    = IxReader_fetch_stat(field_stats, "postings", 8);
+        if (postings && ivars->doc_max) {
+            double avg = (double)postings / (double)ivars->doc_max;
+            Hash_Store_Utf8(field_stats, "avg_doc_terms", 13,
+                            (Obj*)Float_new(avg));
+        }
+    }
+    DECREF(iter);
+
+    double ratio = ivars->doc_max
+                   ? (double)ivars->del_count / (double)ivars->doc_max
+                   : 0.0;
+    Hash_Store_Utf8(stats, "doc_max", 7, (Obj*)Int_new(ivars->doc_max));
+    Hash_Store_Utf8(stats, "doc_count", 9,
+                    (Obj*)Int_new(PolyReader_Doc_Count(self)));
+    Hash_Store_Utf8(stats, "del_count", 9, (Obj*)Int_new(ivars->del_count));
+    Hash_Store_Utf8(stats, "deletion_ratio", 14, (Obj*)Float_new(ratio));
+    Hash_Store_Utf8(stats, "num_segments", 12,
+                    (Obj*)Int_new(Vec_Get_Size(segments)));
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(resident));
+    Hash_Store_Utf8(stats, "fields", 6, (Obj*)fields);
+    Hash_Store_Utf8(stats, "segments", 8, (Obj*)segments);
+    return stats;
+}
 
@@ -114,6 +114,16 @@ MatchPost_Read_Raw_IMP(MatchPosting *self, InStream *instream,
     return RawPost_new(allocation, doc_id, freq, text_buf, text_size);
 }
 
+void
+MatchPost_Copy_Raw_Aux_IMP(MatchPosting *self, InStream *instream,
+                           OutStream *outstream, uint32_t freq) {
+    // Nothing follows the doc code and freq.
+    UNUSED_VAR(self);
+    UNUSED_VAR(instream);
+    UNUSED_VAR(outstream);
+    UNUSED_VAR(freq);
+}
+
 void
 MatchPost_Add_Inversion_To_Pool_IMP(MatchPosting *self,
                                     PostingPool *post_pool,
@@ -223,6 +233,26 @@ MatchPostWriter_Write_Posting_IMP(MatchPostingWriter *self, RawPosting *posting)
     ivars->last_doc_id = doc_id;
 }
 
+void
+MatchPostWriter_Copy_Posting_IMP(MatchPostingWriter *self,
+                                 Posting *posting, InStream *instream,
+                                 int32_t doc_id, uint32_t freq) {
+    MatchPostingWriterIVARS *const ivars = MatchPostWriter_IVARS(self);
+    OutStream *const outstream = ivars->outstream;
+    const uint32_t   delta_doc = doc_id - ivars->last_doc_id;
+    if (freq == 1) {
+        const uint32_t doc_code = (delta_doc << 1) | 1;
+        OutStream_Write_C32(outstream, doc_code);
+    }
+    else {
+        const uint32_t doc_code = delta_doc << 1;
+        OutStream_Write_C32(outstream, doc_code);
+        OutStream_Write_C32(outstream, freq);
+    }
+    Post_Copy_Raw_Aux(posting, instream, outstream, freq);
+    ivars->last_doc_id = doc_id;
+}
+
 void
 MatchPostWriter_Start_Term_IMP(MatchPostingWriter *self, TermInfo *tinfo) {
     MatchPostingWriterIVARS *const ivars = MatchPostWriter_IVARS(self);
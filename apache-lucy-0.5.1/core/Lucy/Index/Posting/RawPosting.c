@@ -27,6 +27,7 @@
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Index/TermInfo.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
 #include "Clownfish/Util/StringHelper.h"
 
@@ -144,4 +145,24 @@ RawPostWriter_Write_Posting_IMP(RawPostingWriter *self, RawPosting *posting) {
     ivars->last_doc_id = doc_id;
 }
 
+void
+RawPostWriter_Copy_Posting_IMP(RawPostingWriter *self,
+                               Posting *posting, InStream *instream,
+                               int32_t doc_id, uint32_t freq) {
+    RawPostingWriterIVARS *const ivars = RawPostWriter_IVARS(self);
+    OutStream *const outstream = ivars->outstream;
+    const uint32_t   delta_doc = doc_id - ivars->last_doc_id;
+    if (freq == 1) {
+        const uint32_t doc_code = (delta_doc << 1) | 1;
+        OutStream_Write_C32(outstream, doc_code);
+    }
+    else {
+        const uint32_t doc_code = delta_doc << 1;
+        OutStream_Write_C32(outstream, doc_code);
+        OutStream_Write_C32(outstream, freq);
+    }
+    Post_Copy_Raw_Aux(posting, instream, outstream, freq);
+    ivars->last_doc_id = doc_id;
+}
+
 
@@ -30,10 +30,12 @@
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Search/Compiler.h"
 #include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
 #include "Lucy/Util/MemoryPool.h"
 #include "Lucy/Util/NumberUtils.h"
 
 #define FREQ_MAX_LEN     C32_MAX_BYTES
+#define COPY_BATCH       64
 #define MAX_RAW_POSTING_LEN(_raw_posting_size, _text_len, _freq) \
     (              _raw_posting_size \
                    + _text_len                /* term text content */ \
@@ -190,6 +192,31 @@ RichPost_Read_Raw_IMP(RichPosting *self, InStream *instream,
     return raw_posting;
 }
 
+void
+RichPost_Copy_Raw_Aux_IMP(RichPosting *self, InStream *instream,
+                          OutStream *outstream, uint32_t freq) {
+    uint32_t remaining = freq;
+    UNUSED_VAR(self);
+
+    // Copy positions and per-position boosts straight out of the
+    // InStream's buffer, a batch of positions at a time.
+    while (remaining) {
+        const uint32_t batch = remaining < COPY_BATCH ? remaining : COPY_BATCH;
+        const char *const buf
+            = InStream_Buf(instream, batch * (C64_MAX_BYTES + 1));
+        const char *end = buf;
+        for (uint32_t i = 0; i < batch; i++) {
+            NumUtil_skip_cint(&end);
+            end++; // boost
+        }
+        if (outstream) {
+            OutStream_Write_Bytes(outstream, buf, (size_t)(end - buf));
+        }
+        InStream_Advance_Buf(instream, end);
+        remaining -= batch;
+    }
+}
+
 RichPostingMatcher*
 RichPost_Make_Matcher_IMP(RichPosting *self, Similarity *sim,
                           PostingList *plist, Compiler *compiler,
@@ -31,11 +31,13 @@
 #include "Lucy/Search/Compiler.h"
 #include "Lucy/Search/Matcher.h"
 #include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
 #include "Lucy/Util/MemoryPool.h"
 #include "Lucy/Util/NumberUtils.h"
 
 #define FIELD_BOOST_LEN  1
 #define FREQ_MAX_LEN     C32_MAX_BYTES
+#define COPY_BATCH       64
 #define MAX_RAW_POSTING_LEN(_raw_post_size, _text_len, _freq) \
     (              _raw_post_size \
                    + _text_len                /* term text content */ \
@@ -211,6 +213,32 @@ ScorePost_Read_Raw_IMP(ScorePosting *self, InStream *instream,
     return raw_posting;
 }
 
+void
+ScorePost_Copy_Raw_Aux_IMP(ScorePosting *self, InStream *instream,
+                           OutStream *outstream, uint32_t freq) {
+    size_t   lead      = FIELD_BOOST_LEN;
+    uint32_t remaining = freq;
+    UNUSED_VAR(self);
+
+    // Copy the field boost and the position deltas straight out of the
+    // InStream's buffer, a batch of positions at a time.
+    do {
+        const uint32_t batch = remaining < COPY_BATCH ? remaining : COPY_BATCH;
+        const char *const buf
+            = InStream_Buf(instream, lead + batch * C64_MAX_BYTES);
+        const char *end = buf + lead;
+        for (uint32_t i = 0; i < batch; i++) {
+            NumUtil_skip_cint(&end);
+        }
+        if (outstream) {
+            OutStream_Write_Bytes(outstream, buf, (size_t)(end - buf));
+        }
+        InStream_Advance_Buf(instream, end);
+        remaining -= batch;
+        lead = 0;
+    } while (remaining);
+}
+
 ScorePostingMatcher*
 ScorePost_Make_Matcher_IMP(ScorePosting *self, Similarity *sim,
                            PostingList *plist, Compiler *compiler,
@@ -30,4 +30,10 @@ PList_init(PostingList *self) {
     return self;
 }
 
+int32_t
+PList_Estimate_Cost_IMP(PostingList *self) {
+    uint32_t doc_freq = PList_Get_Doc_Freq(self);
+    return doc_freq > INT32_MAX ? INT32_MAX : (int32_t)doc_freq;
+}
+
 
@@ -17,9 +17,11 @@
 #define C_LUCY_POSTINGLISTREADER
 #define C_LUCY_POLYPOSTINGLISTREADER
 #define C_LUCY_DEFAULTPOSTINGLISTREADER
+#define C_LUCY_SEGPOSTINGLIST
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/PostingListReader.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/LexiconReader.h"
 #include "Lucy/Index/PostingListWriter.h"
 #include "Lucy/Index/Segment.h"
@@ -29,8 +31,22 @@
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
 #include "Lucy/Util/Json.h"
 
+// Upper bound on the number of SegPostingLists pooled per field.
+#define MAX_POOLED_PLISTS 32
+
+// Return a SegPostingList for `field`, reusing an idle pooled one if
+// possible.
+static SegPostingList*
+S_obtain_plist(DefaultPostingListReader *self, String *field);
+
+// Release the pool and the shared streams.  Pooled posting lists which are
+// still in use are cut loose from the reader.
+static void
+S_drain_pools(DefaultPostingListReader *self);
+
 PostingListReader*
 PListReader_init(PostingListReader *self, Schema *schema, Folder *folder,
                  Snapshot *snapshot, Vector *segments, int32_t seg_tick) {
@@ -69,7 +85,10 @@ DefPListReader_init(DefaultPostingListReader *self, Schema *schema,
     Segment *segment = DefPListReader_Get_Segment(self);
 
     // Derive.
-    ivars->lex_reader = (LexiconReader*)INCREF(lex_reader);
+    ivars->lex_reader   = (LexiconReader*)INCREF(lex_reader);
+    ivars->post_streams = Vec_new(0);
+    ivars->skip_stream  = NULL;
+    ivars->pools        = Vec_new(0);
 
     // Check format.
     Hash *my_meta = (Hash*)Seg_Fetch_Metadata_Utf8(segment, "postings", 8);
@@ -99,15 +118,49 @@ DefPListReader_Close_IMP(DefaultPostingListReader *self) {
         DECREF(ivars->lex_reader);
         ivars->lex_reader = NULL;
     }
+    S_drain_pools(self);
 }
 
 void
 DefPListReader_Destroy_IMP(DefaultPostingListReader *self) {
     DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    S_drain_pools(self);
+    DECREF(ivars->pools);
+    DECREF(ivars->post_streams);
     DECREF(ivars->lex_reader);
     SUPER_DESTROY(self, DEFAULTPOSTINGLISTREADER);
 }
 
+static void
+S_drain_pools(DefaultPostingListReader *self) {
+    DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    if (ivars->pools) {
+        for (size_t i = 0, max = Vec_Get_Size(ivars->pools); i < max; i++) {
+            Vector *pool = (Vector*)Vec_Fetch(ivars->pools, i);
+            if (!pool) { continue; }
+            for (size_t j = 0, limit = Vec_Get_Size(pool); j < limit; j++) {
+                SegPostingList *plist = (SegPostingList*)Vec_Fetch(pool, j);
+                SegPostingListIVARS *const plist_ivars = SegPList_IVARS(plist);
+                plist_ivars->plist_reader = NULL;
+                plist_ivars->pooled       = false;
+            }
+        }
+        Vec_Clear(ivars->pools);
+    }
+    if (ivars->post_streams) {
+        for (size_t i = 0, max = Vec_Get_Size(ivars->post_streams); i < max; i++) {
+            InStream *instream = (InStream*)Vec_Fetch(ivars->post_streams, i);
+            if (instream) { InStream_Close(instream); }
+        }
+        Vec_Clear(ivars->post_streams);
+    }
+    if (ivars->skip_stream) {
+        InStream_Close(ivars->skip_stream);
+        DECREF(ivars->skip_stream);
+        ivars->skip_stream = NULL;
+    }
+}
+
 SegPostingList*
 DefPListReader_Posting_List_IMP(DefaultPostingListReader *self,
                                 String *field, Obj *target) {
@@ -116,7 +169,7 @@ DefPListReader_Posting_List_IMP(DefaultPostingListReader *self,
 
     // Only return an object if we've got an indexed field.
     if (type != NULL && FType_Indexed(type)) {
-        SegPostingList *plist = SegPList_new((PostingListReader*)self, field);
+        SegPostingList *plist = S_obtain_plist(self, field);
         if (target) { SegPList_Seek(plist, target); }
         return plist;
     }
@@ -125,8 +178,120 @@ DefPListReader_Posting_List_IMP(DefaultPostingListReader *self,
     }
 }
 
+static SegPostingList*
+S_obtain_plist(DefaultPostingListReader *self, String *field) {
+    DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    int32_t field_num = Seg_Field_Num(ivars->segment, field);
+    if (!field_num || !ivars->pools) {
+        return SegPList_new((PostingListReader*)self, field);
+    }
+
+    // A pooled posting list is idle once the pool holds the only reference.
+    Vector *pool = (Vector*)Vec_Fetch(ivars->pools, (size_t)field_num);
+    if (pool) {
+        for (size_t i = 0, max = Vec_Get_Size(pool); i < max; i++) {
+            SegPostingList *plist = (SegPostingList*)Vec_Fetch(pool, i);
+            if (REFCOUNT_NN(plist) == 1) {
+                SegPList_Seek_Term_Info(plist, NULL);
+                return (SegPostingList*)INCREF(plist);
+            }
+        }
+    }
+    else {
+        pool = Vec_new(1);
+        Vec_Store(ivars->pools, (size_t)field_num, (Obj*)pool);
+    }
+
+    SegPostingList *plist = SegPList_new((PostingListReader*)self, field);
+    if (Vec_Get_Size(pool) < MAX_POOLED_PLISTS) {
+        // The reader owns its pool, so pooled posting lists must not own
+        // the reader in turn.
+        SegPostingListIVARS *const plist_ivars = SegPList_IVARS(plist);
+        plist_ivars->pooled = true;
+        DECREF(self);
+        Vec_Push(pool, INCREF(plist));
+    }
+    return plist;
+}
+
+InStream*
+DefPListReader_Post_Stream_IMP(DefaultPostingListReader *self,
+                               int32_t field_num) {
+    DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    if (field_num <= 0) { return NULL; }
+    InStream *instream
+        = (InStream*)Vec_Fetch(ivars->post_streams, (size_t)field_num);
+    if (!instream) {
+        String *post_file = Str_newf("%o/postings-%i32.dat",
+                                     Seg_Get_Name(ivars->segment),
+                                     field_num);
+        if (Folder_Exists(ivars->folder, post_file)) {
+            instream = Folder_Open_In(ivars->folder, post_file);
+            if (!instream) {
+                DECREF(post_file);
+                RETHROW((Err*)INCREF(Err_get_error()));
+            }
+            Vec_Store(ivars->post_streams, (size_t)field_num,
+                      (Obj*)instream);
+        }
+        DECREF(post_file);
+    }
+    return instream;
+}
+
+InStream*
+DefPListReader_Skip_Stream_IMP(DefaultPostingListReader *self) {
+    DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    if (!ivars->skip_stream) {
+        String *skip_file = Str_newf("%o/postings.skip",
+                                     Seg_Get_Name(ivars->segment));
+        ivars->skip_stream = Folder_Open_In(ivars->folder, skip_file);
+        DECREF(skip_file);
+        if (!ivars->skip_stream) {
+            RETHROW((Err*)INCREF(Err_get_error()));
+        }
+    }
+    return ivars->skip_stream;
+}
+
 LexiconReader*
 DefPListReader_Get_Lex_Reader_IMP(DefaultPostingListReader *self) {
     return DefPListReader_IVARS(self)->lex_reader;
 }
 
+Hash*
+DefPListReader_Stats_IMP(DefaultPostingListReader *self) {
+    DefaultPostingListReaderIVARS *const ivars = DefPListReader_IVARS(self);
+    String  *seg_name = Seg_Get_Name(ivars->segment);
+    Hash    *fields   = Hash_new(0);
+    Hash    *stats    = Hash_new(0);
+    String  *skip_file  = Str_newf("%o/postings.skip", seg_name);
+    int64_t  skip_bytes = Folder_File_Length(ivars->folder, skip_file);
+    int64_t  bytes      = skip_bytes;
+    DECREF(skip_file);
+
+    for (uint32_t i = 1, max = Schema_Num_Fields(ivars->schema) + 1;
+         i < max; i++
+        ) {
+        String *field = Seg_Field_Name(ivars->segment, (int32_t)i);
+        if (!field) { continue; }
+        String *post_file = Str_newf("%o/postings-%i32.dat", seg_name,
+                                     (int32_t)i);
+        int64_t post_bytes = Folder_File_Length(ivars->folder, post_file);
+        DECREF(post_file);
+        if (post_bytes) {
+            Hash *field_stats = Hash_new(0);
+            Hash_Store_Utf8(field_stats, "posting_bytes", 13,
+                            (Obj*)Int_new(post_bytes));
+            Hash_Store(fields, field, (Obj*)field_stats);
+            bytes += post_bytes;
+        }
+    }
+
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(0));
+    Hash_Store_Utf8(stats, "skip_bytes", 10, (Obj*)Int_new(skip_bytes));
+    Hash_Store_Utf8(stats, "fields", 6, (Obj*)fields);
+    return stats;
+}
+
@@ -48,6 +48,11 @@ S_lazy_init(PostingListWriter *self);
 static PostingPool*
 S_lazy_init_posting_pool(PostingListWriter *self, int32_t field_num);
 
+// Return the PostingPool whose MemoryPool has consumed the most memory, or
+// NULL if no pool holds any buffered postings.
+static PostingPool*
+S_largest_pool(PostingListWriter *self);
+
 PostingListWriter*
 PListWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
                 PolyReader *polyreader, LexiconWriter *lex_writer) {
@@ -70,7 +75,6 @@ PListWriter_init(PostingListWriter *self, Schema *schema, Snapshot *snapshot,
     // Init.
     ivars->pools          = Vec_new(Schema_Num_Fields(schema));
     ivars->mem_thresh     = default_mem_thresh;
-    ivars->mem_pool       = MemPool_new(0);
     ivars->lex_temp_out   = NULL;
     ivars->post_temp_out  = NULL;
 
@@ -94,6 +98,8 @@ S_lazy_init(PostingListWriter *self) {
         if (!ivars->post_temp_out) { RETHROW(INCREF(Err_get_error())); }
         ivars->skip_out = Folder_Open_Out(folder, skip_path);
         if (!ivars->skip_out) { RETHROW(INCREF(Err_get_error())); }
+        OutStream_Set_Buf_Size(ivars->lex_temp_out, OUTSTREAM_BULK_BUF_SIZE);
+        OutStream_Set_Buf_Size(ivars->post_temp_out, OUTSTREAM_BULK_BUF_SIZE);
 
         DECREF(skip_path);
         DECREF(post_temp_path);
@@ -107,11 +113,13 @@ S_lazy_init_posting_pool(PostingListWriter *self, int32_t field_num) {
     PostingPool *pool = (PostingPool*)Vec_Fetch(ivars->pools, field_num);
     if (!pool && field_num != 0) {
         String *field = Seg_Field_Name(ivars->segment, field_num);
+        MemoryPool *mem_pool = MemPool_new(0);
         pool = PostPool_new(ivars->schema, ivars->snapshot, ivars->segment,
                             ivars->polyreader, field, ivars->lex_writer,
-                            ivars->mem_pool, ivars->lex_temp_out,
+                            mem_pool, ivars->lex_temp_out,
                             ivars->post_temp_out, ivars->skip_out);
         Vec_Store(ivars->pools, field_num, (Obj*)pool);
+        DECREF(mem_pool);
     }
     return pool;
 }
@@ -120,7 +128,6 @@ void
 PListWriter_Destroy_IMP(PostingListWriter *self) {
     PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
     DECREF(ivars->lex_writer);
-    DECREF(ivars->mem_pool);
     DECREF(ivars->pools);
     DECREF(ivars->lex_temp_out);
     DECREF(ivars->post_temp_out);
@@ -143,7 +150,6 @@ void
 PListWriter_Add_Inverted_Doc_IMP(PostingListWriter *self, Inverter *inverter,
                                  int32_t doc_id) {
     S_lazy_init(self);
-    PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
 
     // Iterate over fields in document, adding the content of indexed fields
     // to their respective PostingPools.
@@ -162,16 +168,54 @@ PListWriter_Add_Inverted_Doc_IMP(PostingListWriter *self, Inverter *inverter,
                                    length_norm);
         }
     }
+}
 
-    // If our PostingPools have collectively passed the memory threshold,
-    // flush all of them, then release all the RawPostings with a single
-    // action.
-    if (MemPool_Get_Consumed(ivars->mem_pool) > ivars->mem_thresh) {
-        for (uint32_t i = 0, max = Vec_Get_Size(ivars->pools); i < max; i++) {
-            PostingPool *const pool = (PostingPool*)Vec_Fetch(ivars->pools, i);
-            if (pool) { PostPool_Flush(pool); }
+uint64_t
+PListWriter_Mem_Consumed_IMP(PostingListWriter *self) {
+    PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
+    uint64_t consumed = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->pools); i < max; i++) {
+        PostingPool *const pool = (PostingPool*)Vec_Fetch(ivars->pools, i);
+        if (pool) {
+            consumed += MemPool_Get_Consumed(PostPool_Get_Mem_Pool(pool));
         }
-        MemPool_Release_All(ivars->mem_pool);
+    }
+    return consumed;
+}
+
+static PostingPool*
+S_largest_pool(PostingListWriter *self) {
+    PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
+    PostingPool *largest = NULL;
+    size_t largest_consumed = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->pools); i < max; i++) {
+        PostingPool *const pool = (PostingPool*)Vec_Fetch(ivars->pools, i);
+        if (pool) {
+            size_t consumed
+                = MemPool_Get_Consumed(PostPool_Get_Mem_Pool(pool));
+            if (consumed > largest_consumed) {
+                largest          = pool;
+                largest_consumed = consumed;
+            }
+        }
+    }
+    return largest;
+}
+
+uint64_t
+PListWriter_Largest_Buffer_IMP(PostingListWriter *self) {
+    PostingPool *pool = S_largest_pool(self);
+    return pool ? MemPool_Get_Consumed(PostPool_Get_Mem_Pool(pool)) : 0;
+}
+
+void
+PListWriter_Flush_Largest_IMP(PostingListWriter *self) {
+    PostingPool *pool = S_largest_pool(self);
+    if (pool) {
+        // Write a run to the temp files, then release all of the pool's
+        // RawPostings with a single action.
+        PostPool_Flush(pool);
+        MemPool_Release_All(PostPool_Get_Mem_Pool(pool));
     }
 }
 
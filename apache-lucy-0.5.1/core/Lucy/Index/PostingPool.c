@@ -34,6 +34,7 @@
 #include "Lucy/Index/PostingListReader.h"
 #include "Lucy/Index/RawLexicon.h"
 #include "Lucy/Index/RawPostingList.h"
+#include "Lucy/Index/SegPostingList.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
@@ -52,10 +53,53 @@ static void
 S_fresh_flip(PostingPool *self, InStream *lex_temp_in,
              InStream *post_temp_in);
 
+// Supplies the next RawPosting in term/doc order, or NULL when exhausted.
+typedef RawPosting*
+(*S_fetch_t)(PostingPool *self, void *context);
+
+// A run which is already sorted by term -- a segment being merged or a run
+// flushed to temp files -- along with the stream its postings are read
+// from.
+typedef struct {
+    PostingPool *run;
+    InStream    *instream;
+} S_MergeRun;
+
+// State for merging sorted runs a term at a time.  Runs are ordered by doc
+// id and cover disjoint doc id ranges, so each term's postings can be
+// drained from one run after another without sorting.
+typedef struct {
+    S_MergeRun  *runs;
+    S_MergeRun **queue;
+    uint32_t     num_runs;
+    uint32_t     queue_size;
+} S_TermMerge;
+
 // Main loop.
 static void
 S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
-                           OutStream *skip_stream);
+                           OutStream *skip_stream, RawPosting *posting,
+                           S_fetch_t fetch, void *context);
+
+// Fetch from the sort buffer and its runs.
+static RawPosting*
+S_sorted_fetch(PostingPool *self, void *context);
+
+// If every run can be streamed a term at a time, set up `merge` with the
+// runs in doc id order and return true.  Return false if any run must go
+// through the sort buffer or if the runs' doc id ranges overlap.
+static bool
+S_init_term_merge(PostingPool *self, S_TermMerge *merge);
+
+// Find the lowest term among the runs and queue up the runs sharing it.
+static bool
+S_next_merge_term(S_TermMerge *merge);
+
+// Main loop for the term merge: copy each term's postings from the queued
+// runs, rewriting only the doc ids.
+static void
+S_merge_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
+                           OutStream *skip_stream, S_TermMerge *merge);
 
 PostingPool*
 PostPool_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -80,6 +124,8 @@ PostPool_init(PostingPool *self, Schema *schema, Snapshot *snapshot,
     PostingPoolIVARS *const ivars = PostPool_IVARS(self);
     ivars->doc_base         = 0;
     ivars->last_doc_id      = 0;
+    ivars->first_doc_id     = INT32_MAX;
+    ivars->final_doc_id     = 0;
     ivars->doc_map          = NULL;
     ivars->post_count       = 0;
     ivars->lexicon          = NULL;
@@ -261,6 +307,21 @@ PostPool_Add_Segment_IMP(PostingPool *self, SegReader *reader,
         run_ivars->plist    = plist;
         run_ivars->doc_base = doc_base;
         run_ivars->doc_map  = (I32Array*)INCREF(doc_map);
+        if (doc_map) {
+            // Doc maps assign new ids in ascending order; 0 means deleted.
+            uint32_t lo = 0;
+            uint32_t hi = I32Arr_Get_Size(doc_map);
+            while (lo < hi && !I32Arr_Get(doc_map, lo))     { lo++; }
+            while (hi > lo && !I32Arr_Get(doc_map, hi - 1)) { hi--; }
+            if (lo < hi) {
+                run_ivars->first_doc_id = I32Arr_Get(doc_map, lo);
+                run_ivars->final_doc_id = I32Arr_Get(doc_map, hi - 1);
+            }
+        }
+        else if (SegReader_Doc_Max(reader) > 0) {
+            run_ivars->first_doc_id = doc_base + 1;
+            run_ivars->final_doc_id = doc_base + SegReader_Doc_Max(reader);
+        }
         PostPool_Add_Run(self, (SortExternal*)run);
     }
 }
@@ -289,13 +350,27 @@ PostPool_Flush_IMP(PostingPool *self) {
     run_ivars->buf_max  = ivars->buf_max;
     run_ivars->buf_cap  = ivars->buf_cap;
 
+    // Note the doc ids the run covers.
+    for (uint32_t i = ivars->buf_tick; i < ivars->buf_max; i++) {
+        const int32_t doc_id
+            = RawPost_IVARS((RawPosting*)ivars->buffer[i])->doc_id;
+        if (doc_id < run_ivars->first_doc_id) {
+            run_ivars->first_doc_id = doc_id;
+        }
+        if (doc_id > run_ivars->final_doc_id) {
+            run_ivars->final_doc_id = doc_id;
+        }
+    }
+
     // Write to temp files.
     LexWriter_Enter_Temp_Mode(ivars->lex_writer, ivars->field,
                               ivars->lex_temp_out);
     run_ivars->lex_start  = OutStream_Tell(ivars->lex_temp_out);
     run_ivars->post_start = OutStream_Tell(ivars->post_temp_out);
     PostPool_Sort_Buffer(self);
-    S_write_terms_and_postings(run, post_writer, NULL);
+    S_write_terms_and_postings(run, post_writer, NULL,
+                               S_sorted_fetch(run, NULL), S_sorted_fetch,
+                               NULL);
 
     run_ivars->lex_end  = OutStream_Tell(ivars->lex_temp_out);
     run_ivars->post_end = OutStream_Tell(ivars->post_temp_out);
@@ -317,24 +392,263 @@ PostPool_Flush_IMP(PostingPool *self) {
 void
 PostPool_Finish_IMP(PostingPool *self) {
     PostingPoolIVARS *const ivars = PostPool_IVARS(self);
+    Similarity *sim = Schema_Fetch_Sim(ivars->schema, ivars->field);
+    S_TermMerge merge;
+
+    // When all content lives in sorted runs with disjoint doc id ranges,
+    // merge them a term at a time rather than pushing every posting through
+    // the sort buffer.
+    if (S_init_term_merge(self, &merge)) {
+        if (S_next_merge_term(&merge)) {
+            PostingWriter *post_writer
+                = Sim_Make_Posting_Writer(sim, ivars->schema,
+                                          ivars->snapshot, ivars->segment,
+                                          ivars->polyreader,
+                                          ivars->field_num);
+            LexWriter_Start_Field(ivars->lex_writer, ivars->field_num);
+            S_merge_terms_and_postings(self, post_writer, ivars->skip_out,
+                                       &merge);
+            LexWriter_Finish_Field(ivars->lex_writer, ivars->field_num);
+            DECREF(post_writer);
+        }
+        FREEMEM(merge.runs);
+        FREEMEM(merge.queue);
+        return;
+    }
 
     // Bail if there's no data.
-    if (!PostPool_Peek(self)) { return; }
+    RawPosting *posting = S_sorted_fetch(self, NULL);
+    if (posting) {
+        PostingWriter *post_writer
+            = Sim_Make_Posting_Writer(sim, ivars->schema, ivars->snapshot,
+                                      ivars->segment, ivars->polyreader,
+                                      ivars->field_num);
+        LexWriter_Start_Field(ivars->lex_writer, ivars->field_num);
+        S_write_terms_and_postings(self, post_writer, ivars->skip_out,
+                                   posting, S_sorted_fetch, NULL);
+        LexWriter_Finish_Field(ivars->lex_writer, ivars->field_num);
+        DECREF(post_writer);
+    }
+}
 
-    Similarity *sim = Schema_Fetch_Sim(ivars->schema, ivars->field);
-    PostingWriter *post_writer
-        = Sim_Make_Posting_Writer(sim, ivars->schema, ivars->snapshot,
-                                  ivars->segment, ivars->polyreader,
-                                  ivars->field_num);
-    LexWriter_Start_Field(ivars->lex_writer, ivars->field_num);
-    S_write_terms_and_postings(self, post_writer, ivars->skip_out);
-    LexWriter_Finish_Field(ivars->lex_writer, ivars->field_num);
-    DECREF(post_writer);
+static RawPosting*
+S_sorted_fetch(PostingPool *self, void *context) {
+    UNUSED_VAR(context);
+    return (RawPosting*)PostPool_Fetch(self);
+}
+
+static InStream*
+S_post_stream(PostingList *plist) {
+    if (PList_is_a(plist, SEGPOSTINGLIST)) {
+        return SegPList_Get_Post_Stream((SegPostingList*)plist);
+    }
+    else if (PList_is_a(plist, RAWPOSTINGLIST)) {
+        return RawPList_Get_Post_Stream((RawPostingList*)plist);
+    }
+    return NULL;
+}
+
+static bool
+S_init_term_merge(PostingPool *self, S_TermMerge *merge) {
+    PostingPoolIVARS *const ivars = PostPool_IVARS(self);
+    uint32_t num_runs = Vec_Get_Size(ivars->runs);
+    if (!num_runs || PostPool_Buffer_Count(self)) { return false; }
+
+    merge->runs  = (S_MergeRun*)MALLOCATE(num_runs * sizeof(S_MergeRun));
+    merge->queue = (S_MergeRun**)MALLOCATE(num_runs * sizeof(S_MergeRun*));
+    merge->num_runs   = 0;
+    merge->queue_size = 0;
+
+    for (uint32_t i = 0; i < num_runs; i++) {
+        PostingPool *run = (PostingPool*)Vec_Fetch(ivars->runs, i);
+        PostingPoolIVARS *const run_ivars = PostPool_IVARS(run);
+        // Runs flipped straight from the sort buffer have no Lexicon.
+        InStream *instream = run_ivars->plist
+                             ? S_post_stream(run_ivars->plist)
+                             : NULL;
+        if (!run_ivars->lexicon || !instream || PostPool_Buffer_Count(run)) {
+            FREEMEM(merge->runs);
+            FREEMEM(merge->queue);
+            return false;
+        }
+        // Skip runs with nothing left after deletions.
+        if (run_ivars->first_doc_id > run_ivars->final_doc_id) { continue; }
+
+        // Insert in order of first doc id.
+        uint32_t j = merge->num_runs++;
+        while (j > 0 && PostPool_IVARS(merge->runs[j - 1].run)->first_doc_id
+                        > run_ivars->first_doc_id) {
+            merge->runs[j] = merge->runs[j - 1];
+            j--;
+        }
+        merge->runs[j].run      = run;
+        merge->runs[j].instream = instream;
+    }
+
+    // Runs are added in whatever order the writer saw them -- a segment
+    // absorbed with Add_Segment may precede a flushed run holding lower doc
+    // ids -- so streaming is only safe when the ranges don't interleave.
+    for (uint32_t i = 1; i < merge->num_runs; i++) {
+        PostingPoolIVARS *const prev = PostPool_IVARS(merge->runs[i - 1].run);
+        PostingPoolIVARS *const curr = PostPool_IVARS(merge->runs[i].run);
+        if (curr->first_doc_id <= prev->final_doc_id) {
+            FREEMEM(merge->runs);
+            FREEMEM(merge->queue);
+            return false;
+        }
+    }
+
+    // Position each run's Lexicon on its first term.
+    uint32_t num_live = 0;
+    for (uint32_t i = 0; i < merge->num_runs; i++) {
+        PostingPoolIVARS *const run_ivars = PostPool_IVARS(merge->runs[i].run);
+        if (Lex_Next(run_ivars->lexicon)) {
+            merge->runs[num_live++] = merge->runs[i];
+        }
+    }
+    merge->num_runs = num_live;
+
+    return true;
+}
+
+static bool
+S_next_merge_term(S_TermMerge *merge) {
+    String *lowest = NULL;
+
+    merge->queue_size = 0;
+    for (uint32_t i = 0; i < merge->num_runs; i++) {
+        PostingPoolIVARS *const run_ivars = PostPool_IVARS(merge->runs[i].run);
+        if (!run_ivars->lexicon) { continue; } // exhausted
+        String *term_text = (String*)Lex_Get_Term(run_ivars->lexicon);
+        if (!term_text || !Obj_is_a((Obj*)term_text, STRING)) {
+            THROW(ERR, "Only String terms are supported for now");
+        }
+        int32_t comparison = lowest ? Str_Compare_To(term_text, (Obj*)lowest)
+                                    : -1;
+        if (comparison < 0) {
+            lowest = term_text;
+            merge->queue_size = 0;
+        }
+        if (comparison <= 0) {
+            merge->queue[merge->queue_size++] = merge->runs + i;
+        }
+    }
+
+    return merge->queue_size > 0;
+}
+
+static void
+S_merge_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
+                           OutStream *skip_stream, S_TermMerge *merge) {
+    PostingPoolIVARS *const ivars = PostPool_IVARS(self);
+    TermInfo      *const tinfo            = TInfo_new(0);
+    TermInfo      *const skip_tinfo       = TInfo_new(0);
+    TermInfoIVARS *const tinfo_ivars      = TInfo_IVARS(tinfo);
+    TermInfoIVARS *const skip_tinfo_ivars = TInfo_IVARS(skip_tinfo);
+    LexiconWriter *const lex_writer       = ivars->lex_writer;
+    SkipStepper   *const skip_stepper     = ivars->skip_stepper;
+    SkipStepperIVARS *const skip_stepper_ivars
+        = SkipStepper_IVARS(skip_stepper);
+    ByteBuf       *const term_buf         = BB_new(0);
+    const int32_t  skip_interval
+        = Arch_Skip_Interval(Schema_Get_Architecture(ivars->schema));
+
+    // The caller has already queued up the first term.
+    do {
+        PostingPoolIVARS *const first_ivars
+            = PostPool_IVARS(merge->queue[0]->run);
+        String *term_text = (String*)Lex_Get_Term(first_ivars->lexicon);
+        BB_Set_Size(term_buf, 0);
+        BB_Cat_Bytes(term_buf, Str_Get_Ptr8(term_text),
+                     Str_Get_Size(term_text));
+
+        // Start the term afresh.
+        TInfo_Reset(tinfo);
+        PostWriter_Start_Term(post_writer, tinfo);
+        SkipStepper_Set_ID_And_Filepos(skip_stepper, 0,
+                                       tinfo_ivars->post_filepos);
+        int32_t last_skip_doc     = 0;
+        int64_t last_skip_filepos = tinfo_ivars->post_filepos;
+
+        for (uint32_t i = 0; i < merge->queue_size; i++) {
+            PostingPool *run = merge->queue[i]->run;
+            InStream *instream = merge->queue[i]->instream;
+            PostingPoolIVARS *const run_ivars = PostPool_IVARS(run);
+            Posting  *posting  = PList_Get_Posting(run_ivars->plist);
+            I32Array *doc_map  = run_ivars->doc_map;
+            int32_t   doc_base = run_ivars->doc_base;
+            int32_t   last_doc_id = doc_base;
+
+            for (uint32_t count = Lex_Doc_Freq(run_ivars->lexicon);
+                 count > 0;
+                 count--
+                ) {
+                // Decode only the doc code and freq.
+                const uint32_t doc_code = InStream_Read_C32(instream);
+                const uint32_t freq     = (doc_code & 1)
+                                          ? 1
+                                          : InStream_Read_C32(instream);
+                last_doc_id += doc_code >> 1;
+
+                // Skip deletions and remap the doc id; everything else is
+                // copied verbatim.
+                int32_t doc_id = last_doc_id;
+                if (doc_map != NULL) {
+                    doc_id = I32Arr_Get(doc_map, last_doc_id - doc_base);
+                    if (!doc_id) {
+                        Post_Copy_Raw_Aux(posting, instream, NULL, freq);
+                        continue;
+                    }
+                }
+                PostWriter_Copy_Posting(post_writer, posting, instream,
+                                        doc_id, freq);
+                tinfo_ivars->doc_freq++;
+
+                // Write skip data.
+                if (skip_stream != NULL
+                    && tinfo_ivars->doc_freq % skip_interval == 0
+                   ) {
+                    // If first skip group, save skip stream pos for term
+                    // info.
+                    if (tinfo_ivars->doc_freq == skip_interval) {
+                        tinfo_ivars->skip_filepos
+                            = OutStream_Tell(skip_stream);
+                    }
+                    // Write deltas.
+                    last_skip_doc               = skip_stepper_ivars->doc_id;
+                    last_skip_filepos           = skip_stepper_ivars->filepos;
+                    skip_stepper_ivars->doc_id  = doc_id;
+                    PostWriter_Update_Skip_Info(post_writer, skip_tinfo);
+                    skip_stepper_ivars->filepos
+                        = skip_tinfo_ivars->post_filepos;
+                    SkipStepper_Write_Record(skip_stepper, skip_stream,
+                                             last_skip_doc,
+                                             last_skip_filepos);
+                }
+            }
+
+            // Done with this run's postings for the term, so move it along.
+            if (!Lex_Next(run_ivars->lexicon)) {
+                DECREF(run_ivars->lexicon);
+                run_ivars->lexicon = NULL;
+            }
+        }
+
+        // Terms whose postings were all deleted are dropped.
+        if (tinfo_ivars->doc_freq) {
+            LexWriter_Add_Term(lex_writer, (Obj*)term_buf, tinfo);
+        }
+    } while (S_next_merge_term(merge));
+
+    DECREF(term_buf);
+    DECREF(skip_tinfo);
+    DECREF(tinfo);
 }
 
 static void
 S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
-                           OutStream *skip_stream) {
+                           OutStream *skip_stream, RawPosting *posting,
+                           S_fetch_t fetch, void *context) {
     PostingPoolIVARS *const ivars = PostPool_IVARS(self);
     TermInfo      *const tinfo            = TInfo_new(0);
     TermInfo      *const skip_tinfo       = TInfo_new(0);
@@ -350,8 +664,7 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
         = Arch_Skip_Interval(Schema_Get_Architecture(ivars->schema));
 
     // Prime heldover variables.
-    RawPosting *posting
-        = (RawPosting*)CERTIFY(PostPool_Fetch(self), RAWPOSTING);
+    CERTIFY(posting, RAWPOSTING);
     RawPostingIVARS *post_ivars = RawPost_IVARS(posting);
     ByteBuf *last_term_text
         = BB_new_bytes(post_ivars->blob, post_ivars->content_len);
@@ -440,7 +753,7 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
         // Retrieve the next posting from the sort pool.
         // DECREF(posting);  // No!!  DON'T destroy!!!
 
-        posting = (RawPosting*)PostPool_Fetch(self);
+        posting = fetch(self, context);
         post_ivars = RawPost_IVARS(posting);
     }
 
@@ -55,6 +55,11 @@ RawPList_Destroy_IMP(RawPostingList *self) {
     SUPER_DESTROY(self, RAWPOSTINGLIST);
 }
 
+InStream*
+RawPList_Get_Post_Stream_IMP(RawPostingList *self) {
+    return RawPList_IVARS(self)->instream;
+}
+
 Posting*
 RawPList_Get_Posting_IMP(RawPostingList *self) {
     return RawPList_IVARS(self)->posting;
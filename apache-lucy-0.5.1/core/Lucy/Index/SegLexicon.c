@@ -25,6 +25,7 @@
 #include "Lucy/Index/LexiconWriter.h"
 #include "Lucy/Index/Posting/MatchPosting.h"
 #include "Lucy/Index/SegPostingList.h"
+#include "Lucy/Index/TermIndex.h"
 #include "Lucy/Index/TermStepper.h"
 #include "Lucy/Plan/Architecture.h"
 #include "Lucy/Plan/FieldType.h"
@@ -39,14 +40,14 @@ S_scan_to(SegLexicon *self, Obj *target);
 
 SegLexicon*
 SegLex_new(Schema *schema, Folder *folder, Segment *segment,
-           String *field) {
+           String *field, TermIndex *term_index) {
     SegLexicon *self = (SegLexicon*)Class_Make_Obj(SEGLEXICON);
-    return SegLex_init(self, schema, folder, segment, field);
+    return SegLex_init(self, schema, folder, segment, field, term_index);
 }
 
 SegLexicon*
 SegLex_init(SegLexicon *self, Schema *schema, Folder *folder,
-            Segment *segment, String *field) {
+            Segment *segment, String *field, TermIndex *term_index) {
     Hash *metadata = (Hash*)CERTIFY(
                          Seg_Fetch_Metadata_Utf8(segment, "lexicon", 7),
                          HASH);
@@ -81,7 +82,8 @@ SegLex_init(SegLexicon *self, Schema *schema, Folder *folder,
     ivars->segment        = (Segment*)INCREF(segment);
 
     // Derive.
-    ivars->lex_index      = LexIndex_new(schema, folder, segment, field);
+    ivars->lex_index      = LexIndex_new(schema, folder, segment, field,
+                                         term_index);
     ivars->field_num      = field_num;
     ivars->index_interval = Arch_Index_Interval(arch);
     ivars->skip_interval  = Arch_Skip_Interval(arch);
@@ -125,6 +127,7 @@ SegLex_Seek_IMP(SegLexicon *self, Obj *target) {
         SegLex_Reset(self);
         return;
     }
+    SegLex_Clear_Bounds(self);
 
     // Use the LexIndex to get in the ballpark.
     LexIndex_Seek(lex_index, target);
@@ -145,6 +148,7 @@ SegLex_Seek_IMP(SegLexicon *self, Obj *target) {
 void
 SegLex_Reset_IMP(SegLexicon* self) {
     SegLexiconIVARS *const ivars = SegLex_IVARS(self);
+    SegLex_Clear_Bounds(self);
     ivars->term_num = -1;
     InStream_Seek(ivars->instream, 0);
     TermStepper_Reset(ivars->term_stepper);
@@ -196,6 +200,15 @@ SegLex_Next_IMP(SegLexicon *self) {
     TermStepper_Read_Delta(ivars->term_stepper, ivars->instream);
     TermStepper_Read_Delta(ivars->tinfo_stepper, ivars->instream);
 
+    // Stop at the bounds set by Seek_Prefix() or Seek_Range().
+    Obj *term = TermStepper_Get_Value(ivars->term_stepper);
+    if (SegLex_Past_Bounds(self, term)) {
+        ivars->term_num = ivars->size;
+        TermStepper_Reset(ivars->term_stepper);
+        TermStepper_Reset(ivars->tinfo_stepper);
+        return false;
+    }
+
     return true;
 }
 
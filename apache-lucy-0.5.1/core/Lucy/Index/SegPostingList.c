@@ -42,6 +42,12 @@
 static void
 S_seek_tinfo(SegPostingList *self, TermInfo *tinfo);
 
+// Open the postings and skip files for a PostingListReader which doesn't
+// supply its own streams.
+static void
+S_open_streams(SegPostingList *self, Folder *folder, Segment *segment,
+               int32_t field_num);
+
 SegPostingList*
 SegPList_new(PostingListReader *plist_reader, String *field) {
     SegPostingList *self = (SegPostingList*)Class_Make_Obj(SEGPOSTINGLIST);
@@ -56,11 +62,7 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     Folder       *const folder   = PListReader_Get_Folder(plist_reader);
     Segment      *const segment  = PListReader_Get_Segment(plist_reader);
     Architecture *const arch     = Schema_Get_Architecture(schema);
-    String       *const seg_name = Seg_Get_Name(segment);
     int32_t       field_num      = Seg_Field_Num(segment, field);
-    String       *post_file      = Str_newf("%o/postings-%i32.dat",
-                                           seg_name, field_num);
-    String       *skip_file      = Str_newf("%o/postings.skip", seg_name);
 
     // Init.
     ivars->doc_freq        = 0;
@@ -81,7 +83,38 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     ivars->posting   = Sim_Make_Posting(sim);
     ivars->field_num = field_num;
 
-    // Open both a main stream and a skip stream if the field exists.
+    // Open both a main stream and a skip stream if the field exists.  A
+    // DefaultPostingListReader keeps both open, so clone its streams rather
+    // than going back to the Folder.
+    ivars->post_stream = NULL;
+    ivars->skip_stream = NULL;
+    ivars->pooled      = false;
+    if (Obj_is_a((Obj*)plist_reader, DEFAULTPOSTINGLISTREADER)) {
+        DefaultPostingListReader *def_reader
+            = (DefaultPostingListReader*)plist_reader;
+        InStream *post_stream
+            = DefPListReader_Post_Stream(def_reader, field_num);
+        if (post_stream) {
+            InStream *skip_stream = DefPListReader_Skip_Stream(def_reader);
+            ivars->post_stream = InStream_Clone(post_stream);
+            ivars->skip_stream = InStream_Clone(skip_stream);
+        }
+    }
+    else {
+        S_open_streams(self, folder, segment, field_num);
+    }
+
+    return self;
+}
+
+static void
+S_open_streams(SegPostingList *self, Folder *folder, Segment *segment,
+               int32_t field_num) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    String *seg_name  = Seg_Get_Name(segment);
+    String *post_file = Str_newf("%o/postings-%i32.dat", seg_name, field_num);
+    String *skip_file = Str_newf("%o/postings.skip", seg_name);
+
     if (Folder_Exists(folder, post_file)) {
         ivars->post_stream = Folder_Open_In(folder, post_file);
         if (!ivars->post_stream) {
@@ -100,21 +133,16 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
             RETHROW(error);
         }
     }
-    else {
-        //  Empty, so don't bother with these.
-        ivars->post_stream = NULL;
-        ivars->skip_stream = NULL;
-    }
     DECREF(post_file);
     DECREF(skip_file);
-
-    return self;
 }
 
 void
 SegPList_Destroy_IMP(SegPostingList *self) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
-    DECREF(ivars->plist_reader);
+    if (!ivars->pooled) {
+        DECREF(ivars->plist_reader);
+    }
     DECREF(ivars->posting);
     DECREF(ivars->skip_stepper);
     DECREF(ivars->field);
@@ -150,6 +178,21 @@ SegPList_Get_Count_IMP(SegPostingList *self) {
     return SegPList_IVARS(self)->count;
 }
 
+uint32_t
+SegPList_Num_Decoded_IMP(SegPostingList *self) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    return ivars->count - ivars->num_skipped;
+}
+
+uint64_t
+SegPList_Bytes_Read_IMP(SegPostingList *self) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    if (ivars->doc_freq == 0) { return 0; }
+    int64_t post_bytes = InStream_Tell(ivars->post_stream) - ivars->post_start;
+    int64_t skip_bytes = InStream_Tell(ivars->skip_stream) - ivars->skip_start;
+    return (uint64_t)(post_bytes + skip_bytes);
+}
+
 InStream*
 SegPList_Get_Post_Stream_IMP(SegPostingList *self) {
     return SegPList_IVARS(self)->post_stream;
@@ -229,7 +272,8 @@ SegPList_Advance_IMP(SegPostingList *self, int32_t target) {
             posting_ivars->doc_id = new_doc_id;
 
             // Increase count by the number of docs we skipped over.
-            ivars->count += num_skipped;
+            ivars->count       += num_skipped;
+            ivars->num_skipped += num_skipped;
         }
     }
 
@@ -245,6 +289,9 @@ SegPList_Advance_IMP(SegPostingList *self, int32_t target) {
 void
 SegPList_Seek_IMP(SegPostingList *self, Obj *target) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    if (!ivars->plist_reader) {
+        THROW(ERR, "Can't Seek() after the PostingListReader is gone");
+    }
     LexiconReader *lex_reader = PListReader_Get_Lex_Reader(ivars->plist_reader);
     TermInfo      *tinfo      = LexReader_Fetch_Term_Info(lex_reader,
                                                           ivars->field, target);
@@ -261,6 +308,7 @@ SegPList_Seek_Lex_IMP(SegPostingList *self, Lexicon *lexicon) {
 
     // Optimized case.
     if (Obj_is_a((Obj*)lexicon, SEGLEXICON)
+        && ivars->plist_reader
         && (SegLex_Get_Segment(seg_lexicon)
             == PListReader_Get_Segment(ivars->plist_reader)) // i.e. same segment
        ) {
@@ -274,14 +322,28 @@ SegPList_Seek_Lex_IMP(SegPostingList *self, Lexicon *lexicon) {
     }
 }
 
+void
+SegPList_Seek_Term_Info_IMP(SegPostingList *self, TermInfo *tinfo) {
+    S_seek_tinfo(self, tinfo);
+}
+
 static void
 S_seek_tinfo(SegPostingList *self, TermInfo *tinfo) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
-    ivars->count = 0;
+    ivars->count       = 0;
+    ivars->num_skipped = 0;
 
     if (tinfo == NULL) {
         // Next will return false; other methods invalid now.
         ivars->doc_freq = 0;
+        Post_Reset(ivars->posting);
+
+        // Rewind, leaving the streams where a fresh PostingList has them:
+        // PostingPool reads raw postings sequentially from the top.
+        if (ivars->post_stream) {
+            InStream_Seek(ivars->post_stream, 0);
+            InStream_Seek(ivars->skip_stream, 0);
+        }
     }
     else {
         // Transfer doc_freq, seek main stream.
@@ -297,6 +359,8 @@ S_seek_tinfo(SegPostingList *self, TermInfo *tinfo) {
         ivars->num_skips  = ivars->doc_freq / ivars->skip_interval;
         SkipStepper_Set_ID_And_Filepos(ivars->skip_stepper, 0, post_filepos);
         InStream_Seek(ivars->skip_stream, TInfo_Get_Skip_FilePos(tinfo));
+        ivars->post_start = post_filepos;
+        ivars->skip_start = TInfo_Get_Skip_FilePos(tinfo);
     }
 }
 
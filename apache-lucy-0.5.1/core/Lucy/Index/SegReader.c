@@ -18,6 +18,8 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SegReader.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/DeletionsReader.h"
 #include "Lucy/Index/DocReader.h"
 #include "Lucy/Index/DocVector.h"
@@ -134,4 +136,45 @@ SegReader_Seg_Readers_IMP(SegReader *self) {
     return seg_readers;
 }
 
+Hash*
+SegReader_Stats_IMP(SegReader *self) {
+    SegReaderIVARS *const ivars = SegReader_IVARS(self);
+    Hash    *stats      = Hash_new(0);
+    Hash    *components = Hash_new(0);
+    Hash    *fields     = Hash_new(0);
+    int64_t  bytes      = 0;
+    int64_t  resident   = 0;
+
+    HashIterator *iter = HashIter_new(ivars->components);
+    while (HashIter_Next(iter)) {
+        DataReader *component = (DataReader*)HashIter_Get_Value(iter);
+        Hash *component_stats = DataReader_Stats(component);
+        if (!component_stats) { continue; }
+        Hash *component_fields
+            = (Hash*)Hash_Fetch_Utf8(component_stats, "fields", 6);
+        if (component_fields && Obj_is_a((Obj*)component_fields, HASH)) {
+            IxReader_add_stats(fields, component_fields);
+        }
+        bytes    += IxReader_fetch_stat(component_stats, "bytes", 5);
+        resident += IxReader_fetch_stat(component_stats, "resident_bytes", 14);
+        Hash_Store(components, HashIter_Get_Key(iter),
+                   (Obj*)component_stats);
+    }
+    DECREF(iter);
+
+    double ratio = ivars->doc_max
+                   ? (double)ivars->del_count / (double)ivars->doc_max
+                   : 0.0;
+    Hash_Store_Utf8(stats, "name", 4, (Obj*)Str_Clone(ivars->seg_name));
+    Hash_Store_Utf8(stats, "doc_max", 7, (Obj*)Int_new(ivars->doc_max));
+    Hash_Store_Utf8(stats, "doc_count", 9,
+                    (Obj*)Int_new(SegReader_Doc_Count(self)));
+    Hash_Store_Utf8(stats, "del_count", 9, (Obj*)Int_new(ivars->del_count));
+    Hash_Store_Utf8(stats, "deletion_ratio", 14, (Obj*)Float_new(ratio));
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(resident));
+    Hash_Store_Utf8(stats, "fields", 6, (Obj*)fields);
+    Hash_Store_Utf8(stats, "components", 10, (Obj*)components);
+    return stats;
+}
 
@@ -19,11 +19,13 @@
 
 #include "Lucy/Index/SegWriter.h"
 #include "Lucy/Document/Doc.h"
+#include "Lucy/Document/DocBuilder.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Store/DirHandle.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/Inverter.h"
+#include "Lucy/Index/MemoryBudget.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
@@ -46,6 +48,7 @@ SegWriter_init(SegWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->by_api   = Hash_new(0);
     ivars->inverter = Inverter_new(schema, segment);
     ivars->writers  = Vec_new(16);
+    ivars->mem_budget = MemBudget_new(0);
     Arch_Init_Seg_Writer(arch, self);
     return self;
 }
@@ -57,6 +60,7 @@ SegWriter_Destroy_IMP(SegWriter *self) {
     DECREF(ivars->writers);
     DECREF(ivars->by_api);
     DECREF(ivars->del_writer);
+    DECREF(ivars->mem_budget);
     SUPER_DESTROY(self, SEGWRITER);
 }
 
@@ -111,6 +115,16 @@ SegWriter_Add_Doc_IMP(SegWriter *self, Doc *doc, float boost) {
     SegWriter_Add_Inverted_Doc(self, ivars->inverter, doc_id);
 }
 
+void
+SegWriter_Add_Built_Doc_IMP(SegWriter *self, DocBuilder *builder,
+                            float boost) {
+    SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+    int32_t doc_id = (int32_t)Seg_Increment_Count(ivars->segment, 1);
+    Inverter_Invert_Built(ivars->inverter, builder);
+    Inverter_Set_Boost(ivars->inverter, boost);
+    SegWriter_Add_Inverted_Doc(self, ivars->inverter, doc_id);
+}
+
 void
 SegWriter_Add_Inverted_Doc_IMP(SegWriter *self, Inverter *inverter,
                                int32_t doc_id) {
@@ -119,6 +133,7 @@ SegWriter_Add_Inverted_Doc_IMP(SegWriter *self, Inverter *inverter,
         DataWriter *writer = (DataWriter*)Vec_Fetch(ivars->writers, i);
         DataWriter_Add_Inverted_Doc(writer, inverter, doc_id);
     }
+    MemBudget_Balance(ivars->mem_budget, ivars->writers);
 }
 
 // Adjust current doc id. We create our own doc_count rather than rely on
@@ -202,6 +217,16 @@ SegWriter_Finish_IMP(SegWriter *self) {
         DataWriter_Finish(writer);
     }
 
+    // Now that its postings are on disk, delete docs which were replaced
+    // later in the session.
+    if (ivars->del_writer) {
+        DelWriter_Finish_Added(ivars->del_writer);
+    }
+
+    // Record the size of the segment's files for the merge policy.
+    Seg_Set_Size(ivars->segment, Seg_Measure_Size(ivars->segment,
+                                                  ivars->folder));
+
     // Write segment metadata and add the segment directory to the snapshot.
     Snapshot *snapshot = SegWriter_Get_Snapshot(self);
     String *segmeta_filename = Str_newf("%o/segmeta.json", seg_name);
@@ -210,7 +235,8 @@ SegWriter_Finish_IMP(SegWriter *self) {
     DECREF(segmeta_filename);
 
     // Collapse segment files into compound file.
-    Folder_Consolidate(ivars->folder, seg_name);
+    Folder_Consolidate(ivars->folder, seg_name,
+                       Seg_Get_Binary_Metadata(ivars->segment));
 }
 
 void
@@ -232,4 +258,18 @@ SegWriter_Get_Del_Writer_IMP(SegWriter *self) {
     return SegWriter_IVARS(self)->del_writer;
 }
 
+void
+SegWriter_Set_Mem_Budget_IMP(SegWriter *self, MemoryBudget *mem_budget) {
+    SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+    MemoryBudget *temp = ivars->mem_budget;
+    ivars->mem_budget
+        = (MemoryBudget*)INCREF(CERTIFY(mem_budget, MEMORYBUDGET));
+    DECREF(temp);
+}
+
+MemoryBudget*
+SegWriter_Get_Mem_Budget_IMP(SegWriter *self) {
+    return SegWriter_IVARS(self)->mem_budget;
+}
+
 
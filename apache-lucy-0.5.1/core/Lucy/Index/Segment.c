@@ -21,8 +21,12 @@
 
 #include "Lucy/Index/Segment.h"
 #include "Clownfish/Num.h"
+#include "Lucy/Store/CompoundFileReader.h"
+#include "Lucy/Store/DirHandle.h"
 #include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 #include "Clownfish/Util/StringHelper.h"
 #include "Lucy/Util/IndexFileNames.h"
 
@@ -42,6 +46,8 @@ Seg_init(Segment *self, int64_t number) {
     // Init.
     ivars->metadata  = Hash_new(0);
     ivars->count     = 0;
+    ivars->size      = 0;
+    ivars->binary_metadata = false;
     ivars->by_num    = Vec_new(2);
     ivars->by_name   = Hash_new(0);
 
@@ -96,7 +102,7 @@ bool
 Seg_Read_File_IMP(Segment *self, Folder *folder) {
     SegmentIVARS *const ivars = Seg_IVARS(self);
     String *filename = Str_newf("%o/segmeta.json", ivars->name);
-    Hash   *metadata = (Hash*)Json_slurp_json(folder, filename);
+    Hash   *metadata = (Hash*)MetaFile_slurp(folder, filename);
     Hash   *my_metadata;
 
     // Bail unless the segmeta file was read successfully.
@@ -115,6 +121,8 @@ Seg_Read_File_IMP(Segment *self, Folder *folder) {
     if (!count) { count = Hash_Fetch_Utf8(my_metadata, "doc_count", 9); }
     if (!count) { THROW(ERR, "Missing 'count'"); }
     else { ivars->count = Json_obj_to_i64(count); }
+    Obj *size = Hash_Fetch_Utf8(my_metadata, "size", 4);
+    ivars->size = size ? Json_obj_to_i64(size) : 0;
 
     // Get list of field nums.
     Vector *source_by_num = (Vector*)Hash_Fetch_Utf8(my_metadata,
@@ -148,12 +156,17 @@ Seg_Write_File_IMP(Segment *self, Folder *folder) {
     Hash_Store_Utf8(my_metadata, "count", 5,
                     (Obj*)Str_newf("%i64", ivars->count));
     Hash_Store_Utf8(my_metadata, "name", 4, (Obj*)Str_Clone(ivars->name));
+    if (ivars->size) {
+        Hash_Store_Utf8(my_metadata, "size", 4,
+                        (Obj*)Str_newf("%i64", ivars->size));
+    }
     Hash_Store_Utf8(my_metadata, "field_names", 11, INCREF(ivars->by_num));
     Hash_Store_Utf8(my_metadata, "format", 6, (Obj*)Str_newf("%i32", 1));
     Hash_Store_Utf8(ivars->metadata, "segmeta", 7, (Obj*)my_metadata);
 
     String *filename = Str_newf("%o/segmeta.json", ivars->name);
-    bool result = Json_spew_json((Obj*)ivars->metadata, folder, filename);
+    bool result = MetaFile_spew((Obj*)ivars->metadata, folder, filename,
+                                ivars->binary_metadata);
     DECREF(filename);
     if (!result) { RETHROW(INCREF(Err_get_error())); }
 }
@@ -200,6 +213,55 @@ Seg_Increment_Count_IMP(Segment *self, int64_t increment) {
     return ivars->count;
 }
 
+void
+Seg_Set_Size_IMP(Segment *self, int64_t size) {
+    Seg_IVARS(self)->size = size;
+}
+
+int64_t
+Seg_Get_Size_IMP(Segment *self) {
+    return Seg_IVARS(self)->size;
+}
+
+void
+Seg_Set_Binary_Metadata_IMP(Segment *self, bool binary_metadata) {
+    Seg_IVARS(self)->binary_metadata = binary_metadata;
+}
+
+bool
+Seg_Get_Binary_Metadata_IMP(Segment *self) {
+    return Seg_IVARS(self)->binary_metadata;
+}
+
+int64_t
+Seg_Measure_Size_IMP(Segment *self, Folder *folder) {
+    SegmentIVARS *const ivars = Seg_IVARS(self);
+    Folder *seg_folder = Folder_Find_Folder(folder, ivars->name);
+    int64_t size = 0;
+    if (!seg_folder) { return 0; }
+    if (Folder_is_a(seg_folder, COMPOUNDFILEREADER)) {
+        seg_folder
+            = CFReader_Get_Real_Folder((CompoundFileReader*)seg_folder);
+    }
+
+    DirHandle *dh = Folder_Local_Open_Dir(seg_folder);
+    if (!dh) { RETHROW(INCREF(Err_get_error())); }
+    while (DH_Next(dh)) {
+        if (DH_Entry_Is_Dir(dh)) { continue; }
+        String   *entry    = DH_Get_Entry(dh);
+        InStream *instream = Folder_Local_Open_In(seg_folder, entry);
+        if (instream) {
+            size += InStream_Length(instream);
+            InStream_Close(instream);
+            DECREF(instream);
+        }
+        DECREF(entry);
+    }
+    DECREF(dh);
+
+    return size;
+}
+
 void
 Seg_Store_Metadata_IMP(Segment *self, String *key, Obj *value) {
     SegmentIVARS *const ivars = Seg_IVARS(self);
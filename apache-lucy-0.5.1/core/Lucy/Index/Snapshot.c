@@ -24,6 +24,7 @@
 #include "Clownfish/Util/StringHelper.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 static Vector*
 S_clean_segment_contents(Vector *orig);
@@ -49,6 +50,7 @@ S_zero_out(Snapshot *self) {
 Snapshot*
 Snapshot_init(Snapshot *self) {
     S_zero_out(self);
+    Snapshot_IVARS(self)->binary_metadata = false;
     return self;
 }
 
@@ -104,6 +106,16 @@ Snapshot_Get_Path_IMP(Snapshot *self) {
     return Snapshot_IVARS(self)->path;
 }
 
+void
+Snapshot_Set_Binary_Metadata_IMP(Snapshot *self, bool binary_metadata) {
+    Snapshot_IVARS(self)->binary_metadata = binary_metadata;
+}
+
+bool
+Snapshot_Get_Binary_Metadata_IMP(Snapshot *self) {
+    return Snapshot_IVARS(self)->binary_metadata;
+}
+
 Snapshot*
 Snapshot_Read_File_IMP(Snapshot *self, Folder *folder, String *path) {
     SnapshotIVARS *const ivars = Snapshot_IVARS(self);
@@ -116,7 +128,7 @@ Snapshot_Read_File_IMP(Snapshot *self, Folder *folder, String *path) {
 
     if (ivars->path) {
         Hash *snap_data
-            = (Hash*)CERTIFY(Json_slurp_json(folder, ivars->path), HASH);
+            = (Hash*)CERTIFY(MetaFile_slurp(folder, ivars->path), HASH);
         Obj *format_obj
             = CERTIFY(Hash_Fetch_Utf8(snap_data, "format", 6), OBJ);
         int32_t format = (int32_t)Json_obj_to_i64(format_obj);
@@ -209,7 +221,8 @@ Snapshot_Write_File_IMP(Snapshot *self, Folder *folder, String *path) {
                     (Obj*)Str_newf("%i32", (int32_t)Snapshot_current_file_subformat));
 
     // Write out JSON-ized data to the new file.
-    Json_spew_json((Obj*)all_data, folder, ivars->path);
+    MetaFile_spew((Obj*)all_data, folder, ivars->path,
+                  ivars->binary_metadata);
 
     DECREF(all_data);
 }
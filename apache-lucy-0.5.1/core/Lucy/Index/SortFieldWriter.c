@@ -429,6 +429,14 @@ SortFieldWriter_Flush_IMP(SortFieldWriter *self) {
 
     // Add the run to the array.
     SortFieldWriter_Add_Run(self, (SortExternal*)run);
+
+    // The buffered elements are gone, so start counting from zero.
+    Counter_Reset(ivars->counter);
+}
+
+uint64_t
+SortFieldWriter_Mem_Consumed_IMP(SortFieldWriter *self) {
+    return (uint64_t)Counter_Get_Value(SortFieldWriter_IVARS(self)->counter);
 }
 
 uint32_t
@@ -19,6 +19,8 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SortReader.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Index/SortCache/NumericSortCache.h"
@@ -272,4 +274,43 @@ DefSortReader_Fetch_Sort_Cache_IMP(DefaultSortReader *self,
     return cache;
 }
 
+Hash*
+DefSortReader_Stats_IMP(DefaultSortReader *self) {
+    DefaultSortReaderIVARS *const ivars = DefSortReader_IVARS(self);
+    String  *seg_name = Seg_Get_Name(ivars->segment);
+    Hash    *fields   = Hash_new(0);
+    Hash    *stats    = Hash_new(0);
+    int64_t  bytes    = 0;
+
+    if (ivars->counts) {
+        HashIterator *iter = HashIter_new(ivars->counts);
+        while (HashIter_Next(iter)) {
+            String  *field     = HashIter_Get_Key(iter);
+            int32_t  field_num = Seg_Field_Num(ivars->segment, field);
+            if (!field_num) { continue; }
+            static const char *const exts[] = { "ord", "ix", "dat" };
+            int64_t sort_bytes = 0;
+            for (int i = 0; i < 3; i++) {
+                String *path = Str_newf("%o/sort-%i32.%s", seg_name,
+                                        field_num, exts[i]);
+                sort_bytes += Folder_File_Length(ivars->folder, path);
+                DECREF(path);
+            }
+            Hash *field_stats = Hash_new(0);
+            Hash_Store_Utf8(field_stats, "sort_values", 11,
+                            (Obj*)Int_new(Json_obj_to_i64(
+                                              HashIter_Get_Value(iter))));
+            Hash_Store_Utf8(field_stats, "sort_bytes", 10,
+                            (Obj*)Int_new(sort_bytes));
+            Hash_Store(fields, field, (Obj*)field_stats);
+            bytes += sort_bytes;
+        }
+        DECREF(iter);
+    }
+
+    Hash_Store_Utf8(stats, "bytes", 5, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "resident_bytes", 14, (Obj*)Int_new(bytes));
+    Hash_Store_Utf8(stats, "fields", 6, (Obj*)fields);
+    return stats;
+}
 
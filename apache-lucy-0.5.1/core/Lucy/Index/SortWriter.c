@@ -62,7 +62,6 @@ SortWriter_init(SortWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->temp_ord_out    = NULL;
     ivars->temp_ix_out     = NULL;
     ivars->temp_dat_out    = NULL;
-    ivars->counter         = Counter_new();
     ivars->mem_thresh      = default_mem_thresh;
     ivars->flush_at_finish = false;
 
@@ -79,7 +78,6 @@ SortWriter_Destroy_IMP(SortWriter *self) {
     DECREF(ivars->temp_ord_out);
     DECREF(ivars->temp_ix_out);
     DECREF(ivars->temp_dat_out);
-    DECREF(ivars->counter);
     SUPER_DESTROY(self, SORTWRITER);
 }
 
@@ -120,13 +118,17 @@ S_lazy_init_field_writer(SortWriter *self, int32_t field_num) {
             }
         }
 
-        String *field = Seg_Field_Name(ivars->segment, field_num);
+        // Give each field its own Counter so that MemoryBudget can flush
+        // fields individually.
+        String  *field   = Seg_Field_Name(ivars->segment, field_num);
+        Counter *counter = Counter_new();
         field_writer
             = SortFieldWriter_new(ivars->schema, ivars->snapshot, ivars->segment,
-                                  ivars->polyreader, field, ivars->counter,
+                                  ivars->polyreader, field, counter,
                                   ivars->mem_thresh, ivars->temp_ord_out,
                                   ivars->temp_ix_out, ivars->temp_dat_out);
         Vec_Store(ivars->field_writers, field_num, (Obj*)field_writer);
+        DECREF(counter);
     }
     return field_writer;
 }
@@ -134,7 +136,6 @@ S_lazy_init_field_writer(SortWriter *self, int32_t field_num) {
 void
 SortWriter_Add_Inverted_Doc_IMP(SortWriter *self, Inverter *inverter,
                                 int32_t doc_id) {
-    SortWriterIVARS *const ivars = SortWriter_IVARS(self);
     int32_t field_num;
 
     Inverter_Iterate(inverter);
@@ -147,18 +148,55 @@ SortWriter_Add_Inverted_Doc_IMP(SortWriter *self, Inverter *inverter,
                                 Inverter_Get_Value(inverter));
         }
     }
+}
 
-    // If our SortFieldWriters have collectively passed the memory threshold,
-    // flush all of them, then reset the counter which tracks memory
-    // consumption.
-    if ((size_t)Counter_Get_Value(ivars->counter) > ivars->mem_thresh) {
-        for (uint32_t i = 0; i < Vec_Get_Size(ivars->field_writers); i++) {
-            SortFieldWriter *const field_writer
-                = (SortFieldWriter*)Vec_Fetch(ivars->field_writers, i);
-            if (field_writer) { SortFieldWriter_Flush(field_writer); }
+uint64_t
+SortWriter_Mem_Consumed_IMP(SortWriter *self) {
+    SortWriterIVARS *const ivars = SortWriter_IVARS(self);
+    uint64_t consumed = 0;
+    for (uint32_t i = 0; i < Vec_Get_Size(ivars->field_writers); i++) {
+        SortFieldWriter *const field_writer
+            = (SortFieldWriter*)Vec_Fetch(ivars->field_writers, i);
+        if (field_writer) {
+            consumed += SortFieldWriter_Mem_Consumed(field_writer);
+        }
+    }
+    return consumed;
+}
+
+// Return the SortFieldWriter which has consumed the most memory, or NULL if
+// none holds any buffered elements.
+static SortFieldWriter*
+S_largest_field_writer(SortWriter *self) {
+    SortWriterIVARS *const ivars = SortWriter_IVARS(self);
+    SortFieldWriter *largest = NULL;
+    uint64_t largest_consumed = 0;
+    for (uint32_t i = 0; i < Vec_Get_Size(ivars->field_writers); i++) {
+        SortFieldWriter *const field_writer
+            = (SortFieldWriter*)Vec_Fetch(ivars->field_writers, i);
+        if (field_writer) {
+            uint64_t consumed = SortFieldWriter_Mem_Consumed(field_writer);
+            if (consumed > largest_consumed) {
+                largest          = field_writer;
+                largest_consumed = consumed;
+            }
         }
-        Counter_Reset(ivars->counter);
-        ivars->flush_at_finish = true;
+    }
+    return largest;
+}
+
+uint64_t
+SortWriter_Largest_Buffer_IMP(SortWriter *self) {
+    SortFieldWriter *field_writer = S_largest_field_writer(self);
+    return field_writer ? SortFieldWriter_Mem_Consumed(field_writer) : 0;
+}
+
+void
+SortWriter_Flush_Largest_IMP(SortWriter *self) {
+    SortFieldWriter *field_writer = S_largest_field_writer(self);
+    if (field_writer) {
+        SortFieldWriter_Flush(field_writer);
+        SortWriter_IVARS(self)->flush_at_finish = true;
     }
 }
 
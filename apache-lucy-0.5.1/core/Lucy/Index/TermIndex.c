@@ -0,0 +1,308 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_TERMINDEX
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/TermIndex.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Util/StringHelper.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/TermInfo.h"
+#include "Lucy/Index/TermStepper.h"
+#include "Lucy/Plan/Architecture.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Util/NumberUtils.h"
+
+// Number of entries per front-coded block.
+#define BLOCK_SIZE 16
+
+// Upper bound on the encoded size of an entry, not counting its suffix.
+#define MAX_ENTRY_OVERHEAD (3 * C32_MAX_BYTES + 3 * C64_MAX_BYTES)
+
+// Decode the term at `*source` into `term`, which must hold the previous
+// term of the same block.
+static CFISH_INLINE void
+S_decode_term(const char **source, ByteBuf *term);
+
+// Advance past the term info at `*source`.
+static CFISH_INLINE void
+S_skip_tinfo(TermIndexIVARS *ivars, const char **source);
+
+// Compare two UTF-8 byte sequences the way Str_Compare_To does.
+static CFISH_INLINE int32_t
+S_compare(const char *a, size_t a_size, const char *b, size_t b_size);
+
+// Read the lexicon index files and encode every entry.
+static void
+S_load(TermIndex *self, InStream *ixix_in, InStream *ix_in,
+       TermStepper *term_stepper);
+
+TermIndex*
+TermIx_new(Schema *schema, Folder *folder, Segment *segment, String *field) {
+    TermIndex *self = (TermIndex*)Class_Make_Obj(TERMINDEX);
+    return TermIx_init(self, schema, folder, segment, field);
+}
+
+TermIndex*
+TermIx_init(TermIndex *self, Schema *schema, Folder *folder,
+            Segment *segment, String *field) {
+    int32_t  field_num = Seg_Field_Num(segment, field);
+    String  *seg_name  = Seg_Get_Name(segment);
+    String  *ixix_file = Str_newf("%o/lexicon-%i32.ixix", seg_name, field_num);
+    String  *ix_file   = Str_newf("%o/lexicon-%i32.ix", seg_name, field_num);
+    Architecture *arch = Schema_Get_Architecture(schema);
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+
+    ivars->skip_interval = Arch_Skip_Interval(arch);
+
+    FieldType *type = Schema_Fetch_Type(schema, field);
+    if (!type) {
+        String *mess = MAKE_MESS("Unknown field: '%o'", field);
+        DECREF(ix_file);
+        DECREF(ixix_file);
+        DECREF(self);
+        Err_throw_mess(ERR, mess);
+    }
+    InStream *ixix_in = Folder_Open_In(folder, ixix_file);
+    InStream *ix_in   = ixix_in ? Folder_Open_In(folder, ix_file) : NULL;
+    DECREF(ixix_file);
+    DECREF(ix_file);
+    if (!ix_in) {
+        Err *error = (Err*)INCREF(Err_get_error());
+        DECREF(ixix_in);
+        DECREF(self);
+        RETHROW(error);
+    }
+
+    TermStepper *term_stepper = FType_Make_Term_Stepper(type);
+    S_load(self, ixix_in, ix_in, term_stepper);
+    DECREF(term_stepper);
+    InStream_Close(ix_in);
+    InStream_Close(ixix_in);
+    DECREF(ix_in);
+    DECREF(ixix_in);
+
+    return self;
+}
+
+void
+TermIx_Destroy_IMP(TermIndex *self) {
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+    FREEMEM(ivars->blob);
+    FREEMEM(ivars->heads);
+    SUPER_DESTROY(self, TERMINDEX);
+}
+
+static void
+S_load(TermIndex *self, InStream *ixix_in, InStream *ix_in,
+       TermStepper *term_stepper) {
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+    const int64_t  ixix_len = InStream_Length(ixix_in);
+    const int32_t  size     = (int32_t)(ixix_len / sizeof(int64_t));
+    const int64_t *offsets
+        = (const int64_t*)InStream_Buf(ixix_in, (size_t)ixix_len);
+    ByteBuf *last_term = BB_new(0);
+    size_t   cap       = 0;
+    int64_t  last_post_filepos = 0;
+    int64_t  last_lex_filepos  = 0;
+
+    ivars->size       = size;
+    ivars->num_blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    ivars->heads      = (size_t*)MALLOCATE(
+                            (ivars->num_blocks + 1) * sizeof(size_t));
+    ivars->blob       = NULL;
+    ivars->blob_size  = 0;
+
+    for (int32_t i = 0; i < size; i++) {
+        int64_t offset = (int64_t)NumUtil_decode_bigend_u64(offsets + i);
+        InStream_Seek(ix_in, offset);
+        TermStepper_Read_Key_Frame(term_stepper, ix_in);
+        String *term = (String*)CERTIFY(TermStepper_Get_Value(term_stepper),
+                                        STRING);
+        const char *text      = Str_Get_Ptr8(term);
+        size_t      text_size = Str_Get_Size(term);
+        int32_t doc_freq     = InStream_Read_C32(ix_in);
+        int64_t post_filepos = InStream_Read_C64(ix_in);
+        int64_t skip_filepos = doc_freq >= ivars->skip_interval
+                               ? InStream_Read_C64(ix_in)
+                               : 0;
+        int64_t lex_filepos  = InStream_Read_C64(ix_in);
+
+        // Block heads hold their term in full and absolute file positions.
+        size_t overlap = 0;
+        if (i % BLOCK_SIZE == 0) {
+            ivars->heads[i / BLOCK_SIZE] = ivars->blob_size;
+            last_post_filepos = 0;
+            last_lex_filepos  = 0;
+        }
+        else {
+            overlap = (size_t)StrHelp_overlap(BB_Get_Buf(last_term), text,
+                                              BB_Get_Size(last_term),
+                                              text_size);
+        }
+
+        // Encode the entry.
+        size_t needed = ivars->blob_size + MAX_ENTRY_OVERHEAD
+                        + (text_size - overlap);
+        if (needed > cap) {
+            cap = needed + (needed >> 2) + 256;
+            ivars->blob = (char*)REALLOCATE(ivars->blob, cap);
+        }
+        char *dest = ivars->blob + ivars->blob_size;
+        NumUtil_encode_c32((uint32_t)overlap, &dest);
+        NumUtil_encode_c32((uint32_t)(text_size - overlap), &dest);
+        memcpy(dest, text + overlap, text_size - overlap);
+        dest += text_size - overlap;
+        NumUtil_encode_c32((uint32_t)doc_freq, &dest);
+        NumUtil_encode_c64((uint64_t)(post_filepos - last_post_filepos),
+                           &dest);
+        NumUtil_encode_c64((uint64_t)(lex_filepos - last_lex_filepos), &dest);
+        if (doc_freq >= ivars->skip_interval) {
+            NumUtil_encode_c64((uint64_t)skip_filepos, &dest);
+        }
+        ivars->blob_size = (size_t)(dest - ivars->blob);
+
+        last_post_filepos = post_filepos;
+        last_lex_filepos  = lex_filepos;
+        BB_Set_Size(last_term, 0);
+        BB_Cat_Bytes(last_term, text, text_size);
+    }
+    ivars->heads[ivars->num_blocks] = ivars->blob_size;
+
+    // Give back the slack.
+    if (ivars->blob_size) {
+        ivars->blob = (char*)REALLOCATE(ivars->blob, ivars->blob_size);
+    }
+    DECREF(last_term);
+}
+
+static CFISH_INLINE void
+S_decode_term(const char **source, ByteBuf *term) {
+    uint32_t overlap = NumUtil_decode_c32(source);
+    uint32_t len     = NumUtil_decode_c32(source);
+    BB_Set_Size(term, overlap);
+    BB_Cat_Bytes(term, *source, len);
+    *source += len;
+}
+
+static CFISH_INLINE void
+S_skip_tinfo(TermIndexIVARS *ivars, const char **source) {
+    int32_t doc_freq = (int32_t)NumUtil_decode_c32(source);
+    NumUtil_skip_cint(source);
+    NumUtil_skip_cint(source);
+    if (doc_freq >= ivars->skip_interval) {
+        NumUtil_skip_cint(source);
+    }
+}
+
+static CFISH_INLINE int32_t
+S_compare(const char *a, size_t a_size, const char *b, size_t b_size) {
+    int comparison = memcmp(a, b, a_size < b_size ? a_size : b_size);
+    if (comparison < 0) { return -1; }
+    if (comparison > 0) { return 1; }
+    return a_size < b_size ? -1 : a_size > b_size ? 1 : 0;
+}
+
+int32_t
+TermIx_Find_IMP(TermIndex *self, const char *key, size_t size,
+                ByteBuf *scratch) {
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+    int32_t lo = 0;
+    int32_t hi = ivars->num_blocks - 1;
+
+    // Binary search the block heads, whose terms are stored in full.
+    while (hi >= lo) {
+        const int32_t mid = lo + ((hi - lo) / 2);
+        const char *ptr = ivars->blob + ivars->heads[mid];
+        NumUtil_skip_cint(&ptr);
+        uint32_t len = NumUtil_decode_c32(&ptr);
+        int32_t comparison = S_compare(key, size, ptr, len);
+        if (comparison < 0)      { hi = mid - 1; }
+        else if (comparison > 0) { lo = mid + 1; }
+        else                     { return mid * BLOCK_SIZE; }
+    }
+    if (hi < 0) { return 0; } // key lt first entry
+
+    // Scan the block for the last term le key.
+    int32_t     tick  = hi * BLOCK_SIZE;
+    int32_t     limit = tick + BLOCK_SIZE < ivars->size
+                        ? tick + BLOCK_SIZE
+                        : ivars->size;
+    const char *ptr   = ivars->blob + ivars->heads[hi];
+    BB_Set_Size(scratch, 0);
+    S_decode_term(&ptr, scratch);
+    S_skip_tinfo(ivars, &ptr);
+    while (tick + 1 < limit) {
+        S_decode_term(&ptr, scratch);
+        if (S_compare(BB_Get_Buf(scratch), BB_Get_Size(scratch), key, size)
+            > 0) {
+            break;
+        }
+        S_skip_tinfo(ivars, &ptr);
+        tick++;
+    }
+
+    return tick;
+}
+
+void
+TermIx_Read_Entry_IMP(TermIndex *self, int32_t tick, ByteBuf *term,
+                      TermInfo *tinfo) {
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+    if (tick < 0 || tick >= ivars->size) {
+        THROW(ERR, "Entry %i32 out of range (0-%i32)", tick, ivars->size);
+    }
+
+    const int32_t block = tick / BLOCK_SIZE;
+    const char *ptr = ivars->blob + ivars->heads[block];
+    int32_t doc_freq     = 0;
+    int64_t post_filepos = 0;
+    int64_t skip_filepos = 0;
+    int64_t lex_filepos  = 0;
+    BB_Set_Size(term, 0);
+    for (int32_t i = block * BLOCK_SIZE; i <= tick; i++) {
+        S_decode_term(&ptr, term);
+        doc_freq      = (int32_t)NumUtil_decode_c32(&ptr);
+        post_filepos += (int64_t)NumUtil_decode_c64(&ptr);
+        lex_filepos  += (int64_t)NumUtil_decode_c64(&ptr);
+        skip_filepos  = doc_freq >= ivars->skip_interval
+                        ? (int64_t)NumUtil_decode_c64(&ptr)
+                        : 0;
+    }
+
+    TInfo_Set_Doc_Freq(tinfo, doc_freq);
+    TInfo_Set_Post_FilePos(tinfo, post_filepos);
+    TInfo_Set_Skip_FilePos(tinfo, skip_filepos);
+    TInfo_Set_Lex_FilePos(tinfo, lex_filepos);
+}
+
+int32_t
+TermIx_Get_Size_IMP(TermIndex *self) {
+    return TermIx_IVARS(self)->size;
+}
+
+int64_t
+TermIx_Get_Bytes_IMP(TermIndex *self) {
+    TermIndexIVARS *const ivars = TermIx_IVARS(self);
+    return (int64_t)(ivars->blob_size
+                     + (size_t)(ivars->num_blocks + 1) * sizeof(size_t));
+}
+
+
@@ -0,0 +1,326 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_TIEREDMERGEPOLICY
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Object/I32Array.h"
+
+typedef struct {
+    int32_t tick;
+    double  size;
+    double  live;
+    double  del_ratio;
+} SegStat;
+
+// Order by descending live size, then by tick for a stable result.
+static int
+S_compare_live_desc(const void *va, const void *vb);
+
+// Return the number of segments the tiers allow for `total` live bytes.
+static double
+S_allowed_seg_count(TieredMergePolicyIVARS *ivars, double min_size,
+                    double total);
+
+// Find the cheapest merge among `eligible`, which must be sorted by
+// descending size.  Store its ticks in `picks` and return how many there
+// are, or 0 if no merge of two or more segments is possible.
+static uint32_t
+S_best_merge(TieredMergePolicyIVARS *ivars, SegStat *eligible,
+             uint32_t num_eligible, int32_t *picks);
+
+// Find the single segment whose rewrite reclaims the most deleted bytes
+// among those with too many deletions.  Return its tick, or -1.
+static int32_t
+S_best_reclaim(TieredMergePolicyIVARS *ivars, SegStat *stats,
+               uint32_t num_stats);
+
+TieredMergePolicy*
+TieredMP_new() {
+    TieredMergePolicy *self
+        = (TieredMergePolicy*)Class_Make_Obj(TIEREDMERGEPOLICY);
+    return TieredMP_init(self);
+}
+
+TieredMergePolicy*
+TieredMP_init(TieredMergePolicy *self) {
+    MergePolicy_init((MergePolicy*)self);
+    TieredMergePolicyIVARS *const ivars = TieredMP_IVARS(self);
+    ivars->segs_per_tier          = 10;
+    ivars->max_merge_at_once      = 10;
+    ivars->max_merged_size        = INT64_C(5) * 1024 * 1024 * 1024;
+    ivars->floor_size             = INT64_C(2) * 1024 * 1024;
+    ivars->deletes_pct_allowed    = 20.0;
+    ivars->reclaim_deletes_weight = 2.0;
+    return self;
+}
+
+I32Array*
+TieredMP_Find_Merge_IMP(TieredMergePolicy *self, Vector *candidates) {
+    TieredMergePolicyIVARS *const ivars = TieredMP_IVARS(self);
+    uint32_t num_stats = Vec_Get_Size(candidates);
+    if (num_stats == 0) { return I32Arr_new_blank(0); }
+
+    SegStat *stats = (SegStat*)MALLOCATE(num_stats * sizeof(SegStat));
+    for (uint32_t i = 0; i < num_stats; i++) {
+        MergeCandidate *candidate
+            = (MergeCandidate*)CERTIFY(Vec_Fetch(candidates, i),
+                                       MERGECANDIDATE);
+        stats[i].tick      = (int32_t)i;
+        stats[i].size      = (double)MergeCand_Get_Size(candidate);
+        stats[i].live      = MergeCand_Live_Size(candidate);
+        stats[i].del_ratio = MergeCand_Del_Ratio(candidate);
+    }
+    qsort(stats, num_stats, sizeof(SegStat), S_compare_live_desc);
+
+    // Set aside segments too large to be merged with others.  Since stats
+    // are sorted, the eligible ones form a tail.
+    double   half_max = (double)ivars->max_merged_size / 2.0;
+    uint32_t first_eligible = 0;
+    while (first_eligible < num_stats
+           && stats[first_eligible].live > half_max
+          ) {
+        first_eligible++;
+    }
+    SegStat  *eligible     = stats + first_eligible;
+    uint32_t  num_eligible = num_stats - first_eligible;
+    double    total        = 0.0;
+    for (uint32_t i = 0; i < num_eligible; i++) {
+        total += eligible[i].live;
+    }
+
+    int32_t  *picks     = (int32_t*)MALLOCATE((ivars->max_merge_at_once + 1)
+                                              * sizeof(int32_t));
+    uint32_t  num_picks = 0;
+    if (num_eligible > 1) {
+        double min_size = eligible[num_eligible - 1].live;
+        double allowed  = S_allowed_seg_count(ivars, min_size, total);
+        if ((double)num_eligible > allowed) {
+            num_picks = S_best_merge(ivars, eligible, num_eligible, picks);
+        }
+    }
+    if (num_picks == 0) {
+        int32_t tick = S_best_reclaim(ivars, stats, num_stats);
+        if (tick >= 0) { picks[num_picks++] = tick; }
+    }
+
+    FREEMEM(stats);
+    return I32Arr_new_steal(picks, num_picks);
+}
+
+static int
+S_compare_live_desc(const void *va, const void *vb) {
+    const SegStat *a = (const SegStat*)va;
+    const SegStat *b = (const SegStat*)vb;
+    if (a->live > b->live) { return -1; }
+    if (a->live < b->live) { return 1; }
+    return a->tick - b->tick;
+}
+
+static double
+S_allowed_seg_count(TieredMergePolicyIVARS *ivars, double min_size,
+                    double total) {
+    double level     = min_size > (double)ivars->floor_size
+                       ? min_size
+                       : (double)ivars->floor_size;
+    double remaining = total;
+    double allowed   = 0.0;
+    while (true) {
+        double seg_count_level = remaining / level;
+        if (seg_count_level < (double)ivars->segs_per_tier) {
+            allowed += ceil(seg_count_level);
+            break;
+        }
+        allowed   += (double)ivars->segs_per_tier;
+        remaining -= (double)ivars->segs_per_tier * level;
+        level     *= (double)ivars->max_merge_at_once;
+    }
+    // Never merge just because the index is small.
+    if (allowed < (double)ivars->segs_per_tier) {
+        allowed = (double)ivars->segs_per_tier;
+    }
+    return allowed;
+}
+
+static uint32_t
+S_best_merge(TieredMergePolicyIVARS *ivars, SegStat *eligible,
+             uint32_t num_eligible, int32_t *picks) {
+    double    max_merged = (double)ivars->max_merged_size;
+    double    best_score = 0.0;
+    uint32_t  num_best   = 0;
+    int32_t  *trial      = (int32_t*)MALLOCATE(ivars->max_merge_at_once
+                                               * sizeof(int32_t));
+
+    for (uint32_t start = 0; start + 1 < num_eligible; start++) {
+        uint32_t num_trial      = 0;
+        double   total_before   = 0.0;
+        double   total_after    = 0.0;
+        double   largest        = 0.0;
+        bool     hit_too_large  = false;
+
+        for (uint32_t i = start;
+             i < num_eligible && num_trial < ivars->max_merge_at_once;
+             i++
+            ) {
+            SegStat *stat = eligible + i;
+            if (total_after + stat->live > max_merged) {
+                // Skip it, but keep packing smaller segments in.
+                hit_too_large = true;
+                continue;
+            }
+            if (stat->live > largest) { largest = stat->live; }
+            trial[num_trial++] = stat->tick;
+            total_before += stat->size;
+            total_after  += stat->live;
+        }
+        if (num_trial < 2) { continue; }
+
+        // Lower is better.  Favor merges of equally sized segments (low
+        // skew), small merges, and merges which reclaim deletions.  Unlike
+        // the tier budget, skew uses actual sizes so that tiny segments are
+        // gathered into progressively larger ones rather than being
+        // rewritten together with bigger ones over and over.
+        double skew = hit_too_large
+                      ? 1.0 / (double)ivars->max_merge_at_once
+                      : total_after > 0.0
+                      ? largest / total_after
+                      : 0.0;
+        double score = skew * pow(total_after, 0.05);
+        if (total_before > 0.0) {
+            score *= pow(total_after / total_before,
+                         ivars->reclaim_deletes_weight);
+        }
+        if (num_best == 0 || score < best_score) {
+            best_score = score;
+            num_best   = num_trial;
+            memcpy(picks, trial, num_trial * sizeof(int32_t));
+        }
+    }
+
+    FREEMEM(trial);
+    return num_best;
+}
+
+static int32_t
+S_best_reclaim(TieredMergePolicyIVARS *ivars, SegStat *stats,
+               uint32_t num_stats) {
+    double  threshold  = ivars->deletes_pct_allowed / 100.0;
+    double  max_merged = (double)ivars->max_merged_size;
+    double  best       = 0.0;
+    int32_t best_tick  = -1;
+    for (uint32_t i = 0; i < num_stats; i++) {
+        SegStat *stat = stats + i;
+        if (stat->del_ratio > threshold && stat->live <= max_merged) {
+            double reclaimed = stat->size - stat->live;
+            if (best_tick < 0 || reclaimed > best) {
+                best      = reclaimed;
+                best_tick = stat->tick;
+            }
+        }
+    }
+    return best_tick;
+}
+
+void
+TieredMP_Set_Segs_Per_Tier_IMP(TieredMergePolicy *self,
+                               uint32_t segs_per_tier) {
+    if (segs_per_tier < 2) {
+        THROW(ERR, "segs_per_tier must be at least 2: %u32", segs_per_tier);
+    }
+    TieredMP_IVARS(self)->segs_per_tier = segs_per_tier;
+}
+
+uint32_t
+TieredMP_Get_Segs_Per_Tier_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->segs_per_tier;
+}
+
+void
+TieredMP_Set_Max_Merge_At_Once_IMP(TieredMergePolicy *self,
+                                   uint32_t max_merge_at_once) {
+    if (max_merge_at_once < 2) {
+        THROW(ERR, "max_merge_at_once must be at least 2: %u32",
+              max_merge_at_once);
+    }
+    TieredMP_IVARS(self)->max_merge_at_once = max_merge_at_once;
+}
+
+uint32_t
+TieredMP_Get_Max_Merge_At_Once_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->max_merge_at_once;
+}
+
+void
+TieredMP_Set_Max_Merged_Size_IMP(TieredMergePolicy *self,
+                                 int64_t max_merged_size) {
+    if (max_merged_size <= 0) {
+        THROW(ERR, "max_merged_size must be positive: %i64",
+              max_merged_size);
+    }
+    TieredMP_IVARS(self)->max_merged_size = max_merged_size;
+}
+
+int64_t
+TieredMP_Get_Max_Merged_Size_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->max_merged_size;
+}
+
+void
+TieredMP_Set_Floor_Size_IMP(TieredMergePolicy *self, int64_t floor_size) {
+    if (floor_size <= 0) {
+        THROW(ERR, "floor_size must be positive: %i64", floor_size);
+    }
+    TieredMP_IVARS(self)->floor_size = floor_size;
+}
+
+int64_t
+TieredMP_Get_Floor_Size_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->floor_size;
+}
+
+void
+TieredMP_Set_Deletes_Pct_Allowed_IMP(TieredMergePolicy *self,
+                                     double deletes_pct_allowed) {
+    if (deletes_pct_allowed < 0.0 || deletes_pct_allowed > 100.0) {
+        THROW(ERR, "deletes_pct_allowed out of range: %f64",
+              deletes_pct_allowed);
+    }
+    TieredMP_IVARS(self)->deletes_pct_allowed = deletes_pct_allowed;
+}
+
+double
+TieredMP_Get_Deletes_Pct_Allowed_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->deletes_pct_allowed;
+}
+
+void
+TieredMP_Set_Reclaim_Deletes_Weight_IMP(TieredMergePolicy *self,
+                                        double weight) {
+    if (weight < 0.0) {
+        THROW(ERR, "reclaim_deletes_weight can't be negative: %f64", weight);
+    }
+    TieredMP_IVARS(self)->reclaim_deletes_weight = weight;
+}
+
+double
+TieredMP_Get_Reclaim_Deletes_Weight_IMP(TieredMergePolicy *self) {
+    return TieredMP_IVARS(self)->reclaim_deletes_weight;
+}
+
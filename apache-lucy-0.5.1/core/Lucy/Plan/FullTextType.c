@@ -50,6 +50,7 @@ FullTextType_init2(FullTextType *self, Analyzer *analyzer, float boost,
     ivars->sortable      = sortable;
     ivars->highlightable = highlightable;
     ivars->analyzer      = (Analyzer*)INCREF(analyzer);
+    ivars->shingle_field = NULL;
 
     return self;
 }
@@ -58,6 +59,7 @@ void
 FullTextType_Destroy_IMP(FullTextType *self) {
     FullTextTypeIVARS *const ivars = FullTextType_IVARS(self);
     DECREF(ivars->analyzer);
+    DECREF(ivars->shingle_field);
     SUPER_DESTROY(self, FULLTEXTTYPE);
 }
 
@@ -76,6 +78,12 @@ FullTextType_Equals_IMP(FullTextType *self, Obj *other) {
     if (!Analyzer_Equals(ivars->analyzer, (Obj*)ovars->analyzer)) {
         return false;
     }
+    if (ivars->shingle_field || ovars->shingle_field) {
+        if (!ivars->shingle_field || !ovars->shingle_field) { return false; }
+        if (!Str_Equals(ivars->shingle_field, (Obj*)ovars->shingle_field)) {
+            return false;
+        }
+    }
     return true;
 }
 
@@ -101,6 +109,10 @@ FullTextType_Dump_For_Schema_IMP(FullTextType *self) {
     if (ivars->highlightable) {
         Hash_Store_Utf8(dump, "highlightable", 13, (Obj*)CFISH_TRUE);
     }
+    if (ivars->shingle_field) {
+        Hash_Store_Utf8(dump, "shingle_field", 13,
+                        (Obj*)Str_Clone(ivars->shingle_field));
+    }
 
     return dump;
 }
@@ -160,6 +172,12 @@ FullTextType_Load_IMP(FullTextType *self, Obj *dump) {
     FullTextType_init2(loaded, analyzer, boost, indexed, stored,
                        sortable, hl);
     DECREF(analyzer);
+
+    Obj *shingle_dump = Hash_Fetch_Utf8(source, "shingle_field", 13);
+    if (shingle_dump) {
+        FullTextType_Set_Shingle_Field(loaded,
+                                       (String*)CERTIFY(shingle_dump, STRING));
+    }
     return loaded;
 }
 
@@ -173,6 +191,19 @@ FullTextType_Get_Analyzer_IMP(FullTextType *self) {
     return FullTextType_IVARS(self)->analyzer;
 }
 
+void
+FullTextType_Set_Shingle_Field_IMP(FullTextType *self, String *field) {
+    FullTextTypeIVARS *const ivars = FullTextType_IVARS(self);
+    String *temp = ivars->shingle_field;
+    ivars->shingle_field = field ? Str_Clone(field) : NULL;
+    DECREF(temp);
+}
+
+String*
+FullTextType_Get_Shingle_Field_IMP(FullTextType *self) {
+    return FullTextType_IVARS(self)->shingle_field;
+}
+
 bool
 FullTextType_Highlightable_IMP(FullTextType *self) {
     return FullTextType_IVARS(self)->highlightable;
@@ -32,6 +32,7 @@
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Util/Freezer.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 // Scan the array to see if an object testing as Equal is present.  If not,
 // push the elem onto the end of the array.
@@ -420,12 +421,13 @@ Schema_Eat_IMP(Schema *self, Schema *other) {
 }
 
 void
-Schema_Write_IMP(Schema *self, Folder *folder, String *filename) {
+Schema_Write_IMP(Schema *self, Folder *folder, String *filename,
+                 bool binary) {
     Hash *dump = Schema_Dump(self);
     String *schema_temp = SSTR_WRAP_C("schema.temp");
     bool success;
     Folder_Delete(folder, schema_temp); // Just in case.
-    Json_spew_json((Obj*)dump, folder, schema_temp);
+    MetaFile_spew((Obj*)dump, folder, schema_temp, binary);
     success = Folder_Rename(folder, schema_temp, filename);
     DECREF(dump);
     if (!success) { RETHROW(INCREF(Err_get_error())); }
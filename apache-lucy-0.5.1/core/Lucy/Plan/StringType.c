@@ -43,9 +43,20 @@ StringType_init2(StringType *self, float boost, bool indexed,
     ivars->indexed    = indexed;
     ivars->stored     = stored;
     ivars->sortable   = sortable;
+    ivars->primary_key = false;
     return self;
 }
 
+void
+StringType_Set_Primary_Key_IMP(StringType *self, bool primary_key) {
+    StringType_IVARS(self)->primary_key = primary_key;
+}
+
+bool
+StringType_Primary_Key_IMP(StringType *self) {
+    return StringType_IVARS(self)->primary_key;
+}
+
 bool
 StringType_Equals_IMP(StringType *self, Obj *other) {
     if ((StringType*)other == self) { return true; }
@@ -75,6 +86,9 @@ StringType_Dump_For_Schema_IMP(StringType *self) {
     if (ivars->sortable) {
         Hash_Store_Utf8(dump, "sortable", 8, (Obj*)CFISH_TRUE);
     }
+    if (ivars->primary_key) {
+        Hash_Store_Utf8(dump, "primary_key", 11, (Obj*)CFISH_TRUE);
+    }
 
     return dump;
 }
@@ -101,6 +115,7 @@ StringType_Load_IMP(StringType *self, Obj *dump) {
     Obj *indexed_dump    = Hash_Fetch_Utf8(source, "indexed", 7);
     Obj *stored_dump     = Hash_Fetch_Utf8(source, "stored", 6);
     Obj *sortable_dump   = Hash_Fetch_Utf8(source, "sortable", 8);
+    Obj *pk_dump         = Hash_Fetch_Utf8(source, "primary_key", 11);
     UNUSED_VAR(self);
 
     float boost    = boost_dump    ? (float)Json_obj_to_f64(boost_dump) : 1.0f;
@@ -108,7 +123,11 @@ StringType_Load_IMP(StringType *self, Obj *dump) {
     bool  stored   = stored_dump   ? Json_obj_to_bool(stored_dump)      : true;
     bool  sortable = sortable_dump ? Json_obj_to_bool(sortable_dump)    : false;
 
-    return StringType_init2(loaded, boost, indexed, stored, sortable);
+    StringType_init2(loaded, boost, indexed, stored, sortable);
+    if (pk_dump && Json_obj_to_bool(pk_dump)) {
+        StringType_Set_Primary_Key(loaded, true);
+    }
+    return loaded;
 }
 
 Similarity*
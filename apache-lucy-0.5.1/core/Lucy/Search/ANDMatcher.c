@@ -37,12 +37,27 @@ ANDMatcher_init(ANDMatcher *self, Vector *children, Similarity *sim) {
     // Assign.
     ivars->more         = ivars->num_kids ? true : false;
     ivars->kids         = (Matcher**)MALLOCATE(ivars->num_kids * sizeof(Matcher*));
+    ivars->by_cost      = (Matcher**)MALLOCATE(ivars->num_kids * sizeof(Matcher*));
     for (uint32_t i = 0; i < ivars->num_kids; i++) {
         Matcher *child = (Matcher*)Vec_Fetch(children, i);
         ivars->kids[i] = child;
         if (!Matcher_Next(child)) { ivars->more = false; }
     }
 
+    // Order the children from cheapest to most expensive.  Ties keep their
+    // original order.  Scoring still uses `kids`, so the order in which
+    // scores are summed doesn't change.
+    for (uint32_t i = 0; i < ivars->num_kids; i++) {
+        Matcher *child = ivars->kids[i];
+        int32_t  cost  = Matcher_Estimate_Cost(child);
+        uint32_t j     = i;
+        while (j > 0 && Matcher_Estimate_Cost(ivars->by_cost[j - 1]) > cost) {
+            ivars->by_cost[j] = ivars->by_cost[j - 1];
+            j--;
+        }
+        ivars->by_cost[j] = child;
+    }
+
     // Derive.
     ivars->matching_kids = ivars->num_kids;
 
@@ -53,6 +68,7 @@ void
 ANDMatcher_Destroy_IMP(ANDMatcher *self) {
     ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
     FREEMEM(ivars->kids);
+    FREEMEM(ivars->by_cost);
     SUPER_DESTROY(self, ANDMATCHER);
 }
 
@@ -63,7 +79,7 @@ ANDMatcher_Next_IMP(ANDMatcher *self) {
         return ANDMatcher_Advance(self, 1);
     }
     if (ivars->more) {
-        const int32_t target = Matcher_Get_Doc_ID(ivars->kids[0]) + 1;
+        const int32_t target = Matcher_Get_Doc_ID(ivars->by_cost[0]) + 1;
         return ANDMatcher_Advance(self, target);
     }
     else {
@@ -74,78 +90,60 @@ ANDMatcher_Next_IMP(ANDMatcher *self) {
 int32_t
 ANDMatcher_Advance_IMP(ANDMatcher *self, int32_t target) {
     ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
-    Matcher **const kids     = ivars->kids;
+    Matcher **const kids     = ivars->by_cost;
+    Matcher  *const lead     = kids[0];
     const uint32_t  num_kids = ivars->num_kids;
-    int32_t         highest  = 0;
+    int32_t         doc_id;
 
     if (!ivars->more) { return 0; }
 
-    // First step: Advance first child and use its doc as a starting point.
+    // First step: Let the cheapest child propose a doc.  All children were
+    // positioned on their first doc by the constructor.
     if (ivars->first_time) {
         ivars->first_time = false;
+        doc_id = Matcher_Get_Doc_ID(lead);
+        if (doc_id < target) { doc_id = Matcher_Advance(lead, target); }
     }
     else {
-        highest = Matcher_Advance(kids[0], target);
-        if (!highest) {
-            ivars->more = false;
-            return 0;
-        }
+        doc_id = Matcher_Advance(lead, target);
     }
 
-    // Second step: reconcile.
-    while (1) {
-        bool agreement = true;
-
-        // Scoot all Matchers up.
-        for (uint32_t i = 0; i < num_kids; i++) {
+    // Second step: bring the other children up to the proposed doc.  If one
+    // of them overshoots, the lead skips ahead to where it landed and the
+    // others try again.
+    while (doc_id) {
+        uint32_t i = 1;
+        for (; i < num_kids; i++) {
             Matcher *const child = kids[i];
             int32_t candidate = Matcher_Get_Doc_ID(child);
-
-            // If this child is highest, others will need to catch up.
-            if (highest < candidate) {
-                highest = candidate;
-            }
-
-            // If least doc Matchers can agree on exceeds target, raise bar.
-            if (target < highest) {
-                target = highest;
-            }
-
-            // Scoot this Matcher up if not already at highest.
-            if (candidate < target) {
-                // This Matcher is definitely the highest right now.
-                highest = Matcher_Advance(child, target);
-                if (!highest) {
-                    ivars->more = false;
-                    return 0;
+            if (candidate < doc_id) {
+                candidate = Matcher_Advance(child, doc_id);
+                if (!candidate) {
+                    doc_id = 0;
+                    break;
                 }
             }
-        }
-
-        // If Matchers don't agree, send back through the loop.
-        for (uint32_t i = 0; i < num_kids; i++) {
-            Matcher *const child = kids[i];
-            const int32_t candidate = Matcher_Get_Doc_ID(child);
-            if (candidate != highest) {
-                agreement = false;
+            if (candidate > doc_id) {
+                doc_id = Matcher_Advance(lead, candidate);
                 break;
             }
         }
-
-        if (!agreement) {
-            continue;
-        }
-        if (highest >= target) {
-            break;
-        }
+        if (i == num_kids) { return doc_id; }
     }
 
-    return highest;
+    ivars->more = false;
+    return 0;
 }
 
 int32_t
 ANDMatcher_Get_Doc_ID_IMP(ANDMatcher *self) {
-    return Matcher_Get_Doc_ID(ANDMatcher_IVARS(self)->kids[0]);
+    return Matcher_Get_Doc_ID(ANDMatcher_IVARS(self)->by_cost[0]);
+}
+
+int32_t
+ANDMatcher_Estimate_Cost_IMP(ANDMatcher *self) {
+    ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
+    return ivars->num_kids ? Matcher_Estimate_Cost(ivars->by_cost[0]) : 0;
 }
 
 float
@@ -112,7 +112,7 @@ ANDCompiler_Make_Matcher_IMP(ANDCompiler *self, SegReader *reader,
 
     if (num_kids == 1) {
         Compiler *only_child = (Compiler*)Vec_Fetch(ivars->children, 0);
-        return Compiler_Make_Matcher(only_child, reader, need_score);
+        return Compiler_Open_Matcher(only_child, reader, need_score);
     }
     else {
         Vector *child_matchers = Vec_new(num_kids);
@@ -121,7 +121,7 @@ ANDCompiler_Make_Matcher_IMP(ANDCompiler *self, SegReader *reader,
         for (uint32_t i = 0; i < num_kids; i++) {
             Compiler *child = (Compiler*)Vec_Fetch(ivars->children, i);
             Matcher *child_matcher
-                = Compiler_Make_Matcher(child, reader, need_score);
+                = Compiler_Open_Matcher(child, reader, need_score);
 
             // If any required clause fails, the whole thing fails.
             if (child_matcher == NULL) {
@@ -25,10 +25,13 @@
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/Matcher.h"
+#include "Lucy/Search/ProfileMatcher.h"
 #include "Lucy/Search/Query.h"
+#include "Lucy/Search/QueryProfile.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Clock.h"
 #include "Lucy/Util/Freezer.h"
 
 Compiler*
@@ -51,9 +54,49 @@ Compiler_Destroy_IMP(Compiler *self) {
     CompilerIVARS *const ivars = Compiler_IVARS(self);
     DECREF(ivars->parent);
     DECREF(ivars->sim);
+    DECREF(ivars->profile);
     SUPER_DESTROY(self, COMPILER);
 }
 
+Matcher*
+Compiler_Open_Matcher_IMP(Compiler *self, SegReader *reader,
+                          bool need_score) {
+    CompilerIVARS *const ivars = Compiler_IVARS(self);
+    if (!ivars->profile) {
+        return Compiler_Make_Matcher(self, reader, need_score);
+    }
+
+    uint64_t start = Clock_nanoseconds();
+    Matcher *matcher = Compiler_Make_Matcher(self, reader, need_score);
+    QueryProfile_Add_Setup_Nanos(ivars->profile, Clock_nanoseconds() - start);
+    if (!matcher) { return NULL; }
+    Matcher *wrapped = (Matcher*)ProfMatcher_new(matcher, ivars->profile);
+    DECREF(matcher);
+    return wrapped;
+}
+
+void
+Compiler_Enable_Profiling_IMP(Compiler *self) {
+    CompilerIVARS *const ivars = Compiler_IVARS(self);
+    if (ivars->profile) { return; }
+    String *description = Query_To_String(ivars->parent);
+    ivars->profile = QueryProfile_new(Obj_get_class_name((Obj*)self),
+                                      description);
+    DECREF(description);
+}
+
+void
+Compiler_Disable_Profiling_IMP(Compiler *self) {
+    CompilerIVARS *const ivars = Compiler_IVARS(self);
+    DECREF(ivars->profile);
+    ivars->profile = NULL;
+}
+
+QueryProfile*
+Compiler_Get_Profile_IMP(Compiler *self) {
+    return Compiler_IVARS(self)->profile;
+}
+
 float
 Compiler_Get_Weight_IMP(Compiler *self) {
     return Compiler_Get_Boost(self);
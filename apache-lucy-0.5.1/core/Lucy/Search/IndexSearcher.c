@@ -25,6 +25,8 @@
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/IndexReader.h"
 #include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/SortCache.h"
 #include "Lucy/Index/HighlightReader.h"
@@ -36,12 +38,14 @@
 #include "Lucy/Search/MatchDoc.h"
 #include "Lucy/Search/Matcher.h"
 #include "Lucy/Search/Query.h"
+#include "Lucy/Search/QueryProfile.h"
 #include "Lucy/Search/SortRule.h"
 #include "Lucy/Search/SortSpec.h"
 #include "Lucy/Search/TopDocs.h"
 #include "Lucy/Search/Compiler.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/FSFolder.h"
+#include "Lucy/Util/Clock.h"
 
 IndexSearcher*
 IxSearcher_new(Obj *index) {
@@ -89,6 +93,59 @@ IxSearcher_Fetch_Doc_IMP(IndexSearcher *self, int32_t doc_id) {
     return DocReader_Fetch_Doc(ivars->doc_reader, doc_id);
 }
 
+HitDoc*
+IxSearcher_Fetch_By_Key_IMP(IndexSearcher *self, String *field, Obj *term) {
+    IndexSearcherIVARS *const ivars = IxSearcher_IVARS(self);
+    Vector   *const seg_readers = ivars->seg_readers;
+    I32Array *const seg_starts  = ivars->seg_starts;
+
+    // Search the newest segments first, since recently added documents are
+    // the likeliest to be looked up.
+    for (uint32_t i = Vec_Get_Size(seg_readers); i-- > 0;) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(seg_readers, i);
+        LexiconReader *lex_reader
+            = (LexiconReader*)SegReader_Fetch(
+                  seg_reader, Class_Get_Name(LEXICONREADER));
+        PostingListReader *plist_reader
+            = (PostingListReader*)SegReader_Fetch(
+                  seg_reader, Class_Get_Name(POSTINGLISTREADER));
+        if (!lex_reader || !plist_reader) { continue; }
+        if (!LexReader_Might_Contain(lex_reader, field, term)) { continue; }
+
+        PostingList *plist
+            = PListReader_Posting_List(plist_reader, field, term);
+        if (!plist) { continue; }
+
+        // Return the last posting which hasn't been deleted.
+        DeletionsReader *del_reader = (DeletionsReader*)SegReader_Fetch(
+                                          seg_reader,
+                                          Class_Get_Name(DELETIONSREADER));
+        Matcher *deletions = del_reader ? DelReader_Iterator(del_reader) : NULL;
+        int32_t  next_deletion = 0;
+        int32_t  live_doc_id   = 0;
+        int32_t  doc_id;
+        while (0 != (doc_id = PList_Next(plist))) {
+            if (deletions && next_deletion < doc_id) {
+                next_deletion = Matcher_Advance(deletions, doc_id);
+                if (!next_deletion) {
+                    DECREF(deletions);
+                    deletions = NULL;
+                }
+            }
+            if (doc_id != next_deletion) { live_doc_id = doc_id; }
+        }
+        DECREF(deletions);
+        DECREF(plist);
+
+        if (live_doc_id) {
+            return IxSearcher_Fetch_Doc(self, I32Arr_Get(seg_starts, i)
+                                              + live_doc_id);
+        }
+    }
+
+    return NULL;
+}
+
 DocVector*
 IxSearcher_Fetch_Doc_Vec_IMP(IndexSearcher *self, int32_t doc_id) {
     IndexSearcherIVARS *const ivars = IxSearcher_IVARS(self);
@@ -127,6 +184,40 @@ IxSearcher_Top_Docs_IMP(IndexSearcher *self, Query *query, uint32_t num_wanted,
     return retval;
 }
 
+TopDocs*
+IxSearcher_Profile_Top_Docs_IMP(IndexSearcher *self, Query *query,
+                                uint32_t num_wanted, SortSpec *sort_spec) {
+    String       *desc = Query_To_String(query);
+    QueryProfile *root = QueryProfile_new(SSTR_WRAP_C("IndexSearcher"), desc);
+
+    // Compile up front so that the Compiler tree can be instrumented.  A
+    // caller's Compiler starts from fresh profiles.
+    uint64_t  start    = Clock_nanoseconds();
+    Compiler *compiler = Query_is_a(query, COMPILER)
+                         ? (Compiler*)INCREF(query)
+                         : Query_Make_Compiler(query, (Searcher*)self,
+                                               Query_Get_Boost(query), false);
+    QueryProfile_Add_Setup_Nanos(root, Clock_nanoseconds() - start);
+    Compiler_Disable_Profiling(compiler);
+    Compiler_Enable_Profiling(compiler);
+
+    start = Clock_nanoseconds();
+    TopDocs *retval = IxSearcher_Top_Docs(self, (Query*)compiler, num_wanted,
+                                          sort_spec);
+    QueryProfile_Add_Run_Nanos(root, Clock_nanoseconds() - start);
+    QueryProfile_Add_Docs_Matched(root, TopDocs_Get_Total_Hits(retval));
+    QueryProfile_Add_Child(root, Compiler_Get_Profile(compiler));
+    TopDocs_Set_Profile(retval, root);
+
+    // Leave a caller's Compiler unprofiled, so that later searches with it
+    // neither pay for profiling nor add to this profile.
+    Compiler_Disable_Profiling(compiler);
+    DECREF(compiler);
+    DECREF(root);
+    DECREF(desc);
+    return retval;
+}
+
 void
 IxSearcher_Collect_IMP(IndexSearcher *self, Query *query, Collector *collector) {
     IndexSearcherIVARS *const ivars = IxSearcher_IVARS(self);
@@ -145,7 +236,7 @@ IxSearcher_Collect_IMP(IndexSearcher *self, Query *query, Collector *collector)
                                           seg_reader,
                                           Class_Get_Name(DELETIONSREADER));
         Matcher *matcher
-            = Compiler_Make_Matcher(compiler, seg_reader, need_score);
+            = Compiler_Open_Matcher(compiler, seg_reader, need_score);
         if (matcher) {
             int32_t  seg_start = I32Arr_Get(seg_starts, i);
             Matcher *deletions = DelReader_Iterator(del_reader);
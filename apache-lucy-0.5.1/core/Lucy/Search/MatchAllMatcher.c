@@ -64,4 +64,9 @@ MatchAllMatcher_Get_Doc_ID_IMP(MatchAllMatcher* self) {
     return MatchAllMatcher_IVARS(self)->doc_id;
 }
 
+int32_t
+MatchAllMatcher_Estimate_Cost_IMP(MatchAllMatcher* self) {
+    return MatchAllMatcher_IVARS(self)->doc_max;
+}
+
 
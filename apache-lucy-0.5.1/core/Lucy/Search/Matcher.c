@@ -38,6 +38,12 @@ Matcher_Advance_IMP(Matcher *self, int32_t target) {
     }
 }
 
+int32_t
+Matcher_Estimate_Cost_IMP(Matcher *self) {
+    UNUSED_VAR(self);
+    return INT32_MAX;
+}
+
 void
 Matcher_Collect_IMP(Matcher *self, Collector *collector, Matcher *deletions) {
     int32_t doc_id        = 0;
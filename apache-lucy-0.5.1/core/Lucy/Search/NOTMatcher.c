@@ -93,6 +93,11 @@ NOTMatcher_Get_Doc_ID_IMP(NOTMatcher *self) {
     return NOTMatcher_IVARS(self)->doc_id;
 }
 
+int32_t
+NOTMatcher_Estimate_Cost_IMP(NOTMatcher *self) {
+    return NOTMatcher_IVARS(self)->doc_max;
+}
+
 float
 NOTMatcher_Score_IMP(NOTMatcher *self) {
     UNUSED_VAR(self);
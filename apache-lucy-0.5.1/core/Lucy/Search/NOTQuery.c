@@ -120,7 +120,7 @@ NOTCompiler_Make_Matcher_IMP(NOTCompiler *self, SegReader *reader,
     Compiler *negated_compiler
         = (Compiler*)CERTIFY(Vec_Fetch(ivars->children, 0), COMPILER);
     Matcher *negated_matcher
-        = Compiler_Make_Matcher(negated_compiler, reader, false);
+        = Compiler_Open_Matcher(negated_compiler, reader, false);
     UNUSED_VAR(need_score);
 
     if (negated_matcher == NULL) {
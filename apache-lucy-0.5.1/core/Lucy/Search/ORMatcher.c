@@ -156,6 +156,17 @@ ORMatcher_Get_Doc_ID_IMP(ORMatcher *self) {
     return ORMatcher_IVARS(self)->top_hmd->doc;
 }
 
+int32_t
+ORMatcher_Estimate_Cost_IMP(ORMatcher *self) {
+    ORMatcherIVARS *const ivars = ORMatcher_IVARS(self);
+    int64_t cost = 0;
+    for (uint32_t i = 0; i < ivars->num_kids; i++) {
+        Matcher *child = (Matcher*)Vec_Fetch(ivars->children, i);
+        cost += Matcher_Estimate_Cost(child);
+    }
+    return cost > INT32_MAX ? INT32_MAX : (int32_t)cost;
+}
+
 static void
 S_clear(ORMatcher *self, ORMatcherIVARS *ivars) {
     UNUSED_VAR(self);
@@ -109,7 +109,7 @@ ORCompiler_Make_Matcher_IMP(ORCompiler *self, SegReader *reader,
     if (num_kids == 1) {
         // No need for an ORMatcher wrapper.
         Compiler *only_child = (Compiler*)Vec_Fetch(ivars->children, 0);
-        return Compiler_Make_Matcher(only_child, reader, need_score);
+        return Compiler_Open_Matcher(only_child, reader, need_score);
     }
     else {
         Vector *submatchers = Vec_new(num_kids);
@@ -119,7 +119,7 @@ ORCompiler_Make_Matcher_IMP(ORCompiler *self, SegReader *reader,
         for (uint32_t i = 0; i < num_kids; i++) {
             Compiler *child = (Compiler*)Vec_Fetch(ivars->children, i);
             Matcher *submatcher
-                = Compiler_Make_Matcher(child, reader, need_score);
+                = Compiler_Open_Matcher(child, reader, need_score);
             Vec_Push(submatchers, (Obj*)submatcher);
             if (submatcher != NULL) {
                 num_submatchers++;
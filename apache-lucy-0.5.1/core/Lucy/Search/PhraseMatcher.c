@@ -58,6 +58,22 @@ PhraseMatcher_init(PhraseMatcher *self, Similarity *similarity, Vector *plists,
         ivars->plists[i] = (PostingList*)INCREF(plist);
     }
 
+    // Order the PostingLists by doc freq, so that the rarest term proposes
+    // the docs which the others must match.  `plists` stays in phrase order
+    // for matching positions.
+    ivars->by_cost = (PostingList**)MALLOCATE(
+                        ivars->num_elements * sizeof(PostingList*));
+    for (uint32_t i = 0; i < ivars->num_elements; i++) {
+        PostingList *plist     = ivars->plists[i];
+        uint32_t     doc_freq  = PList_Get_Doc_Freq(plist);
+        uint32_t     j         = i;
+        while (j > 0 && PList_Get_Doc_Freq(ivars->by_cost[j - 1]) > doc_freq) {
+            ivars->by_cost[j] = ivars->by_cost[j - 1];
+            j--;
+        }
+        ivars->by_cost[j] = plist;
+    }
+
     // Assign.
     ivars->sim       = (Similarity*)INCREF(similarity);
     ivars->compiler  = (Compiler*)INCREF(compiler);
@@ -75,6 +91,7 @@ PhraseMatcher_Destroy_IMP(PhraseMatcher *self) {
         }
         FREEMEM(ivars->plists);
     }
+    FREEMEM(ivars->by_cost);
     DECREF(ivars->sim);
     DECREF(ivars->anchor_set);
     DECREF(ivars->compiler);
@@ -88,7 +105,7 @@ PhraseMatcher_Next_IMP(PhraseMatcher *self) {
         return PhraseMatcher_Advance(self, 1);
     }
     else if (ivars->more) {
-        const int32_t target = PList_Get_Doc_ID(ivars->plists[0]) + 1;
+        const int32_t target = PList_Get_Doc_ID(ivars->by_cost[0]) + 1;
         return PhraseMatcher_Advance(self, target);
     }
     else {
@@ -99,97 +116,75 @@ PhraseMatcher_Next_IMP(PhraseMatcher *self) {
 int32_t
 PhraseMatcher_Advance_IMP(PhraseMatcher *self, int32_t target) {
     PhraseMatcherIVARS *const ivars  = PhraseMatcher_IVARS(self);
-    PostingList **const plists       = ivars->plists;
+    PostingList **const plists       = ivars->by_cost;
+    PostingList  *const lead         = plists[0];
     const uint32_t      num_elements = ivars->num_elements;
-    int32_t             highest      = 0;
+    int32_t             doc_id       = 0;
 
     // Reset match variables to indicate no match.  New values will be
     // assigned if a match succeeds.
     ivars->phrase_freq = 0.0;
     ivars->doc_id      = 0;
 
-    // Find the lowest possible matching doc ID greater than the current doc
-    // ID.  If any one of the PostingLists is exhausted, we're done.
+    if (!ivars->more) { return 0; }
+
+    // Let the rarest term propose a doc.  If any one of the PostingLists is
+    // exhausted, we're done.
     if (ivars->first_time) {
         ivars->first_time = false;
 
-        // On the first call to Advance(), advance all PostingLists.
-        for (size_t i = 0, max = ivars->num_elements; i < max; i++) {
+        // On the first call to Advance(), advance all PostingLists, starting
+        // with the lead.
+        for (uint32_t i = 0; i < num_elements; i++) {
             int32_t candidate = PList_Advance(plists[i], target);
             if (!candidate) {
                 ivars->more = false;
                 return 0;
             }
-            else if (candidate > highest) {
-                // Remember the highest doc ID so far.
-                highest = candidate;
-            }
         }
+        doc_id = PList_Get_Doc_ID(lead);
     }
     else {
-        // On subsequent iters, advance only one PostingList.  Its new doc ID
-        // becomes the minimum target which all the others must move up to.
-        highest = PList_Advance(plists[0], target);
-        if (highest == 0) {
-            ivars->more = false;
-            return 0;
-        }
+        doc_id = PList_Advance(lead, target);
     }
 
     // Find a doc which contains all the terms.
-    while (1) {
-        bool agreement = true;
-
-        // Scoot all posting lists up to at least the current minimum.
-        for (uint32_t i = 0; i < num_elements; i++) {
+    while (doc_id) {
+        // Scoot the other PostingLists up to the proposed doc.  If one of
+        // them lands beyond it, the lead skips ahead to that doc instead.
+        uint32_t i = 1;
+        for (; i < num_elements; i++) {
             PostingList *const plist = plists[i];
             int32_t candidate = PList_Get_Doc_ID(plist);
-
-            // Is this PostingList already beyond the minimum?  Then raise the
-            // bar for everyone else.
-            if (highest < candidate) { highest = candidate; }
-            if (target < highest)    { target = highest; }
-
-            // Scoot this posting list up.
-            if (candidate < target) {
-                candidate = PList_Advance(plist, target);
-
-                // If this PostingList is exhausted, we're done.
-                if (candidate == 0) {
-                    ivars->more = false;
-                    return 0;
+            if (candidate < doc_id) {
+                candidate = PList_Advance(plist, doc_id);
+                if (!candidate) {
+                    doc_id = 0;
+                    break;
                 }
-
-                // After calling PList_Advance(), we are guaranteed to be
-                // either at or beyond the minimum, so we can assign without
-                // checking and the minumum will either go up or stay the
-                // same.
-                highest = candidate;
+            }
+            if (candidate > doc_id) {
+                doc_id = PList_Advance(lead, candidate);
+                break;
             }
         }
+        if (i < num_elements) { continue; }
 
-        // See whether all the PostingLists have managed to converge on a
-        // single doc ID.
-        for (uint32_t i = 0; i < num_elements; i++) {
-            const int32_t candidate = PList_Get_Doc_ID(plists[i]);
-            if (candidate != highest) { agreement = false; }
-        }
-
-        // If we've found a doc with all terms in it, see if they form a
+        // We've found a doc with all terms in it, so see if they form a
         // phrase.
-        if (agreement && highest >= target) {
-            ivars->phrase_freq = PhraseMatcher_Calc_Phrase_Freq(self);
-            if (ivars->phrase_freq == 0.0) {
-                // No phrase.  Move on to another doc.
-                target += 1;
-            }
-            else {
-                // Success!
-                ivars->doc_id = highest;
-                return highest;
-            }
+        ivars->phrase_freq = PhraseMatcher_Calc_Phrase_Freq(self);
+        if (ivars->phrase_freq != 0.0) {
+            // Success!
+            ivars->doc_id = doc_id;
+            return doc_id;
         }
+
+        // No phrase.  Move on to another doc.
+        doc_id = PList_Advance(lead, doc_id + 1);
     }
+
+    ivars->more = false;
+    return 0;
 }
 
 static CFISH_INLINE uint32_t
@@ -316,4 +311,9 @@ PhraseMatcher_Score_IMP(PhraseMatcher *self) {
     return score;
 }
 
+int32_t
+PhraseMatcher_Estimate_Cost_IMP(PhraseMatcher *self) {
+    PhraseMatcherIVARS *const ivars = PhraseMatcher_IVARS(self);
+    return ivars->num_elements ? PList_Estimate_Cost(ivars->by_cost[0]) : 0;
+}
 
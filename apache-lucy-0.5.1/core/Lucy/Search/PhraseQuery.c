@@ -31,6 +31,7 @@
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Index/TermVector.h"
+#include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/PhraseMatcher.h"
 #include "Lucy/Search/Searcher.h"
@@ -292,6 +293,43 @@ PhraseCompiler_Apply_Norm_Factor_IMP(PhraseCompiler *self, float factor) {
     ivars->normalized_weight = ivars->raw_weight * ivars->idf * factor;
 }
 
+// If the field indexes shingles, return the phrase's adjacent pairs of
+// terms as shingles and set `field` to the shingle field.  Otherwise,
+// return NULL.
+static Vector*
+S_shingle_terms(Schema *schema, String **field, Vector *terms) {
+    uint32_t num_terms = Vec_Get_Size(terms);
+    if (num_terms < 2) { return NULL; }
+
+    FieldType *type = Schema_Fetch_Type(schema, *field);
+    if (!type || !FType_is_a(type, FULLTEXTTYPE)) { return NULL; }
+    String *shingle_field
+        = FullTextType_Get_Shingle_Field((FullTextType*)type);
+    if (!shingle_field) { return NULL; }
+    FieldType *shingle_type = Schema_Fetch_Type(schema, shingle_field);
+    if (!shingle_type || !FType_is_a(shingle_type, FULLTEXTTYPE)) {
+        return NULL;
+    }
+    Posting *posting
+        = Sim_Make_Posting(Schema_Fetch_Sim(schema, shingle_field));
+    bool has_positions = Obj_is_a((Obj*)posting, SCOREPOSTING);
+    DECREF(posting);
+    if (!has_positions) { return NULL; }
+
+    Vector *shingles = Vec_new(num_terms - 1);
+    for (uint32_t i = 0; i < num_terms - 1; i++) {
+        Obj *term = Vec_Fetch(terms, i);
+        Obj *next = Vec_Fetch(terms, i + 1);
+        if (!Obj_is_a(term, STRING) || !Obj_is_a(next, STRING)) {
+            DECREF(shingles);
+            return NULL;
+        }
+        Vec_Push(shingles, (Obj*)Str_newf("%o %o", term, next));
+    }
+    *field = shingle_field;
+    return shingles;
+}
+
 Matcher*
 PhraseCompiler_Make_Matcher_IMP(PhraseCompiler *self, SegReader *reader,
                                 bool need_score) {
@@ -320,21 +358,33 @@ PhraseCompiler_Make_Matcher_IMP(PhraseCompiler *self, SegReader *reader,
               reader, Class_Get_Name(POSTINGLISTREADER));
     if (!plist_reader) { return NULL; }
 
+    // Common words make for long posting lists and lots of positions to
+    // compare.  If the field indexes shingles, match the phrase's adjacent
+    // pairs of terms instead: a phrase of N terms is a phrase of N - 1
+    // shingles, or just one shingle for a two-word phrase.
+    String *field    = parent_ivars->field;
+    Vector *shingles = S_shingle_terms(SegReader_Get_Schema(reader), &field,
+                                       terms);
+    Vector *wanted   = shingles ? shingles : terms;
+    uint32_t num_wanted = Vec_Get_Size(wanted);
+
     // Look up each term.
-    Vector  *plists = Vec_new(num_terms);
-    for (uint32_t i = 0; i < num_terms; i++) {
-        Obj *term = Vec_Fetch(terms, i);
+    Vector  *plists = Vec_new(num_wanted);
+    for (uint32_t i = 0; i < num_wanted; i++) {
+        Obj *term = Vec_Fetch(wanted, i);
         PostingList *plist
-            = PListReader_Posting_List(plist_reader, parent_ivars->field, term);
+            = PListReader_Posting_List(plist_reader, field, term);
 
         // Bail if any one of the terms isn't in the index.
         if (!plist || !PList_Get_Doc_Freq(plist)) {
             DECREF(plist);
             DECREF(plists);
+            DECREF(shingles);
             return NULL;
         }
         Vec_Push(plists, (Obj*)plist);
     }
+    DECREF(shingles);
 
     Matcher *retval
         = (Matcher*)PhraseMatcher_new(sim, plists, (Compiler*)self);
@@ -19,6 +19,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Search/PolyQuery.h"
+#include "Lucy/Search/QueryProfile.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Plan/Schema.h"
@@ -184,6 +185,32 @@ PolyCompiler_Apply_Norm_Factor_IMP(PolyCompiler *self, float factor) {
     }
 }
 
+void
+PolyCompiler_Enable_Profiling_IMP(PolyCompiler *self) {
+    PolyCompilerIVARS *const ivars = PolyCompiler_IVARS(self);
+    if (PolyCompiler_Get_Profile(self)) { return; }
+    PolyCompiler_Enable_Profiling_t super_enable
+        = SUPER_METHOD_PTR(POLYCOMPILER, LUCY_PolyCompiler_Enable_Profiling);
+    super_enable(self);
+    QueryProfile *profile = PolyCompiler_Get_Profile(self);
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->children); i < max; i++) {
+        Compiler *child = (Compiler*)Vec_Fetch(ivars->children, i);
+        Compiler_Enable_Profiling(child);
+        QueryProfile_Add_Child(profile, Compiler_Get_Profile(child));
+    }
+}
+
+void
+PolyCompiler_Disable_Profiling_IMP(PolyCompiler *self) {
+    PolyCompilerIVARS *const ivars = PolyCompiler_IVARS(self);
+    PolyCompiler_Disable_Profiling_t super_disable
+        = SUPER_METHOD_PTR(POLYCOMPILER, LUCY_PolyCompiler_Disable_Profiling);
+    super_disable(self);
+    for (uint32_t i = 0, max = Vec_Get_Size(ivars->children); i < max; i++) {
+        Compiler_Disable_Profiling((Compiler*)Vec_Fetch(ivars->children, i));
+    }
+}
+
 Vector*
 PolyCompiler_Highlight_Spans_IMP(PolyCompiler *self, Searcher *searcher,
                                  DocVector *doc_vec, String *field) {
@@ -0,0 +1,132 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_PROFILEMATCHER
+#define C_LUCY_QUERYPROFILE
+#define C_LUCY_TERMMATCHER
+#define C_LUCY_PHRASEMATCHER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/ProfileMatcher.h"
+#include "Lucy/Index/SegPostingList.h"
+#include "Lucy/Search/PhraseMatcher.h"
+#include "Lucy/Search/QueryProfile.h"
+#include "Lucy/Search/TermMatcher.h"
+#include "Lucy/Util/Clock.h"
+
+ProfileMatcher*
+ProfMatcher_new(Matcher *child, QueryProfile *profile) {
+    ProfileMatcher *self = (ProfileMatcher*)Class_Make_Obj(PROFILEMATCHER);
+    return ProfMatcher_init(self, child, profile);
+}
+
+static void
+S_push_plist(Vector *plists, PostingList *plist) {
+    if (plist && PList_is_a(plist, SEGPOSTINGLIST)) {
+        Vec_Push(plists, INCREF(plist));
+    }
+}
+
+ProfileMatcher*
+ProfMatcher_init(ProfileMatcher *self, Matcher *child,
+                 QueryProfile *profile) {
+    ProfileMatcherIVARS *const ivars = ProfMatcher_IVARS(self);
+    Matcher_init((Matcher*)self);
+    ivars->child   = (Matcher*)INCREF(child);
+    ivars->profile = (QueryProfile*)INCREF(profile);
+    ivars->plists  = Vec_new(0);
+    QueryProfile_IVARS(profile)->num_matchers++;
+
+    // Remember the posting lists of leaf Matchers so that their counters
+    // can be harvested once the Matcher is done.
+    if (Matcher_is_a(child, TERMMATCHER)) {
+        TermMatcherIVARS *const child_ivars
+            = TermMatcher_IVARS((TermMatcher*)child);
+        S_push_plist(ivars->plists, child_ivars->plist);
+    }
+    else if (Matcher_is_a(child, PHRASEMATCHER)) {
+        PhraseMatcherIVARS *const child_ivars
+            = PhraseMatcher_IVARS((PhraseMatcher*)child);
+        for (uint32_t i = 0; i < child_ivars->num_elements; i++) {
+            S_push_plist(ivars->plists, child_ivars->plists[i]);
+        }
+    }
+
+    return self;
+}
+
+void
+ProfMatcher_Destroy_IMP(ProfileMatcher *self) {
+    ProfileMatcherIVARS *const ivars = ProfMatcher_IVARS(self);
+    for (size_t i = 0, max = Vec_Get_Size(ivars->plists); i < max; i++) {
+        SegPostingList *plist
+            = (SegPostingList*)Vec_Fetch(ivars->plists, i);
+        QueryProfile_Add_Postings(ivars->profile,
+                                  SegPList_Num_Decoded(plist),
+                                  SegPList_Bytes_Read(plist));
+    }
+    DECREF(ivars->plists);
+    DECREF(ivars->child);
+    DECREF(ivars->profile);
+    SUPER_DESTROY(self, PROFILEMATCHER);
+}
+
+int32_t
+ProfMatcher_Next_IMP(ProfileMatcher *self) {
+    ProfileMatcherIVARS *const ivars = ProfMatcher_IVARS(self);
+    QueryProfileIVARS *const profile_ivars = QueryProfile_IVARS(ivars->profile);
+    uint64_t start  = Clock_nanoseconds();
+    int32_t  doc_id = Matcher_Next(ivars->child);
+    profile_ivars->run_nanos += Clock_nanoseconds() - start;
+    profile_ivars->next_calls++;
+    if (doc_id) { profile_ivars->docs_matched++; }
+    return doc_id;
+}
+
+int32_t
+ProfMatcher_Advance_IMP(ProfileMatcher *self, int32_t target) {
+    ProfileMatcherIVARS *const ivars = ProfMatcher_IVARS(self);
+    QueryProfileIVARS *const profile_ivars = QueryProfile_IVARS(ivars->profile);
+    uint64_t start  = Clock_nanoseconds();
+    int32_t  doc_id = Matcher_Advance(ivars->child, target);
+    profile_ivars->run_nanos += Clock_nanoseconds() - start;
+    profile_ivars->advance_calls++;
+    if (doc_id) { profile_ivars->docs_matched++; }
+    return doc_id;
+}
+
+int32_t
+ProfMatcher_Get_Doc_ID_IMP(ProfileMatcher *self) {
+    return Matcher_Get_Doc_ID(ProfMatcher_IVARS(self)->child);
+}
+
+float
+ProfMatcher_Score_IMP(ProfileMatcher *self) {
+    ProfileMatcherIVARS *const ivars = ProfMatcher_IVARS(self);
+    QueryProfileIVARS *const profile_ivars = QueryProfile_IVARS(ivars->profile);
+    uint64_t start = Clock_nanoseconds();
+    float    score = Matcher_Score(ivars->child);
+    profile_ivars->run_nanos += Clock_nanoseconds() - start;
+    profile_ivars->score_calls++;
+    return score;
+}
+
+int32_t
+ProfMatcher_Estimate_Cost_IMP(ProfileMatcher *self) {
+    return Matcher_Estimate_Cost(ProfMatcher_IVARS(self)->child);
+}
+
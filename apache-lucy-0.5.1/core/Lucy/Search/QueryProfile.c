@@ -0,0 +1,216 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_QUERYPROFILE
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/QueryProfile.h"
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Num.h"
+
+QueryProfile*
+QueryProfile_new(String *name, String *description) {
+    QueryProfile *self = (QueryProfile*)Class_Make_Obj(QUERYPROFILE);
+    return QueryProfile_init(self, name, description);
+}
+
+QueryProfile*
+QueryProfile_init(QueryProfile *self, String *name, String *description) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    ivars->name        = Str_Clone(name);
+    ivars->description = description ? Str_Clone(description) : NULL;
+    ivars->children    = Vec_new(0);
+    return self;
+}
+
+void
+QueryProfile_Destroy_IMP(QueryProfile *self) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    DECREF(ivars->name);
+    DECREF(ivars->description);
+    DECREF(ivars->children);
+    SUPER_DESTROY(self, QUERYPROFILE);
+}
+
+String*
+QueryProfile_Get_Name_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->name;
+}
+
+String*
+QueryProfile_Get_Description_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->description;
+}
+
+void
+QueryProfile_Add_Child_IMP(QueryProfile *self, QueryProfile *child) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    Vec_Push(ivars->children, INCREF(child));
+}
+
+Vector*
+QueryProfile_Get_Children_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->children;
+}
+
+uint64_t
+QueryProfile_Get_Num_Matchers_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->num_matchers;
+}
+
+uint64_t
+QueryProfile_Get_Next_Calls_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->next_calls;
+}
+
+uint64_t
+QueryProfile_Get_Advance_Calls_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->advance_calls;
+}
+
+uint64_t
+QueryProfile_Get_Score_Calls_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->score_calls;
+}
+
+uint64_t
+QueryProfile_Get_Docs_Matched_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->docs_matched;
+}
+
+uint64_t
+QueryProfile_Get_Postings_Decoded_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->postings_decoded;
+}
+
+uint64_t
+QueryProfile_Get_Bytes_Read_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->bytes_read;
+}
+
+uint64_t
+QueryProfile_Get_Setup_Nanos_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->setup_nanos;
+}
+
+uint64_t
+QueryProfile_Get_Run_Nanos_IMP(QueryProfile *self) {
+    return QueryProfile_IVARS(self)->run_nanos;
+}
+
+uint64_t
+QueryProfile_Get_Self_Nanos_IMP(QueryProfile *self) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    uint64_t child_nanos = 0;
+    for (size_t i = 0, max = Vec_Get_Size(ivars->children); i < max; i++) {
+        QueryProfile *child = (QueryProfile*)Vec_Fetch(ivars->children, i);
+        child_nanos += QueryProfile_IVARS(child)->run_nanos;
+    }
+    return child_nanos < ivars->run_nanos
+           ? ivars->run_nanos - child_nanos
+           : 0;
+}
+
+void
+QueryProfile_Add_Setup_Nanos_IMP(QueryProfile *self, uint64_t nanos) {
+    QueryProfile_IVARS(self)->setup_nanos += nanos;
+}
+
+void
+QueryProfile_Add_Run_Nanos_IMP(QueryProfile *self, uint64_t nanos) {
+    QueryProfile_IVARS(self)->run_nanos += nanos;
+}
+
+void
+QueryProfile_Add_Docs_Matched_IMP(QueryProfile *self, uint64_t count) {
+    QueryProfile_IVARS(self)->docs_matched += count;
+}
+
+void
+QueryProfile_Add_Postings_IMP(QueryProfile *self, uint64_t decoded,
+                              uint64_t bytes_read) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    ivars->postings_decoded += decoded;
+    ivars->bytes_read       += bytes_read;
+}
+
+static void
+S_store_count(Hash *dump, const char *key, uint64_t count) {
+    Hash_Store_Utf8(dump, key, strlen(key), (Obj*)Int_new((int64_t)count));
+}
+
+Hash*
+QueryProfile_Dump_IMP(QueryProfile *self) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    Hash *dump = Hash_new(0);
+    Hash_Store_Utf8(dump, "name", 4, (Obj*)Str_Clone(ivars->name));
+    if (ivars->description) {
+        Hash_Store_Utf8(dump, "description", 11,
+                        (Obj*)Str_Clone(ivars->description));
+    }
+    S_store_count(dump, "num_matchers", ivars->num_matchers);
+    S_store_count(dump, "next_calls", ivars->next_calls);
+    S_store_count(dump, "advance_calls", ivars->advance_calls);
+    S_store_count(dump, "score_calls", ivars->score_calls);
+    S_store_count(dump, "docs_matched", ivars->docs_matched);
+    S_store_count(dump, "postings_decoded", ivars->postings_decoded);
+    S_store_count(dump, "bytes_read", ivars->bytes_read);
+    S_store_count(dump, "setup_nanos", ivars->setup_nanos);
+    S_store_count(dump, "run_nanos", ivars->run_nanos);
+    S_store_count(dump, "self_nanos", QueryProfile_Get_Self_Nanos(self));
+
+    size_t num_children = Vec_Get_Size(ivars->children);
+    Vector *children = Vec_new(num_children);
+    for (size_t i = 0; i < num_children; i++) {
+        QueryProfile *child = (QueryProfile*)Vec_Fetch(ivars->children, i);
+        Vec_Push(children, (Obj*)QueryProfile_Dump(child));
+    }
+    Hash_Store_Utf8(dump, "children", 8, (Obj*)children);
+
+    return dump;
+}
+
+static void
+S_render(QueryProfile *self, CharBuf *buf, int depth) {
+    QueryProfileIVARS *const ivars = QueryProfile_IVARS(self);
+    for (int i = 0; i < depth; i++) { CB_Cat_Trusted_Utf8(buf, "  ", 2); }
+    CB_Cat(buf, ivars->name);
+    if (ivars->description) {
+        CB_catf(buf, " (%o)", ivars->description);
+    }
+    CB_catf(buf, "  setup=%f64ms run=%f64ms self=%f64ms matchers=%u64"
+            " docs=%u64 next=%u64 advance=%u64 score=%u64"
+            " postings=%u64 bytes=%u64\n",
+            ivars->setup_nanos / 1e6, ivars->run_nanos / 1e6,
+            QueryProfile_Get_Self_Nanos(self) / 1e6, ivars->num_matchers,
+            ivars->docs_matched, ivars->next_calls, ivars->advance_calls,
+            ivars->score_calls, ivars->postings_decoded, ivars->bytes_read);
+    for (size_t i = 0, max = Vec_Get_Size(ivars->children); i < max; i++) {
+        QueryProfile *child = (QueryProfile*)Vec_Fetch(ivars->children, i);
+        S_render(child, buf, depth + 1);
+    }
+}
+
+String*
+QueryProfile_To_String_IMP(QueryProfile *self) {
+    CharBuf *buf = CB_new(128);
+    S_render(self, buf, 0);
+    String *retval = CB_Yield_String(buf);
+    DECREF(buf);
+    return retval;
+}
+
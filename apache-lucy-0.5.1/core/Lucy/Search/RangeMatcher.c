@@ -94,4 +94,10 @@ RangeMatcher_Get_Doc_ID_IMP(RangeMatcher* self) {
     return RangeMatcher_IVARS(self)->doc_id;
 }
 
+int32_t
+RangeMatcher_Estimate_Cost_IMP(RangeMatcher* self) {
+    // Every doc gets examined, whether it matches or not.
+    return RangeMatcher_IVARS(self)->doc_max;
+}
+
 
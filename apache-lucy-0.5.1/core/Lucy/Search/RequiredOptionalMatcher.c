@@ -75,6 +75,12 @@ ReqOptMatcher_Get_Doc_ID_IMP(RequiredOptionalMatcher *self) {
     return Matcher_Get_Doc_ID(ivars->req_matcher);
 }
 
+int32_t
+ReqOptMatcher_Estimate_Cost_IMP(RequiredOptionalMatcher *self) {
+    RequiredOptionalMatcherIVARS *const ivars = ReqOptMatcher_IVARS(self);
+    return Matcher_Estimate_Cost(ivars->req_matcher);
+}
+
 float
 ReqOptMatcher_Score_IMP(RequiredOptionalMatcher *self) {
     RequiredOptionalMatcherIVARS *const ivars = ReqOptMatcher_IVARS(self);
@@ -129,9 +129,9 @@ ReqOptCompiler_Make_Matcher_IMP(RequiredOptionalCompiler *self,
     Compiler   *req_compiler = (Compiler*)Vec_Fetch(ivars->children, 0);
     Compiler   *opt_compiler = (Compiler*)Vec_Fetch(ivars->children, 1);
     Matcher *req_matcher
-        = Compiler_Make_Matcher(req_compiler, reader, need_score);
+        = Compiler_Open_Matcher(req_compiler, reader, need_score);
     Matcher *opt_matcher
-        = Compiler_Make_Matcher(opt_compiler, reader, need_score);
+        = Compiler_Open_Matcher(opt_compiler, reader, need_score);
 
     if (req_matcher == NULL) {
         // No required matcher, ergo no matches possible.
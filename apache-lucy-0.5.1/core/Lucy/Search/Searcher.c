@@ -19,6 +19,7 @@
 
 #include "Lucy/Search/Searcher.h"
 
+#include "Lucy/Document/HitDoc.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/Collector.h"
@@ -26,7 +27,9 @@
 #include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/Query.h"
 #include "Lucy/Search/QueryParser.h"
+#include "Lucy/Search/SortRule.h"
 #include "Lucy/Search/SortSpec.h"
+#include "Lucy/Search/TermQuery.h"
 #include "Lucy/Search/TopDocs.h"
 #include "Lucy/Search/Compiler.h"
 
@@ -63,6 +66,22 @@ Searcher_Hits_IMP(Searcher *self, Obj *query, uint32_t offset,
     return hits;
 }
 
+HitDoc*
+Searcher_Fetch_By_Key_IMP(Searcher *self, String *field, Obj *term) {
+    // Newer documents have higher doc ids.
+    TermQuery *query = TermQuery_new(field, term);
+    Vector    *rules = Vec_new(1);
+    Vec_Push(rules, (Obj*)SortRule_new(SortRule_DOC_ID, NULL, true));
+    SortSpec  *spec  = SortSpec_new(rules);
+    Hits      *hits  = Searcher_Hits(self, (Obj*)query, 0, 1, spec);
+    HitDoc    *doc   = Hits_Next(hits);
+    DECREF(hits);
+    DECREF(spec);
+    DECREF(rules);
+    DECREF(query);
+    return doc;
+}
+
 Query*
 Searcher_Glean_Query_IMP(Searcher *self, Obj *query) {
     SearcherIVARS *const ivars = Searcher_IVARS(self);
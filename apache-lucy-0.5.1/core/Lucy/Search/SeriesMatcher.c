@@ -112,4 +112,15 @@ SeriesMatcher_Get_Doc_ID_IMP(SeriesMatcher *self) {
     return SeriesMatcher_IVARS(self)->doc_id;
 }
 
+int32_t
+SeriesMatcher_Estimate_Cost_IMP(SeriesMatcher *self) {
+    SeriesMatcherIVARS *const ivars = SeriesMatcher_IVARS(self);
+    int64_t cost = 0;
+    for (int32_t i = 0; i < ivars->num_matchers; i++) {
+        Matcher *matcher = (Matcher*)Vec_Fetch(ivars->matchers, (size_t)i);
+        if (matcher) { cost += Matcher_Estimate_Cost(matcher); }
+    }
+    return cost > INT32_MAX ? INT32_MAX : (int32_t)cost;
+}
+
 
@@ -96,4 +96,9 @@ TermMatcher_Get_Doc_ID_IMP(TermMatcher* self) {
     return Post_Get_Doc_ID(ivars->posting);
 }
 
+int32_t
+TermMatcher_Estimate_Cost_IMP(TermMatcher *self) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    return ivars->plist ? PList_Estimate_Cost(ivars->plist) : 0;
+}
 
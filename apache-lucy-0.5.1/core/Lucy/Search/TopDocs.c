@@ -20,6 +20,7 @@
 #include "Lucy/Search/TopDocs.h"
 #include "Lucy/Index/IndexReader.h"
 #include "Lucy/Index/Lexicon.h"
+#include "Lucy/Search/QueryProfile.h"
 #include "Lucy/Search/SortRule.h"
 #include "Lucy/Search/SortSpec.h"
 #include "Lucy/Store/InStream.h"
@@ -44,6 +45,7 @@ void
 TopDocs_Destroy_IMP(TopDocs *self) {
     TopDocsIVARS *const ivars = TopDocs_IVARS(self);
     DECREF(ivars->match_docs);
+    DECREF(ivars->profile);
     SUPER_DESTROY(self, TOPDOCS);
 }
 
@@ -84,4 +86,16 @@ TopDocs_Set_Total_Hits_IMP(TopDocs *self, uint32_t total_hits) {
     TopDocs_IVARS(self)->total_hits = total_hits;
 }
 
+QueryProfile*
+TopDocs_Get_Profile_IMP(TopDocs *self) {
+    return TopDocs_IVARS(self)->profile;
+}
+
+void
+TopDocs_Set_Profile_IMP(TopDocs *self, QueryProfile *profile) {
+    TopDocsIVARS *const ivars = TopDocs_IVARS(self);
+    QueryProfile *temp = ivars->profile;
+    ivars->profile = (QueryProfile*)INCREF(profile);
+    DECREF(temp);
+}
 
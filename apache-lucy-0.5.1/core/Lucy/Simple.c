@@ -117,7 +117,11 @@ Simple_Add_Doc_IMP(Simple *self, Doc *doc) {
 
     for (size_t i = 0, max = Vec_Get_Size(field_names); i < max; i++) {
         String *field = (String*)Vec_Fetch(field_names, i);
-        Schema_Spec_Field(ivars->schema, field, ivars->type);
+        // Fields spec'd by an earlier doc share our FieldType, so skip the
+        // deep FieldType comparison Spec_Field would otherwise perform.
+        if (Schema_Fetch_Type(ivars->schema, field) != ivars->type) {
+            Schema_Spec_Field(ivars->schema, field, ivars->type);
+        }
     }
 
     Indexer_Add_Doc(ivars->indexer, doc, 1.0);
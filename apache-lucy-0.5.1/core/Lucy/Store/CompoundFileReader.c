@@ -26,6 +26,7 @@
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 #include "Clownfish/Util/StringHelper.h"
 
 CompoundFileReader*
@@ -39,7 +40,7 @@ CompoundFileReader*
 CFReader_do_open(CompoundFileReader *self, Folder *folder) {
     CompoundFileReaderIVARS *const ivars = CFReader_IVARS(self);
     String *cfmeta_file = SSTR_WRAP_C("cfmeta.json");
-    Hash *metadata = (Hash*)Json_slurp_json((Folder*)folder, cfmeta_file);
+    Hash *metadata = (Hash*)MetaFile_slurp((Folder*)folder, cfmeta_file);
     Err *error = NULL;
 
     Folder_init((Folder*)self, Folder_Get_Path(folder));
@@ -234,6 +235,17 @@ CFReader_Local_Is_Directory_IMP(CompoundFileReader *self,
     return false;
 }
 
+int64_t
+CFReader_Local_File_Length_IMP(CompoundFileReader *self, String *name) {
+    CompoundFileReaderIVARS *const ivars = CFReader_IVARS(self);
+    Hash *entry = (Hash*)Hash_Fetch(ivars->records, name);
+    if (!entry) {
+        return Folder_Local_File_Length(ivars->real_folder, name);
+    }
+    Obj *len = Hash_Fetch_Utf8(entry, "length", 6);
+    return len ? Json_obj_to_i64(len) : 0;
+}
+
 void
 CFReader_Close_IMP(CompoundFileReader *self) {
     CompoundFileReaderIVARS *const ivars = CFReader_IVARS(self);
@@ -267,6 +279,15 @@ CFReader_Local_Open_Dir_IMP(CompoundFileReader *self) {
     return (DirHandle*)CFReaderDH_new(self);
 }
 
+bool
+CFReader_Local_Sync_IMP(CompoundFileReader *self, String *name) {
+    CompoundFileReaderIVARS *const ivars = CFReader_IVARS(self);
+    if (name && Hash_Fetch(ivars->records, name)) {
+        return true;
+    }
+    return Folder_Local_Sync(ivars->real_folder, name);
+}
+
 /****************************************************************************/
 
 CFReaderDirHandle*
@@ -23,6 +23,7 @@
 #include "Lucy/Store/OutStream.h"
 #include "Lucy/Util/IndexFileNames.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 int32_t CFWriter_current_file_format = 2;
 
@@ -36,16 +37,18 @@ S_clean_up_old_temp_files(CompoundFileWriter *self,
                           CompoundFileWriterIVARS *ivars);
 
 CompoundFileWriter*
-CFWriter_new(Folder *folder) {
+CFWriter_new(Folder *folder, bool binary_metadata) {
     CompoundFileWriter *self
         = (CompoundFileWriter*)Class_Make_Obj(COMPOUNDFILEWRITER);
-    return CFWriter_init(self, folder);
+    return CFWriter_init(self, folder, binary_metadata);
 }
 
 CompoundFileWriter*
-CFWriter_init(CompoundFileWriter *self, Folder *folder) {
+CFWriter_init(CompoundFileWriter *self, Folder *folder,
+              bool binary_metadata) {
     CompoundFileWriterIVARS *const ivars = CFWriter_IVARS(self);
-    ivars->folder = (Folder*)INCREF(folder);
+    ivars->folder          = (Folder*)INCREF(folder);
+    ivars->binary_metadata = binary_metadata;
     return self;
 }
 
@@ -103,6 +106,7 @@ S_do_consolidate(CompoundFileWriter *self, CompoundFileWriterIVARS *ivars) {
     bool       rename_success;
 
     if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+    OutStream_Set_Buf_Size(outstream, OUTSTREAM_BULK_BUF_SIZE);
 
     // Start metadata.
     Hash_Store_Utf8(metadata, "files", 5, INCREF(sub_files));
@@ -145,7 +149,8 @@ S_do_consolidate(CompoundFileWriter *self, CompoundFileWriterIVARS *ivars) {
     // Write metadata to cfmeta file.
     String *cfmeta_temp = SSTR_WRAP_C("cfmeta.json.temp");
     String *cfmeta_file = SSTR_WRAP_C("cfmeta.json");
-    Json_spew_json((Obj*)metadata, (Folder*)ivars->folder, cfmeta_temp);
+    MetaFile_spew((Obj*)metadata, (Folder*)ivars->folder, cfmeta_temp,
+                  ivars->binary_metadata);
     rename_success = Folder_Rename(ivars->folder, cfmeta_temp, cfmeta_file);
     if (!rename_success) { RETHROW(INCREF(Err_get_error())); }
 
@@ -27,8 +27,15 @@
   #include <unistd.h> // close
 #endif
 
+// writev() comes along with the POSIX mmap() API.
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_SYS_MMAN_H)
+  #include <sys/uio.h>
+  #define HAS_WRITEV
+#endif
+
 #ifdef CHY_HAS_SYS_MMAN_H
   #include <sys/mman.h>
+  #include <sys/stat.h>
 #elif defined(CHY_HAS_WINDOWS_H)
   #include <windows.h>
   #include <io.h>
@@ -38,6 +45,7 @@
 
 #include "Lucy/Store/FSFileHandle.h"
 #include "Lucy/Store/FileWindow.h"
+#include "Lucy/Store/RateLimiter.h"
 
 // Convert FileHandle flags to POSIX flags.
 static CFISH_INLINE int
@@ -58,6 +66,18 @@ SI_posix_flags(uint32_t fh_flags) {
 
 #define IS_64_BIT (CHY_SIZEOF_PTR == 8 ? 1 : 0)
 
+// mincore() isn't POSIX, and BSD-derived systems declare its vector as
+// char* rather than unsigned char*.
+#if defined(CHY_HAS_SYS_MMAN_H) && defined(__linux__)
+  #define HAS_MINCORE
+  typedef unsigned char mincore_vec_t;
+#elif defined(CHY_HAS_SYS_MMAN_H) \
+      && (defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) \
+          || defined(__OpenBSD__))
+  #define HAS_MINCORE
+  typedef char mincore_vec_t;
+#endif
+
 // Memory map a region of the file with shared (read-only) permissions.  If
 // the requested length is 0, return NULL.  If an error occurs, return NULL
 // and set the global error object.
@@ -78,6 +98,21 @@ SI_window(FSFileHandle *self, FSFileHandleIVARS *ivars, FileWindow *window,
 static CFISH_INLINE bool
 SI_init_read_only(FSFileHandle *self, FSFileHandleIVARS *ivars);
 
+// On 64-bit POSIX systems, whole-file mappings are shared process-wide by
+// every read-only FSFileHandle on the same file.
+#if IS_64_BIT && defined(CHY_HAS_SYS_MMAN_H)
+  #define HAS_SHARED_MAPS
+
+// Open a read-only handle, reusing an existing mapping of the file if there
+// is one.
+static bool
+S_open_shared(FSFileHandle *self, FSFileHandleIVARS *ivars);
+
+// Give up the handle's claim on its shared mapping.
+static void
+S_release_shared(FSFileHandleIVARS *ivars);
+#endif
+
 // Windows-specific routine needed for closing read-only handles.
 #ifdef CHY_HAS_WINDOWS_H
 static CFISH_INLINE bool
@@ -137,6 +172,12 @@ FSFH_do_open(FSFileHandle *self, String *path, uint32_t flags) {
         }
     }
     else if (flags & FH_READ_ONLY) {
+#ifdef HAS_SHARED_MAPS
+        if (!S_open_shared(self, ivars)) {
+            CFISH_DECREF(self);
+            return NULL;
+        }
+#else
         if (SI_init_read_only(self, ivars)) {
             // On 64-bit systems, map the whole file up-front.
             if (IS_64_BIT && ivars->len) {
@@ -153,6 +194,7 @@ FSFH_do_open(FSFileHandle *self, String *path, uint32_t flags) {
             CFISH_DECREF(self);
             return NULL;
         }
+#endif
     }
     else {
         Err_set_error(Err_new(Str_newf("Must specify FH_READ_ONLY or FH_WRITE_ONLY to open '%o'",
@@ -168,6 +210,12 @@ bool
 FSFH_Close_IMP(FSFileHandle *self) {
     FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
 
+#ifdef HAS_SHARED_MAPS
+    if (ivars->shared_map) {
+        S_release_shared(ivars);
+    }
+#endif
+
     // On 64-bit systems, cancel the whole-file mapping.
     if (IS_64_BIT && (ivars->flags & FH_READ_ONLY) && ivars->buf != NULL) {
         if (!SI_unmap(self, ivars->buf, ivars->len)) { return false; }
@@ -196,7 +244,17 @@ bool
 FSFH_Write_IMP(FSFileHandle *self, const void *data, size_t len) {
     FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
 
+    if (!(ivars->flags & FH_WRITE_ONLY)) {
+        // Read-only handles may have no descriptor of their own.
+        Err_set_error(Err_new(Str_newf("Can't write to read-only filehandle")));
+        return false;
+    }
+
     if (len) {
+        if (ivars->rate_limiter) {
+            RateLimiter_Pause(ivars->rate_limiter, len);
+        }
+
         // Write data, track file length, check for errors.
         int64_t check_val = write(ivars->fd, data, len);
         ivars->len += check_val;
@@ -216,11 +274,235 @@ FSFH_Write_IMP(FSFileHandle *self, const void *data, size_t len) {
     return true;
 }
 
+bool
+FSFH_Gather_Write_IMP(FSFileHandle *self, const void *head, size_t head_len,
+                      const void *tail, size_t tail_len) {
+#ifdef HAS_WRITEV
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    if (!head_len || !tail_len || !(ivars->flags & FH_WRITE_ONLY)) {
+        return FSFH_Write(self, head, head_len)
+               && FSFH_Write(self, tail, tail_len);
+    }
+
+    const size_t total = head_len + tail_len;
+    if (ivars->rate_limiter) {
+        RateLimiter_Pause(ivars->rate_limiter, total);
+    }
+
+    // Gather both runs into one system call, picking up where a short write
+    // left off.
+    struct iovec iov[2];
+    struct iovec *vecs = iov;
+    int num_vecs = 2;
+    size_t written = 0;
+    iov[0].iov_base = (void*)head;
+    iov[0].iov_len  = head_len;
+    iov[1].iov_base = (void*)tail;
+    iov[1].iov_len  = tail_len;
+    while (written < total) {
+        ssize_t check_val = writev(ivars->fd, vecs, num_vecs);
+        if (check_val <= 0) {
+            if (check_val == -1 && errno == EINTR) { continue; }
+            Err_set_error(Err_new(Str_newf("Error when writing %u64 bytes: %s",
+                                           (uint64_t)total,
+                                           check_val == -1
+                                           ? strerror(errno)
+                                           : "no progress")));
+            return false;
+        }
+        ivars->len += check_val;
+        written    += (size_t)check_val;
+        while (num_vecs && (size_t)check_val >= vecs->iov_len) {
+            check_val -= (ssize_t)vecs->iov_len;
+            vecs++;
+            num_vecs--;
+        }
+        if (num_vecs) {
+            vecs->iov_base = (char*)vecs->iov_base + check_val;
+            vecs->iov_len  -= (size_t)check_val;
+        }
+    }
+    return true;
+#else
+    return FSFH_Write(self, head, head_len)
+           && FSFH_Write(self, tail, tail_len);
+#endif
+}
+
+#ifndef HAS_SHARED_MAPS
+uint32_t
+FSFH_num_shared_maps() {
+    return 0;
+}
+#endif
+
+void
+FSFH_Set_Rate_Limiter_IMP(FSFileHandle *self, RateLimiter *rate_limiter) {
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    RateLimiter *temp = ivars->rate_limiter;
+    ivars->rate_limiter = (RateLimiter*)INCREF(rate_limiter);
+    DECREF(temp);
+}
+
+void
+FSFH_Destroy_IMP(FSFileHandle *self) {
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    DECREF(ivars->rate_limiter);
+    SUPER_DESTROY(self, FSFILEHANDLE);
+}
+
 int64_t
 FSFH_Length_IMP(FSFileHandle *self) {
     return FSFH_IVARS(self)->len;
 }
 
+// Clamp [offset, offset + len) to the bounds of the file, returning false if
+// nothing is left.
+static CFISH_INLINE bool
+SI_clamp_range(FSFileHandleIVARS *ivars, int64_t *offset, int64_t *len) {
+    if (*offset < 0) {
+        *len += *offset;
+        *offset = 0;
+    }
+    if (*offset + *len > ivars->len) { *len = ivars->len - *offset; }
+    return *len > 0;
+}
+
+bool
+FSFH_Advise_IMP(FSFileHandle *self, int64_t offset, int64_t len,
+                int32_t advice) {
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    if (!(ivars->flags & FH_READ_ONLY)) { return true; }
+    if (!SI_clamp_range(ivars, &offset, &len)) { return true; }
+
+#ifdef CHY_HAS_SYS_MMAN_H
+    if (IS_64_BIT && ivars->buf != NULL) {
+        // posix_madvise() wants a page-aligned address.
+        const int64_t remainder = offset % ivars->page_size;
+        int posix_advice;
+        switch (advice) {
+            case FH_ADVISE_RANDOM:
+                posix_advice = POSIX_MADV_RANDOM;
+                break;
+            case FH_ADVISE_SEQUENTIAL:
+                posix_advice = POSIX_MADV_SEQUENTIAL;
+                break;
+            case FH_ADVISE_WILLNEED:
+                posix_advice = POSIX_MADV_WILLNEED;
+                break;
+            default:
+                posix_advice = POSIX_MADV_NORMAL;
+        }
+        int check_val = posix_madvise(ivars->buf + offset - remainder,
+                                      (size_t)(len + remainder),
+                                      posix_advice);
+        if (check_val != 0) {
+            Err_set_error(Err_new(Str_newf("posix_madvise on '%o' failed: %s",
+                                           ivars->path,
+                                           strerror(check_val))));
+            return false;
+        }
+        return true;
+    }
+  #ifdef POSIX_FADV_WILLNEED
+    else {
+        int posix_advice;
+        switch (advice) {
+            case FH_ADVISE_RANDOM:
+                posix_advice = POSIX_FADV_RANDOM;
+                break;
+            case FH_ADVISE_SEQUENTIAL:
+                posix_advice = POSIX_FADV_SEQUENTIAL;
+                break;
+            case FH_ADVISE_WILLNEED:
+                posix_advice = POSIX_FADV_WILLNEED;
+                break;
+            default:
+                posix_advice = POSIX_FADV_NORMAL;
+        }
+        int check_val = posix_fadvise(ivars->fd, offset, len, posix_advice);
+        if (check_val != 0) {
+            Err_set_error(Err_new(Str_newf("posix_fadvise on '%o' failed: %s",
+                                           ivars->path,
+                                           strerror(check_val))));
+            return false;
+        }
+    }
+  #endif
+#else
+    UNUSED_VAR(advice);
+#endif
+
+    return true;
+}
+
+int64_t
+FSFH_Touch_IMP(FSFileHandle *self, int64_t offset, int64_t len) {
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    if (!(ivars->flags & FH_READ_ONLY)) { return 0; }
+    if (!SI_clamp_range(ivars, &offset, &len)) { return 0; }
+
+    if (IS_64_BIT && ivars->buf != NULL) {
+        // Reading a single byte is enough to fault in a whole page.
+        const volatile char *const buf = ivars->buf;
+        const int64_t end = offset + len;
+        char sink = 0;
+        for (int64_t pos = offset; pos < end; pos += ivars->page_size) {
+            sink ^= buf[pos];
+        }
+        sink ^= buf[end - 1];
+        UNUSED_VAR(sink);
+        return len;
+    }
+
+    FSFH_Touch_t super_touch
+        = SUPER_METHOD_PTR(FSFILEHANDLE, LUCY_FSFH_Touch);
+    return super_touch(self, offset, len);
+}
+
+bool
+FSFH_can_measure_residency() {
+#ifdef HAS_MINCORE
+    return IS_64_BIT ? true : false;
+#else
+    return false;
+#endif
+}
+
+int64_t
+FSFH_Resident_Bytes_IMP(FSFileHandle *self, int64_t offset, int64_t len) {
+    FSFileHandleIVARS *const ivars = FSFH_IVARS(self);
+    if (!SI_clamp_range(ivars, &offset, &len)) { return 0; }
+
+#ifdef HAS_MINCORE
+    if (IS_64_BIT && ivars->buf != NULL) {
+        const int64_t page_size = ivars->page_size;
+        const int64_t start     = offset - offset % page_size;
+        const int64_t end       = offset + len;
+        const size_t  num_pages
+            = (size_t)((end - start + page_size - 1) / page_size);
+        mincore_vec_t *vec = (mincore_vec_t*)MALLOCATE(num_pages);
+        if (mincore(ivars->buf + start, (size_t)(end - start), vec) != 0) {
+            FREEMEM(vec);
+            return -1;
+        }
+        int64_t resident = 0;
+        for (size_t i = 0; i < num_pages; i++) {
+            if (!(vec[i] & 1)) { continue; }
+            int64_t page_start = start + (int64_t)i * page_size;
+            int64_t page_end   = page_start + page_size;
+            if (page_start < offset) { page_start = offset; }
+            if (page_end > end)      { page_end = end; }
+            resident += page_end - page_start;
+        }
+        FREEMEM(vec);
+        return resident;
+    }
+#endif
+
+    return -1;
+}
+
 bool
 FSFH_Window_IMP(FSFileHandle *self, FileWindow *window, int64_t offset,
                 int64_t len) {
@@ -407,6 +689,163 @@ SI_unmap(FSFileHandle *self, char *buf, int64_t len) {
     return true;
 }
 
+#ifdef HAS_SHARED_MAPS
+
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+  #include <pthread.h>
+  static pthread_mutex_t S_maps_mutex = PTHREAD_MUTEX_INITIALIZER;
+  #define LOCK_MAPS()   pthread_mutex_lock(&S_maps_mutex)
+  #define UNLOCK_MAPS() pthread_mutex_unlock(&S_maps_mutex)
+#else
+  #define LOCK_MAPS()
+  #define UNLOCK_MAPS()
+#endif
+
+#define NUM_MAP_BUCKETS 512
+
+/* A whole-file mapping shared by every read-only FSFileHandle open on the
+ * file.  Files are identified by device and inode, so a path which has been
+ * replaced gets a fresh mapping; size and modification time guard against a
+ * file which has been rewritten in place.
+ */
+typedef struct SharedMap {
+    struct SharedMap *next;
+    dev_t             dev;
+    ino_t             ino;
+    time_t            mtime;
+    int64_t           len;
+    int64_t           page_size;
+    char             *buf;
+    uint32_t          refcount;
+} SharedMap;
+
+static SharedMap *S_maps[NUM_MAP_BUCKETS];
+static uint32_t   S_num_maps = 0;
+
+static CFISH_INLINE SharedMap**
+SI_bucket(dev_t dev, ino_t ino) {
+    uint64_t hash = (uint64_t)ino * UINT64_C(0x9E3779B97F4A7C15)
+                    ^ (uint64_t)dev;
+    return &S_maps[(hash >> 32) % NUM_MAP_BUCKETS];
+}
+
+// Find the mapping for a file and claim a reference to it.  The caller must
+// hold the lock.
+static SharedMap*
+S_claim(struct stat *st) {
+    SharedMap *map = *SI_bucket(st->st_dev, st->st_ino);
+    for (; map != NULL; map = map->next) {
+        if (map->dev == st->st_dev
+            && map->ino == st->st_ino
+            && map->len == (int64_t)st->st_size
+            && map->mtime == st->st_mtime
+           ) {
+            map->refcount++;
+            return map;
+        }
+    }
+    return NULL;
+}
+
+static CFISH_INLINE void
+SI_use_map(FSFileHandleIVARS *ivars, SharedMap *map) {
+    ivars->shared_map = map;
+    ivars->buf        = map->buf;
+    ivars->len        = map->len;
+    ivars->page_size  = map->page_size;
+}
+
+static bool
+S_open_shared(FSFileHandle *self, FSFileHandleIVARS *ivars) {
+    struct stat st;
+
+    // Fast path: another handle already maps the file, so there's no need
+    // to open() or mmap() it again.
+    char *path_ptr = Str_To_Utf8(ivars->path);
+    int check_val = stat(path_ptr, &st);
+    FREEMEM(path_ptr);
+    if (check_val == 0) {
+        LOCK_MAPS();
+        SharedMap *map = S_claim(&st);
+        UNLOCK_MAPS();
+        if (map) {
+            SI_use_map(ivars, map);
+            return true;
+        }
+    }
+
+    // Open and map the file ourselves.
+    if (!SI_init_read_only(self, ivars)) { return false; }
+    if (!ivars->len) { return true; }
+    if (fstat(ivars->fd, &st) != 0) {
+        Err_set_error(Err_new(Str_newf("fstat on %o failed: %s", ivars->path,
+                                       strerror(errno))));
+        return false;
+    }
+    char *buf = (char*)SI_map(self, ivars, 0, ivars->len);
+    if (!buf) { return false; }
+
+    // The descriptor isn't needed once the file is mapped.
+    close(ivars->fd);
+    ivars->fd = 0;
+
+    // Another thread may have mapped the file in the meantime.
+    LOCK_MAPS();
+    SharedMap *map = S_claim(&st);
+    if (!map) {
+        map = (SharedMap*)MALLOCATE(sizeof(SharedMap));
+        SharedMap **bucket = SI_bucket(st.st_dev, st.st_ino);
+        map->dev       = st.st_dev;
+        map->ino       = st.st_ino;
+        map->mtime     = st.st_mtime;
+        map->len       = ivars->len;
+        map->page_size = ivars->page_size;
+        map->buf       = buf;
+        map->refcount  = 1;
+        map->next      = *bucket;
+        *bucket        = map;
+        S_num_maps++;
+        buf = NULL;
+    }
+    UNLOCK_MAPS();
+    if (buf) { munmap(buf, ivars->len); }
+
+    SI_use_map(ivars, map);
+    return true;
+}
+
+static void
+S_release_shared(FSFileHandleIVARS *ivars) {
+    SharedMap *map = (SharedMap*)ivars->shared_map;
+    ivars->shared_map = NULL;
+    ivars->buf        = NULL;
+
+    LOCK_MAPS();
+    bool last = --map->refcount == 0;
+    if (last) {
+        SharedMap **link = SI_bucket(map->dev, map->ino);
+        while (*link != map) { link = &(*link)->next; }
+        *link = map->next;
+        S_num_maps--;
+    }
+    UNLOCK_MAPS();
+
+    if (last) {
+        munmap(map->buf, map->len);
+        FREEMEM(map);
+    }
+}
+
+uint32_t
+FSFH_num_shared_maps() {
+    LOCK_MAPS();
+    uint32_t num_maps = S_num_maps;
+    UNLOCK_MAPS();
+    return num_maps;
+}
+
+#endif // HAS_SHARED_MAPS
+
 #if !IS_64_BIT
 bool
 FSFH_Read_IMP(FSFileHandle *self, char *dest, int64_t offset, size_t len) {
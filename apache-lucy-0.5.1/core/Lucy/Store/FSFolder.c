@@ -47,6 +47,7 @@
 #include "Lucy/Store/FSFileHandle.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RateLimiter.h"
 #include "Lucy/Util/IndexFileNames.h"
 
 // Return a String containing a platform-specific absolute filepath.
@@ -81,6 +82,10 @@ S_absolutify(String *path);
 static bool
 S_hard_link(char *from_path, char *to_path);
 
+// Flush a file or directory to stable storage.
+static bool
+S_sync(char *path);
+
 FSFolder*
 FSFolder_new(String *path) {
     FSFolder *self = (FSFolder*)Class_Make_Obj(FSFOLDER);
@@ -92,9 +97,30 @@ FSFolder_init(FSFolder *self, String *path) {
     String *abs_path = S_absolutify(path);
     Folder_init((Folder*)self, abs_path);
     DECREF(abs_path);
+    FSFolder_IVARS(self)->rate_limiter = NULL;
     return self;
 }
 
+void
+FSFolder_Destroy_IMP(FSFolder *self) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
+    DECREF(ivars->rate_limiter);
+    SUPER_DESTROY(self, FSFOLDER);
+}
+
+void
+FSFolder_Set_Rate_Limiter_IMP(FSFolder *self, RateLimiter *rate_limiter) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
+    RateLimiter *temp = ivars->rate_limiter;
+    ivars->rate_limiter = (RateLimiter*)INCREF(rate_limiter);
+    DECREF(temp);
+}
+
+RateLimiter*
+FSFolder_Get_Rate_Limiter_IMP(FSFolder *self) {
+    return FSFolder_IVARS(self)->rate_limiter;
+}
+
 void
 FSFolder_Initialize_IMP(FSFolder *self) {
     FSFolderIVARS *const ivars = FSFolder_IVARS(self);
@@ -114,9 +140,13 @@ FSFolder_Check_IMP(FSFolder *self) {
 FileHandle*
 FSFolder_Local_Open_FileHandle_IMP(FSFolder *self, String *name,
                                    uint32_t flags) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
     String       *fullpath = S_fullpath(self, name);
     FSFileHandle *fh = FSFH_open(fullpath, flags);
     if (!fh) { ERR_ADD_FRAME(Err_get_error()); }
+    else if (ivars->rate_limiter && (flags & FH_WRITE_ONLY)) {
+        FSFH_Set_Rate_Limiter(fh, ivars->rate_limiter);
+    }
     DECREF(fullpath);
     return (FileHandle*)fh;
 }
@@ -176,6 +206,24 @@ FSFolder_Local_Is_Directory_IMP(FSFolder *self, String *name) {
     }
 }
 
+int64_t
+FSFolder_Local_File_Length_IMP(FSFolder *self, String *name) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
+    if (Hash_Fetch(ivars->entries, name) || !S_is_local_entry(name)) {
+        return 0;
+    }
+    struct stat stat_buf;
+    char *fullpath_ptr = S_fullpath_ptr(self, name);
+    int64_t length = 0;
+    if (stat(fullpath_ptr, &stat_buf) != -1
+        && (stat_buf.st_mode & S_IFMT) == S_IFREG
+       ) {
+        length = (int64_t)stat_buf.st_size;
+    }
+    FREEMEM(fullpath_ptr);
+    return length;
+}
+
 bool
 FSFolder_Rename_IMP(FSFolder *self, String* from, String *to) {
     char *from_path = S_fullpath_ptr(self, from);
@@ -216,6 +264,17 @@ FSFolder_Local_Delete_IMP(FSFolder *self, String *name) {
     return result;
 }
 
+bool
+FSFolder_Local_Sync_IMP(FSFolder *self, String *name) {
+    FSFolderIVARS *const ivars = FSFolder_IVARS(self);
+    char *path_ptr = name && Str_Get_Size(name)
+                     ? S_fullpath_ptr(self, name)
+                     : Str_To_Utf8(ivars->path);
+    bool result = S_sync(path_ptr);
+    FREEMEM(path_ptr);
+    return result;
+}
+
 void
 FSFolder_Close_IMP(FSFolder *self) {
     FSFolderIVARS *const ivars = FSFolder_IVARS(self);
@@ -254,6 +313,10 @@ FSFolder_Local_Find_Folder_IMP(FSFolder *self, String *name) {
             DECREF(fullpath);
             THROW(ERR, "Failed to open FSFolder at '%o'", fullpath);
         }
+        if (ivars->rate_limiter) {
+            FSFolder_Set_Rate_Limiter((FSFolder*)subfolder,
+                                      ivars->rate_limiter);
+        }
         // Try to open a CompoundFileReader. On failure, just use the
         // existing folder.
         String *cfmeta_file = SSTR_WRAP_C("cfmeta.json");
@@ -406,6 +469,32 @@ S_hard_link(char *from8, char *to8) {
     }
 }
 
+static bool
+S_sync(char *path) {
+    // Directory entries can't be flushed on Windows, so only sync files.
+    DWORD attributes = GetFileAttributes(path);
+    if (attributes != INVALID_FILE_ATTRIBUTES
+        && (attributes & FILE_ATTRIBUTE_DIRECTORY)
+       ) {
+        return true;
+    }
+    HANDLE handle = CreateFile(path, GENERIC_WRITE,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE
+                               | FILE_SHARE_DELETE,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                               NULL);
+    if (handle == INVALID_HANDLE_VALUE || !FlushFileBuffers(handle)) {
+        char *win_error = Err_win_error();
+        Err_set_error(Err_new(Str_newf("Failed to sync '%s': %s",
+                                       path, win_error)));
+        FREEMEM(win_error);
+        if (handle != INVALID_HANDLE_VALUE) { CloseHandle(handle); }
+        return false;
+    }
+    CloseHandle(handle);
+    return true;
+}
+
 #elif (defined(CHY_HAS_UNISTD_H))
 
 static bool
@@ -444,6 +533,37 @@ S_hard_link(char *from8, char *to8) {
     }
 }
 
+static bool
+S_sync(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        Err_set_error(Err_new(Str_newf("Failed to open '%s' for sync: %s",
+                                       path, strerror(errno))));
+        return false;
+    }
+
+    struct stat stat_buf;
+    bool is_dir = fstat(fd, &stat_buf) == 0 && (stat_buf.st_mode & S_IFDIR);
+    int  check;
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    // A directory's entries are metadata, which fdatasync may skip.
+    check = is_dir ? fsync(fd) : fdatasync(fd);
+#else
+    check = fsync(fd);
+#endif
+    // Some filesystems refuse to sync directories; nothing more can be done
+    // for them.
+    if (check == -1 && is_dir && (errno == EINVAL || errno == EBADF)) {
+        check = 0;
+    }
+    if (check == -1) {
+        Err_set_error(Err_new(Str_newf("Failed to sync '%s': %s",
+                                       path, strerror(errno))));
+    }
+    close(fd);
+    return check == 0;
+}
+
 #else
   #error "Need either windows.h or unistd.h"
 #endif /* CHY_HAS_UNISTD_H vs. CHY_HAS_WINDOWS_H */
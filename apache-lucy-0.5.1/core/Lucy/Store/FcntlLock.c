@@ -0,0 +1,609 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_FCNTLLOCK
+#include "Lucy/Util/ToolSet.h"
+
+#include "charmony.h"
+
+#include "Lucy/Store/FcntlLock.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/Lock.h"
+
+#if (defined(CHY_HAS_FCNTL_H) && defined(CHY_HAS_UNISTD_H) \
+     && defined(CHY_HAS_SYS_STAT_H) && defined(CHY_HAS_SYS_TIME_H) \
+     && defined(CHY_HAS_PTHREAD_H) && !defined(CHY_HAS_WINDOWS_H))
+#define LUCY_HAS_FCNTL_LOCK
+#endif
+
+FcntlLock*
+FcntlLock_new(Folder *folder, String *name, String *host,
+              int32_t timeout, int32_t interval) {
+    FcntlLock *self = (FcntlLock*)Class_Make_Obj(FCNTLLOCK);
+    return FcntlLock_init(self, folder, name, host, timeout, interval);
+}
+
+bool
+FcntlLock_Shared_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
+/********************************* UNIXEN *********************************/
+#ifdef LUCY_HAS_FCNTL_LOCK
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "Lucy/Util/Json.h"
+#include "Lucy/Util/ProcessID.h"
+#include "Lucy/Util/Sleep.h"
+
+/* Paths of the lock files claimed by FcntlLocks in this process.  Record
+ * locks can't arbitrate between two descriptors held by one process, and
+ * closing any descriptor for a file drops all of the process's record locks
+ * on it, so no descriptor for a claimed path may be opened except by its
+ * claimant.
+ */
+typedef struct lucy_FcntlLockClaim {
+    char *path;
+    struct lucy_FcntlLockClaim *next;
+} lucy_FcntlLockClaim;
+
+static lucy_FcntlLockClaim *S_claims = NULL;
+static pthread_mutex_t S_claims_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  S_claims_cond  = PTHREAD_COND_INITIALIZER;
+
+// Must be called with S_claims_mutex held.
+static bool
+S_is_claimed(const char *path) {
+    for (lucy_FcntlLockClaim *claim = S_claims; claim; claim = claim->next) {
+        if (strcmp(claim->path, path) == 0) { return true; }
+    }
+    return false;
+}
+
+// Must be called with S_claims_mutex held.
+static void
+S_add_claim(const char *path) {
+    size_t size = strlen(path) + 1;
+    lucy_FcntlLockClaim *claim
+        = (lucy_FcntlLockClaim*)MALLOCATE(sizeof(lucy_FcntlLockClaim));
+    claim->path = (char*)MALLOCATE(size);
+    memcpy(claim->path, path, size);
+    claim->next = S_claims;
+    S_claims = claim;
+}
+
+// Must be called with S_claims_mutex held.
+static void
+S_drop_claim(const char *path) {
+    for (lucy_FcntlLockClaim **ptr = &S_claims; *ptr; ptr = &(*ptr)->next) {
+        lucy_FcntlLockClaim *claim = *ptr;
+        if (strcmp(claim->path, path) == 0) {
+            *ptr = claim->next;
+            FREEMEM(claim->path);
+            FREEMEM(claim);
+            break;
+        }
+    }
+    pthread_cond_broadcast(&S_claims_cond);
+}
+
+static void
+S_remove_claim(const char *path) {
+    pthread_mutex_lock(&S_claims_mutex);
+    S_drop_claim(path);
+    pthread_mutex_unlock(&S_claims_mutex);
+}
+
+/* A blocking F_SETLKW runs on a helper thread, so that its caller can give
+ * up at a deadline.  If the caller gives up, the claim on the path passes to
+ * the helper, which releases the record lock as soon as it gets it and then
+ * drops the claim.  All fields are guarded by S_claims_mutex.
+ */
+typedef struct lucy_FcntlLockWait {
+    char *path;
+    int   fd;
+    int   error;
+    bool  done;
+    bool  abandoned;
+} lucy_FcntlLockWait;
+
+static uint64_t
+S_now_micros() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+}
+
+static void
+S_set_lock_err(String *mess) {
+    Err_set_error((Err*)LockErr_new(mess));
+}
+
+static int
+S_set_record_lock(int fd, short type, bool wait) {
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type   = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start  = 0;
+    lock.l_len    = 0;
+    int result;
+    do {
+        result = fcntl(fd, wait ? F_SETLKW : F_SETLK, &lock);
+    } while (wait && result != 0 && errno == EINTR);
+    return result;
+}
+
+static void*
+S_wait_for_record_lock(void *context) {
+    lucy_FcntlLockWait *wait = (lucy_FcntlLockWait*)context;
+    int error = S_set_record_lock(wait->fd, F_WRLCK, true) == 0 ? 0 : errno;
+
+    pthread_mutex_lock(&S_claims_mutex);
+    if (wait->abandoned) {
+        close(wait->fd);
+        S_drop_claim(wait->path);
+        FREEMEM(wait->path);
+        FREEMEM(wait);
+    }
+    else {
+        wait->error = error;
+        wait->done  = true;
+        pthread_cond_broadcast(&S_claims_cond);
+    }
+    pthread_mutex_unlock(&S_claims_mutex);
+    return NULL;
+}
+
+// Block until `fd` is locked or `deadline` passes.  On failure `fd` is
+// closed, unless the wait was abandoned, in which case the helper thread
+// owns both `fd` and the claim on the path.
+static bool
+S_wait_record_lock(FcntlLock *self, int fd, uint64_t deadline,
+                   bool *abandoned_ptr) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    size_t path_size = strlen(ivars->path) + 1;
+    lucy_FcntlLockWait *wait
+        = (lucy_FcntlLockWait*)MALLOCATE(sizeof(lucy_FcntlLockWait));
+    wait->path = (char*)MALLOCATE(path_size);
+    memcpy(wait->path, ivars->path, path_size);
+    wait->fd        = fd;
+    wait->error     = 0;
+    wait->done      = false;
+    wait->abandoned = false;
+
+    pthread_t      thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int check = pthread_create(&thread, &attr, S_wait_for_record_lock, wait);
+    pthread_attr_destroy(&attr);
+    if (check != 0) {
+        close(fd);
+        FREEMEM(wait->path);
+        FREEMEM(wait);
+        S_set_lock_err(Str_newf("Can't wait for '%o': %s", ivars->lock_path,
+                                strerror(check)));
+        return false;
+    }
+
+    struct timespec until;
+    until.tv_sec  = (time_t)(deadline / 1000000);
+    until.tv_nsec = (long)(deadline % 1000000) * 1000;
+    pthread_mutex_lock(&S_claims_mutex);
+    while (!wait->done) {
+        if (pthread_cond_timedwait(&S_claims_cond, &S_claims_mutex, &until)
+            == ETIMEDOUT
+           ) {
+            break;
+        }
+    }
+    bool done = wait->done;
+    if (!done) { wait->abandoned = true; }
+    pthread_mutex_unlock(&S_claims_mutex);
+
+    if (!done) {
+        *abandoned_ptr = true;
+        S_set_lock_err(Str_newf("Can't obtain lock: '%o' is locked",
+                                ivars->lock_path));
+        return false;
+    }
+    int error = wait->error;
+    FREEMEM(wait->path);
+    FREEMEM(wait);
+    if (error) {
+        close(fd);
+        S_set_lock_err(Str_newf("Can't lock '%o': %s", ivars->lock_path,
+                                strerror(error)));
+        return false;
+    }
+    return true;
+}
+
+// Return true if the file open at `fd` names a holder which must be
+// honored: one on another host, or a live process on this one.  Empty or
+// unparsable files, and files naming dead processes, are stale.
+static bool
+S_names_live_holder(FcntlLock *self, int fd) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) != 0 || stat_buf.st_size <= 0) { return false; }
+    if (stat_buf.st_size > 4096) { return true; } // Not ours to judge.
+
+    size_t  size = (size_t)stat_buf.st_size;
+    char   *buf  = (char*)MALLOCATE(size);
+    ssize_t got  = pread(fd, buf, size, 0);
+    if (got != (ssize_t)size) {
+        FREEMEM(buf);
+        return false;
+    }
+    String *json = Str_new_from_utf8(buf, size);
+    FREEMEM(buf);
+    Hash *hash = (Hash*)Json_from_json(json);
+    DECREF(json);
+
+    bool live = false;
+    if (hash && Obj_is_a((Obj*)hash, HASH)) {
+        String *pid_buf = (String*)Hash_Fetch_Utf8(hash, "pid", 3);
+        String *host    = (String*)Hash_Fetch_Utf8(hash, "host", 4);
+        if (host && Obj_is_a((Obj*)host, STRING)
+            && !Str_Equals(host, (Obj*)ivars->host)
+           ) {
+            live = true;
+        }
+        else if (pid_buf && Obj_is_a((Obj*)pid_buf, STRING)) {
+            live = PID_active((int)Str_To_I64(pid_buf));
+        }
+    }
+    DECREF(hash);
+    return live;
+}
+
+// Create the "locks" subdirectory if necessary.
+static bool
+S_ensure_lock_dir(Folder *folder) {
+    String *lock_dir_name = SSTR_WRAP_C("locks");
+    if (Folder_Exists(folder, lock_dir_name)) { return true; }
+    if (Folder_MkDir(folder, lock_dir_name)) { return true; }
+
+    // Maybe our attempt failed because another process succeeded.
+    if (Folder_Find_Folder(folder, lock_dir_name)) { return true; }
+    Err *mkdir_err = (Err*)CERTIFY(Err_get_error(), ERR);
+    S_set_lock_err(Str_newf("Can't create 'locks' directory: %o",
+                            Err_Get_Mess(mkdir_err)));
+    return false;
+}
+
+// Take the record lock, blocking until `deadline` if another process holds
+// it.  The caller must have claimed the path.  If the wait is abandoned,
+// the claim passes to the helper thread and `*abandoned_ptr` is set.
+static bool
+S_lock_file(FcntlLock *self, uint64_t deadline, bool *abandoned_ptr) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    if (!S_ensure_lock_dir(ivars->folder)) { return false; }
+
+    while (true) {
+        int fd = open(ivars->path, O_RDWR | O_CREAT, 0666);
+        if (fd < 0) {
+            S_set_lock_err(Str_newf("Can't open '%o': %s", ivars->lock_path,
+                                    strerror(errno)));
+            return false;
+        }
+        if (S_set_record_lock(fd, F_WRLCK, false) != 0) {
+            int lock_errno = errno;
+            if ((lock_errno == EACCES || lock_errno == EAGAIN)
+                && S_now_micros() < deadline
+               ) {
+                if (!S_wait_record_lock(self, fd, deadline, abandoned_ptr)) {
+                    return false;
+                }
+            }
+            else {
+                close(fd);
+                if (lock_errno == EACCES || lock_errno == EAGAIN) {
+                    S_set_lock_err(Str_newf("Can't obtain lock: '%o' is "
+                                            "locked", ivars->lock_path));
+                }
+                else {
+                    S_set_lock_err(Str_newf("Can't lock '%o': %s",
+                                            ivars->lock_path,
+                                            strerror(lock_errno)));
+                }
+                return false;
+            }
+        }
+
+        // If the previous holder unlinked the file while we were waiting
+        // on it, we hold a lock on an orphan.  Start over.
+        struct stat fd_stat, path_stat;
+        if (fstat(fd, &fd_stat) != 0
+            || stat(ivars->path, &path_stat) != 0
+            || fd_stat.st_dev != path_stat.st_dev
+            || fd_stat.st_ino != path_stat.st_ino
+           ) {
+            close(fd);
+            continue;
+        }
+
+        // Honor a LockFileLock, or a holder on another host.
+        if (S_names_live_holder(self, fd)) {
+            close(fd);
+            S_set_lock_err(Str_newf("Can't obtain lock: '%o' exists",
+                                    ivars->lock_path));
+            return false;
+        }
+
+        // Record pid, lock name, and host, as LockFileLock does.
+        Hash *file_data = Hash_new(3);
+        Hash_Store_Utf8(file_data, "pid", 3,
+                        (Obj*)Str_newf("%i32", (int32_t)PID_getpid()));
+        Hash_Store_Utf8(file_data, "host", 4, INCREF(ivars->host));
+        Hash_Store_Utf8(file_data, "name", 4, INCREF(ivars->name));
+        String *json = Json_to_json((Obj*)file_data);
+        DECREF(file_data);
+        size_t  size  = Str_Get_Size(json);
+        bool    wrote = ftruncate(fd, 0) == 0
+                        && pwrite(fd, Str_Get_Ptr8(json), size, 0)
+                           == (ssize_t)size;
+        DECREF(json);
+        if (!wrote) {
+            S_set_lock_err(Str_newf("Can't write '%o': %s", ivars->lock_path,
+                                    strerror(errno)));
+            close(fd);
+            return false;
+        }
+
+        ivars->fd = fd;
+        return true;
+    }
+}
+
+FcntlLock*
+FcntlLock_init(FcntlLock *self, Folder *folder, String *name,
+               String *host, int32_t timeout, int32_t interval) {
+    Lock_init((Lock*)self, folder, name, host, timeout, interval);
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    ivars->fd = -1;
+    String *folder_path = Folder_Get_Path(folder);
+    if (!folder_path || !Str_Get_Size(folder_path)) {
+        DECREF(self);
+        THROW(ERR, "FcntlLock requires a folder in the file system");
+    }
+    String *path = Str_newf("%o/%o", folder_path, ivars->lock_path);
+    ivars->path = Str_To_Utf8(path);
+    DECREF(path);
+    return self;
+}
+
+bool
+FcntlLock_available() {
+    return true;
+}
+
+bool
+FcntlLock_Request_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    if (ivars->fd >= 0) {
+        S_set_lock_err(Str_newf("Can't obtain lock: '%o' is already held",
+                                ivars->lock_path));
+        return false;
+    }
+
+    pthread_mutex_lock(&S_claims_mutex);
+    bool claimed = S_is_claimed(ivars->path);
+    if (!claimed) { S_add_claim(ivars->path); }
+    pthread_mutex_unlock(&S_claims_mutex);
+    if (claimed) {
+        S_set_lock_err(Str_newf("Can't obtain lock: '%o' is held by this "
+                                "process", ivars->lock_path));
+        return false;
+    }
+
+    bool abandoned = false;
+    if (!S_lock_file(self, 0, &abandoned)) {
+        S_remove_claim(ivars->path);
+        return false;
+    }
+    return true;
+}
+
+bool
+FcntlLock_Obtain_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    uint64_t deadline = S_now_micros()
+                        + (ivars->timeout > 0 ? ivars->timeout : 0) * 1000;
+    if (ivars->fd >= 0) {
+        S_set_lock_err(Str_newf("Can't obtain lock: '%o' is already held",
+                                ivars->lock_path));
+        return false;
+    }
+
+    // Wait for any holder in this process to release.
+    pthread_mutex_lock(&S_claims_mutex);
+    while (S_is_claimed(ivars->path)) {
+        if (S_now_micros() >= deadline) {
+            pthread_mutex_unlock(&S_claims_mutex);
+            S_set_lock_err(Str_newf("Can't obtain lock: '%o' is held by "
+                                    "this process", ivars->lock_path));
+            ERR_ADD_FRAME(Err_get_error());
+            return false;
+        }
+        struct timespec until;
+        until.tv_sec  = (time_t)(deadline / 1000000);
+        until.tv_nsec = (long)(deadline % 1000000) * 1000;
+        pthread_cond_timedwait(&S_claims_cond, &S_claims_mutex, &until);
+    }
+    S_add_claim(ivars->path);
+    pthread_mutex_unlock(&S_claims_mutex);
+
+    // Block on a record lock held by another process.  Only a LockFileLock
+    // holder, which no record lock guards, has to be polled for, backing
+    // off from 1 ms up to `interval`.
+    uint32_t pause     = 1;
+    bool     abandoned = false;
+    while (!S_lock_file(self, deadline, &abandoned)) {
+        uint64_t now = S_now_micros();
+        if (abandoned || now >= deadline) {
+            if (!abandoned) { S_remove_claim(ivars->path); }
+            ERR_ADD_FRAME(Err_get_error());
+            return false;
+        }
+        uint64_t left = (deadline - now + 999) / 1000;
+        Sleep_millisleep(pause < left ? pause : (uint32_t)left);
+        pause *= 2;
+        if (pause > (uint32_t)ivars->interval) {
+            pause = (uint32_t)ivars->interval;
+        }
+    }
+    return true;
+}
+
+void
+FcntlLock_Release_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    if (ivars->fd < 0) { return; }
+
+    // Unlink before unlocking, so that waiters which opened the file can
+    // tell that they've locked an orphan.
+    unlink(ivars->path);
+    close(ivars->fd);
+    ivars->fd = -1;
+    S_remove_claim(ivars->path);
+}
+
+bool
+FcntlLock_Is_Locked_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    if (ivars->fd >= 0) { return true; }
+
+    bool locked = false;
+    pthread_mutex_lock(&S_claims_mutex);
+    if (S_is_claimed(ivars->path)) {
+        locked = true;
+    }
+    else {
+        int fd = open(ivars->path, O_RDONLY);
+        if (fd >= 0) {
+            struct flock lock;
+            memset(&lock, 0, sizeof(lock));
+            lock.l_type   = F_WRLCK;
+            lock.l_whence = SEEK_SET;
+            if (fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK) {
+                locked = true;
+            }
+            else {
+                locked = S_names_live_holder(self, fd);
+            }
+            close(fd);
+        }
+    }
+    pthread_mutex_unlock(&S_claims_mutex);
+    return locked;
+}
+
+void
+FcntlLock_Clear_Stale_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+
+    pthread_mutex_lock(&S_claims_mutex);
+    if (!S_is_claimed(ivars->path)) {
+        int fd = open(ivars->path, O_RDWR);
+        if (fd >= 0) {
+            if (S_set_record_lock(fd, F_WRLCK, false) == 0
+                && !S_names_live_holder(self, fd)
+               ) {
+                unlink(ivars->path);
+            }
+            close(fd);
+        }
+    }
+    pthread_mutex_unlock(&S_claims_mutex);
+}
+
+void
+FcntlLock_Destroy_IMP(FcntlLock *self) {
+    FcntlLockIVARS *const ivars = FcntlLock_IVARS(self);
+    FcntlLock_Release(self);
+    FREEMEM(ivars->path);
+    SUPER_DESTROY(self, FCNTLLOCK);
+}
+
+/******************************** FALLBACK ********************************/
+#else
+
+FcntlLock*
+FcntlLock_init(FcntlLock *self, Folder *folder, String *name,
+               String *host, int32_t timeout, int32_t interval) {
+    UNUSED_VAR(folder);
+    UNUSED_VAR(name);
+    UNUSED_VAR(host);
+    UNUSED_VAR(timeout);
+    UNUSED_VAR(interval);
+    DECREF(self);
+    THROW(ERR, "FcntlLock is not available on this platform");
+    UNREACHABLE_RETURN(FcntlLock*);
+}
+
+bool
+FcntlLock_available() {
+    return false;
+}
+
+bool
+FcntlLock_Request_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+    UNREACHABLE_RETURN(bool);
+}
+
+bool
+FcntlLock_Obtain_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+    UNREACHABLE_RETURN(bool);
+}
+
+void
+FcntlLock_Release_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+}
+
+bool
+FcntlLock_Is_Locked_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+    UNREACHABLE_RETURN(bool);
+}
+
+void
+FcntlLock_Clear_Stale_IMP(FcntlLock *self) {
+    UNUSED_VAR(self);
+}
+
+void
+FcntlLock_Destroy_IMP(FcntlLock *self) {
+    SUPER_DESTROY(self, FCNTLLOCK);
+}
+
+#endif // LUCY_HAS_FCNTL_LOCK
+
+
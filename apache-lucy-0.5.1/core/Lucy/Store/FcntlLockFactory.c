@@ -0,0 +1,50 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_FCNTLLOCKFACTORY
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Store/FcntlLockFactory.h"
+#include "Lucy/Store/FcntlLock.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/Lock.h"
+
+FcntlLockFactory*
+FcntlLockFact_new(Folder *folder, String *host) {
+    FcntlLockFactory *self
+        = (FcntlLockFactory*)Class_Make_Obj(FCNTLLOCKFACTORY);
+    return FcntlLockFact_init(self, folder, host);
+}
+
+FcntlLockFactory*
+FcntlLockFact_init(FcntlLockFactory *self, Folder *folder, String *host) {
+    LockFact_init((LockFactory*)self, folder, host);
+    return self;
+}
+
+Lock*
+FcntlLockFact_Make_Lock_IMP(FcntlLockFactory *self, String *name,
+                            int32_t timeout, int32_t interval) {
+    FcntlLockFactoryIVARS *const ivars = FcntlLockFact_IVARS(self);
+    if (FcntlLock_available() && Obj_is_a((Obj*)ivars->folder, FSFOLDER)) {
+        return (Lock*)FcntlLock_new(ivars->folder, name, ivars->host,
+                                    timeout, interval);
+    }
+    return (Lock*)LFLock_new(ivars->folder, name, ivars->host, timeout,
+                             interval);
+}
+
+
@@ -52,6 +52,43 @@ FH_Grow_IMP(FileHandle *self, int64_t length) {
     return true;
 }
 
+bool
+FH_Advise_IMP(FileHandle *self, int64_t offset, int64_t len, int32_t advice) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(offset);
+    UNUSED_VAR(len);
+    UNUSED_VAR(advice);
+    return true;
+}
+
+int64_t
+FH_Touch_IMP(FileHandle *self, int64_t offset, int64_t len) {
+    char    buf[16384];
+    int64_t touched = 0;
+    while (touched < len) {
+        int64_t remaining = len - touched;
+        size_t  amount    = remaining < (int64_t)sizeof(buf)
+                            ? (size_t)remaining
+                            : sizeof(buf);
+        if (!FH_Read(self, buf, offset + touched, amount)) { return -1; }
+        touched += (int64_t)amount;
+    }
+    return touched;
+}
+
+int64_t
+FH_Resident_Bytes_IMP(FileHandle *self, int64_t offset, int64_t len) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(offset);
+    return len;
+}
+
+bool
+FH_Gather_Write_IMP(FileHandle *self, const void *head, size_t head_len,
+                    const void *tail, size_t tail_len) {
+    return FH_Write(self, head, head_len) && FH_Write(self, tail, tail_len);
+}
+
 void
 FH_Set_Path_IMP(FileHandle *self, String *path) {
     FileHandleIVARS *const ivars = FH_IVARS(self);
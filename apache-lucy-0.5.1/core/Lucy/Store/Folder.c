@@ -395,6 +395,35 @@ Folder_Slurp_File_IMP(Folder *self, String *path) {
     return retval;
 }
 
+int64_t
+Folder_File_Length_IMP(Folder *self, String *path) {
+    Folder *enclosing_folder = Folder_Enclosing_Folder(self, path);
+    int64_t length = 0;
+    if (enclosing_folder) {
+        String *name = IxFileNames_local_part(path);
+        length = Folder_Local_File_Length(enclosing_folder, name);
+        DECREF(name);
+    }
+    return length;
+}
+
+int64_t
+Folder_Local_File_Length_IMP(Folder *self, String *name) {
+    if (!Folder_Local_Exists(self, name)
+        || Folder_Local_Is_Directory(self, name)
+       ) {
+        return 0;
+    }
+    FileHandle *fh = Folder_Local_Open_FileHandle(self, name, FH_READ_ONLY);
+    if (!fh) {
+        RETHROW(INCREF(Err_get_error()));
+    }
+    int64_t length = FH_Length(fh);
+    FH_Close(fh);
+    DECREF(fh);
+    return length;
+}
+
 String*
 Folder_Get_Path_IMP(Folder *self) {
     return Folder_IVARS(self)->path;
@@ -409,7 +438,7 @@ Folder_Set_Path_IMP(Folder *self, String *path) {
 }
 
 void
-Folder_Consolidate_IMP(Folder *self, String *path) {
+Folder_Consolidate_IMP(Folder *self, String *path, bool binary_metadata) {
     Folder *folder = Folder_Find_Folder(self, path);
     Folder *enclosing_folder = Folder_Enclosing_Folder(self, path);
     if (!folder) {
@@ -419,7 +448,7 @@ Folder_Consolidate_IMP(Folder *self, String *path) {
         THROW(ERR, "Can't consolidate %o twice", path);
     }
     else {
-        CompoundFileWriter *cf_writer = CFWriter_new(folder);
+        CompoundFileWriter *cf_writer = CFWriter_new(folder, binary_metadata);
         CFWriter_Consolidate(cf_writer);
         DECREF(cf_writer);
         if (Str_Get_Size(path)) {
@@ -433,6 +462,51 @@ Folder_Consolidate_IMP(Folder *self, String *path) {
     }
 }
 
+bool
+Folder_Sync_IMP(Folder *self, Vector *paths) {
+    Vector *dirs    = Vec_new(0);
+    bool    success = true;
+
+    for (size_t i = 0, max = Vec_Get_Size(paths); i < max && success; i++) {
+        String *path = (String*)CERTIFY(Vec_Fetch(paths, i), STRING);
+        Folder *enclosing_folder = Folder_Enclosing_Folder(self, path);
+        if (!enclosing_folder) {
+            Err_set_error(Err_new(Str_newf("Can't sync '%o': invalid path",
+                                           path)));
+            success = false;
+            break;
+        }
+        String *name = IxFileNames_local_part(path);
+        success = Folder_Local_Sync(enclosing_folder, name);
+        DECREF(name);
+
+        // Remember the directory unless we've seen it already.
+        bool seen = false;
+        for (size_t j = 0, num_dirs = Vec_Get_Size(dirs); j < num_dirs; j++) {
+            if (Vec_Fetch(dirs, j) == (Obj*)enclosing_folder) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) { Vec_Push(dirs, INCREF(enclosing_folder)); }
+    }
+
+    for (size_t i = 0, max = Vec_Get_Size(dirs); i < max && success; i++) {
+        Folder *dir = (Folder*)Vec_Fetch(dirs, i);
+        success = Folder_Local_Sync(dir, NULL);
+    }
+
+    DECREF(dirs);
+    return success;
+}
+
+bool
+Folder_Local_Sync_IMP(Folder *self, String *name) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(name);
+    return true;
+}
+
 static Folder*
 S_enclosing_folder(Folder *self, StringIterator *path) {
     int32_t code_point;
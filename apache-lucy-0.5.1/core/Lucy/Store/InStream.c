@@ -158,6 +158,15 @@ InStream_Clone_IMP(InStream *self) {
     Class *klass = InStream_get_class(self);
     InStream *twin = (InStream*)Class_Make_Obj(klass);
     InStream_do_open(twin, (Obj*)ivars->file_handle);
+
+    // Preserve the view of a sub-file, e.g. within a compound file.
+    InStreamIVARS *const tvars = InStream_IVARS(twin);
+    String *temp = tvars->filename;
+    tvars->filename = Str_Clone(ivars->filename);
+    DECREF(temp);
+    tvars->offset = ivars->offset;
+    tvars->len    = ivars->len;
+
     InStream_Seek(twin, SI_tell(self));
     return twin;
 }
@@ -288,6 +297,42 @@ InStream_Length_IMP(InStream *self) {
     return InStream_IVARS(self)->len;
 }
 
+// Translate a stream-relative range into an absolute range within the
+// underlying FileHandle, clamped to the stream's bounds.
+static CFISH_INLINE bool
+SI_file_range(InStreamIVARS *ivars, int64_t *offset, int64_t *len) {
+    if (!ivars->file_handle) { return false; }
+    if (*offset < 0) { *offset = 0; }
+    if (*offset > ivars->len) { *offset = ivars->len; }
+    if (*len < 0 || *len > ivars->len - *offset) {
+        *len = ivars->len - *offset;
+    }
+    *offset += ivars->offset;
+    return true;
+}
+
+bool
+InStream_Advise_IMP(InStream *self, int64_t offset, int64_t len,
+                    int32_t advice) {
+    InStreamIVARS *const ivars = InStream_IVARS(self);
+    if (!SI_file_range(ivars, &offset, &len)) { return false; }
+    return FH_Advise(ivars->file_handle, offset, len, advice);
+}
+
+int64_t
+InStream_Touch_IMP(InStream *self, int64_t offset, int64_t len) {
+    InStreamIVARS *const ivars = InStream_IVARS(self);
+    if (!SI_file_range(ivars, &offset, &len)) { return -1; }
+    return FH_Touch(ivars->file_handle, offset, len);
+}
+
+int64_t
+InStream_Resident_Bytes_IMP(InStream *self, int64_t offset, int64_t len) {
+    InStreamIVARS *const ivars = InStream_IVARS(self);
+    if (!SI_file_range(ivars, &offset, &len)) { return -1; }
+    return FH_Resident_Bytes(ivars->file_handle, offset, len);
+}
+
 const char*
 InStream_Buf_IMP(InStream *self, size_t request) {
     InStreamIVARS *const ivars = InStream_IVARS(self);
@@ -52,9 +52,10 @@ OutStream_do_open(OutStream *self, Obj *file) {
     OutStreamIVARS *const ivars = OutStream_IVARS(self);
 
     // Init.
-    ivars->buf         = (char*)MALLOCATE(IO_STREAM_BUF_SIZE);
+    ivars->buf         = (char*)MALLOCATE(OUTSTREAM_BUF_SIZE);
     ivars->buf_start   = 0;
     ivars->buf_pos     = 0;
+    ivars->buf_size    = OUTSTREAM_BUF_SIZE;
 
     // Obtain a FileHandle.
     if (Obj_is_a(file, FILEHANDLE)) {
@@ -106,24 +107,40 @@ OutStream_Get_Path_IMP(OutStream *self) {
     return OutStream_IVARS(self)->path;
 }
 
+void
+OutStream_Set_Buf_Size_IMP(OutStream *self, size_t size) {
+    OutStreamIVARS *const ivars = OutStream_IVARS(self);
+    if (size < IO_STREAM_BUF_SIZE) { size = IO_STREAM_BUF_SIZE; }
+    if (size == ivars->buf_size) { return; }
+    if (ivars->buf_pos) { S_flush(self, ivars); }
+    FREEMEM(ivars->buf);
+    ivars->buf      = (char*)MALLOCATE(size);
+    ivars->buf_size = size;
+}
+
+size_t
+OutStream_Get_Buf_Size_IMP(OutStream *self) {
+    return OutStream_IVARS(self)->buf_size;
+}
+
 void
 OutStream_Absorb_IMP(OutStream *self, InStream *instream) {
     OutStreamIVARS *const ivars = OutStream_IVARS(self);
-    char buf[IO_STREAM_BUF_SIZE];
     int64_t bytes_left = InStream_Length(instream);
+    const size_t chunk_size = ivars->buf_size > OUTSTREAM_BULK_BUF_SIZE
+                              ? ivars->buf_size
+                              : OUTSTREAM_BULK_BUF_SIZE;
 
-    // Read blocks of content into an intermediate buffer, than write them to
-    // the OutStream.
-    //
-    // TODO: optimize by utilizing OutStream's buffer directly, while still
-    // not flushing too frequently and keeping code complexity under control.
+    // Write straight out of the InStream's buffer, in chunks large enough
+    // to bypass our own.
     OutStream_Grow(self, OutStream_Tell(self) + bytes_left);
-    while (bytes_left) {
-        const size_t bytes_this_iter = bytes_left < IO_STREAM_BUF_SIZE
+    while (bytes_left > 0) {
+        const size_t bytes_this_iter = bytes_left < (int64_t)chunk_size
                                        ? (size_t)bytes_left
-                                       : IO_STREAM_BUF_SIZE;
-        InStream_Read_Bytes(instream, buf, bytes_this_iter);
+                                       : chunk_size;
+        const char *buf = InStream_Buf(instream, bytes_this_iter);
         SI_write_bytes(self, ivars, buf, bytes_this_iter);
+        InStream_Advance_Buf(instream, buf + bytes_this_iter);
         bytes_left -= bytes_this_iter;
     }
 }
@@ -182,16 +199,22 @@ OutStream_Write_Bytes_IMP(OutStream *self, const void *bytes, size_t len) {
 static CFISH_INLINE void
 SI_write_bytes(OutStream *self, OutStreamIVARS *ivars,
                const void *bytes, size_t len) {
-    // If this data is larger than the buffer size, flush and write.
-    if (len >= IO_STREAM_BUF_SIZE) {
-        S_flush(self, ivars);
-        if (!FH_Write(ivars->file_handle, bytes, len)) {
+    // If this data is larger than the buffer size, write it along with
+    // whatever is buffered.
+    if (len >= ivars->buf_size) {
+        if (ivars->file_handle == NULL) {
+            THROW(ERR, "Can't write to a closed OutStream for %o",
+                  ivars->path);
+        }
+        if (!FH_Gather_Write(ivars->file_handle, ivars->buf, ivars->buf_pos,
+                             bytes, len)) {
             RETHROW(INCREF(Err_get_error()));
         }
-        ivars->buf_start += len;
+        ivars->buf_start += ivars->buf_pos + len;
+        ivars->buf_pos = 0;
     }
     // If there's not enough room in the buffer, flush then add.
-    else if (ivars->buf_pos + len >= IO_STREAM_BUF_SIZE) {
+    else if (ivars->buf_pos + len >= ivars->buf_size) {
         S_flush(self, ivars);
         memcpy((ivars->buf + ivars->buf_pos), bytes, len);
         ivars->buf_pos += len;
@@ -205,7 +228,7 @@ SI_write_bytes(OutStream *self, OutStreamIVARS *ivars,
 
 static CFISH_INLINE void
 SI_write_u8(OutStream *self, OutStreamIVARS *ivars, uint8_t value) {
-    if (ivars->buf_pos >= IO_STREAM_BUF_SIZE) {
+    if (ivars->buf_pos >= ivars->buf_size) {
         S_flush(self, ivars);
     }
     ivars->buf[ivars->buf_pos++] = (char)value;
@@ -0,0 +1,88 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_RATELIMITER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Store/RateLimiter.h"
+#include "Lucy/Util/Clock.h"
+#include "Lucy/Util/Sleep.h"
+
+#define BYTES_PER_MB 1048576.0
+
+RateLimiter*
+RateLimiter_new(double mb_per_sec) {
+    RateLimiter *self = (RateLimiter*)Class_Make_Obj(RATELIMITER);
+    return RateLimiter_init(self, mb_per_sec);
+}
+
+RateLimiter*
+RateLimiter_init(RateLimiter *self, double mb_per_sec) {
+    RateLimiterIVARS *const ivars = RateLimiter_IVARS(self);
+    ivars->next_usec   = 0;
+    ivars->paused_usec = 0;
+    ivars->total_bytes = 0;
+    RateLimiter_Set_MB_Per_Sec(self, mb_per_sec);
+    return self;
+}
+
+void
+RateLimiter_Set_MB_Per_Sec_IMP(RateLimiter *self, double mb_per_sec) {
+    if (!(mb_per_sec > 0.0)) {
+        THROW(ERR, "mb_per_sec must be positive: %f64", mb_per_sec);
+    }
+    RateLimiter_IVARS(self)->bytes_per_usec
+        = mb_per_sec * BYTES_PER_MB / 1000000.0;
+}
+
+double
+RateLimiter_Get_MB_Per_Sec_IMP(RateLimiter *self) {
+    return RateLimiter_IVARS(self)->bytes_per_usec * 1000000.0 / BYTES_PER_MB;
+}
+
+uint64_t
+RateLimiter_Get_Paused_Millis_IMP(RateLimiter *self) {
+    return RateLimiter_IVARS(self)->paused_usec / 1000;
+}
+
+uint64_t
+RateLimiter_Get_Total_Bytes_IMP(RateLimiter *self) {
+    return RateLimiter_IVARS(self)->total_bytes;
+}
+
+void
+RateLimiter_Pause_IMP(RateLimiter *self, uint64_t bytes) {
+    RateLimiterIVARS *const ivars = RateLimiter_IVARS(self);
+    uint64_t now   = Clock_microseconds();
+    uint64_t delay = (uint64_t)((double)bytes / ivars->bytes_per_usec);
+
+    // Don't let idle time build up credit.  Since every call sleeps off all
+    // but the last millisecond of its delay, a schedule more than a second
+    // ahead of the clock means the clock went backwards; start over.
+    if (ivars->next_usec < now || ivars->next_usec > now + 1000000) {
+        ivars->next_usec = now;
+    }
+    ivars->next_usec   += delay;
+    ivars->total_bytes += bytes;
+
+    uint64_t ahead = ivars->next_usec - now;
+    if (ahead >= 1000) {
+        Sleep_millisleep((uint32_t)(ahead / 1000));
+        ivars->paused_usec += Clock_microseconds() - now;
+    }
+}
+
@@ -27,20 +27,31 @@
 #include "Lucy/Test/Analysis/TestNormalizer.h"
 #include "Lucy/Test/Analysis/TestPolyAnalyzer.h"
 #include "Lucy/Test/Analysis/TestRegexTokenizer.h"
+#include "Lucy/Test/Analysis/TestShingleFilter.h"
 #include "Lucy/Test/Analysis/TestSnowballStemmer.h"
 #include "Lucy/Test/Analysis/TestSnowballStopFilter.h"
 #include "Lucy/Test/Analysis/TestStandardTokenizer.h"
+#include "Lucy/Test/Document/TestDocBuilder.h"
 #include "Lucy/Test/Highlight/TestHeatMap.h"
 #include "Lucy/Test/Highlight/TestHighlighter.h"
+#include "Lucy/Test/Index/TestCommitGroup.h"
+#include "Lucy/Test/Index/TestDeletionsWriter.h"
 #include "Lucy/Test/Index/TestDocWriter.h"
 #include "Lucy/Test/Index/TestHighlightWriter.h"
+#include "Lucy/Test/Index/TestFilePurger.h"
 #include "Lucy/Test/Index/TestIndexManager.h"
+#include "Lucy/Test/Index/TestIndexWarmer.h"
+#include "Lucy/Test/Index/TestMemoryBudget.h"
+#include "Lucy/Test/Index/TestMergePolicy.h"
+#include "Lucy/Test/Index/TestMergeScheduler.h"
 #include "Lucy/Test/Index/TestPolyReader.h"
+#include "Lucy/Test/Index/TestPostingListReader.h"
 #include "Lucy/Test/Index/TestPostingListWriter.h"
 #include "Lucy/Test/Index/TestSegWriter.h"
 #include "Lucy/Test/Index/TestSegment.h"
 #include "Lucy/Test/Index/TestSnapshot.h"
 #include "Lucy/Test/Index/TestSortWriter.h"
+#include "Lucy/Test/Index/TestTermIndex.h"
 #include "Lucy/Test/Index/TestTermInfo.h"
 #include "Lucy/Test/Object/TestBitVector.h"
 #include "Lucy/Test/Object/TestI32Array.h"
@@ -49,6 +60,7 @@
 #include "Lucy/Test/Plan/TestFieldType.h"
 #include "Lucy/Test/Plan/TestFullTextType.h"
 #include "Lucy/Test/Plan/TestNumericType.h"
+#include "Lucy/Test/Search/TestANDMatcher.h"
 #include "Lucy/Test/Search/TestLeafQuery.h"
 #include "Lucy/Test/Search/TestMatchAllQuery.h"
 #include "Lucy/Test/Search/TestNOTQuery.h"
@@ -56,6 +68,7 @@
 #include "Lucy/Test/Search/TestPhraseQuery.h"
 #include "Lucy/Test/Search/TestPolyQuery.h"
 #include "Lucy/Test/Search/TestQueryParserLogic.h"
+#include "Lucy/Test/Search/TestQueryProfile.h"
 #include "Lucy/Test/Search/TestQueryParserSyntax.h"
 #include "Lucy/Test/Search/TestRangeQuery.h"
 #include "Lucy/Test/Search/TestReqOptQuery.h"
@@ -68,6 +81,7 @@
 #include "Lucy/Test/Store/TestFSDirHandle.h"
 #include "Lucy/Test/Store/TestFSFileHandle.h"
 #include "Lucy/Test/Store/TestFSFolder.h"
+#include "Lucy/Test/Store/TestFcntlLock.h"
 #include "Lucy/Test/Store/TestFileHandle.h"
 #include "Lucy/Test/Store/TestFolder.h"
 #include "Lucy/Test/Store/TestIOChunks.h"
@@ -78,10 +92,12 @@
 #include "Lucy/Test/Store/TestRAMFolder.h"
 #include "Lucy/Test/TestSchema.h"
 #include "Lucy/Test/TestSimple.h"
+#include "Lucy/Test/Util/TestBloomFilter.h"
 #include "Lucy/Test/Util/TestFreezer.h"
 #include "Lucy/Test/Util/TestIndexFileNames.h"
 #include "Lucy/Test/Util/TestJson.h"
 #include "Lucy/Test/Util/TestMemoryPool.h"
+#include "Lucy/Test/Util/TestMetaFile.h"
 #include "Lucy/Test/Util/TestNumberUtils.h"
 #include "Lucy/Test/Util/TestPriorityQueue.h"
 #include "Lucy/Test/Util/TestSortExternal.h"
@@ -91,12 +107,14 @@ Test_create_test_suite() {
     TestSuite *suite = TestSuite_new();
 
     TestSuite_Add_Batch(suite, (TestBatch*)TestPriQ_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestBloom_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBitVector_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSortExternal_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestMemPool_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNumUtil_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestIxFileNames_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestJson_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMetaFile_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFreezer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestI32Arr_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRAMFH_new());
@@ -108,6 +126,7 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestRAMDH_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFSDH_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFSFolder_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestFcntlLock_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRAMFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestIxManager_new());
@@ -118,6 +137,7 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestCaseFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRegexTokenizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStop_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestShingleFilter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStemmer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNormalizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestStandardTokenizer_new());
@@ -126,11 +146,21 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestFieldMisc_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBatchSchema_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestDocWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestDocBuilder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHLWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestDelWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestPListReader_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPListWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestTermIx_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSegWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestFilePurger_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSortWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMemBudget_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMergePolicy_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMergeSched_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCommitGroup_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPolyReader_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestIxWarmer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFullTextType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBlobType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNumericType_new());
@@ -151,9 +181,11 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestLeafQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNoMatchQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSeriesMatcher_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestANDMatcher_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestORQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestQPLogic_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestQPSyntax_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestQueryProfile_new());
 
     return suite;
 }
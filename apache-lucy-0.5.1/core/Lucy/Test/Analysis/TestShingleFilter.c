@@ -0,0 +1,110 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTSHINGLEFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Test/Analysis/TestShingleFilter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
+#include "Lucy/Analysis/ShingleFilter.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Analysis/Token.h"
+
+TestShingleFilter*
+TestShingleFilter_new() {
+    return (TestShingleFilter*)Class_Make_Obj(TESTSHINGLEFILTER);
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    ShingleFilter *shingler = ShingleFilter_new();
+    ShingleFilter *other    = ShingleFilter_new();
+    Obj           *dump     = (Obj*)ShingleFilter_Dump(shingler);
+    ShingleFilter *clone    = (ShingleFilter*)ShingleFilter_Load(other, dump);
+
+    TEST_TRUE(runner, ShingleFilter_Equals(shingler, (Obj*)other), "Equals");
+    TEST_FALSE(runner, ShingleFilter_Equals(shingler, (Obj*)CFISH_TRUE),
+               "Not Equals");
+    TEST_TRUE(runner, ShingleFilter_Equals(shingler, (Obj*)clone),
+              "Dump => Load round trip");
+
+    DECREF(shingler);
+    DECREF(other);
+    DECREF(dump);
+    DECREF(clone);
+}
+
+static void
+test_analysis(TestBatchRunner *runner) {
+    Vector *analyzers = Vec_new(2);
+    Vec_Push(analyzers, (Obj*)StandardTokenizer_new());
+    Vec_Push(analyzers, (Obj*)ShingleFilter_new());
+    PolyAnalyzer *analyzer = PolyAnalyzer_new(NULL, analyzers);
+    String *source = Str_newf("Rio de Janeiro");
+    Vector *wanted = Vec_new(2);
+    Vec_Push(wanted, (Obj*)Str_newf("Rio de"));
+    Vec_Push(wanted, (Obj*)Str_newf("de Janeiro"));
+    TestUtils_test_analyzer(runner, (Analyzer*)analyzer, source, wanted,
+                            "join adjacent tokens");
+    DECREF(wanted);
+    DECREF(source);
+    DECREF(analyzer);
+    DECREF(analyzers);
+}
+
+static void
+test_positions(TestBatchRunner *runner) {
+    // Tokens at positions 0, 1, 3 and 4: "b" is followed by a gap.
+    Inversion *inversion = Inversion_new(NULL);
+    Inversion_Append(inversion, Token_new("a", 1, 0, 1, 1.0f, 1));
+    Inversion_Append(inversion, Token_new("b", 1, 2, 3, 1.0f, 2));
+    Inversion_Append(inversion, Token_new("c", 1, 6, 7, 1.0f, 1));
+    Inversion_Append(inversion, Token_new("d", 1, 8, 9, 1.0f, 1));
+
+    ShingleFilter *shingler = ShingleFilter_new();
+    Inversion *shingles = ShingleFilter_Transform(shingler, inversion);
+    Inversion_Invert(shingles);
+
+    TEST_INT_EQ(runner, Inversion_Get_Size(shingles), 2,
+                "No shingle across a position gap");
+    Token *first  = Inversion_Next(shingles);
+    Token *second = Inversion_Next(shingles);
+    TEST_INT_EQ(runner, Token_Get_Pos(second) - Token_Get_Pos(first), 3,
+                "Shingles keep the distance between their first tokens");
+    TEST_TRUE(runner,
+              Token_Get_Start_Offset(second) == 6
+              && Token_Get_End_Offset(second) == 9,
+              "Offsets span both tokens");
+
+    DECREF(shingles);
+    DECREF(shingler);
+    DECREF(inversion);
+}
+
+void
+TestShingleFilter_Run_IMP(TestShingleFilter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 9);
+    test_Dump_Load_and_Equals(runner);
+    test_analysis(runner);
+    test_positions(runner);
+}
+
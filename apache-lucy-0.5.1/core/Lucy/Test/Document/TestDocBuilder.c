@@ -0,0 +1,275 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/Num.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Document/TestDocBuilder.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/DocBuilder.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/Inverter.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestDocBuilder*
+TestDocBuilder_new() {
+    return (TestDocBuilder*)Class_Make_Obj(TESTDOCBUILDER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *full_text_type = FullTextType_new((Analyzer*)tokenizer);
+    StringType *string_type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"),
+                      (FieldType*)full_text_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)string_type);
+    DECREF(string_type);
+    DECREF(full_text_type);
+    DECREF(tokenizer);
+    return schema;
+}
+
+static void
+S_add_unknown_field(void *context) {
+    DocBuilder_Add_Field((DocBuilder*)context, SSTR_WRAP_C("nope"));
+}
+
+static void
+S_set_wrong_type(void *context) {
+    Integer *value = Int_new(42);
+    DocBuilder_Set_Value((DocBuilder*)context, 0, (Obj*)value);
+    DECREF(value);
+}
+
+static void
+S_set_bad_slot(void *context) {
+    DocBuilder_Set_Value((DocBuilder*)context, 99,
+                         (Obj*)SSTR_WRAP_C("foo"));
+}
+
+static void
+S_add_foreign_builder(void *context) {
+    Indexer **indexers = (Indexer**)context;
+    DocBuilder *builder = Indexer_Make_Doc_Builder(indexers[0]);
+    DocBuilder_Add_Field(builder, SSTR_WRAP_C("id"));
+    DocBuilder_Set_Value(builder, 0, (Obj*)SSTR_WRAP_C("foreign"));
+    Indexer_Add_Built_Doc(indexers[1], builder, 1.0f);
+    DECREF(builder);
+}
+
+static void
+test_slots(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    DocBuilder *builder = Indexer_Make_Doc_Builder(indexer);
+
+    uint32_t content_slot = DocBuilder_Add_Field(builder,
+                                                 SSTR_WRAP_C("content"));
+    uint32_t id_slot = DocBuilder_Add_Field(builder, SSTR_WRAP_C("id"));
+    TEST_INT_EQ(runner, content_slot, 0, "First slot");
+    TEST_INT_EQ(runner, id_slot, 1, "Second slot");
+    TEST_INT_EQ(runner, DocBuilder_Add_Field(builder, SSTR_WRAP_C("id")), 1,
+                "Re-adding a field returns its slot");
+    TEST_INT_EQ(runner, DocBuilder_Num_Slots(builder), 2, "Num_Slots");
+    TEST_INT_EQ(runner, DocBuilder_Find_Slot(builder, SSTR_WRAP_C("id")), 1,
+                "Find_Slot");
+    TEST_INT_EQ(runner, DocBuilder_Find_Slot(builder, SSTR_WRAP_C("nope")),
+                -1, "Find_Slot for unregistered field");
+    TEST_TRUE(runner,
+              Str_Equals_Utf8(DocBuilder_Get_Field_Name(builder, id_slot),
+                              "id", 2),
+              "Get_Field_Name");
+    TEST_TRUE(runner, DocBuilder_Get_Field_Num(builder, content_slot) > 0,
+              "Field number assigned on Add_Field");
+
+    Err *error = Err_trap(S_add_unknown_field, builder);
+    TEST_TRUE(runner, error != NULL, "Unknown field throws");
+    DECREF(error);
+    error = Err_trap(S_set_wrong_type, builder);
+    TEST_TRUE(runner, error != NULL, "Value of wrong type throws");
+    DECREF(error);
+    error = Err_trap(S_set_bad_slot, builder);
+    TEST_TRUE(runner, error != NULL, "Out of range slot throws");
+    DECREF(error);
+
+    DocBuilder_Set_Value(builder, id_slot, (Obj*)SSTR_WRAP_C("a"));
+    TEST_TRUE(runner, DocBuilder_Get_Value(builder, id_slot) != NULL,
+              "Set_Value");
+    DocBuilder_Clear(builder);
+    TEST_TRUE(runner, DocBuilder_Get_Value(builder, id_slot) == NULL,
+              "Clear empties slots");
+
+    RAMFolder *other_folder = RAMFolder_new(NULL);
+    Indexer *indexers[2];
+    indexers[0] = indexer;
+    indexers[1] = Indexer_new(schema, (Obj*)other_folder, NULL, 0);
+    error = Err_trap(S_add_foreign_builder, indexers);
+    TEST_TRUE(runner, error != NULL,
+              "Add_Built_Doc rejects another Indexer's builder");
+    DECREF(error);
+
+    DECREF(indexers[1]);
+    DECREF(other_folder);
+    DECREF(builder);
+    DECREF(indexer);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static uint32_t
+S_num_hits(IndexSearcher *searcher, const char *field, const char *term) {
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C(field),
+                                     (Obj*)SSTR_WRAP_C(term));
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t num_hits = Hits_Total_Hits(hits);
+    DECREF(hits);
+    DECREF(query);
+    return num_hits;
+}
+
+static void
+test_indexing(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    DocBuilder *builder = Indexer_Make_Doc_Builder(indexer);
+    uint32_t id_slot = DocBuilder_Add_Field(builder, SSTR_WRAP_C("id"));
+    uint32_t content_slot = DocBuilder_Add_Field(builder,
+                                                 SSTR_WRAP_C("content"));
+
+    static const char *const contents[] = {
+        "red green", "green blue", NULL
+    };
+    for (int i = 0; i < 3; i++) {
+        String *id = Str_newf("built%i32", (int32_t)i);
+        DocBuilder_Clear(builder);
+        DocBuilder_Set_Value(builder, id_slot, (Obj*)id);
+        if (contents[i]) {
+            String *content = Str_new_from_utf8(contents[i],
+                                                strlen(contents[i]));
+            DocBuilder_Set_Value(builder, content_slot, (Obj*)content);
+            DECREF(content);
+        }
+        Indexer_Add_Built_Doc(indexer, builder, 1.0f);
+        DECREF(id);
+    }
+
+    // Built docs and ordinary docs can be mixed.
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("plain"));
+    Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)SSTR_WRAP_C("green"));
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+
+    Indexer_Commit(indexer);
+    DECREF(builder);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TEST_INT_EQ(runner, IxSearcher_Doc_Max(searcher), 4, "All docs added");
+    TEST_INT_EQ(runner, S_num_hits(searcher, "content", "green"), 3,
+                "Built and plain docs share postings");
+    TEST_INT_EQ(runner, S_num_hits(searcher, "content", "red"), 1,
+                "Built doc indexed");
+    TEST_INT_EQ(runner, S_num_hits(searcher, "id", "built2"), 1,
+                "Doc with empty slot indexed");
+
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C("id"),
+                                     (Obj*)SSTR_WRAP_C("built1"));
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    HitDoc *hit = Hits_Next(hits);
+    String *content = hit
+                      ? (String*)HitDoc_Extract(hit, SSTR_WRAP_C("content"))
+                      : NULL;
+    TEST_TRUE(runner,
+              content && Str_Equals_Utf8(content, "green blue", 10),
+              "Built doc's fields are stored");
+    DECREF(content);
+    DECREF(hit);
+    DECREF(hits);
+    DECREF(query);
+
+    query = TermQuery_new(SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("built2"));
+    hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    hit = Hits_Next(hits);
+    content = hit ? (String*)HitDoc_Extract(hit, SSTR_WRAP_C("content"))
+                  : NULL;
+    TEST_TRUE(runner, hit && content == NULL,
+              "Empty slot is left out of the doc");
+    DECREF(content);
+    DECREF(hit);
+    DECREF(hits);
+    DECREF(query);
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_inverter_doc(TestBatchRunner *runner) {
+    Schema     *schema   = S_create_schema();
+    Segment    *segment  = Seg_new(1);
+    DocBuilder *builder  = DocBuilder_new(schema, segment);
+    Inverter   *inverter = Inverter_new(schema, segment);
+    uint32_t id_slot = DocBuilder_Add_Field(builder, SSTR_WRAP_C("id"));
+    DocBuilder_Add_Field(builder, SSTR_WRAP_C("content"));
+    DocBuilder_Set_Value(builder, id_slot, (Obj*)SSTR_WRAP_C("built"));
+
+    Inverter_Invert_Built(inverter, builder);
+    Doc *doc = Inverter_Get_Doc(inverter);
+    String *id = doc ? (String*)Doc_Extract(doc, SSTR_WRAP_C("id")) : NULL;
+    Obj *content = doc ? Doc_Extract(doc, SSTR_WRAP_C("content")) : NULL;
+    TEST_TRUE(runner,
+              id && Str_Equals_Utf8(id, "built", 5) && content == NULL,
+              "Inverter_Get_Doc after Invert_Built holds the builder's values");
+    DECREF(content);
+    DECREF(id);
+    Inverter_Clear(inverter);
+    TEST_TRUE(runner, Inverter_Get_Doc(inverter) == NULL,
+              "Inverter_Get_Doc is NULL after Clear");
+
+    DECREF(inverter);
+    DECREF(builder);
+    DECREF(segment);
+    DECREF(schema);
+}
+
+void
+TestDocBuilder_Run_IMP(TestDocBuilder *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_slots(runner);
+    test_indexing(runner);
+    test_inverter_doc(runner);
+}
+
+
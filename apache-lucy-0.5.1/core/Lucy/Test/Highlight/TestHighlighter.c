@@ -320,6 +320,69 @@ test_Create_Excerpt(TestBatchRunner *runner, Searcher *searcher, Obj *query,
     DECREF(query);
 }
 
+struct create_excerpts_context {
+    Highlighter *highlighter;
+    Vector      *hit_docs;
+};
+
+static void
+S_create_excerpts(void *context) {
+    struct create_excerpts_context *args
+        = (struct create_excerpts_context*)context;
+    Vector *excerpts
+        = Highlighter_Create_Excerpts(args->highlighter, args->hit_docs);
+    DECREF(excerpts);
+}
+
+static void
+test_Create_Excerpts(TestBatchRunner *runner, Searcher *searcher,
+                     Obj *query) {
+    String *content = SSTR_WRAP_C("content");
+    Highlighter *highlighter = Highlighter_new(searcher, query, content, 200);
+    Hits *hits = Searcher_Hits(searcher, query, 0, 10, NULL);
+    Vector *hit_docs = Vec_new(0);
+    HitDoc *hit;
+    while (NULL != (hit = Hits_Next(hits))) {
+        Vec_Push(hit_docs, (Obj*)hit);
+    }
+    // A doc without the field, placed last to check alignment.
+    Vec_Push(hit_docs, (Obj*)HitDoc_new(NULL, 0, 0.0f));
+
+    Vector *excerpts = Highlighter_Create_Excerpts(highlighter, hit_docs);
+    size_t num_docs = Vec_Get_Size(hit_docs);
+    TEST_INT_EQ(runner, Vec_Get_Size(excerpts), num_docs,
+                "Create_Excerpts returns one entry per HitDoc");
+    bool all_match = true;
+    for (size_t i = 0; i < num_docs - 1; i++) {
+        hit = (HitDoc*)Vec_Fetch(hit_docs, i);
+        String *expected = Highlighter_Create_Excerpt(highlighter, hit);
+        Obj *got = Vec_Fetch(excerpts, i);
+        if (!expected || !got || !Str_Equals(expected, got)) {
+            all_match = false;
+        }
+        DECREF(expected);
+    }
+    TEST_TRUE(runner, num_docs > 2 && all_match,
+              "Create_Excerpts matches Create_Excerpt in rank order");
+    TEST_TRUE(runner, Vec_Fetch(excerpts, num_docs - 1) == NULL,
+              "Create_Excerpts leaves NULL for a doc without the field");
+
+    // Anything other than a HitDoc is rejected, after earlier docs have
+    // already been queued.
+    Vec_Push(hit_docs, (Obj*)Str_newf("not a HitDoc"));
+    struct create_excerpts_context context;
+    context.highlighter = highlighter;
+    context.hit_docs    = hit_docs;
+    Err *error = Err_trap(S_create_excerpts, &context);
+    TEST_TRUE(runner, error != NULL, "Create_Excerpts rejects non-HitDocs");
+    DECREF(error);
+
+    DECREF(excerpts);
+    DECREF(hit_docs);
+    DECREF(hits);
+    DECREF(highlighter);
+}
+
 static void
 test_highlighting(TestBatchRunner *runner) {
     Schema *schema = Schema_new();
@@ -370,6 +433,7 @@ test_highlighting(TestBatchRunner *runner) {
     test_Raw_Excerpt(runner, searcher, query);
     test_Highlight_Excerpt(runner, searcher, query);
     test_Create_Excerpt(runner, searcher, query, hits);
+    test_Create_Excerpts(runner, searcher, query);
 
     DECREF(hits);
     DECREF(searcher);
@@ -436,7 +500,7 @@ test_hl_selection(TestBatchRunner *runner) {
 
 void
 TestHighlighter_Run_IMP(TestHighlighter *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 23);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 27);
     test_highlighting(runner);
     test_hl_selection(runner);
 }
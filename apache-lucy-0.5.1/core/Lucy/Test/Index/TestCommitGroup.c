@@ -0,0 +1,332 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "charmony.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestCommitGroup.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/CommitGroup.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define TEST_DIR "_commitgroup"
+
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+  #include <pthread.h>
+  #define HAS_PTHREADS
+#endif
+
+#define NUM_PRODUCERS      4
+#define DOCS_PER_PRODUCER  150
+
+TestCommitGroup*
+TestCommitGroup_new() {
+    return (TestCommitGroup*)Class_Make_Obj(TESTCOMMITGROUP);
+}
+
+static void
+S_zap_test_dir() {
+    FSFolder *cwd = FSFolder_new(SSTR_WRAP_C("."));
+    FSFolder_Delete_Tree(cwd, SSTR_WRAP_C(TEST_DIR));
+    DECREF(cwd);
+}
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+    DECREF(type);
+    DECREF(tokenizer);
+    return schema;
+}
+
+static Doc*
+S_make_doc(const char *content) {
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)SSTR_WRAP_C(content));
+    return doc;
+}
+
+static uint32_t
+S_doc_count(Obj *index) {
+    PolyReader *reader = PolyReader_open(index, NULL, NULL);
+    uint32_t doc_count = (uint32_t)PolyReader_Doc_Count(reader);
+    DECREF(reader);
+    return doc_count;
+}
+
+static void
+test_sync_commits(TestBatchRunner *runner) {
+    S_zap_test_dir();
+    Schema       *schema  = S_create_schema();
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    TEST_FALSE(runner, IxManager_Get_Sync_Commits(manager),
+               "Commits aren't synced by default");
+    IxManager_Set_Sync_Commits(manager, true);
+    TEST_TRUE(runner, IxManager_Get_Sync_Commits(manager),
+              "Set_Sync_Commits");
+
+    for (int i = 0; i < 2; i++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)SSTR_WRAP_C(TEST_DIR),
+                                       manager, Indexer_CREATE);
+        Doc *doc = S_make_doc("synced");
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        Indexer_Commit(indexer);
+        DECREF(doc);
+        DECREF(indexer);
+    }
+    TEST_INT_EQ(runner, S_doc_count((Obj*)SSTR_WRAP_C(TEST_DIR)), 2,
+                "Synced commits are readable");
+    TEST_TRUE(runner, IxManager_Get_Last_Commit_Micros(manager) > 0,
+              "Commit latency reported");
+    TEST_TRUE(runner,
+              IxManager_Get_Last_Commit_Micros(manager)
+              >= IxManager_Get_Last_Sync_Micros(manager),
+              "Sync time is part of commit latency");
+
+    IxManager_Set_Sync_Commits(manager, false);
+    Indexer *indexer = Indexer_new(schema, (Obj*)SSTR_WRAP_C(TEST_DIR),
+                                   manager, 0);
+    Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("content"),
+                           (Obj*)SSTR_WRAP_C("synced"));
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    TEST_TRUE(runner, IxManager_Get_Last_Sync_Micros(manager) == 0,
+              "No sync time without Sync_Commits");
+
+    DECREF(manager);
+    DECREF(schema);
+    S_zap_test_dir();
+}
+
+static void
+S_add_bad_doc(void *context) {
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("nope"), (Obj*)SSTR_WRAP_C("bad"));
+    CommitGroup_Add_Doc((CommitGroup*)context, doc, 1.0f);
+    DECREF(doc);
+}
+
+static void
+S_commit(void *context) {
+    CommitGroup_Commit((CommitGroup*)context);
+}
+
+static void
+test_commit_group(TestBatchRunner *runner) {
+    Schema      *schema = S_create_schema();
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    CommitGroup *group  = CommitGroup_new(schema, (Obj*)folder, NULL,
+                                          Indexer_CREATE);
+
+    CommitGroup_Commit(group);
+    TEST_INT_EQ(runner, CommitGroup_Get_Commit_Count(group), 0,
+                "Nothing to commit");
+
+    for (int i = 0; i < 3; i++) {
+        Doc *doc = S_make_doc("grouped");
+        CommitGroup_Add_Doc(group, doc, 1.0f);
+        DECREF(doc);
+    }
+    CommitGroup_Commit(group);
+    CommitGroup_Commit(group);
+    TEST_INT_EQ(runner, CommitGroup_Get_Commit_Count(group), 1,
+                "Changes already committed aren't committed again");
+    TEST_INT_EQ(runner, CommitGroup_Get_Request_Count(group), 3,
+                "Get_Request_Count");
+    TEST_INT_EQ(runner, S_doc_count((Obj*)folder), 3, "Docs committed");
+
+    Doc *doc = S_make_doc("discarded");
+    CommitGroup_Add_Doc(group, doc, 1.0f);
+    DECREF(doc);
+    Err *error = Err_trap(S_add_bad_doc, group);
+    TEST_TRUE(runner, error != NULL, "Errors propagate to the caller");
+    DECREF(error);
+    error = Err_trap(S_commit, group);
+    TEST_TRUE(runner, error != NULL,
+              "Commit reports changes discarded by a failed change");
+    DECREF(error);
+    error = Err_trap(S_commit, group);
+    TEST_TRUE(runner, error == NULL, "Failure reported only once");
+    DECREF(error);
+
+    doc = S_make_doc("more");
+    CommitGroup_Add_Doc(group, doc, 1.0f);
+    CommitGroup_Delete_By_Term(group, SSTR_WRAP_C("content"),
+                               (Obj*)SSTR_WRAP_C("grouped"));
+    CommitGroup_Commit(group);
+    DECREF(doc);
+    TEST_INT_EQ(runner, CommitGroup_Get_Commit_Count(group), 2,
+                "Group usable after an error");
+    TEST_INT_EQ(runner, S_doc_count((Obj*)folder), 1,
+                "Additions and deletions committed together");
+
+    DECREF(group);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+#ifdef HAS_PTHREADS
+
+typedef struct {
+    CommitGroup *group;
+    int32_t      producer;
+    bool         failed;
+} ProducerContext;
+
+static void
+S_produce(void *context) {
+    ProducerContext *args = (ProducerContext*)context;
+    for (int32_t i = 0; i < DOCS_PER_PRODUCER; i++) {
+        Doc    *doc     = Doc_new(NULL, 0);
+        String *id      = Str_newf("p%i32-%i32", args->producer, i);
+        String *content = Str_newf("producer%i32 shared", args->producer);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)content);
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        CommitGroup_Add_Doc(args->group, doc, 1.0f);
+        DECREF(content);
+        DECREF(id);
+        DECREF(doc);
+        if (i % 25 == 24) { CommitGroup_Commit(args->group); }
+    }
+    CommitGroup_Commit(args->group);
+}
+
+static void*
+S_producer_thread(void *context) {
+    ProducerContext *args = (ProducerContext*)context;
+    Err *error = Err_trap(S_produce, args);
+    if (error) {
+        args->failed = true;
+        DECREF(error);
+    }
+    return NULL;
+}
+
+static void
+test_concurrent_producers(TestBatchRunner *runner) {
+    Schema     *schema  = S_create_schema();
+    StringType *id_type = StringType_new();
+    StringType_Set_Sortable(id_type, true);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)id_type);
+    DECREF(id_type);
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    CommitGroup *group  = CommitGroup_new(schema, (Obj*)folder, NULL,
+                                          Indexer_CREATE);
+
+    pthread_t       threads[NUM_PRODUCERS];
+    ProducerContext contexts[NUM_PRODUCERS];
+    for (int32_t i = 0; i < NUM_PRODUCERS; i++) {
+        contexts[i].group    = group;
+        contexts[i].producer = i;
+        contexts[i].failed   = false;
+        if (pthread_create(&threads[i], NULL, S_producer_thread,
+                           &contexts[i]) != 0) {
+            THROW(ERR, "pthread_create failed");
+        }
+    }
+    bool failed = false;
+    for (int32_t i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        if (contexts[i].failed) { failed = true; }
+    }
+
+    TEST_FALSE(runner, failed, "No producer failed");
+    TEST_INT_EQ(runner, S_doc_count((Obj*)folder),
+                NUM_PRODUCERS * DOCS_PER_PRODUCER,
+                "Every producer's docs committed");
+    uint32_t commits  = CommitGroup_Get_Commit_Count(group);
+    uint32_t requests = CommitGroup_Get_Request_Count(group);
+    TEST_TRUE(runner, commits >= 1 && commits <= requests,
+              "Commits shared among %u32 requests: %u32", requests,
+              commits);
+
+    DECREF(group);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void*
+S_bad_doc_thread(void *context) {
+    Err *error = Err_trap(S_add_bad_doc, context);
+    DECREF(error);
+    error = Err_trap(S_commit, context);
+    bool *failed = (bool*)MALLOCATE(sizeof(bool));
+    *failed = error != NULL;
+    DECREF(error);
+    return failed;
+}
+
+static void
+test_failure_reaches_owner(TestBatchRunner *runner) {
+    Schema      *schema = S_create_schema();
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    CommitGroup *group  = CommitGroup_new(schema, (Obj*)folder, NULL,
+                                          Indexer_CREATE);
+
+    Doc *doc = S_make_doc("discarded");
+    CommitGroup_Add_Doc(group, doc, 1.0f);
+    DECREF(doc);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, S_bad_doc_thread, group) != 0) {
+        THROW(ERR, "pthread_create failed");
+    }
+    void *result = NULL;
+    pthread_join(thread, &result);
+    bool *other_failed = (bool*)result;
+    TEST_FALSE(runner, *other_failed,
+               "Failed change has no pending changes to report");
+    FREEMEM(other_failed);
+
+    Err *error = Err_trap(S_commit, group);
+    TEST_TRUE(runner, error != NULL,
+              "Another thread's failure is reported to the changes' owner");
+    DECREF(error);
+
+    DECREF(group);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+#endif /* HAS_PTHREADS */
+
+void
+TestCommitGroup_Run_IMP(TestCommitGroup *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 20);
+    test_sync_commits(runner);
+    test_commit_group(runner);
+#ifdef HAS_PTHREADS
+    test_concurrent_producers(runner);
+    test_failure_reaches_owner(runner);
+#else
+    SKIP(runner, 5, "No pthreads");
+#endif
+}
+
@@ -0,0 +1,415 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTDELETIONSWRITER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestDeletionsWriter.h"
+#include "Lucy/Index/DeletionsWriter.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/DeletionsReader.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Clownfish/CharBuf.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/Matcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 100
+
+TestDeletionsWriter*
+TestDelWriter_new() {
+    return (TestDeletionsWriter*)Class_Make_Obj(TESTDELETIONSWRITER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+    StringType *type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("version"), (FieldType*)type);
+    DECREF(type);
+    return schema;
+}
+
+static void
+S_delete(RAMFolder *folder, const int *ids, int num_ids) {
+    Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+    for (int i = 0; i < num_ids; i++) {
+        String *id = Str_newf("%i32", (int32_t)ids[i]);
+        Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"), (Obj*)id);
+        DECREF(id);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+}
+
+// Return the latest deletions metadata for the first segment.
+static Hash*
+S_fetch_entry(RAMFolder *folder) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader *seg_reader
+        = (SegReader*)Vec_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    Vector *segments = SegReader_Get_Segments(seg_reader);
+    Hash *entry = DefDelReader_find_files_data(segments,
+                                               SSTR_WRAP_C("seg_1"));
+    Hash *retval = entry ? (Hash*)INCREF(entry) : NULL;
+    DECREF(reader);
+    return retval;
+}
+
+// Check that exactly the docs in `ids` are reported as deleted.
+static bool
+S_deleted_docs_are(RAMFolder *folder, const int *ids, int num_ids) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    DeletionsReader *del_reader
+        = (DeletionsReader*)PolyReader_Obtain(
+              reader, Class_Get_Name(DELETIONSREADER));
+    Matcher *deletions = DelReader_Iterator(del_reader);
+    bool     retval    = DelReader_Del_Count(del_reader) == num_ids
+                         && PolyReader_Doc_Count(reader) == NUM_DOCS - num_ids;
+    for (int i = 0; i < num_ids; i++) {
+        if (!deletions || Matcher_Next(deletions) != ids[i]) {
+            retval = false;
+        }
+    }
+    if (deletions && Matcher_Next(deletions) != 0) { retval = false; }
+    DECREF(deletions);
+    DECREF(reader);
+    return retval;
+}
+
+static Doc*
+S_make_doc(int32_t id, const char *version) {
+    Doc *doc = Doc_new(NULL, 0);
+    String *id_str = Str_newf("%i32", id);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id_str);
+    Doc_Store(doc, SSTR_WRAP_C("version"), (Obj*)SSTR_WRAP_C(version));
+    DECREF(id_str);
+    return doc;
+}
+
+static RAMFolder*
+S_create_index(Schema *schema) {
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 1; i <= NUM_DOCS; i++) {
+        Doc *doc = S_make_doc(i, "1");
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    return folder;
+}
+
+static void
+test_sparse_deletions(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = S_create_index(schema);
+
+    static const int ids[] = { 5, 7, 9, 11 };
+    S_delete(folder, ids, 1);
+    Hash *entry = S_fetch_entry(folder);
+    Vector *deltas = (Vector*)Hash_Fetch_Utf8(entry, "deltas", 6);
+    TEST_TRUE(runner, deltas && Vec_Get_Size(deltas) == 1,
+              "Deleting one doc writes a delta");
+    TEST_TRUE(runner, Hash_Fetch_Utf8(entry, "filename", 8) == NULL,
+              "... and no BitVector");
+    TEST_TRUE(runner, S_deleted_docs_are(folder, ids, 1),
+              "Delta is read back");
+    DECREF(entry);
+
+    S_delete(folder, ids + 1, 1);
+    entry = S_fetch_entry(folder);
+    deltas = (Vector*)Hash_Fetch_Utf8(entry, "deltas", 6);
+    TEST_TRUE(runner, deltas && Vec_Get_Size(deltas) == 2,
+              "A second commit extends the chain of deltas");
+    TEST_TRUE(runner, S_deleted_docs_are(folder, ids, 2),
+              "Deltas are overlaid");
+    DECREF(entry);
+
+    S_delete(folder, ids + 2, 2);
+    entry = S_fetch_entry(folder);
+    String *filename = (String*)Hash_Fetch_Utf8(entry, "filename", 8);
+    TEST_TRUE(runner, Hash_Fetch_Utf8(entry, "deltas", 6) == NULL,
+              "Deltas are compacted once they grow large");
+    TEST_TRUE(runner,
+              filename
+              && Str_Starts_With_Utf8(filename, "seg_1/", 6)
+              && Str_Ends_With_Utf8(filename, ".bv", 3),
+              "... into a BitVector in the segment's directory");
+    TEST_TRUE(runner, S_deleted_docs_are(folder, ids, 4),
+              "Compacted deletions are read back");
+    DECREF(entry);
+
+    DECREF(folder);
+    DECREF(schema);
+}
+
+// Check that the deletions files in the first segment's directory are
+// exactly those named by its latest deletions entry.
+static bool
+S_only_live_deletions_files(RAMFolder *folder) {
+    Hash *entry    = S_fetch_entry(folder);
+    Hash *expected = Hash_new(0);
+    if (entry) {
+        Obj    *filename = Hash_Fetch_Utf8(entry, "filename", 8);
+        Vector *deltas   = (Vector*)Hash_Fetch_Utf8(entry, "deltas", 6);
+        if (filename) {
+            Hash_Store(expected, (String*)filename, (Obj*)CFISH_TRUE);
+        }
+        for (uint32_t i = 0; deltas && i < Vec_Get_Size(deltas); i++) {
+            Hash_Store(expected, (String*)Vec_Fetch(deltas, i),
+                       (Obj*)CFISH_TRUE);
+        }
+    }
+
+    Vector  *names  = RAMFolder_List(folder, SSTR_WRAP_C("seg_1"));
+    bool     retval = entry != NULL;
+    uint32_t found  = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(names); i < max; i++) {
+        String *name = (String*)Vec_Fetch(names, i);
+        if (!Str_Starts_With_Utf8(name, "deletions-", 10)) { continue; }
+        String *path = Str_newf("seg_1/%o", name);
+        if (Hash_Fetch(expected, path)) { found++; }
+        else                            { retval = false; }
+        DECREF(path);
+    }
+    if (found != Hash_Get_Size(expected)) { retval = false; }
+
+    DECREF(names);
+    DECREF(expected);
+    DECREF(entry);
+    return retval;
+}
+
+static void
+test_stale_files_purged(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = S_create_index(schema);
+
+    // Keep the merge policy from folding the first segment away.
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    TieredMergePolicy *policy = TieredMP_new();
+    TieredMP_Set_Deletes_Pct_Allowed(policy, 100.0);
+    IxManager_Set_Merge_Policy(manager, (MergePolicy*)policy);
+
+    // Leave a file behind as a failed session would.
+    String *orphan = SSTR_WRAP_C("seg_1/deletions-seg_z.dd");
+    OutStream *outstream = RAMFolder_Open_Out(folder, orphan);
+    OutStream_Write_C32(outstream, 0);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    // Cycle through several deltas and compactions.
+    bool only_live = true;
+    for (int32_t i = 1; i <= 10; i++) {
+        Indexer *indexer = Indexer_new(NULL, (Obj*)folder, manager, 0);
+        String  *id      = Str_newf("%i32", i * 3);
+        Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"), (Obj*)id);
+        Indexer_Commit(indexer);
+        DECREF(id);
+        DECREF(indexer);
+        if (!S_only_live_deletions_files(folder)) { only_live = false; }
+    }
+
+    TEST_TRUE(runner, only_live,
+              "Superseded deletions files are purged after each commit");
+    String *first_delta = SSTR_WRAP_C("seg_1/deletions-seg_2.dd");
+    TEST_FALSE(runner, RAMFolder_Exists(folder, first_delta),
+               "First delta is gone");
+    TEST_FALSE(runner, RAMFolder_Exists(folder, orphan),
+               "Orphaned deletions file is gone");
+
+    DECREF(policy);
+    DECREF(manager);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_own_file_purged(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+
+    // Replacing a doc within the session which added it leaves the new
+    // segment with deletions of its own.
+    for (int32_t i = 1; i <= NUM_DOCS; i++) {
+        Doc *doc = S_make_doc(i, "1");
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Doc *doc = S_make_doc(1, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("1"),
+                       doc, 1.0f);
+    DECREF(doc);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    String *own_file = SSTR_WRAP_C("seg_1/deletions-seg_1.bv");
+    TEST_TRUE(runner, RAMFolder_Exists(folder, own_file),
+              "Segment records its own deletions");
+
+    // Enough deletions to compact them into a new BitVector.
+    static const int ids[] = {
+        2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16
+    };
+    S_delete(folder, ids, (int)(sizeof(ids) / sizeof(ids[0])));
+    TEST_FALSE(runner, RAMFolder_Exists(folder, own_file),
+               "Segment's own deletions file purged once superseded");
+    TEST_TRUE(runner, S_only_live_deletions_files(folder),
+              "Only the compacted deletions remain");
+
+    DECREF(folder);
+    DECREF(schema);
+}
+
+// Return the versions of the docs with the given id, joined by commas.
+static String*
+S_versions(Searcher *searcher, const char *id) {
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C("id"),
+                                     (Obj*)SSTR_WRAP_C(id));
+    Hits *hits = Searcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    CharBuf *buf = CB_new(0);
+    HitDoc *hit_doc;
+    while (NULL != (hit_doc = Hits_Next(hits))) {
+        Obj *version = HitDoc_Extract(hit_doc, SSTR_WRAP_C("version"));
+        if (CB_Get_Size(buf)) { CB_Cat_Trusted_Utf8(buf, ",", 1); }
+        CB_Cat(buf, (String*)version);
+        DECREF(version);
+        DECREF(hit_doc);
+    }
+    String *retval = CB_Yield_String(buf);
+    DECREF(buf);
+    DECREF(hits);
+    DECREF(query);
+    return retval;
+}
+
+static void
+S_update_with_bad_key(void *context) {
+    Doc     *doc = S_make_doc(9, "2");
+    Integer *key = Int_new(9);
+    Indexer_Update_Doc((Indexer*)context, SSTR_WRAP_C("id"), (Obj*)key, doc,
+                       1.0f);
+    DECREF(key);
+    DECREF(doc);
+}
+
+static void
+test_Update_Doc(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_schema();
+    RAMFolder *folder  = S_create_index(schema);
+    Indexer   *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+
+    Doc *doc = S_make_doc(3, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("3"),
+                       doc, 1.0f);
+    DECREF(doc);
+    doc = S_make_doc(5, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("5"),
+                       doc, 1.0f);
+    DECREF(doc);
+    doc = S_make_doc(5, "3");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("5"),
+                       doc, 1.0f);
+    DECREF(doc);
+    doc = S_make_doc(7, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("7"),
+                       doc, 1.0f);
+    DECREF(doc);
+    Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"),
+                           (Obj*)SSTR_WRAP_C("7"));
+    doc = S_make_doc(NUM_DOCS + 1, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"),
+                       (Obj*)SSTR_WRAP_C("101"), doc, 1.0f);
+    DECREF(doc);
+    doc = S_make_doc(NUM_DOCS + 2, "1");
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+    doc = S_make_doc(NUM_DOCS + 2, "2");
+    Indexer_Update_Doc(indexer, SSTR_WRAP_C("id"),
+                       (Obj*)SSTR_WRAP_C("102"), doc, 1.0f);
+    DECREF(doc);
+    Err *error = Err_trap(S_update_with_bad_key, indexer);
+    TEST_TRUE(runner, error != NULL, "Update_Doc rejects a non-String key");
+    DECREF(error);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    Searcher *searcher = (Searcher*)IxSearcher_new((Obj*)folder);
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C("version"),
+                                     (Obj*)SSTR_WRAP_C("1"));
+    Hits *hits = Searcher_Hits(searcher, (Obj*)query, 0, 0, NULL);
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), NUM_DOCS - 3,
+                "Update_Doc deletes the replaced docs");
+    DECREF(hits);
+    DECREF(query);
+    String *versions = S_versions(searcher, "3");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "2", 1),
+              "Update_Doc replaces a doc");
+    DECREF(versions);
+    versions = S_versions(searcher, "5");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "3", 1),
+              "A later update in the same session wins");
+    DECREF(versions);
+    versions = S_versions(searcher, "7");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "", 0),
+              "Delete_By_Term drops a pending update");
+    DECREF(versions);
+    versions = S_versions(searcher, "9");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "1", 1),
+              "A rejected update adds nothing");
+    DECREF(versions);
+    versions = S_versions(searcher, "101");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "2", 1),
+              "Update_Doc adds a doc with a new term");
+    DECREF(versions);
+    versions = S_versions(searcher, "102");
+    TEST_TRUE(runner, Str_Equals_Utf8(versions, "2", 1),
+              "Update_Doc replaces a doc added earlier in the session");
+    DECREF(versions);
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestDelWriter_Run_IMP(TestDeletionsWriter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_sparse_deletions(runner);
+    test_stale_files_purged(runner);
+    test_own_file_purged(runner);
+    test_Update_Doc(runner);
+}
+
@@ -0,0 +1,182 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTFILEPURGER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestFilePurger.h"
+#include "Lucy/Index/FilePurger.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Json.h"
+
+TestFilePurger*
+TestFilePurger_new() {
+    return (TestFilePurger*)Class_Make_Obj(TESTFILEPURGER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+    StringType *type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)type);
+    DECREF(type);
+    return schema;
+}
+
+static void
+S_add_doc(RAMFolder *folder, int32_t id, bool optimize) {
+    Schema  *schema  = S_create_schema();
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    Doc     *doc     = Doc_new(NULL, 0);
+    String  *value   = Str_newf("%i32", id);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)value);
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    if (optimize) { Indexer_Optimize(indexer); }
+    Indexer_Commit(indexer);
+    DECREF(value);
+    DECREF(doc);
+    DECREF(indexer);
+    DECREF(schema);
+}
+
+// Return the snapshots recorded in the reference table, or NULL.
+static Hash*
+S_fetch_refs(RAMFolder *folder) {
+    Hash *dump = (Hash*)Json_slurp_json((Folder*)folder,
+                                        SSTR_WRAP_C("refcounts.json"));
+    if (!dump) {
+        Err_set_error(NULL);
+        return NULL;
+    }
+    Hash *snapshots = (Hash*)Hash_Fetch_Utf8(dump, "snapshots", 9);
+    Hash *retval = snapshots ? (Hash*)INCREF(snapshots) : NULL;
+    DECREF(dump);
+    return retval;
+}
+
+static void
+test_incremental_purge(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    S_add_doc(folder, 1, false);
+    Hash *refs = S_fetch_refs(folder);
+    TEST_TRUE(runner, refs != NULL, "Commit writes reference table");
+    TEST_INT_EQ(runner, refs ? Hash_Get_Size(refs) : 0, 1,
+                "Table records current snapshot");
+    DECREF(refs);
+
+    // Hold a read lock on the first snapshot while seg_1 gets merged away.
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, manager);
+    S_add_doc(folder, 2, true);
+    TEST_TRUE(runner, RAMFolder_Exists(folder, SSTR_WRAP_C("seg_1")),
+              "Segment of locked snapshot spared");
+    TEST_TRUE(runner,
+              RAMFolder_Exists(folder, SSTR_WRAP_C("snapshot_1.json")),
+              "Locked snapshot file spared");
+    refs = S_fetch_refs(folder);
+    TEST_INT_EQ(runner, refs ? Hash_Get_Size(refs) : 0, 2,
+                "Table keeps locked snapshot");
+    DECREF(refs);
+
+    DECREF(reader);
+    S_add_doc(folder, 3, false);
+    TEST_FALSE(runner, RAMFolder_Exists(folder, SSTR_WRAP_C("seg_1")),
+               "Segment purged once lock released");
+    TEST_FALSE(runner,
+               RAMFolder_Exists(folder, SSTR_WRAP_C("snapshot_1.json")),
+               "Snapshot file purged once lock released");
+    refs = S_fetch_refs(folder);
+    TEST_INT_EQ(runner, refs ? Hash_Get_Size(refs) : 0, 1,
+                "Table drops released snapshot");
+    DECREF(refs);
+
+    PolyReader *latest = PolyReader_open((Obj*)folder, NULL, NULL);
+    TEST_INT_EQ(runner, PolyReader_Doc_Max(latest), 3, "All docs survive");
+    DECREF(latest);
+
+    DECREF(manager);
+    DECREF(folder);
+}
+
+static void
+test_rebuild(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    // A table which lags behind the index forces a full scan.
+    S_add_doc(folder, 1, false);
+    Hash *stale = S_fetch_refs(folder);
+    S_add_doc(folder, 2, false);
+    S_add_doc(folder, 3, true);
+    Hash *dump = Hash_new(0);
+    Hash_Store_Utf8(dump, "format", 6, (Obj*)Str_newf("1"));
+    Hash_Store_Utf8(dump, "current", 7, (Obj*)Str_newf("snapshot_1.json"));
+    Hash_Store_Utf8(dump, "snapshots", 9, (Obj*)stale);
+    RAMFolder_Delete(folder, SSTR_WRAP_C("refcounts.json"));
+    Json_spew_json((Obj*)dump, (Folder*)folder,
+                   SSTR_WRAP_C("refcounts.json"));
+    DECREF(dump);
+    S_add_doc(folder, 4, false);
+    Hash *refs = S_fetch_refs(folder);
+    TEST_INT_EQ(runner, refs ? Hash_Get_Size(refs) : 0, 1,
+                "Stale table rebuilt");
+    DECREF(refs);
+
+    // So does a missing or garbled one.
+    RAMFolder_Delete(folder, SSTR_WRAP_C("refcounts.json"));
+    S_add_doc(folder, 5, false);
+    TEST_TRUE(runner,
+              RAMFolder_Exists(folder, SSTR_WRAP_C("refcounts.json")),
+              "Missing table rebuilt");
+    RAMFolder_Delete(folder, SSTR_WRAP_C("refcounts.json"));
+    Json_spew_json((Obj*)SSTR_WRAP_C("garbage"), (Folder*)folder,
+                   SSTR_WRAP_C("refcounts.json"));
+    S_add_doc(folder, 6, true);
+    refs = S_fetch_refs(folder);
+    TEST_INT_EQ(runner, refs ? Hash_Get_Size(refs) : 0, 1,
+                "Garbled table rebuilt");
+    DECREF(refs);
+
+    Vector *entries = RAMFolder_List(folder, NULL);
+    uint32_t num_segs = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(entries); i < max; i++) {
+        String *entry = (String*)Vec_Fetch(entries, i);
+        if (Str_Starts_With_Utf8(entry, "seg_", 4)) { num_segs++; }
+    }
+    TEST_INT_EQ(runner, num_segs, 1, "Obsolete segments purged");
+    DECREF(entries);
+
+    DECREF(folder);
+}
+
+void
+TestFilePurger_Run_IMP(TestFilePurger *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 13);
+    test_incremental_purge(runner);
+    test_rebuild(runner);
+}
+
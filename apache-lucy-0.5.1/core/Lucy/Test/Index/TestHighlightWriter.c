@@ -23,15 +23,126 @@
 #include "Lucy/Test/Index/TestHighlightWriter.h"
 #include "Lucy/Index/HighlightWriter.h"
 
+#include "Clownfish/Blob.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/DocVector.h"
+#include "Lucy/Index/HighlightReader.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/TermVector.h"
+#include "Lucy/Object/I32Array.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/RAMFolder.h"
+
 TestHighlightWriter*
 TestHLWriter_new() {
     return (TestHighlightWriter*)Class_Make_Obj(TESTHIGHLIGHTWRITER);
 }
 
+static DocVector*
+S_fetch_doc_vec(String *text) {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType_Set_Highlightable(type, true);
+    String *content = SSTR_WRAP_C("content");
+    Schema_Spec_Field(schema, content, (FieldType*)type);
+    DECREF(type);
+    DECREF(tokenizer);
+
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, content, (Obj*)text);
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexReader *reader = IxReader_open((Obj*)folder, NULL, NULL);
+    HighlightReader *hl_reader = (HighlightReader*)IxReader_Obtain(
+        reader, Class_Get_Name(HIGHLIGHTREADER));
+    DocVector *doc_vec = HLReader_Fetch_Doc_Vec(hl_reader, 1);
+
+    DECREF(reader);
+    DECREF(folder);
+    DECREF(schema);
+    return doc_vec;
+}
+
+static bool
+S_has_term(DocVector *doc_vec, const char *text) {
+    String *field = SSTR_WRAP_C("content");
+    String *term_text = SSTR_WRAP_C(text);
+    TermVector *tv = DocVec_Term_Vector(doc_vec, field, term_text);
+    bool retval = tv != NULL;
+    DECREF(tv);
+    return retval;
+}
+
+static void
+test_term_directory(TestBatchRunner *runner) {
+    DocVector *doc_vec = S_fetch_doc_vec(SSTR_WRAP_C("b d ab d f"));
+    String *field = SSTR_WRAP_C("content");
+
+    TermVector *tv = DocVec_Term_Vector(doc_vec, field, SSTR_WRAP_C("d"));
+    TEST_TRUE(runner, tv != NULL, "Term_Vector finds a term");
+    I32Array *positions = TV_Get_Positions(tv);
+    I32Array *starts    = TV_Get_Start_Offsets(tv);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(positions), 2, "all positions");
+    TEST_INT_EQ(runner, I32Arr_Get(positions, 1), 3, "position");
+    TEST_INT_EQ(runner, I32Arr_Get(starts, 1), 7, "start offset");
+    DECREF(tv);
+
+    TEST_TRUE(runner, S_has_term(doc_vec, "ab"), "first term");
+    TEST_TRUE(runner, S_has_term(doc_vec, "b"), "term after longer term");
+    TEST_TRUE(runner, S_has_term(doc_vec, "f"), "last term");
+    TEST_FALSE(runner, S_has_term(doc_vec, "a"), "prefix of first term");
+    TEST_FALSE(runner, S_has_term(doc_vec, "abc"), "extension of a term");
+    TEST_FALSE(runner, S_has_term(doc_vec, "c"), "between terms");
+    TEST_FALSE(runner, S_has_term(doc_vec, "z"), "after last term");
+    TEST_TRUE(runner,
+              DocVec_Term_Vector(doc_vec, SSTR_WRAP_C("nope"), field) == NULL,
+              "unknown field");
+
+    DECREF(doc_vec);
+}
+
+static void
+test_upgrade_field_buf(TestBatchRunner *runner) {
+    // Format 1: num_terms, then per term the front-coded text followed
+    // directly by num_pos and (pos, start, end) triples.
+    static const char format_1[] = {
+        2,
+        0, 2, 'a', 'b', 1, 4, 9, 11,
+        0, 1, 'b', 2, 0, 0, 1, 2, 4, 5
+    };
+    Blob *old_buf = Blob_new(format_1, sizeof(format_1));
+    Blob *field_buf = DocVec_upgrade_field_buf(old_buf);
+    DocVector *doc_vec = DocVec_new();
+    String *field = SSTR_WRAP_C("content");
+    DocVec_Add_Field_Buf(doc_vec, field, field_buf);
+
+    TermVector *tv = DocVec_Term_Vector(doc_vec, field, SSTR_WRAP_C("ab"));
+    TEST_INT_EQ(runner, I32Arr_Get(TV_Get_Start_Offsets(tv), 0), 9,
+                "upgraded field buf keeps posdata");
+    DECREF(tv);
+    tv = DocVec_Term_Vector(doc_vec, field, SSTR_WRAP_C("b"));
+    TEST_INT_EQ(runner, I32Arr_Get(TV_Get_End_Offsets(tv), 1), 5,
+                "upgraded field buf keeps directory");
+    DECREF(tv);
+
+    DECREF(doc_vec);
+    DECREF(field_buf);
+    DECREF(old_buf);
+}
+
 void
 TestHLWriter_Run_IMP(TestHighlightWriter *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
-    PASS(runner, "Placeholder");
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 14);
+    test_term_directory(runner);
+    test_upgrade_field_buf(runner);
 }
 
-
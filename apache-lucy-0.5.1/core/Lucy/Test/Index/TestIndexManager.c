@@ -20,7 +20,19 @@
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Lucy/Test.h"
 #include "Lucy/Test/Index/TestIndexManager.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/RAMFolder.h"
 
 TestIndexManager*
 TestIxManager_new() {
@@ -28,36 +40,92 @@ TestIxManager_new() {
 }
 
 static void
-test_Choose_Sparse(TestBatchRunner *runner) {
+S_add_docs(Schema *schema, RAMFolder *folder, IndexManager *manager,
+           int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *content = Str_newf("doc%i32", i);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)content);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(content);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+}
+
+static void
+test_Recycle(TestBatchRunner *runner) {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    // Two big segs that shouldn't merge, then small, mergable segs.
+    IndexManager *deferring = IxManager_new(NULL, NULL);
+    IxManager_Set_Defer_Merges(deferring, true);
+    for (int32_t i = 0; i < 20; i++) {
+        S_add_docs(schema, folder, deferring, i < 2 ? 100 : 1);
+    }
+
     IndexManager *manager = IxManager_new(NULL, NULL);
+    IxManager_Set_Folder(manager, (Folder*)folder);
+    TEST_TRUE(runner,
+              Obj_is_a((Obj*)IxManager_Get_Merge_Policy(manager),
+                       TIEREDMERGEPOLICY),
+              "Default merge policy is tiered");
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    Vector *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    TEST_INT_EQ(runner, Vec_Get_Size(seg_readers), 20, "No merging");
+    uint32_t num_unsized = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(seg_readers); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(seg_readers, i);
+        Segment *segment = SegReader_Get_Segment(seg_reader);
+        if (Seg_Get_Size(segment) <= 0) { num_unsized++; }
+    }
+    TEST_INT_EQ(runner, num_unsized, 0, "Segment size recorded in segmeta");
+
+    Segment *segment = Seg_new(22);
+    Snapshot *snapshot = Snapshot_Read_File(Snapshot_new(), (Folder*)folder,
+                                            NULL);
+    DeletionsWriter *del_writer
+        = (DeletionsWriter*)DefDelWriter_new(schema, snapshot, segment,
+                                             reader);
+
+    Vector *recyclables
+        = IxManager_Recycle(manager, reader, del_writer, 19, true);
+    TEST_INT_EQ(runner, Vec_Get_Size(recyclables), 1, "cutoff");
+    DECREF(recyclables);
 
-    for (uint32_t num_segs = 2; num_segs < 20; num_segs++) {
-        I32Array *doc_counts = I32Arr_new_blank(num_segs);
-        for (uint32_t j = 0; j < num_segs; j++) {
-            I32Arr_Set(doc_counts, j, 1000);
-        }
-        uint32_t threshold = IxManager_Choose_Sparse(manager, doc_counts);
-        TEST_TRUE(runner, threshold != 1,
-                  "Either don't merge, or merge two segments: %u segs, thresh %u",
-                  (unsigned)num_segs, (unsigned)threshold);
-
-        if (num_segs != 12 && num_segs != 13) {  // when 2 is correct
-            I32Arr_Set(doc_counts, 0, 1);
-            threshold = IxManager_Choose_Sparse(manager, doc_counts);
-            TEST_TRUE(runner, threshold != 2,
-                      "Don't include big next seg: %u segs, thresh %u",
-                      (unsigned)num_segs, (unsigned)threshold);
-        }
-
-        DECREF(doc_counts);
+    recyclables = IxManager_Recycle(manager, reader, del_writer, 0, false);
+    TEST_INT_EQ(runner, Vec_Get_Size(recyclables), 10,
+                "Recycle a tier of small segs");
+    bool big_recycled = false;
+    for (uint32_t i = 0, max = Vec_Get_Size(recyclables); i < max; i++) {
+        SegReader *seg_reader = (SegReader*)Vec_Fetch(recyclables, i);
+        if (SegReader_Doc_Max(seg_reader) > 1) { big_recycled = true; }
     }
+    TEST_FALSE(runner, big_recycled, "Leave big ones alone");
+    DECREF(recyclables);
 
+    DECREF(del_writer);
+    DECREF(snapshot);
+    DECREF(segment);
+    DECREF(reader);
     DECREF(manager);
+    DECREF(deferring);
+    DECREF(folder);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
 }
 
 void
 TestIxManager_Run_IMP(TestIndexManager *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 34);
-    test_Choose_Sparse(runner);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 6);
+    test_Recycle(runner);
 }
 
@@ -0,0 +1,179 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestIndexWarmer.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexWarmer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/FSFileHandle.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/WorkerThread.h"
+
+#define TEST_DIR "_ixwarmer"
+
+TestIndexWarmer*
+TestIxWarmer_new() {
+    return (TestIndexWarmer*)Class_Make_Obj(TESTINDEXWARMER);
+}
+
+static void
+S_zap_test_dir() {
+    FSFolder *cwd = FSFolder_new(SSTR_WRAP_C("."));
+    FSFolder_Delete_Tree(cwd, SSTR_WRAP_C(TEST_DIR));
+    DECREF(cwd);
+}
+
+static void
+S_build_index(Obj *index) {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *content_type = FullTextType_new((Analyzer*)tokenizer);
+    StringType *id_type = StringType_new();
+    StringType_Set_Sortable(id_type, true);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"),
+                      (FieldType*)content_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)id_type);
+
+    Indexer *indexer = Indexer_new(schema, index, NULL, Indexer_CREATE);
+    for (int32_t i = 0; i < 500; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *content = Str_newf("common doc%i32 %s", i,
+                                   i % 3 ? "odd" : "even");
+        String *id = Str_newf("%i32", i);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)content);
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(content);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+
+    DECREF(indexer);
+    DECREF(id_type);
+    DECREF(content_type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
+static void
+test_fs_index(TestBatchRunner *runner) {
+    S_zap_test_dir();
+    S_build_index((Obj*)SSTR_WRAP_C(TEST_DIR));
+    PolyReader *reader = PolyReader_open((Obj*)SSTR_WRAP_C(TEST_DIR), NULL,
+                                         NULL);
+    IndexWarmer *warmer = IxWarmer_new();
+
+    TEST_INT_EQ(runner, IxWarmer_Get_Kinds(warmer), IXWARMER_ALL,
+                "Warm all file kinds by default");
+    TEST_TRUE(runner, IxWarmer_Get_Random_Postings(warmer),
+              "Flag postings for random access by default");
+
+    int64_t touched = IxWarmer_Warm(warmer, (IndexReader*)reader);
+    int64_t bytes   = IxWarmer_Get_Bytes(warmer);
+    TEST_TRUE(runner, touched > 0, "Warm() touches bytes");
+    TEST_TRUE(runner, touched == bytes, "Warm() touches every range");
+
+    double warmth = IxWarmer_Measure(warmer, (IndexReader*)reader);
+    if (FSFH_can_measure_residency()) {
+        TEST_TRUE(runner, warmth == 1.0,
+                  "Measure() after Warm() reports resident ranges");
+    }
+    else {
+        SKIP(runner, 1, "mincore() not available");
+    }
+    TEST_TRUE(runner, IxWarmer_Get_Bytes(warmer) == bytes,
+              "Measure() selects the same ranges as Warm()");
+
+    IxWarmer_Add_Hot_Term(warmer, SSTR_WRAP_C("content"),
+                          (Obj*)SSTR_WRAP_C("common"));
+    IxWarmer_Add_Hot_Term(warmer, SSTR_WRAP_C("content"),
+                          (Obj*)SSTR_WRAP_C("nonexistent"));
+    IxWarmer_Warm(warmer, (IndexReader*)reader);
+    TEST_TRUE(runner, IxWarmer_Get_Bytes(warmer) > bytes,
+              "Hot terms add posting ranges");
+
+    IxWarmer_Set_Kinds(warmer, IXWARMER_HOT_POSTINGS);
+    IxWarmer_Warm(warmer, (IndexReader*)reader);
+    int64_t hot_bytes = IxWarmer_Get_Bytes(warmer);
+    TEST_TRUE(runner, hot_bytes > 0 && hot_bytes < bytes,
+              "Hot posting range covers a single term");
+
+    IxWarmer_Set_Kinds(warmer, IXWARMER_ALL);
+    IxWarmer_Start(warmer, (IndexReader*)reader);
+    IxWarmer_Wait(warmer);
+    TEST_FALSE(runner, IxWarmer_Is_Running(warmer),
+               "Not running after Wait()");
+    TEST_TRUE(runner,
+              IxWarmer_Get_Touched_Bytes(warmer) == IxWarmer_Get_Bytes(warmer),
+              "Start() touches every range");
+
+    IxWarmer_Set_Kinds(warmer, 0);
+    TEST_INT_EQ(runner, IxWarmer_Warm(warmer, (IndexReader*)reader), 0,
+                "Nothing to warm with no kinds selected");
+    TEST_TRUE(runner, IxWarmer_Measure(warmer, (IndexReader*)reader) == 1.0,
+              "Empty selection counts as warm");
+
+    DECREF(warmer);
+    DECREF(reader);
+    S_zap_test_dir();
+}
+
+static void
+test_ram_index(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_build_index((Obj*)folder);
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    IndexWarmer *warmer = IxWarmer_new();
+
+    TEST_INT_EQ(runner, IxWarmer_Start(warmer, (IndexReader*)reader),
+                WorkerThread_enabled(),
+                "Start() warms on a thread where threads are available");
+    // Destroy() must join the running thread before releasing the
+    // InStreams it reads through.
+    DECREF(warmer);
+
+    warmer = IxWarmer_new();
+    int64_t touched = IxWarmer_Warm(warmer, (IndexReader*)reader);
+    TEST_TRUE(runner, touched > 0 && touched == IxWarmer_Get_Bytes(warmer),
+              "Warm() a RAMFolder index");
+    TEST_TRUE(runner, IxWarmer_Measure(warmer, (IndexReader*)reader) == 1.0,
+              "RAM files are always resident");
+
+    DECREF(warmer);
+    DECREF(reader);
+    DECREF(folder);
+}
+
+void
+TestIxWarmer_Run_IMP(TestIndexWarmer *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 15);
+    test_fs_index(runner);
+    test_ram_index(runner);
+}
+
+
@@ -0,0 +1,163 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestMemoryBudget.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/MemoryBudget.h"
+#include "Lucy/Index/SegWriter.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 500
+
+TestMemoryBudget*
+TestMemBudget_new() {
+    return (TestMemoryBudget*)Class_Make_Obj(TESTMEMORYBUDGET);
+}
+
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *full_text_type = FullTextType_new((Analyzer*)tokenizer);
+    StringType *string_type = StringType_new();
+    StringType_Set_Sortable(string_type, true);
+
+    Schema_Spec_Field(schema, SSTR_WRAP_C("body"), (FieldType*)full_text_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("cat"), (FieldType*)string_type);
+
+    DECREF(string_type);
+    DECREF(full_text_type);
+    DECREF(tokenizer);
+
+    return schema;
+}
+
+static void
+S_add_docs(Indexer *indexer) {
+    for (int i = 0; i < NUM_DOCS; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *body = Str_newf("common word%i32 word%i32 text%i32 more text",
+                                (int32_t)i, (int32_t)(i % 7),
+                                (int32_t)(i % 13));
+        String *cat = Str_newf("cat%i32", (int32_t)(i % 3));
+        Doc_Store(doc, SSTR_WRAP_C("body"), (Obj*)body);
+        Doc_Store(doc, SSTR_WRAP_C("cat"), (Obj*)cat);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(cat);
+        DECREF(body);
+        DECREF(doc);
+    }
+}
+
+static uint32_t
+S_num_hits(RAMFolder *folder, const char *field, const char *term) {
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C(field),
+                                     (Obj*)SSTR_WRAP_C(term));
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t num_hits = Hits_Total_Hits(hits);
+    DECREF(hits);
+    DECREF(searcher);
+    DECREF(query);
+    return num_hits;
+}
+
+static void
+test_defaults(TestBatchRunner *runner) {
+    MemoryBudget *budget = MemBudget_new(0);
+    Vector *writers = Vec_new(0);
+    TEST_TRUE(runner, MemBudget_Get_Limit(budget) == 0x1400000,
+              "Default limit");
+    TEST_INT_EQ(runner, MemBudget_Balance(budget, writers), 0,
+                "Balance with no writers doesn't flush");
+    TEST_TRUE(runner, MemBudget_Get_Usage(budget) == 0, "No usage");
+    MemBudget_Set_Limit(budget, 1024);
+    TEST_TRUE(runner, MemBudget_Get_Limit(budget) == 1024, "Set_Limit");
+    DECREF(writers);
+    DECREF(budget);
+}
+
+static void
+test_budget(TestBatchRunner *runner, uint64_t limit, bool expect_flushes) {
+    Schema       *schema  = S_create_schema();
+    RAMFolder    *folder  = RAMFolder_new(NULL);
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    IxManager_Set_Mem_Budget(manager, limit);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    MemoryBudget *budget
+        = SegWriter_Get_Mem_Budget(Indexer_Get_Seg_Writer(indexer));
+    TEST_TRUE(runner, MemBudget_Get_Limit(budget) == limit,
+              "Indexer applies IndexManager's budget");
+
+    S_add_docs(indexer);
+    if (expect_flushes) {
+        TEST_TRUE(runner, MemBudget_Get_Flush_Count(budget) > 0,
+                  "Flushes when over budget");
+        TEST_TRUE(runner, MemBudget_Get_Usage(budget) <= limit,
+                  "Usage stays within budget");
+        TEST_TRUE(runner, MemBudget_Get_Peak_Usage(budget) > limit,
+                  "Peak usage recorded before flushing");
+    }
+    else {
+        TEST_TRUE(runner, MemBudget_Get_Flush_Count(budget) == 0,
+                  "No flushes under budget");
+        TEST_TRUE(runner, MemBudget_Get_Usage(budget) > 0,
+                  "Usage reported");
+        TEST_TRUE(runner,
+                  MemBudget_Get_Usage(budget)
+                  == MemBudget_Get_Peak_Usage(budget),
+                  "Peak usage equals usage without flushes");
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    TEST_INT_EQ(runner, S_num_hits(folder, "body", "common"), NUM_DOCS,
+                "All postings survive");
+    TEST_INT_EQ(runner, S_num_hits(folder, "body", "word3"), 71,
+                "Postings merged across runs");
+    TEST_INT_EQ(runner, S_num_hits(folder, "cat", "cat1"), 167,
+                "String field postings merged across runs");
+
+    DECREF(manager);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestMemBudget_Run_IMP(TestMemoryBudget *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
+    test_defaults(runner);
+    test_budget(runner, 0x1000, true);
+    test_budget(runner, 0x4000000, false);
+}
+
@@ -0,0 +1,222 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestMergePolicy.h"
+#include "Lucy/Index/MergePolicy.h"
+#include "Lucy/Index/MergeSimulator.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Object/I32Array.h"
+
+#define KB INT64_C(1024)
+#define MB (KB * KB)
+
+TestMergePolicy*
+TestMergePolicy_new() {
+    return (TestMergePolicy*)Class_Make_Obj(TESTMERGEPOLICY);
+}
+
+static Vector*
+S_candidates(int64_t *sizes, int64_t *del_counts, uint32_t num) {
+    Vector *candidates = Vec_new(num);
+    for (uint32_t i = 0; i < num; i++) {
+        int64_t del_count = del_counts ? del_counts[i] : 0;
+        Vec_Push(candidates, (Obj*)MergeCand_new(sizes[i], 100, del_count));
+    }
+    return candidates;
+}
+
+static I32Array*
+S_find_merge(TieredMergePolicy *policy, int64_t *sizes, int64_t *del_counts,
+             uint32_t num) {
+    Vector *candidates = S_candidates(sizes, del_counts, num);
+    I32Array *picks = TieredMP_Find_Merge(policy, candidates);
+    DECREF(candidates);
+    return picks;
+}
+
+static bool
+S_picked(I32Array *picks, int32_t tick) {
+    for (uint32_t i = 0, max = I32Arr_Get_Size(picks); i < max; i++) {
+        if (I32Arr_Get(picks, i) == tick) { return true; }
+    }
+    return false;
+}
+
+static void
+test_tiers(TestBatchRunner *runner) {
+    TieredMergePolicy *policy = TieredMP_new();
+    int64_t sizes[20];
+    I32Array *picks;
+
+    for (uint32_t i = 0; i < 20; i++) { sizes[i] = 2 * KB; }
+    picks = S_find_merge(policy, sizes, NULL, 10);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(picks), 0,
+                "Don't merge while a tier has room");
+    DECREF(picks);
+
+    picks = S_find_merge(policy, sizes, NULL, 11);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(picks), 10,
+                "Merge a full tier of tiny segments at once");
+    DECREF(picks);
+
+    // Two big segments followed by many small ones.
+    sizes[0] = 50 * MB;
+    sizes[1] = 50 * MB;
+    picks = S_find_merge(policy, sizes, NULL, 20);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(picks), 10,
+                "Merge small segments");
+    TEST_TRUE(runner, !S_picked(picks, 0) && !S_picked(picks, 1),
+              "Leave big segments alone");
+    DECREF(picks);
+
+    // Segments over half the maximum merged size are never merged with
+    // others.
+    TieredMP_Set_Max_Merged_Size(policy, 80 * MB);
+    TieredMP_Set_Segs_Per_Tier(policy, 2);
+    picks = S_find_merge(policy, sizes, NULL, 3);
+    TEST_TRUE(runner, !S_picked(picks, 0) && !S_picked(picks, 1),
+              "Too-large segments excluded");
+    DECREF(picks);
+
+    DECREF(policy);
+}
+
+static void
+test_deletions(TestBatchRunner *runner) {
+    TieredMergePolicy *policy = TieredMP_new();
+    int64_t sizes[3]      = { 10 * MB, 10 * MB, 10 * MB };
+    int64_t del_counts[3] = { 1, 25, 0 };
+    I32Array *picks;
+
+    picks = S_find_merge(policy, sizes, del_counts, 3);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(picks), 1,
+                "Rewrite one segment with too many deletions");
+    TEST_TRUE(runner, S_picked(picks, 1), "Pick the segment over the limit");
+    DECREF(picks);
+
+    del_counts[1] = 15;
+    picks = S_find_merge(policy, sizes, del_counts, 3);
+    TEST_INT_EQ(runner, I32Arr_Get_Size(picks), 0,
+                "Tolerate deletions under the limit");
+    DECREF(picks);
+
+    // With equal sizes, a tier merge prefers segments with deletions.
+    int64_t many_sizes[12];
+    int64_t many_dels[12];
+    for (uint32_t i = 0; i < 12; i++) {
+        many_sizes[i] = 10 * MB;
+        many_dels[i]  = 0;
+    }
+    many_dels[0] = 15;
+    many_dels[1] = 15;
+    picks = S_find_merge(policy, many_sizes, many_dels, 12);
+    TEST_TRUE(runner, S_picked(picks, 0) && S_picked(picks, 1),
+              "Favor reclaiming deletions");
+    DECREF(picks);
+
+    DECREF(policy);
+}
+
+static void
+S_zero_segs_per_tier(void *context) {
+    TieredMP_Set_Segs_Per_Tier((TieredMergePolicy*)context, 1);
+}
+
+static void
+S_zero_max_merged_size(void *context) {
+    TieredMP_Set_Max_Merged_Size((TieredMergePolicy*)context, 0);
+}
+
+static void
+test_settings(TestBatchRunner *runner) {
+    TieredMergePolicy *policy = TieredMP_new();
+    TEST_INT_EQ(runner, TieredMP_Get_Segs_Per_Tier(policy), 10,
+                "Default segs_per_tier");
+    TEST_TRUE(runner, TieredMP_Get_Floor_Size(policy) == 2 * MB,
+              "Default floor_size");
+
+    Err *error = Err_trap(S_zero_segs_per_tier, policy);
+    TEST_TRUE(runner, error != NULL, "segs_per_tier below 2 throws");
+    DECREF(error);
+    error = Err_trap(S_zero_max_merged_size, policy);
+    TEST_TRUE(runner, error != NULL, "Non-positive max_merged_size throws");
+    DECREF(error);
+
+    DECREF(policy);
+}
+
+static void
+S_replay_garbage(void *context) {
+    MergeSim_Replay((MergeSimulator*)context, SSTR_WRAP_C("1 2 3 4\n"));
+}
+
+static void
+test_simulator(TestBatchRunner *runner) {
+    TieredMergePolicy *policy = TieredMP_new();
+    MergeSimulator *sim = MergeSim_new((MergePolicy*)policy);
+
+    // One small document per commit.
+    for (uint32_t i = 0; i < 1000; i++) {
+        MergeSim_Commit(sim, 1, 2 * KB, 0);
+    }
+    TEST_INT_EQ(runner, MergeSim_Get_Num_Commits(sim), 1000, "Num_Commits");
+    TEST_TRUE(runner, MergeSim_Get_Max_Seg_Count(sim) <= 11,
+              "Segment count stays bounded: %u",
+              (unsigned)MergeSim_Get_Max_Seg_Count(sim));
+    TEST_TRUE(runner, MergeSim_Get_Bytes_Added(sim) == 1000 * 2 * KB,
+              "Bytes_Added");
+    double write_amp = MergeSim_Write_Amplification(sim);
+    TEST_TRUE(runner, write_amp > 1.0 && write_amp < 6.0,
+              "Write amplification stays low: %f", write_amp);
+    DECREF(sim);
+
+    sim = MergeSim_new((MergePolicy*)policy);
+    MergeSim_Replay(sim, SSTR_WRAP_C("# docs bytes deletions\n"
+                                     "10 1000\n"
+                                     "\n"
+                                     "5 500 2\n"));
+    TEST_INT_EQ(runner, MergeSim_Get_Num_Commits(sim), 2,
+                "Replay skips comments and blank lines");
+    TEST_TRUE(runner, MergeSim_Get_Bytes_Added(sim) == 1500,
+              "Replay adds bytes");
+    TEST_INT_EQ(runner, MergeSim_Get_Seg_Count(sim), 2, "Seg_Count");
+    String *report = MergeSim_Report(sim);
+    TEST_TRUE(runner, Str_Contains_Utf8(report, "commits: 2", 10), "Report");
+    DECREF(report);
+
+    Err *error = Err_trap(S_replay_garbage, sim);
+    TEST_TRUE(runner, error != NULL, "Malformed log line throws");
+    DECREF(error);
+
+    DECREF(sim);
+    DECREF(policy);
+}
+
+void
+TestMergePolicy_Run_IMP(TestMergePolicy *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_tiers(runner);
+    test_deletions(runner);
+    test_settings(runner);
+    test_simulator(runner);
+}
+
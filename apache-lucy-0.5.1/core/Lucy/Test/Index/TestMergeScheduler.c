@@ -0,0 +1,301 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestMergeScheduler.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/MergeScheduler.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/FcntlLock.h"
+#include "Lucy/Store/FcntlLockFactory.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RateLimiter.h"
+#include "Lucy/Util/IndexFileNames.h"
+#include "Lucy/Util/MetaFile.h"
+
+#define TEST_DIR "_mergesched"
+
+TestMergeScheduler*
+TestMergeSched_new() {
+    return (TestMergeScheduler*)Class_Make_Obj(TESTMERGESCHEDULER);
+}
+
+static void
+S_zap_test_dir() {
+    FSFolder *cwd = FSFolder_new(SSTR_WRAP_C("."));
+    FSFolder_Delete_Tree(cwd, SSTR_WRAP_C(TEST_DIR));
+    DECREF(cwd);
+}
+
+static void
+S_add_session(IndexManager *manager, int32_t num) {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)SSTR_WRAP_C(TEST_DIR),
+                                   manager, Indexer_CREATE);
+    Doc *doc = Doc_new(NULL, 0);
+    String *content = Str_newf("doc%i32 common", num);
+    Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)content);
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    Indexer_Commit(indexer);
+
+    DECREF(content);
+    DECREF(doc);
+    DECREF(indexer);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
+static uint32_t
+S_num_segments(uint32_t *doc_count) {
+    PolyReader *reader = PolyReader_open((Obj*)SSTR_WRAP_C(TEST_DIR), NULL,
+                                         NULL);
+    uint32_t num_segments = Vec_Get_Size(PolyReader_Get_Seg_Readers(reader));
+    *doc_count = (uint32_t)PolyReader_Doc_Count(reader);
+    DECREF(reader);
+    return num_segments;
+}
+
+static void
+S_set_bad_rate(void *context) {
+    RateLimiter_Set_MB_Per_Sec((RateLimiter*)context, 0.0);
+}
+
+static void
+test_rate_limiter(TestBatchRunner *runner) {
+    RateLimiter *limiter = RateLimiter_new(16.0);
+    TEST_TRUE(runner, RateLimiter_Get_MB_Per_Sec(limiter) == 16.0,
+              "Get_MB_Per_Sec");
+
+    // Two megabytes at 16 MB/s should take about an eighth of a second.
+    for (int i = 0; i < 32; i++) {
+        RateLimiter_Pause(limiter, 0x10000);
+    }
+    TEST_TRUE(runner, RateLimiter_Get_Total_Bytes(limiter) == 0x200000,
+              "Get_Total_Bytes");
+    TEST_TRUE(runner, RateLimiter_Get_Paused_Millis(limiter) >= 60,
+              "Pause throttles writer");
+
+    Err *error = Err_trap(S_set_bad_rate, limiter);
+    TEST_TRUE(runner, error != NULL, "Non-positive rate throws");
+    DECREF(error);
+    DECREF(limiter);
+}
+
+static void
+test_fs_folder(TestBatchRunner *runner) {
+    S_zap_test_dir();
+    FSFolder *folder = FSFolder_new(SSTR_WRAP_C(TEST_DIR));
+    FSFolder_Initialize(folder);
+    FSFolder_MkDir(folder, SSTR_WRAP_C("sub"));
+
+    RateLimiter *limiter = RateLimiter_new(1024.0);
+    FSFolder_Set_Rate_Limiter(folder, limiter);
+    TEST_TRUE(runner, FSFolder_Get_Rate_Limiter(folder) == limiter,
+              "Get_Rate_Limiter");
+
+    OutStream *outstream
+        = FSFolder_Open_Out(folder, SSTR_WRAP_C("sub/file"));
+    OutStream_Write_Bytes(outstream, "0123456789", 10);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    TEST_TRUE(runner, RateLimiter_Get_Total_Bytes(limiter) == 10,
+              "Writes in subfolders are throttled");
+
+    DECREF(limiter);
+    DECREF(folder);
+    S_zap_test_dir();
+}
+
+static void
+test_deferred_merges(TestBatchRunner *runner) {
+    uint32_t doc_count;
+    S_zap_test_dir();
+
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    IxManager_Set_Defer_Merges(manager, true);
+    IxManager_Set_Write_Lock_Timeout(manager, 10000);
+    TEST_TRUE(runner, IxManager_Get_Defer_Merges(manager),
+              "Get_Defer_Merges");
+    for (int32_t i = 0; i < 11; i++) {
+        S_add_session(manager, i);
+    }
+    TEST_INT_EQ(runner, S_num_segments(&doc_count), 11,
+                "Indexer doesn't merge when merges are deferred");
+
+    MergeScheduler *scheduler
+        = MergeSched_new(SSTR_WRAP_C(TEST_DIR), manager);
+    MergeSched_Set_MB_Per_Sec(scheduler, 64.0);
+    TEST_TRUE(runner, MergeSched_Schedule(scheduler), "Schedule");
+
+    // Keep indexing while the merge runs.
+    S_add_session(manager, 11);
+    MergeSched_Wait(scheduler);
+    TEST_FALSE(runner, MergeSched_Is_Running(scheduler),
+               "Not running after Wait");
+    TEST_INT_EQ(runner, MergeSched_Get_Failure_Count(scheduler), 0,
+                "No failures");
+    TEST_INT_EQ(runner, MergeSched_Get_Merge_Count(scheduler), 1,
+                "Merge completed");
+
+    uint32_t num_segments = S_num_segments(&doc_count);
+    TEST_TRUE(runner, num_segments < 12, "Background merge consolidated");
+    TEST_INT_EQ(runner, doc_count, 12, "No docs lost");
+
+    DECREF(scheduler);
+    DECREF(manager);
+    S_zap_test_dir();
+}
+
+static void
+test_fcntl_locks(TestBatchRunner *runner) {
+    uint32_t doc_count;
+    S_zap_test_dir();
+
+    FSFolder *folder = FSFolder_new(SSTR_WRAP_C(TEST_DIR));
+    FSFolder_Initialize(folder);
+    FcntlLockFactory *lock_factory
+        = FcntlLockFact_new((Folder*)folder, SSTR_WRAP_C(""));
+    IndexManager *manager
+        = IxManager_new(NULL, (LockFactory*)lock_factory);
+    IxManager_Set_Defer_Merges(manager, true);
+    TEST_TRUE(runner,
+              IxManager_Get_Lock_Factory(manager)
+              == (LockFactory*)lock_factory,
+              "Get_Lock_Factory");
+    for (int32_t i = 0; i < 11; i++) {
+        S_add_session(manager, i);
+    }
+
+    MergeScheduler *scheduler
+        = MergeSched_new(SSTR_WRAP_C(TEST_DIR), manager);
+    MergeSched_Schedule(scheduler);
+    S_add_session(manager, 11);
+    MergeSched_Wait(scheduler);
+    TEST_INT_EQ(runner, MergeSched_Get_Merge_Count(scheduler), 1,
+                "Merge with FcntlLocks completed");
+    uint32_t num_segments = S_num_segments(&doc_count);
+    TEST_TRUE(runner, num_segments < 12 && doc_count == 12,
+              "Merge with FcntlLocks consolidated without losing docs");
+
+    DECREF(scheduler);
+    DECREF(manager);
+    DECREF(lock_factory);
+    DECREF(folder);
+    S_zap_test_dir();
+}
+
+static void
+test_merge_policy(TestBatchRunner *runner) {
+    uint32_t doc_count;
+    S_zap_test_dir();
+
+    // Room for every segment in the first tier means nothing to merge.
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    TieredMergePolicy *policy = TieredMP_new();
+    TieredMP_Set_Segs_Per_Tier(policy, 50);
+    IxManager_Set_Merge_Policy(manager, (MergePolicy*)policy);
+    IxManager_Set_Defer_Merges(manager, true);
+    for (int32_t i = 0; i < 11; i++) {
+        S_add_session(manager, i);
+    }
+
+    MergeScheduler *scheduler
+        = MergeSched_new(SSTR_WRAP_C(TEST_DIR), manager);
+    MergeSched_Schedule(scheduler);
+    MergeSched_Wait(scheduler);
+    TEST_INT_EQ(runner, MergeSched_Get_Failure_Count(scheduler), 0,
+                "Merge with custom policy succeeded");
+    TEST_INT_EQ(runner, S_num_segments(&doc_count), 11,
+                "Worker follows the manager's merge policy");
+
+    // Changes to the policy take effect with the next merge.
+    TieredMP_Set_Segs_Per_Tier(policy, 2);
+    MergeSched_Schedule(scheduler);
+    MergeSched_Wait(scheduler);
+    TEST_TRUE(runner, S_num_segments(&doc_count) < 11 && doc_count == 11,
+              "Policy settings captured at Schedule");
+
+    DECREF(scheduler);
+    DECREF(policy);
+    DECREF(manager);
+    S_zap_test_dir();
+}
+
+static void
+test_binary_metadata(TestBatchRunner *runner) {
+    uint32_t doc_count;
+    S_zap_test_dir();
+
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    IxManager_Set_Binary_Metadata(manager, true);
+    IxManager_Set_Defer_Merges(manager, true);
+    for (int32_t i = 0; i < 11; i++) {
+        S_add_session(manager, i);
+    }
+
+    MergeScheduler *scheduler
+        = MergeSched_new(SSTR_WRAP_C(TEST_DIR), manager);
+    MergeSched_Schedule(scheduler);
+    MergeSched_Wait(scheduler);
+    TEST_TRUE(runner, S_num_segments(&doc_count) < 11,
+              "Merge with binary metadata consolidated");
+
+    FSFolder *folder = FSFolder_new(SSTR_WRAP_C(TEST_DIR));
+    String   *snapfile = IxFileNames_latest_snapshot((Folder*)folder);
+    InStream *instream = FSFolder_Open_In(folder, snapfile);
+    size_t    len      = instream ? (size_t)InStream_Length(instream) : 0;
+    TEST_TRUE(runner,
+              instream
+              && MetaFile_is_binary(InStream_Buf(instream, len), len),
+              "Worker writes binary metadata when the manager does");
+    DECREF(instream);
+    DECREF(snapfile);
+    DECREF(folder);
+
+    DECREF(scheduler);
+    DECREF(manager);
+    S_zap_test_dir();
+}
+
+void
+TestMergeSched_Run_IMP(TestMergeScheduler *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_rate_limiter(runner);
+    test_fs_folder(runner);
+    test_deferred_merges(runner);
+    test_fcntl_locks(runner);
+    test_merge_policy(runner);
+    test_binary_metadata(runner);
+}
+
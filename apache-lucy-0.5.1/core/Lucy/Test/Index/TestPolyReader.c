@@ -21,7 +21,18 @@
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Lucy/Test.h"
 #include "Lucy/Test/Index/TestPolyReader.h"
+#include "Clownfish/Num.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
 #include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/TieredMergePolicy.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Json.h"
 
 TestPolyReader*
 TestPolyReader_new() {
@@ -45,9 +56,104 @@ test_sub_tick(TestBatchRunner *runner) {
     FREEMEM(ints);
 }
 
+static void
+S_add_docs(Schema *schema, Folder *folder, const char **texts,
+           int32_t num_texts, int32_t first_id) {
+    // Keep the merge policy from reclaiming the deletion below.
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    TieredMergePolicy *policy = TieredMP_new();
+    TieredMP_Set_Deletes_Pct_Allowed(policy, 100.0);
+    IxManager_Set_Merge_Policy(manager, (MergePolicy*)policy);
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    for (int32_t i = 0; i < num_texts; i++) {
+        Doc    *doc = Doc_new(NULL, 0);
+        String *id  = Str_newf("%i32", first_id + i);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)SSTR_WRAP_C(texts[i]));
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    if (first_id > 0) {
+        Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"),
+                               (Obj*)SSTR_WRAP_C("0"));
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(policy);
+    DECREF(manager);
+}
+
+static int64_t
+S_stat(Hash *stats, const char *key) {
+    Obj *value = Hash_Fetch_Utf8(stats, key, strlen(key));
+    return value ? Json_obj_to_i64(value) : -1;
+}
+
+static void
+test_stats(TestBatchRunner *runner) {
+    static const char *first[]  = { "a b c", "a b", "c d e f" };
+    static const char *second[] = { "a", "b c" };
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *full_text_type = FullTextType_new((Analyzer*)tokenizer);
+    StringType *string_type = StringType_new();
+    StringType_Set_Sortable(string_type, true);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"),
+                      (FieldType*)full_text_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)string_type);
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, (Folder*)folder, first, 3, 0);
+    S_add_docs(schema, (Folder*)folder, second, 2, 3);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    Hash *stats = PolyReader_Stats(reader);
+    TEST_INT_EQ(runner, S_stat(stats, "num_segments"), 2, "num_segments");
+    TEST_INT_EQ(runner, S_stat(stats, "doc_max"), 5, "doc_max");
+    TEST_INT_EQ(runner, S_stat(stats, "del_count"), 1, "del_count");
+    TEST_TRUE(runner, S_stat(stats, "bytes") > S_stat(stats, "resident_bytes")
+              && S_stat(stats, "resident_bytes") > 0,
+              "bytes and resident_bytes");
+
+    Hash *fields  = (Hash*)Hash_Fetch_Utf8(stats, "fields", 6);
+    Hash *content = (Hash*)Hash_Fetch_Utf8(fields, "content", 7);
+    Hash *id      = (Hash*)Hash_Fetch_Utf8(fields, "id", 2);
+    TEST_INT_EQ(runner, S_stat(content, "terms"), 6 + 3,
+                "terms summed across segments");
+    TEST_INT_EQ(runner, S_stat(content, "postings"), 9 + 3,
+                "postings summed across segments");
+    TEST_TRUE(runner, S_stat(content, "posting_bytes") > 0, "posting_bytes");
+    TEST_TRUE(runner, S_stat(content, "lexicon_index_bytes") > 0,
+              "lexicon_index_bytes");
+    Obj *avg = Hash_Fetch_Utf8(content, "avg_doc_terms", 13);
+    TEST_TRUE(runner, avg && Json_obj_to_f64(avg) == 12.0 / 5.0,
+              "avg_doc_terms");
+    TEST_TRUE(runner, S_stat(id, "sort_bytes") > 0, "sort_bytes");
+    TEST_INT_EQ(runner, S_stat(id, "sort_values"), 5, "sort_values");
+
+    Vector *segments = (Vector*)Hash_Fetch_Utf8(stats, "segments", 8);
+    Hash *seg_stats = (Hash*)Vec_Fetch(segments, 0);
+    TEST_INT_EQ(runner, S_stat(seg_stats, "del_count"), 1,
+                "per-segment del_count");
+    TEST_TRUE(runner, Hash_Fetch_Utf8(seg_stats, "components", 10) != NULL,
+              "per-component stats");
+    TEST_INT_EQ(runner,
+                Folder_File_Length((Folder*)folder, SSTR_WRAP_C("nope")), 0,
+                "File_Length of missing file");
+
+    DECREF(stats);
+    DECREF(reader);
+    DECREF(folder);
+    DECREF(string_type);
+    DECREF(full_text_type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
 void
 TestPolyReader_Run_IMP(TestPolyReader *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 15);
     test_sub_tick(runner);
+    test_stats(runner);
 }
 
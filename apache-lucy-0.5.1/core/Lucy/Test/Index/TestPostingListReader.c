@@ -0,0 +1,143 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTPOSTINGLISTREADER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestPostingListReader.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 60
+
+TestPostingListReader*
+TestPListReader_new() {
+    return (TestPostingListReader*)Class_Make_Obj(TESTPOSTINGLISTREADER);
+}
+
+static RAMFolder*
+S_create_index() {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+    DECREF(type);
+    DECREF(tokenizer);
+
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *content = Str_newf("all m%i32 n%i32", i % 2, i % 3);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)content);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(content);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+    return folder;
+}
+
+static PostingList*
+S_plist(PostingListReader *plist_reader, const char *term) {
+    return PListReader_Posting_List(plist_reader, SSTR_WRAP_C("content"),
+                                    (Obj*)SSTR_WRAP_C(term));
+}
+
+// Count the remaining docs, checking that each one is a multiple of `step`
+// apart from `first`.
+static bool
+S_docs_match(PostingList *plist, int32_t first, int32_t step,
+             int32_t expected) {
+    int32_t count = 0;
+    int32_t doc_id;
+    while (0 != (doc_id = PList_Next(plist))) {
+        if ((doc_id - 1 - first) % step != 0) { return false; }
+        count++;
+    }
+    return count == expected;
+}
+
+static void
+test_pooling(TestBatchRunner *runner) {
+    RAMFolder  *folder = S_create_index();
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)Vec_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Obtain(
+              seg_reader, Class_Get_Name(POSTINGLISTREADER));
+
+    PostingList *first = S_plist(plist_reader, "m0");
+    PostingList *held  = S_plist(plist_reader, "m1");
+    TEST_TRUE(runner, first != held,
+              "Posting list in use isn't handed out again");
+    TEST_TRUE(runner, S_docs_match(held, 1, 2, NUM_DOCS / 2),
+              "Fresh posting list iterates");
+
+    PList_Next(first);
+    DECREF(first);
+    PostingList *reused = S_plist(plist_reader, "n2");
+    TEST_TRUE(runner, reused == first, "Released posting list is reused");
+    TEST_INT_EQ(runner, PList_Get_Doc_Freq(reused), NUM_DOCS / 3,
+                "Reused posting list reports new doc freq");
+    TEST_TRUE(runner, S_docs_match(reused, 2, 3, NUM_DOCS / 3),
+              "Reused posting list iterates from the top");
+
+    PList_Seek(reused, (Obj*)SSTR_WRAP_C("all"));
+    TEST_TRUE(runner, S_docs_match(reused, 0, 1, NUM_DOCS),
+              "Seek after reuse");
+    PList_Seek(reused, (Obj*)SSTR_WRAP_C("nope"));
+    TEST_INT_EQ(runner, PList_Next(reused), 0,
+                "Seek to missing term after reuse");
+    DECREF(reused);
+
+    PostingList *missing = PListReader_Posting_List(
+        plist_reader, SSTR_WRAP_C("nope"), NULL);
+    TEST_TRUE(runner, missing == NULL, "No posting list for unknown field");
+
+    // Keep a pooled list past the life of its reader.
+    PostingList *orphan = S_plist(plist_reader, "m0");
+    DECREF(held);
+    DECREF(reader);
+    TEST_TRUE(runner, S_docs_match(orphan, 0, 2, NUM_DOCS / 2),
+              "Pooled posting list outlives its reader");
+    DECREF(orphan);
+
+    DECREF(folder);
+}
+
+void
+TestPListReader_Run_IMP(TestPostingListReader *self,
+                        TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 9);
+    test_pooling(runner);
+}
+
+
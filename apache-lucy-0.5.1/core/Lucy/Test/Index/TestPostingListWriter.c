@@ -18,19 +18,237 @@
 #define TESTLUCY_USE_SHORT_NAMES
 #include "Lucy/Util/ToolSet.h"
 
+#include "Clownfish/CharBuf.h"
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Lucy/Test.h"
 #include "Lucy/Test/Index/TestPostingListWriter.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define DOCS_PER_SESSION 100
 
 TestPostingListWriter*
 TestPListWriter_new() {
     return (TestPostingListWriter*)Class_Make_Obj(TESTPOSTINGLISTWRITER);
 }
 
-void
-TestPListWriter_Run_IMP(TestPostingListWriter *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
-    PASS(runner, "Placeholder");
+static Schema*
+S_create_schema() {
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *full_text_type = FullTextType_new((Analyzer*)tokenizer);
+    StringType *string_type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("body"), (FieldType*)full_text_type);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)string_type);
+    DECREF(string_type);
+    DECREF(full_text_type);
+    DECREF(tokenizer);
+    return schema;
+}
+
+static String*
+S_body(int32_t i) {
+    return Str_newf("common beta gamma w%i32 tail%i32", i % 5, i);
+}
+
+static void
+S_add_docs(Indexer *indexer, int32_t start) {
+    for (int32_t i = start; i < start + DOCS_PER_SESSION; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *body = S_body(i);
+        String *id   = Str_newf("id%i32", i);
+        Doc_Store(doc, SSTR_WRAP_C("body"), (Obj*)body);
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(body);
+        DECREF(doc);
+    }
+}
+
+static uint32_t
+S_num_hits(IndexSearcher *searcher, Query *query) {
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t num_hits = Hits_Total_Hits(hits);
+    DECREF(hits);
+    return num_hits;
+}
+
+static uint32_t
+S_term_hits(IndexSearcher *searcher, const char *field, const char *term) {
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C(field),
+                                     (Obj*)SSTR_WRAP_C(term));
+    uint32_t num_hits = S_num_hits(searcher, (Query*)query);
+    DECREF(query);
+    return num_hits;
+}
+
+static uint32_t
+S_phrase_hits(IndexSearcher *searcher, const char *first,
+              const char *second) {
+    Vector *terms = Vec_new(2);
+    Vec_Push(terms, (Obj*)Str_new_from_utf8(first, strlen(first)));
+    Vec_Push(terms, (Obj*)Str_new_from_utf8(second, strlen(second)));
+    PhraseQuery *query = PhraseQuery_new(SSTR_WRAP_C("body"), terms);
+    uint32_t num_hits = S_num_hits(searcher, (Query*)query);
+    DECREF(query);
+    DECREF(terms);
+    return num_hits;
+}
+
+static bool
+S_doc_intact(IndexSearcher *searcher, int32_t i) {
+    String *id = Str_newf("id%i32", i);
+    TermQuery *query = TermQuery_new(SSTR_WRAP_C("id"), (Obj*)id);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    HitDoc *hit = Hits_Next(hits);
+    bool intact = false;
+    if (hit && Hits_Total_Hits(hits) == 1) {
+        String *body = S_body(i);
+        Obj *stored = HitDoc_Extract(hit, SSTR_WRAP_C("body"));
+        intact = stored && Str_Equals(body, stored);
+        DECREF(stored);
+        DECREF(body);
+    }
+    DECREF(hit);
+    DECREF(hits);
+    DECREF(query);
+    DECREF(id);
+    return intact;
 }
 
+static void
+test_merge(TestBatchRunner *runner) {
+    Schema       *schema  = S_create_schema();
+    RAMFolder    *folder  = RAMFolder_new(NULL);
+    IndexManager *manager = IxManager_new(NULL, NULL);
+
+    for (int32_t session = 0; session < 2; session++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, session * DOCS_PER_SESSION);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
 
+    // Third session: delete some docs and flush runs to temp files.
+    IxManager_Set_Mem_Budget(manager, 0x1000);
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    for (int32_t i = 0; i < 2 * DOCS_PER_SESSION; i += 10) {
+        String *id = Str_newf("id%i32", i);
+        Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"), (Obj*)id);
+        DECREF(id);
+    }
+    S_add_docs(indexer, 2 * DOCS_PER_SESSION);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    // Pure merge: every posting comes from an existing segment.
+    indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    TEST_INT_EQ(runner, Vec_Get_Size(PolyReader_Seg_Readers(reader)), 1,
+                "Optimized to one segment");
+    DECREF(reader);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "common"), 280,
+                "Deleted docs dropped from merged postings");
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "w0"), 40,
+                "Postings for term with deletions");
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "w3"), 60,
+                "Postings for term without deletions");
+    TEST_INT_EQ(runner, S_term_hits(searcher, "id", "id10"), 0,
+                "Deleted doc gone");
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "tail250"), 1,
+                "Postings from flushed runs");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "beta", "gamma"), 280,
+                "Positions copied intact");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "gamma", "beta"), 0,
+                "Positions keep their order");
+    TEST_TRUE(runner,
+              S_doc_intact(searcher, 17) && S_doc_intact(searcher, 123)
+              && S_doc_intact(searcher, 299),
+              "Remapped doc ids point at the right docs");
+    DECREF(searcher);
+
+    DECREF(manager);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_mixed_runs(TestBatchRunner *runner) {
+    Schema       *schema  = S_create_schema();
+    RAMFolder    *folder  = RAMFolder_new(NULL);
+    RAMFolder    *other   = RAMFolder_new(NULL);
+    IndexManager *manager = IxManager_new(NULL, NULL);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)other, NULL, 0);
+    S_add_docs(indexer, 1000);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    // Docs still buffered when the other index is absorbed get lower doc
+    // ids than its segment, but land in a run flushed after it.
+    IxManager_Set_Mem_Budget(manager, 0x2000);
+    indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    S_add_docs(indexer, 0);
+    Indexer_Add_Index(indexer, (Obj*)other);
+    Doc *doc = Doc_new(NULL, 0);
+    CharBuf *buf = CB_new(0);
+    for (int32_t i = 0; i < 5000; i++) {
+        CB_Cat_Trusted_Utf8(buf, "common beta gamma ", 18);
+    }
+    String *body = CB_Yield_String(buf);
+    Doc_Store(doc, SSTR_WRAP_C("body"), (Obj*)body);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("big"));
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    Indexer_Commit(indexer);
+    DECREF(body);
+    DECREF(buf);
+    DECREF(doc);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "common"),
+                2 * DOCS_PER_SESSION + 1,
+                "Mixed runs: every doc in merged postings");
+    TEST_INT_EQ(runner, S_term_hits(searcher, "body", "w2"),
+                2 * DOCS_PER_SESSION / 5,
+                "Mixed runs: postings from both sources");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "beta", "gamma"),
+                2 * DOCS_PER_SESSION + 1,
+                "Mixed runs: positions intact");
+    TEST_TRUE(runner,
+              S_doc_intact(searcher, 3) && S_doc_intact(searcher, 99)
+              && S_doc_intact(searcher, 1000) && S_doc_intact(searcher, 1099),
+              "Mixed runs: doc ids point at the right docs");
+    DECREF(searcher);
+
+    DECREF(manager);
+    DECREF(other);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestPListWriter_Run_IMP(TestPostingListWriter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 13);
+    test_merge(runner);
+    test_mixed_runs(runner);
+}
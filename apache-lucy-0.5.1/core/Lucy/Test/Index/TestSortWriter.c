@@ -26,6 +26,7 @@
 #include "Lucy/Index/DocReader.h"
 #include "Lucy/Index/Indexer.h"
 #include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/MemoryBudget.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
@@ -280,11 +281,13 @@ TestSortWriter_Run_IMP(TestSortWriter *self, TestBatchRunner *runner) {
     TestBatchRunner_Plan(runner, (TestBatch*)self, 57);
 
     // Force frequent flushes.
+    MemBudget_set_default_limit(100);
     SortWriter_set_default_mem_thresh(100);
 
     S_init_strings();
     test_sort_writer(runner);
     S_destroy_strings();
+    MemBudget_set_default_limit(0x1400000);
 }
 
 NonMergingIndexManager*
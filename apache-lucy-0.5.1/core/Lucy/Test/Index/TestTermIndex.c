@@ -0,0 +1,179 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTTERMINDEX
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestTermIndex.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/TermIndex.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/RAMFolder.h"
+
+// Enough terms for the lexicon index to span several front-coded blocks.
+#define NUM_TERMS 5000
+
+TestTermIndex*
+TestTermIx_new() {
+    return (TestTermIndex*)Class_Make_Obj(TESTTERMINDEX);
+}
+
+static void
+S_add_terms(RAMFolder *folder, const char *prefix, int32_t num_terms) {
+    Schema *schema = Schema_new();
+    StringType *type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)type);
+    DECREF(type);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < num_terms; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *id = Str_newf("%s%i32", prefix, 10000 + i);
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+}
+
+static LexiconReader*
+S_lex_reader(IndexReader *reader) {
+    return (LexiconReader*)IxReader_Obtain(reader,
+                                           Class_Get_Name(LEXICONREADER));
+}
+
+static int32_t
+S_count_terms(Lexicon *lexicon) {
+    int32_t count = 0;
+    while (Lex_Next(lexicon)) { count++; }
+    return count;
+}
+
+static bool
+S_term_is(Lexicon *lexicon, const char *expected) {
+    Obj *term = Lex_Get_Term(lexicon);
+    return term && Str_Equals_Utf8((String*)term, expected, strlen(expected));
+}
+
+static void
+test_lookup(TestBatchRunner *runner, PolyReader *reader) {
+    SegReader *seg_reader
+        = (SegReader*)Vec_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    TermIndex *term_index
+        = TermIx_new(PolyReader_Get_Schema(reader),
+                     PolyReader_Get_Folder(reader),
+                     SegReader_Get_Segment(seg_reader), SSTR_WRAP_C("id"));
+    TEST_INT_EQ(runner, TermIx_Get_Size(term_index), (NUM_TERMS + 127) / 128,
+                "One entry per index interval");
+    TEST_TRUE(runner, TermIx_Get_Bytes(term_index) > 0, "Get_Bytes");
+    DECREF(term_index);
+
+    LexiconReader *lex_reader = S_lex_reader((IndexReader*)seg_reader);
+    Lexicon *lexicon = LexReader_Lexicon(lex_reader, SSTR_WRAP_C("id"), NULL);
+    bool all_found = true;
+    for (int32_t i = 0; i < NUM_TERMS; i++) {
+        String *id = Str_newf("t%i32", 10000 + i);
+        Lex_Seek(lexicon, (Obj*)id);
+        Obj *found = Lex_Get_Term(lexicon);
+        if (!found || !Str_Equals(id, found)
+            || LexReader_Doc_Freq(lex_reader, SSTR_WRAP_C("id"), (Obj*)id)
+               != 1
+           ) {
+            all_found = false;
+        }
+        DECREF(id);
+    }
+    TEST_TRUE(runner, all_found, "Every term found");
+
+    Lex_Seek(lexicon, (Obj*)SSTR_WRAP_C("a"));
+    TEST_TRUE(runner, S_term_is(lexicon, "t10000"),
+              "Seek before first term lands on first term");
+    Lex_Seek(lexicon, (Obj*)SSTR_WRAP_C("t12345x"));
+    TEST_TRUE(runner, S_term_is(lexicon, "t12346"),
+              "Seek between terms lands on the next one");
+    TEST_INT_EQ(runner,
+                LexReader_Doc_Freq(lex_reader, SSTR_WRAP_C("id"),
+                                   (Obj*)SSTR_WRAP_C("t12345x")),
+                0, "Missing term has no doc freq");
+    DECREF(lexicon);
+}
+
+static void
+test_bounds(TestBatchRunner *runner, PolyReader *reader, bool poly) {
+    IndexReader *ix_reader
+        = poly
+          ? (IndexReader*)reader
+          : (IndexReader*)Vec_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    LexiconReader *lex_reader = S_lex_reader(ix_reader);
+    Lexicon *lexicon = LexReader_Lexicon(lex_reader, SSTR_WRAP_C("id"), NULL);
+    const char *label = poly ? "multi-segment" : "single segment";
+
+    Lex_Seek_Prefix(lexicon, SSTR_WRAP_C("t123"));
+    bool first_ok = S_term_is(lexicon, "t12300");
+    TEST_TRUE(runner, first_ok && S_count_terms(lexicon) == 99,
+              "Seek_Prefix (%s)", label);
+
+    Lex_Seek_Prefix(lexicon, SSTR_WRAP_C("t2"));
+    TEST_FALSE(runner, Lex_Next(lexicon), "Seek_Prefix with no match (%s)",
+               label);
+
+    Lex_Seek_Range(lexicon, (Obj*)SSTR_WRAP_C("t10100"),
+                   (Obj*)SSTR_WRAP_C("t10200"), false);
+    TEST_INT_EQ(runner, S_count_terms(lexicon), 99,
+                "Seek_Range excluding upper (%s)", label);
+    Lex_Seek_Range(lexicon, (Obj*)SSTR_WRAP_C("t10100"),
+                   (Obj*)SSTR_WRAP_C("t10200"), true);
+    TEST_INT_EQ(runner, S_count_terms(lexicon), 100,
+                "Seek_Range including upper (%s)", label);
+
+    Lex_Seek(lexicon, (Obj*)SSTR_WRAP_C("t14990"));
+    TEST_INT_EQ(runner, S_count_terms(lexicon), poly ? 109 : 9,
+                "Seek lifts bounds (%s)", label);
+    DECREF(lexicon);
+}
+
+void
+TestTermIx_Run_IMP(TestTermIndex *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 16);
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_terms(folder, "t", NUM_TERMS);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    test_lookup(runner, reader);
+    test_bounds(runner, reader, false);
+    DECREF(reader);
+
+    S_add_terms(folder, "u", 100);
+    reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    test_bounds(runner, reader, true);
+    DECREF(reader);
+
+    DECREF(folder);
+}
+
+
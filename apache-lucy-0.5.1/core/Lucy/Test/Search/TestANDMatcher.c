@@ -0,0 +1,132 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestANDMatcher.h"
+#include "Lucy/Search/ANDMatcher.h"
+#include "LucyX/Search/MockMatcher.h"
+
+#define DOC_MAX 200
+
+TestANDMatcher*
+TestANDMatcher_new() {
+    return (TestANDMatcher*)Class_Make_Obj(TESTANDMATCHER);
+}
+
+// Return the doc ids below DOC_MAX which are multiples of `interval`.
+static I32Array*
+S_modulo_set(int32_t interval) {
+    int32_t *doc_ids = (int32_t*)MALLOCATE(DOC_MAX * sizeof(int32_t));
+    size_t   count   = 0;
+    for (int32_t doc_id = 1; doc_id < DOC_MAX; doc_id++) {
+        if (doc_id % interval == 0) { doc_ids[count++] = doc_id; }
+    }
+    return I32Arr_new_steal(doc_ids, count);
+}
+
+static ANDMatcher*
+S_make_and_matcher(int32_t *intervals, size_t num_intervals) {
+    Vector *children = Vec_new(num_intervals);
+    for (size_t i = 0; i < num_intervals; i++) {
+        I32Array *doc_ids = S_modulo_set(intervals[i]);
+        Vec_Push(children, (Obj*)MockMatcher_new(doc_ids, NULL));
+        DECREF(doc_ids);
+    }
+    ANDMatcher *and_matcher = ANDMatcher_new(children, NULL);
+    DECREF(children);
+    return and_matcher;
+}
+
+static bool
+S_is_match(int32_t doc_id, int32_t *intervals, size_t num_intervals) {
+    for (size_t i = 0; i < num_intervals; i++) {
+        if (doc_id % intervals[i] != 0) { return false; }
+    }
+    return true;
+}
+
+static int32_t
+S_expected_advance(int32_t target, int32_t *intervals, size_t num_intervals) {
+    for (int32_t doc_id = target; doc_id < DOC_MAX; doc_id++) {
+        if (S_is_match(doc_id, intervals, num_intervals)) { return doc_id; }
+    }
+    return 0;
+}
+
+static void
+S_check_matcher(TestBatchRunner *runner, int32_t *intervals,
+                size_t num_intervals) {
+    ANDMatcher *and_matcher = S_make_and_matcher(intervals, num_intervals);
+    int32_t expected = 0;
+    int32_t got      = 0;
+    do {
+        expected = S_expected_advance(expected + 1, intervals,
+                                      num_intervals);
+        got = ANDMatcher_Next(and_matcher);
+    } while (got == expected && got != 0);
+    TEST_INT_EQ(runner, got, expected, "Next %d %d %d", intervals[0],
+                intervals[1], num_intervals > 2 ? intervals[2] : 0);
+    DECREF(and_matcher);
+
+    and_matcher = S_make_and_matcher(intervals, num_intervals);
+    int32_t target = 1;
+    do {
+        expected = S_expected_advance(target, intervals, num_intervals);
+        got = ANDMatcher_Advance(and_matcher, target);
+        target = got + 7;
+    } while (got == expected && got != 0);
+    TEST_INT_EQ(runner, got, expected, "Advance %d %d %d", intervals[0],
+                intervals[1], num_intervals > 2 ? intervals[2] : 0);
+    DECREF(and_matcher);
+}
+
+static void
+test_intersection(TestBatchRunner *runner) {
+    for (int32_t a = 1; a <= 6; a++) {
+        for (int32_t b = 2; b <= 4; b++) {
+            int32_t pair[2]          = { a, b };
+            int32_t rare_last[3]     = { a, b, 11 };
+            int32_t rare_first[3]    = { 11, b, a };
+            S_check_matcher(runner, pair, 2);
+            S_check_matcher(runner, rare_last, 3);
+            S_check_matcher(runner, rare_first, 3);
+        }
+    }
+}
+
+static void
+test_Estimate_Cost(TestBatchRunner *runner) {
+    int32_t intervals[3] = { 2, 13, 5 };
+    ANDMatcher *and_matcher = S_make_and_matcher(intervals, 3);
+    I32Array *rarest = S_modulo_set(13);
+    TEST_INT_EQ(runner, ANDMatcher_Estimate_Cost(and_matcher),
+                I32Arr_Get_Size(rarest),
+                "Estimate_Cost is the cost of the cheapest child");
+    DECREF(rarest);
+    DECREF(and_matcher);
+}
+
+void
+TestANDMatcher_Run_IMP(TestANDMatcher *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 109);
+    test_intersection(runner);
+    test_Estimate_Cost(runner);
+}
+
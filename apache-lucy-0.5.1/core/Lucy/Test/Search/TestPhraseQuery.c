@@ -23,7 +23,21 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/TestUtils.h"
 #include "Lucy/Test/Search/TestPhraseQuery.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
+#include "Lucy/Analysis/ShingleFilter.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/Matcher.h"
 #include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Store/RAMFolder.h"
 #include "Lucy/Util/Freezer.h"
 
 TestPhraseQuery*
@@ -44,10 +58,158 @@ test_Dump_And_Load(TestBatchRunner *runner) {
     DECREF(twin);
 }
 
+static Schema*
+S_create_shingle_schema() {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType_Set_Shingle_Field(type, SSTR_WRAP_C("content_shingles"));
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+
+    Vector *analyzers = Vec_new(2);
+    Vec_Push(analyzers, INCREF(tokenizer));
+    Vec_Push(analyzers, (Obj*)ShingleFilter_new());
+    PolyAnalyzer *shingler = PolyAnalyzer_new(NULL, analyzers);
+    FullTextType *shingle_type = FullTextType_new((Analyzer*)shingler);
+    FullTextType_Set_Stored(shingle_type, false);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content_shingles"),
+                      (FieldType*)shingle_type);
+
+    DECREF(shingle_type);
+    DECREF(shingler);
+    DECREF(analyzers);
+    DECREF(type);
+    DECREF(tokenizer);
+    return schema;
+}
+
+static uint32_t
+S_phrase_hits(IndexSearcher *searcher, const char *a, const char *b,
+              const char *c) {
+    PhraseQuery *query
+        = TestUtils_make_phrase_query("content", a, b, c, NULL);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t total = Hits_Total_Hits(hits);
+    DECREF(hits);
+    DECREF(query);
+    return total;
+}
+
+static void
+test_shingles(TestBatchRunner *runner) {
+    Schema    *schema  = S_create_shingle_schema();
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    const char *docs[] = {
+        "rio de janeiro",
+        "de rio janeiro",
+        "o rio de janeiro e sao paulo",
+        "sao paulo",
+        NULL
+    };
+    for (uint32_t i = 0; docs[i] != NULL; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        Doc_Store(doc, SSTR_WRAP_C("content"),
+                  (Obj*)SSTR_WRAP_C(docs[i]));
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "rio", "de", "janeiro"), 2,
+                "three-word phrase");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "sao", "paulo", NULL), 2,
+                "two-word phrase");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "janeiro", "rio", NULL), 0,
+                "words out of order");
+    TEST_INT_EQ(runner, S_phrase_hits(searcher, "rio", NULL, NULL), 3,
+                "single-word phrase");
+
+    // "rio", "de" and "janeiro" each occur in three docs, but the shingles
+    // "rio de" and "de janeiro" in only two.
+    PhraseQuery *query
+        = TestUtils_make_phrase_query("content", "rio", "de", "janeiro",
+                                      NULL);
+    Compiler *compiler
+        = PhraseQuery_Make_Compiler(query, (Searcher*)searcher, 1.0f, false);
+    IndexReader *reader = IxSearcher_Get_Reader(searcher);
+    Vector *seg_readers = IxReader_Seg_Readers(reader);
+    SegReader *seg_reader = (SegReader*)Vec_Fetch(seg_readers, 0);
+    Matcher *matcher = Compiler_Make_Matcher(compiler, seg_reader, true);
+    TEST_INT_EQ(runner, Matcher_Estimate_Cost(matcher), 2,
+                "phrase matched against shingles");
+    DECREF(matcher);
+    DECREF(seg_readers);
+    DECREF(compiler);
+    DECREF(query);
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_shingle_field_Dump_And_Load(TestBatchRunner *runner) {
+    Schema    *schema = S_create_shingle_schema();
+    FieldType *type   = Schema_Fetch_Type(schema, SSTR_WRAP_C("content"));
+    Obj       *dump   = (Obj*)FType_Dump(type);
+    FieldType *clone  = (FieldType*)FType_Load(type, dump);
+    TEST_TRUE(runner, FType_Equals(type, (Obj*)clone)
+              && Str_Equals_Utf8(
+                     FullTextType_Get_Shingle_Field((FullTextType*)clone),
+                     "content_shingles", 16),
+              "shingle_field survives Dump => Load");
+    DECREF(clone);
+    DECREF(dump);
+    DECREF(schema);
+}
+
+static void
+S_add_doc(void *context) {
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)SSTR_WRAP_C("a b c"));
+    Indexer_Add_Doc((Indexer*)context, doc, 1.0f);
+    DECREF(doc);
+}
+
+static void
+test_misconfigured_shingle_field(TestBatchRunner *runner) {
+    Schema            *schema    = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType      *type      = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType_Set_Shingle_Field(type, SSTR_WRAP_C("content_shingles"));
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+    FullTextType *shingle_type = FullTextType_new((Analyzer*)tokenizer);
+    FullTextType_Set_Stored(shingle_type, false);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content_shingles"),
+                      (FieldType*)shingle_type);
+
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    Err *error = Err_trap(S_add_doc, indexer);
+    TEST_TRUE(runner,
+              error && Str_Contains_Utf8(Err_Get_Mess(error),
+                                         "ShingleFilter", 13),
+              "Shingle field without a ShingleFilter is rejected");
+
+    DECREF(error);
+    DECREF(indexer);
+    DECREF(folder);
+    DECREF(shingle_type);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
 void
 TestPhraseQuery_Run_IMP(TestPhraseQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 8);
     test_Dump_And_Load(runner);
+    test_shingles(runner);
+    test_shingle_field_Dump_And_Load(runner);
+    test_misconfigured_shingle_field(runner);
 }
 
 
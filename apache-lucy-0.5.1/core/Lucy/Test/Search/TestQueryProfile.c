@@ -0,0 +1,194 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestQueryProfile.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/ANDQuery.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/QueryProfile.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TopDocs.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestQueryProfile*
+TestQueryProfile_new() {
+    return (TestQueryProfile*)Class_Make_Obj(TESTQUERYPROFILE);
+}
+
+static Folder*
+S_create_index() {
+    static const char *const texts[] = {
+        "a b c", "a b", "a c", "b c", "a b d", "d e"
+    };
+    Schema *schema = Schema_new();
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType *type = FullTextType_new((Analyzer*)tokenizer);
+    String *field = SSTR_WRAP_C("content");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        Doc_Store(doc, field, (Obj*)SSTR_WRAP_C(texts[i]));
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+
+    DECREF(indexer);
+    DECREF(type);
+    DECREF(tokenizer);
+    DECREF(schema);
+    return (Folder*)folder;
+}
+
+static Query*
+S_make_and_query() {
+    String    *field = SSTR_WRAP_C("content");
+    Vector    *children = Vec_new(2);
+    Vec_Push(children, (Obj*)TermQuery_new(field, (Obj*)SSTR_WRAP_C("a")));
+    Vec_Push(children, (Obj*)TermQuery_new(field, (Obj*)SSTR_WRAP_C("b")));
+    ANDQuery *query = ANDQuery_new(children);
+    DECREF(children);
+    return (Query*)query;
+}
+
+static void
+test_profile(TestBatchRunner *runner) {
+    Folder        *folder   = S_create_index();
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    Query         *query    = S_make_and_query();
+
+    TopDocs *plain    = IxSearcher_Top_Docs(searcher, query, 10, NULL);
+    TopDocs *profiled = IxSearcher_Profile_Top_Docs(searcher, query, 10,
+                                                    NULL);
+    TEST_INT_EQ(runner, TopDocs_Get_Total_Hits(profiled),
+                TopDocs_Get_Total_Hits(plain),
+                "Profiling doesn't change the result");
+    TEST_TRUE(runner, TopDocs_Get_Profile(plain) == NULL,
+              "Top_Docs doesn't attach a profile");
+
+    QueryProfile *root = TopDocs_Get_Profile(profiled);
+    TEST_TRUE(runner, root != NULL, "Profile_Top_Docs attaches a profile");
+    TEST_TRUE(runner,
+              Str_Equals_Utf8(QueryProfile_Get_Name(root), "IndexSearcher",
+                              13),
+              "Root node name");
+    TEST_INT_EQ(runner, QueryProfile_Get_Docs_Matched(root), 3,
+                "Root docs matched equals total hits");
+
+    Vector *children = QueryProfile_Get_Children(root);
+    TEST_INT_EQ(runner, Vec_Get_Size(children), 1, "Root has one child");
+    QueryProfile *and_prof = (QueryProfile*)Vec_Fetch(children, 0);
+    TEST_INT_EQ(runner, QueryProfile_Get_Num_Matchers(and_prof), 1,
+                "One ANDMatcher for one segment");
+    TEST_INT_EQ(runner, QueryProfile_Get_Docs_Matched(and_prof), 3,
+                "ANDMatcher docs matched");
+    TEST_TRUE(runner,
+              QueryProfile_Get_Next_Calls(and_prof)
+              + QueryProfile_Get_Advance_Calls(and_prof) > 0,
+              "ANDMatcher iteration calls counted");
+
+    Vector *leaves = QueryProfile_Get_Children(and_prof);
+    TEST_INT_EQ(runner, Vec_Get_Size(leaves), 2,
+                "ANDQuery node has a child per clause");
+    QueryProfile *leaf = (QueryProfile*)Vec_Fetch(leaves, 0);
+    TEST_INT_EQ(runner, QueryProfile_Get_Postings_Decoded(leaf), 4,
+                "TermMatcher postings decoded");
+    TEST_TRUE(runner, QueryProfile_Get_Bytes_Read(leaf) > 0,
+              "TermMatcher bytes read");
+    TEST_TRUE(runner,
+              QueryProfile_Get_Run_Nanos(root)
+              >= QueryProfile_Get_Run_Nanos(and_prof),
+              "Root run time covers children");
+
+    Hash *dump = QueryProfile_Dump(root);
+    Vector *dumped_children
+        = (Vector*)Hash_Fetch_Utf8(dump, "children", 8);
+    TEST_TRUE(runner,
+              dumped_children != NULL
+              && Vec_Get_Size(dumped_children) == 1,
+              "Dump nests children");
+    String *string = QueryProfile_To_String(root);
+    TEST_TRUE(runner, Str_Contains_Utf8(string, "TermCompiler", 12),
+              "To_String renders leaf nodes");
+
+    DECREF(string);
+    DECREF(dump);
+    DECREF(profiled);
+    DECREF(plain);
+    DECREF(query);
+    DECREF(searcher);
+    DECREF(folder);
+}
+
+static int64_t
+S_and_docs_matched(TopDocs *top_docs) {
+    Vector *children = QueryProfile_Get_Children(TopDocs_Get_Profile(top_docs));
+    QueryProfile *and_prof = (QueryProfile*)Vec_Fetch(children, 0);
+    return (int64_t)QueryProfile_Get_Docs_Matched(and_prof);
+}
+
+static void
+test_compiler(TestBatchRunner *runner) {
+    Folder        *folder   = S_create_index();
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    Query         *query    = S_make_and_query();
+    Compiler      *compiler = Query_Make_Compiler(query, (Searcher*)searcher,
+                                                  Query_Get_Boost(query),
+                                                  false);
+
+    TopDocs *first = IxSearcher_Profile_Top_Docs(searcher, (Query*)compiler,
+                                                 10, NULL);
+    TEST_TRUE(runner, Compiler_Get_Profile(compiler) == NULL,
+              "Profiling a caller's Compiler leaves it unprofiled");
+    TopDocs *plain = IxSearcher_Top_Docs(searcher, (Query*)compiler, 10,
+                                         NULL);
+    TopDocs *second = IxSearcher_Profile_Top_Docs(searcher, (Query*)compiler,
+                                                  10, NULL);
+    TEST_TRUE(runner,
+              S_and_docs_matched(first) == 3
+              && S_and_docs_matched(second) == 3,
+              "Profiles of a reused Compiler don't accumulate");
+
+    DECREF(second);
+    DECREF(plain);
+    DECREF(first);
+    DECREF(compiler);
+    DECREF(query);
+    DECREF(searcher);
+    DECREF(folder);
+}
+
+void
+TestQueryProfile_Run_IMP(TestQueryProfile *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 17);
+    test_profile(runner);
+    test_compiler(runner);
+}
+
+
@@ -28,6 +28,7 @@
 #include "Lucy/Store/OutStream.h"
 #include "Lucy/Store/RAMFolder.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 static String *cfmeta_file = NULL;
 static String *cfmeta_temp = NULL;
@@ -79,7 +80,7 @@ S_folder_with_contents() {
     DECREF(foo_out);
     DECREF(bar_out);
     String *empty = SSTR_BLANK();
-    RAMFolder_Consolidate(folder, empty);
+    RAMFolder_Consolidate(folder, empty, false);
     return (Folder*)folder;
 }
 
@@ -111,7 +112,7 @@ test_open(TestBatchRunner *runner) {
 
     Err_set_error(NULL);
     real_folder = S_folder_with_contents();
-    metadata = (Hash*)Json_slurp_json(real_folder, cfmeta_file);
+    metadata = (Hash*)MetaFile_slurp(real_folder, cfmeta_file);
     Hash_Store_Utf8(metadata, "format", 6, (Obj*)Str_newf("%i32", -1));
     Folder_Delete(real_folder, cfmeta_file);
     Json_spew_json((Obj*)metadata, real_folder, cfmeta_file);
@@ -343,6 +344,23 @@ test_Local_Open_In(TestBatchRunner *runner) {
     DECREF(real_folder);
 }
 
+static void
+test_Local_File_Length(TestBatchRunner *runner) {
+    Folder *real_folder = S_folder_with_contents();
+    CompoundFileReader *cf_reader = CFReader_open(real_folder);
+
+    TEST_INT_EQ(runner, CFReader_Local_File_Length(cf_reader, foo), 3,
+                "Local_File_Length for virtual file");
+    TEST_INT_EQ(runner, CFReader_Local_File_Length(cf_reader, cfmeta_file),
+                Folder_Local_File_Length(real_folder, cfmeta_file),
+                "Local_File_Length pass-through for real file");
+    TEST_INT_EQ(runner, CFReader_Local_File_Length(cf_reader, stuff), 0,
+                "Local_File_Length for non-existent file");
+
+    DECREF(cf_reader);
+    DECREF(real_folder);
+}
+
 static void
 test_Close(TestBatchRunner *runner) {
     Folder *real_folder = S_folder_with_contents();
@@ -360,7 +378,7 @@ test_Close(TestBatchRunner *runner) {
 
 void
 TestCFReader_Run_IMP(TestCompoundFileReader *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 48);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 51);
     S_init_strings();
     test_open(runner);
     test_Local_MkDir_and_Find_Folder(runner);
@@ -368,6 +386,7 @@ TestCFReader_Run_IMP(TestCompoundFileReader *self, TestBatchRunner *runner) {
     test_Local_Open_Dir(runner);
     test_Local_Open_FileHandle(runner);
     test_Local_Open_In(runner);
+    test_Local_File_Length(runner);
     test_Close(runner);
     S_destroy_strings();
 }
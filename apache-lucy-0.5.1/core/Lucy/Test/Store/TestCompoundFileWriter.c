@@ -28,6 +28,7 @@
 #include "Lucy/Store/OutStream.h"
 #include "Lucy/Store/RAMFolder.h"
 #include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
 
 static String *cfmeta_file = NULL;
 static String *cfmeta_temp = NULL;
@@ -88,7 +89,7 @@ test_Consolidate(TestBatchRunner *runner) {
                                 FH_CREATE | FH_WRITE_ONLY | FH_EXCLUSIVE);
     DECREF(fh);
 
-    CompoundFileWriter *cf_writer = CFWriter_new(folder);
+    CompoundFileWriter *cf_writer = CFWriter_new(folder, false);
     CFWriter_Consolidate(cf_writer);
     PASS(runner, "Consolidate completes despite leftover files");
     DECREF(cf_writer);
@@ -108,14 +109,14 @@ test_Consolidate(TestBatchRunner *runner) {
 static void
 test_offsets(TestBatchRunner *runner) {
     Folder *folder = S_folder_with_contents();
-    CompoundFileWriter *cf_writer = CFWriter_new(folder);
+    CompoundFileWriter *cf_writer = CFWriter_new(folder, false);
     Hash    *cf_metadata;
     Hash    *files;
 
     CFWriter_Consolidate(cf_writer);
 
     cf_metadata = (Hash*)CERTIFY(
-                      Json_slurp_json(folder, cfmeta_file), HASH);
+                      MetaFile_slurp(folder, cfmeta_file), HASH);
     files = (Hash*)CERTIFY(
                 Hash_Fetch_Utf8(cf_metadata, "files", 5), HASH);
 
@@ -21,6 +21,8 @@
 #define TESTLUCY_USE_SHORT_NAMES
 #include "Lucy/Util/ToolSet.h"
 
+#include "charmony.h"
+
 #ifdef CHY_HAS_UNISTD_H
   #include <unistd.h> // close
 #elif defined(CHY_HAS_IO_H)
@@ -119,6 +121,10 @@ test_Read_Write(TestBatchRunner *runner) {
     TEST_TRUE(runner, FSFH_Length(fh) == INT64_C(3), "Length after Write");
     TEST_TRUE(runner, FSFH_Write(fh, bar, 3), "Write returns success");
     TEST_TRUE(runner, FSFH_Length(fh) == INT64_C(6), "Length after 2 Writes");
+    TEST_TRUE(runner, FSFH_Gather_Write(fh, foo, 3, bar, 3),
+              "Gather_Write returns success");
+    TEST_TRUE(runner, FSFH_Length(fh) == INT64_C(12),
+              "Length after Gather_Write");
 
     Err_set_error(NULL);
     TEST_FALSE(runner, FSFH_Read(fh, buf, 0, 2),
@@ -132,9 +138,10 @@ test_Read_Write(TestBatchRunner *runner) {
     Err_set_error(NULL);
     fh = FSFH_open(test_filename, FH_READ_ONLY);
 
-    TEST_TRUE(runner, FSFH_Length(fh) == INT64_C(6), "Length on Read");
-    TEST_TRUE(runner, FSFH_Read(fh, buf, 0, 6), "Read returns success");
-    TEST_TRUE(runner, strncmp(buf, "foobar", 6) == 0, "Read/Write");
+    TEST_TRUE(runner, FSFH_Length(fh) == INT64_C(12), "Length on Read");
+    TEST_TRUE(runner, FSFH_Read(fh, buf, 0, 12), "Read returns success");
+    TEST_TRUE(runner, strncmp(buf, "foobarfoobar", 12) == 0,
+              "Read/Write/Gather_Write");
     TEST_TRUE(runner, FSFH_Read(fh, buf, 2, 3), "Read returns success");
     TEST_TRUE(runner, strncmp(buf, "oba", 3) == 0, "Read with offset");
 
@@ -145,7 +152,7 @@ test_Read_Write(TestBatchRunner *runner) {
               "Read() with a negative offset sets error");
 
     Err_set_error(NULL);
-    TEST_FALSE(runner, FSFH_Read(fh, buf, 6, 1),
+    TEST_FALSE(runner, FSFH_Read(fh, buf, 12, 1),
                "Read() past EOF returns false");
     TEST_TRUE(runner, Err_get_error() != NULL,
               "Read() past EOF sets error");
@@ -247,13 +254,113 @@ test_Window(TestBatchRunner *runner) {
     remove(Str_Get_Ptr8(test_filename));
 }
 
+static void
+test_Advise_and_Touch(TestBatchRunner *runner) {
+    String *test_filename = SSTR_WRAP_C("_fstest");
+    FSFileHandle *fh;
+    char block[1024];
+
+    remove(Str_Get_Ptr8(test_filename));
+    fh = FSFH_open(test_filename,
+                   FH_CREATE | FH_WRITE_ONLY | FH_EXCLUSIVE);
+    memset(block, 'x', sizeof(block));
+    for (uint32_t i = 0; i < 100; i++) {
+        FSFH_Write(fh, block, sizeof(block));
+    }
+    TEST_TRUE(runner, FSFH_Advise(fh, 0, 1024, FH_ADVISE_WILLNEED),
+              "Advise() on write-only handle is a no-op");
+    if (!FSFH_Close(fh)) { RETHROW(INCREF(Err_get_error())); }
+
+    DECREF(fh);
+    fh = FSFH_open(test_filename, FH_READ_ONLY);
+    if (!fh) { RETHROW(INCREF(Err_get_error())); }
+
+    TEST_TRUE(runner, FSFH_Advise(fh, 1000, 50000, FH_ADVISE_RANDOM),
+              "Advise() with an unaligned offset");
+    TEST_TRUE(runner, FSFH_Advise(fh, 0, 102400, FH_ADVISE_WILLNEED),
+              "Advise() WILLNEED");
+    TEST_INT_EQ(runner, FSFH_Touch(fh, 0, 102400), 102400, "Touch()");
+    TEST_INT_EQ(runner, FSFH_Touch(fh, 100000, 5000), 2400,
+                "Touch() clamps to EOF");
+
+    if (FSFH_can_measure_residency()) {
+        TEST_INT_EQ(runner, FSFH_Resident_Bytes(fh, 1000, 100000), 100000,
+                    "Resident_Bytes() after Touch()");
+    }
+    else {
+        TEST_INT_EQ(runner, FSFH_Resident_Bytes(fh, 1000, 100000), -1,
+                    "Resident_Bytes() unknown without mincore()");
+    }
+
+    DECREF(fh);
+    remove(Str_Get_Ptr8(test_filename));
+}
+
+static void
+S_write_file(String *filename, const char *content) {
+    remove(Str_Get_Ptr8(filename));
+    FSFileHandle *fh = FSFH_open(filename,
+                                 FH_CREATE | FH_WRITE_ONLY | FH_EXCLUSIVE);
+    if (!fh) { RETHROW(INCREF(Err_get_error())); }
+    FSFH_Write(fh, content, strlen(content));
+    if (!FSFH_Close(fh)) { RETHROW(INCREF(Err_get_error())); }
+    DECREF(fh);
+}
+
+static void
+test_shared_maps(TestBatchRunner *runner) {
+#if CHY_SIZEOF_PTR == 8 && defined(CHY_HAS_SYS_MMAN_H)
+    String *test_filename = SSTR_WRAP_C("_fstest");
+    uint32_t num_maps = FSFH_num_shared_maps();
+    char buf[4];
+
+    S_write_file(test_filename, "foo ");
+    FSFileHandle *fh1 = FSFH_open(test_filename, FH_READ_ONLY);
+    FSFileHandle *fh2 = FSFH_open(test_filename, FH_READ_ONLY);
+    TEST_TRUE(runner, FSFH_IVARS(fh1)->buf == FSFH_IVARS(fh2)->buf,
+              "Handles on the same file share a mapping");
+    TEST_INT_EQ(runner, FSFH_num_shared_maps(), num_maps + 1,
+                "One mapping per file");
+    TEST_INT_EQ(runner, FSFH_IVARS(fh2)->fd, 0,
+                "No descriptor held once mapped");
+
+    // Replace the file while the old mapping is still in use.
+    S_write_file(test_filename, "bar ");
+    FSFileHandle *fh3 = FSFH_open(test_filename, FH_READ_ONLY);
+    TEST_TRUE(runner, FSFH_IVARS(fh3)->buf != FSFH_IVARS(fh1)->buf,
+              "Replaced file gets a fresh mapping");
+    FSFH_Read(fh3, buf, 0, 4);
+    TEST_TRUE(runner, strncmp(buf, "bar ", 4) == 0,
+              "Read from replaced file");
+    FSFH_Read(fh2, buf, 0, 4);
+    TEST_TRUE(runner, strncmp(buf, "foo ", 4) == 0,
+              "Old mapping still readable");
+
+    FSFH_Close(fh1);
+    FSFH_Read(fh2, buf, 0, 4);
+    TEST_TRUE(runner, strncmp(buf, "foo ", 4) == 0,
+              "Mapping survives until the last handle closes");
+    DECREF(fh1);
+    DECREF(fh2);
+    DECREF(fh3);
+    TEST_INT_EQ(runner, FSFH_num_shared_maps(), num_maps,
+                "Mappings released when all handles close");
+
+    remove(Str_Get_Ptr8(test_filename));
+#else
+    SKIP(runner, 8, "No shared mappings on this platform");
+#endif
+}
+
 void
 TestFSFH_Run_IMP(TestFSFileHandle *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 46);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 62);
     test_open(runner);
     test_Read_Write(runner);
     test_Close(runner);
     test_Window(runner);
+    test_Advise_and_Touch(runner);
+    test_shared_maps(runner);
 }
 
 
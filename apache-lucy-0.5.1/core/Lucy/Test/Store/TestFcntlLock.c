@@ -0,0 +1,294 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTFCNTLLOCK
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "charmony.h"
+
+#ifdef CHY_HAS_UNISTD_H
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+#ifdef CHY_HAS_SYS_TIME_H
+  #include <sys/time.h>
+#endif
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Store/TestFcntlLock.h"
+#include "Lucy/Store/FcntlLock.h"
+#include "Lucy/Store/FcntlLockFactory.h"
+#include "Lucy/Store/FSFolder.h"
+#include "Lucy/Store/Lock.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define TEST_DIR "_fcntllocktest"
+
+TestFcntlLock*
+TestFcntlLock_new() {
+    return (TestFcntlLock*)Class_Make_Obj(TESTFCNTLLOCK);
+}
+
+static FSFolder*
+S_set_up() {
+    FSFolder *folder = FSFolder_new(SSTR_WRAP_C(TEST_DIR));
+    FSFolder_Initialize(folder);
+    if (!FSFolder_Check(folder)) {
+        RETHROW(INCREF(Err_get_error()));
+    }
+    return folder;
+}
+
+static void
+S_tear_down(FSFolder *folder) {
+    FSFolder_Delete(folder, SSTR_WRAP_C("locks/foo.lock"));
+    FSFolder_Delete(folder, SSTR_WRAP_C("locks"));
+    DECREF(folder);
+    rmdir(TEST_DIR);
+}
+
+static void
+test_factory(TestBatchRunner *runner) {
+    FSFolder *folder = S_set_up();
+    String   *host   = SSTR_WRAP_C("somehost");
+    FcntlLockFactory *factory = FcntlLockFact_new((Folder*)folder, host);
+    Lock *lock = FcntlLockFact_Make_Lock(factory, SSTR_WRAP_C("foo"), 0, 100);
+    TEST_TRUE(runner, Lock_is_a(lock, FCNTLLOCK),
+              "Make_Lock makes an FcntlLock for an FSFolder");
+    DECREF(lock);
+    lock = FcntlLockFact_Make_Shared_Lock(factory, SSTR_WRAP_C("foo"), 0, 100);
+    TEST_FALSE(runner, Lock_is_a(lock, FCNTLLOCK),
+               "Make_Shared_Lock makes a SharedLock");
+    DECREF(lock);
+    DECREF(factory);
+
+    RAMFolder *ram_folder = RAMFolder_new(NULL);
+    factory = FcntlLockFact_new((Folder*)ram_folder, host);
+    lock = FcntlLockFact_Make_Lock(factory, SSTR_WRAP_C("foo"), 0, 100);
+    TEST_TRUE(runner, Lock_is_a(lock, LOCKFILELOCK),
+              "Make_Lock falls back to LockFileLock for a RAMFolder");
+    DECREF(lock);
+    DECREF(factory);
+    DECREF(ram_folder);
+    S_tear_down(folder);
+}
+
+static void
+test_in_process(TestBatchRunner *runner) {
+    FSFolder *folder = S_set_up();
+    String   *host   = SSTR_WRAP_C("somehost");
+    String   *name   = SSTR_WRAP_C("foo");
+    String   *path   = SSTR_WRAP_C("locks/foo.lock");
+    FcntlLock *lock1 = FcntlLock_new((Folder*)folder, name, host, 0, 100);
+    FcntlLock *lock2 = FcntlLock_new((Folder*)folder, name, host, 50, 10);
+
+    TEST_FALSE(runner, FcntlLock_Is_Locked(lock2), "Not locked initially");
+    TEST_TRUE(runner, FcntlLock_Obtain(lock1), "Obtain");
+    TEST_TRUE(runner, FSFolder_Exists(folder, path), "Lock file exists");
+    TEST_TRUE(runner, FcntlLock_Is_Locked(lock2),
+              "Is_Locked sees holder in same process");
+    TEST_FALSE(runner, FcntlLock_Request(lock2),
+               "Request fails while held in same process");
+    TEST_FALSE(runner, FcntlLock_Obtain(lock2),
+               "Obtain times out while held in same process");
+    TEST_TRUE(runner, Obj_is_a((Obj*)Err_get_error(), LOCKERR),
+              "Failure sets a LockErr");
+
+    LockFileLock *lf_lock = LFLock_new((Folder*)folder, name, host, 0, 100);
+    TEST_FALSE(runner, LFLock_Request(lf_lock),
+               "LockFileLock can't take a held FcntlLock");
+    DECREF(lf_lock);
+
+    FcntlLock_Release(lock1);
+    TEST_FALSE(runner, FSFolder_Exists(folder, path),
+               "Release deletes lock file");
+    TEST_FALSE(runner, FcntlLock_Is_Locked(lock2), "Released");
+    TEST_TRUE(runner, FcntlLock_Obtain(lock2), "Obtain after Release");
+    FcntlLock_Release(lock2);
+
+    lf_lock = LFLock_new((Folder*)folder, name, host, 0, 100);
+    LFLock_Obtain(lf_lock);
+    TEST_FALSE(runner, FcntlLock_Request(lock1),
+               "FcntlLock honors a LockFileLock held by a live process");
+    LFLock_Release(lf_lock);
+    DECREF(lf_lock);
+
+    // A leftover empty lock file is stale.
+    OutStream *outstream = FSFolder_Open_Out(folder, path);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    TEST_FALSE(runner, FcntlLock_Is_Locked(lock1),
+               "Empty lock file isn't locked");
+    FcntlLock_Clear_Stale(lock1);
+    TEST_FALSE(runner, FSFolder_Exists(folder, path),
+               "Clear_Stale deletes stale lock file");
+
+    DECREF(lock1);
+    DECREF(lock2);
+    S_tear_down(folder);
+}
+
+static void
+test_cross_process(TestBatchRunner *runner) {
+#ifdef CHY_HAS_UNISTD_H
+    FSFolder *folder = S_set_up();
+    String   *host   = SSTR_WRAP_C("somehost");
+    String   *name   = SSTR_WRAP_C("foo");
+    FcntlLock *lock  = FcntlLock_new((Folder*)folder, name, host, 5000, 100);
+    int pipe_fds[2];
+    char byte;
+
+    // Child holds the lock briefly, then releases it.
+    if (pipe(pipe_fds) != 0) { THROW(ERR, "pipe failed"); }
+    pid_t pid = fork();
+    if (pid == 0) {
+        FcntlLock *child_lock = FcntlLock_new((Folder*)folder, name, host,
+                                              0, 100);
+        bool got = FcntlLock_Obtain(child_lock);
+        if (write(pipe_fds[1], "x", 1) != 1) { got = false; }
+        usleep(100000);
+        FcntlLock_Release(child_lock);
+        _exit(got ? 0 : 1);
+    }
+    if (read(pipe_fds[0], &byte, 1) != 1) { THROW(ERR, "read failed"); }
+    TEST_TRUE(runner, FcntlLock_Is_Locked(lock),
+              "Is_Locked sees holder in other process");
+    TEST_TRUE(runner, FcntlLock_Obtain(lock),
+              "Obtain waits for other process to release");
+    FcntlLock_Release(lock);
+    int status;
+    waitpid(pid, &status, 0);
+
+    // Child dies while holding the lock.
+    pid = fork();
+    if (pid == 0) {
+        FcntlLock *child_lock = FcntlLock_new((Folder*)folder, name, host,
+                                              0, 100);
+        _exit(FcntlLock_Obtain(child_lock) ? 0 : 1);
+    }
+    waitpid(pid, &status, 0);
+    TEST_TRUE(runner, WIFEXITED(status) && WEXITSTATUS(status) == 0,
+              "Child obtained lock and exited without releasing it");
+    TEST_FALSE(runner, FcntlLock_Is_Locked(lock),
+               "Lock of a dead process isn't held");
+    TEST_TRUE(runner, FcntlLock_Request(lock),
+              "Lock of a dead process can be taken over");
+    FcntlLock_Release(lock);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    DECREF(lock);
+    S_tear_down(folder);
+#else
+    SKIP(runner, 5, "No fork()");
+#endif
+}
+
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_SYS_TIME_H)
+static uint64_t
+S_millis_since(struct timeval *start) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000
+           + (uint64_t)(now.tv_usec / 1000) - (uint64_t)(start->tv_usec / 1000);
+}
+
+// Fork a child which holds the lock for `millis` and return once it has
+// the lock.
+static pid_t
+S_fork_holder(FSFolder *folder, String *name, uint32_t millis) {
+    int pipe_fds[2];
+    char byte;
+    if (pipe(pipe_fds) != 0) { THROW(ERR, "pipe failed"); }
+    pid_t pid = fork();
+    if (pid == 0) {
+        FcntlLock *child_lock = FcntlLock_new((Folder*)folder, name,
+                                              SSTR_WRAP_C("somehost"), 0,
+                                              100);
+        bool got = FcntlLock_Obtain(child_lock);
+        if (write(pipe_fds[1], "x", 1) != 1) { got = false; }
+        usleep(millis * 1000);
+        FcntlLock_Release(child_lock);
+        _exit(got ? 0 : 1);
+    }
+    if (read(pipe_fds[0], &byte, 1) != 1) { THROW(ERR, "read failed"); }
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return pid;
+}
+#endif
+
+static void
+test_blocking_wait(TestBatchRunner *runner) {
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_SYS_TIME_H)
+    FSFolder *folder = S_set_up();
+    String   *host   = SSTR_WRAP_C("somehost");
+    String   *name   = SSTR_WRAP_C("foo");
+    struct timeval start;
+    int status;
+
+    // With a long poll interval, only a blocking wait wakes up promptly.
+    FcntlLock *lock = FcntlLock_new((Folder*)folder, name, host, 5000, 5000);
+    pid_t pid = S_fork_holder(folder, name, 600);
+    gettimeofday(&start, NULL);
+    bool got = FcntlLock_Obtain(lock);
+    uint64_t elapsed = S_millis_since(&start);
+    TEST_TRUE(runner, got && elapsed < 900,
+              "Obtain wakes as soon as other process releases");
+    FcntlLock_Release(lock);
+    waitpid(pid, &status, 0);
+    DECREF(lock);
+
+    lock = FcntlLock_new((Folder*)folder, name, host, 200, 100);
+    pid = S_fork_holder(folder, name, 1000);
+    gettimeofday(&start, NULL);
+    got = FcntlLock_Obtain(lock);
+    elapsed = S_millis_since(&start);
+    TEST_TRUE(runner, !got && elapsed >= 190 && elapsed < 900,
+              "Blocking wait gives up at timeout");
+    waitpid(pid, &status, 0);
+
+    // The abandoned wait hands its claim back once the holder is gone.
+    FcntlLock *other = FcntlLock_new((Folder*)folder, name, host, 5000, 100);
+    TEST_TRUE(runner, FcntlLock_Obtain(other),
+              "Obtain after an abandoned wait");
+    FcntlLock_Release(other);
+    DECREF(other);
+    DECREF(lock);
+    S_tear_down(folder);
+#else
+    SKIP(runner, 3, "No fork()");
+#endif
+}
+
+void
+TestFcntlLock_Run_IMP(TestFcntlLock *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 25);
+    if (!FcntlLock_available()) {
+        SKIP(runner, 25, "FcntlLock not available");
+        return;
+    }
+    test_factory(runner);
+    test_in_process(runner);
+    test_cross_process(runner);
+    test_blocking_wait(runner);
+}
+
+
@@ -120,6 +120,38 @@ test_Local_Is_Directory(TestBatchRunner *runner, set_up_t set_up,
     tear_down();
 }
 
+static void
+test_Local_File_Length(TestBatchRunner *runner, set_up_t set_up,
+                       tear_down_t tear_down) {
+    Folder *folder = set_up();
+    OutStream *outstream = Folder_Open_Out(folder, boffo);
+    OutStream_Write_Bytes(outstream, "boffo", 5);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    Folder_Local_MkDir(folder, foo);
+    outstream = Folder_Open_Out(folder, foo_bar);
+    OutStream_Write_Bytes(outstream, "bar", 3);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    TEST_INT_EQ(runner, Folder_Local_File_Length(folder, boffo), 5,
+                "Local_File_Length() of file");
+    TEST_INT_EQ(runner, Folder_Local_File_Length(folder, foo), 0,
+                "Local_File_Length() of dir is 0");
+    TEST_INT_EQ(runner, Folder_Local_File_Length(folder, bar), 0,
+                "Local_File_Length() of non-existent entry is 0");
+    TEST_INT_EQ(runner, Folder_File_Length(folder, foo_bar), 3,
+                "File_Length() of nested file");
+    TEST_INT_EQ(runner, Folder_File_Length(folder, nope_nyet), 0,
+                "File_Length() in non-existent dir is 0");
+
+    Folder_Delete(folder, foo_bar);
+    Folder_Delete(folder, foo);
+    Folder_Delete(folder, boffo);
+    DECREF(folder);
+    tear_down();
+}
+
 static void
 test_Local_Find_Folder(TestBatchRunner *runner, set_up_t set_up,
                        tear_down_t tear_down) {
@@ -525,6 +557,44 @@ test_Hard_Link(TestBatchRunner *runner, set_up_t set_up, tear_down_t tear_down)
     tear_down();
 }
 
+static void
+test_Sync(TestBatchRunner *runner, set_up_t set_up, tear_down_t tear_down) {
+    Folder *folder = set_up();
+    OutStream *outstream;
+    Vector *paths = Vec_new(3);
+
+    Folder_Local_MkDir(folder, foo);
+    outstream = Folder_Open_Out(folder, foo_boffo);
+    OutStream_Write_Bytes(outstream, "boffo", 5);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    outstream = Folder_Open_Out(folder, boffo);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    Vec_Push(paths, INCREF(foo_boffo));
+    Vec_Push(paths, INCREF(boffo));
+    Vec_Push(paths, INCREF(foo));
+    TEST_TRUE(runner, Folder_Sync(folder, paths),
+              "Sync files and directories");
+    TEST_TRUE(runner, Folder_Local_Sync(folder, NULL),
+              "Local_Sync on the Folder itself");
+
+    Vec_Push(paths, INCREF(nope_nyet));
+    Err_set_error(NULL);
+    TEST_FALSE(runner, Folder_Sync(folder, paths),
+               "Sync with an invalid path fails");
+    TEST_TRUE(runner, Err_get_error() != NULL,
+              "Sync with an invalid path sets global error");
+
+    DECREF(paths);
+    Folder_Delete(folder, foo_boffo);
+    Folder_Delete(folder, foo);
+    Folder_Delete(folder, boffo);
+    DECREF(folder);
+    tear_down();
+}
+
 static void
 test_Close(TestBatchRunner *runner, set_up_t set_up, tear_down_t tear_down) {
     Folder *folder = set_up();
@@ -539,7 +609,7 @@ test_Close(TestBatchRunner *runner, set_up_t set_up, tear_down_t tear_down) {
 
 uint32_t
 TestFolderCommon_num_tests() {
-    return 99;
+    return 108;
 }
 
 void
@@ -548,6 +618,7 @@ TestFolderCommon_run_tests(TestBatchRunner *runner, set_up_t set_up,
     S_init_strings();
     test_Local_Exists(runner, set_up, tear_down);
     test_Local_Is_Directory(runner, set_up, tear_down);
+    test_Local_File_Length(runner, set_up, tear_down);
     test_Local_Find_Folder(runner, set_up, tear_down);
     test_Local_MkDir(runner, set_up, tear_down);
     test_Local_Open_Dir(runner, set_up, tear_down);
@@ -555,6 +626,7 @@ TestFolderCommon_run_tests(TestBatchRunner *runner, set_up_t set_up,
     test_Local_Delete(runner, set_up, tear_down);
     test_Rename(runner, set_up, tear_down);
     test_Hard_Link(runner, set_up, tear_down);
+    test_Sync(runner, set_up, tear_down);
     test_Close(runner, set_up, tear_down);
     S_destroy_strings();
 }
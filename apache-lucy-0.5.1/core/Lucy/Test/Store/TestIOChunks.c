@@ -114,13 +114,74 @@ test_Buf(TestBatchRunner *runner) {
     DECREF(file);
 }
 
+static void
+test_Buf_Size(TestBatchRunner *runner) {
+    RAMFile   *file      = RAMFile_new(NULL, false);
+    OutStream *outstream = OutStream_open((Obj*)file);
+    size_t     big_len   = OUTSTREAM_BULK_BUF_SIZE + 7;
+    char      *big       = (char*)MALLOCATE(big_len);
+    for (size_t i = 0; i < big_len; i++) { big[i] = (char)(i % 251); }
+
+    TEST_INT_EQ(runner, OutStream_Get_Buf_Size(outstream),
+                OUTSTREAM_BUF_SIZE, "Default buffer size");
+    OutStream_Write_Bytes(outstream, "abc", 3);
+    OutStream_Set_Buf_Size(outstream, OUTSTREAM_BULK_BUF_SIZE);
+    TEST_INT_EQ(runner, OutStream_Get_Buf_Size(outstream),
+                OUTSTREAM_BULK_BUF_SIZE, "Set_Buf_Size");
+    TEST_INT_EQ(runner, OutStream_Tell(outstream), 3,
+                "Set_Buf_Size keeps file position");
+
+    // Write more than a buffer's worth on top of buffered content.
+    OutStream_Write_Bytes(outstream, "d", 1);
+    OutStream_Write_Bytes(outstream, big, big_len);
+    OutStream_Write_Bytes(outstream, "e", 1);
+    TEST_INT_EQ(runner, OutStream_Tell(outstream), (int64_t)big_len + 5,
+                "Tell after oversized write");
+    OutStream_Set_Buf_Size(outstream, 0);
+    TEST_INT_EQ(runner, OutStream_Get_Buf_Size(outstream),
+                IO_STREAM_BUF_SIZE, "Buffer size has a floor");
+    OutStream_Close(outstream);
+
+    InStream *instream = InStream_open((Obj*)file);
+    char *got = (char*)MALLOCATE(big_len + 5);
+    InStream_Read_Bytes(instream, got, big_len + 5);
+    TEST_TRUE(runner, memcmp(got, "abcd", 4) == 0
+                      && memcmp(got + 4, big, big_len) == 0
+                      && got[big_len + 4] == 'e',
+              "Content survives buffer resizing and oversized writes");
+
+    // Absorb copies everything, even past the bulk chunk size.
+    RAMFile   *copy     = RAMFile_new(NULL, false);
+    OutStream *copy_out = OutStream_open((Obj*)copy);
+    InStream_Seek(instream, 0);
+    OutStream_Write_Bytes(copy_out, "x", 1);
+    OutStream_Absorb(copy_out, instream);
+    OutStream_Close(copy_out);
+    InStream *copy_in = InStream_open((Obj*)copy);
+    TEST_INT_EQ(runner, InStream_Length(copy_in), (int64_t)big_len + 6,
+                "Absorb length");
+    InStream_Seek(copy_in, 1);
+    InStream_Read_Bytes(copy_in, got, big_len + 5);
+    TEST_TRUE(runner, memcmp(got + 4, big, big_len) == 0, "Absorb content");
+
+    FREEMEM(got);
+    FREEMEM(big);
+    DECREF(copy_in);
+    DECREF(copy_out);
+    DECREF(copy);
+    DECREF(instream);
+    DECREF(outstream);
+    DECREF(file);
+}
+
 void
 TestIOChunks_Run_IMP(TestIOChunks *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 36);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 44);
     srand((unsigned int)time((time_t*)NULL));
     test_Align(runner);
     test_Read_Write_Bytes(runner);
     test_Buf(runner);
+    test_Buf_Size(runner);
 }
 
 
@@ -0,0 +1,278 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTBLOOMFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Util/TestBloomFilter.h"
+#include "Lucy/Util/BloomFilter.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/PolySearcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Freezer.h"
+
+#define NUM_KEYS 1000
+
+TestBloomFilter*
+TestBloom_new() {
+    return (TestBloomFilter*)Class_Make_Obj(TESTBLOOMFILTER);
+}
+
+static void
+test_membership(TestBatchRunner *runner) {
+    BloomFilter *bloom = Bloom_new(NUM_KEYS, 10);
+
+    for (int32_t i = 0; i < NUM_KEYS; i++) {
+        String *key = Str_newf("key%i32", i);
+        Bloom_Add(bloom, (Obj*)key);
+        DECREF(key);
+    }
+
+    int32_t num_missing = 0;
+    for (int32_t i = 0; i < NUM_KEYS; i++) {
+        String *key = Str_newf("key%i32", i);
+        if (!Bloom_Might_Contain(bloom, (Obj*)key)) { num_missing++; }
+        DECREF(key);
+    }
+    TEST_INT_EQ(runner, num_missing, 0, "No false negatives");
+
+    int32_t num_false_pos = 0;
+    for (int32_t i = NUM_KEYS; i < NUM_KEYS * 11; i++) {
+        String *key = Str_newf("key%i32", i);
+        if (Bloom_Might_Contain(bloom, (Obj*)key)) { num_false_pos++; }
+        DECREF(key);
+    }
+    TEST_TRUE(runner, num_false_pos < NUM_KEYS * 10 / 50,
+              "False positive rate under 2%% (%d of %d)",
+              (int)num_false_pos, (int)(NUM_KEYS * 10));
+
+    // Round-trip through a file.
+    RAMFolder *folder   = RAMFolder_new(NULL);
+    String    *filename = SSTR_WRAP_C("bloom");
+    OutStream *outstream = RAMFolder_Open_Out(folder, filename);
+    Bloom_Serialize(bloom, outstream);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    InStream *instream = RAMFolder_Open_In(folder, filename);
+    BloomFilter *loaded
+        = Bloom_Deserialize((BloomFilter*)Class_Make_Obj(BLOOMFILTER),
+                            instream);
+    DECREF(instream);
+
+    TEST_INT_EQ(runner, Bloom_Get_Num_Bits(loaded), Bloom_Get_Num_Bits(bloom),
+                "Deserialized num_bits");
+    bool all_present = true;
+    for (int32_t i = 0; i < NUM_KEYS; i++) {
+        String *key = Str_newf("key%i32", i);
+        if (!Bloom_Might_Contain(loaded, (Obj*)key)) { all_present = false; }
+        DECREF(key);
+    }
+    TEST_TRUE(runner, all_present, "Deserialized filter holds all keys");
+
+    DECREF(loaded);
+    DECREF(folder);
+    DECREF(bloom);
+}
+
+static Schema*
+S_create_schema(bool primary_key) {
+    Schema *schema = Schema_new();
+    StringType *type = StringType_new();
+    StringType_Set_Primary_Key(type, primary_key);
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)type);
+    DECREF(type);
+    type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("content"), (FieldType*)type);
+    DECREF(type);
+    return schema;
+}
+
+static void
+S_add_doc(Indexer *indexer, const char *id, const char *content) {
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C(id));
+    Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)SSTR_WRAP_C(content));
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    DECREF(doc);
+}
+
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t end) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = start; i < end; i++) {
+        Doc *doc = Doc_new(NULL, 0);
+        String *id = Str_newf("%i32", i);
+        Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)id);
+        Doc_Store(doc, SSTR_WRAP_C("content"), (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+}
+
+static int32_t
+S_count_blooms(RAMFolder *folder, const char *seg_name) {
+    Vector *files = RAMFolder_List(folder, SSTR_WRAP_C(seg_name));
+    int32_t count = 0;
+    for (uint32_t i = 0, max = Vec_Get_Size(files); i < max; i++) {
+        String *file = (String*)Vec_Fetch(files, i);
+        if (Str_Ends_With_Utf8(file, ".bloom", 6)) { count++; }
+    }
+    DECREF(files);
+    return count;
+}
+
+static bool
+S_fetch_by_key_is(Searcher *searcher, const char *id, bool expected) {
+    HitDoc *hit_doc = Searcher_Fetch_By_Key(searcher, SSTR_WRAP_C("id"),
+                                            (Obj*)SSTR_WRAP_C(id));
+    bool retval = expected ? hit_doc != NULL : hit_doc == NULL;
+    if (hit_doc) {
+        Obj *content = HitDoc_Extract(hit_doc, SSTR_WRAP_C("content"));
+        if (!content || !Str_Equals_Utf8((String*)content, id, strlen(id))) {
+            retval = false;
+        }
+        DECREF(content);
+        DECREF(hit_doc);
+    }
+    return retval;
+}
+
+static bool
+S_fetch_by_key_gets(Searcher *searcher, const char *id, const char *content) {
+    HitDoc *hit_doc = Searcher_Fetch_By_Key(searcher, SSTR_WRAP_C("id"),
+                                            (Obj*)SSTR_WRAP_C(id));
+    Obj *value = hit_doc
+                 ? HitDoc_Extract(hit_doc, SSTR_WRAP_C("content"))
+                 : NULL;
+    bool retval = value
+                  && Str_Equals_Utf8((String*)value, content, strlen(content));
+    DECREF(value);
+    DECREF(hit_doc);
+    return retval;
+}
+
+static void
+test_primary_key(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema(true);
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    {
+        Hash *dump = Schema_Dump(schema);
+        Schema *loaded = (Schema*)Freezer_load((Obj*)dump);
+        FieldType *type = Schema_Fetch_Type(loaded, SSTR_WRAP_C("id"));
+        TEST_TRUE(runner, StringType_Primary_Key((StringType*)type),
+                  "primary_key survives Dump/Load");
+        TEST_TRUE(runner,
+                  FType_Equals(type, (Obj*)Schema_Fetch_Type(
+                                   loaded, SSTR_WRAP_C("content"))),
+                  "primary_key doesn't affect Equals");
+        DECREF(loaded);
+        DECREF(dump);
+    }
+
+    S_add_docs(folder, schema, 0, 50);
+    S_add_docs(folder, schema, 50, 100);
+    TEST_INT_EQ(runner, S_count_blooms(folder, "seg_1"), 1,
+                "Only the primary key field gets a bloom filter");
+
+    Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+    Indexer_Delete_By_Term(indexer, SSTR_WRAP_C("id"),
+                           (Obj*)SSTR_WRAP_C("75"));
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    Searcher *searcher = (Searcher*)IxSearcher_new((Obj*)folder);
+    TEST_TRUE(runner, S_fetch_by_key_is(searcher, "10", true),
+              "Fetch_By_Key in first segment");
+    TEST_TRUE(runner, S_fetch_by_key_is(searcher, "60", true),
+              "Fetch_By_Key in second segment");
+    TEST_TRUE(runner, S_fetch_by_key_is(searcher, "75", false),
+              "Fetch_By_Key skips deleted docs");
+    TEST_TRUE(runner, S_fetch_by_key_is(searcher, "1000", false),
+              "Fetch_By_Key for missing key");
+    TEST_INT_EQ(runner, IxSearcher_Doc_Freq((IndexSearcher*)searcher,
+                                            SSTR_WRAP_C("id"),
+                                            (Obj*)SSTR_WRAP_C("99")),
+                1, "Doc_Freq with bloom filter");
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_enable_primary_key(TestBatchRunner *runner) {
+    Schema    *plain  = S_create_schema(false);
+    Schema    *keyed  = S_create_schema(true);
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    S_add_docs(folder, plain, 0, 10);
+    S_add_docs(folder, keyed, 10, 20);
+    TEST_INT_EQ(runner, S_count_blooms(folder, "seg_1"), 0,
+                "Segment written before primary_key was set has no filter");
+    TEST_INT_EQ(runner, S_count_blooms(folder, "seg_2"), 1,
+                "Primary key can be enabled on an existing index");
+
+    Indexer *indexer = Indexer_new(NULL, (Obj*)folder, NULL, 0);
+    S_add_doc(indexer, "7", "7b");
+    S_add_doc(indexer, "7", "7c");
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *ix_searcher = IxSearcher_new((Obj*)folder);
+    Vector *searchers = Vec_new(1);
+    Vec_Push(searchers, INCREF(ix_searcher));
+    PolySearcher *poly_searcher
+        = PolySearcher_new(IxSearcher_Get_Schema(ix_searcher), searchers);
+
+    TEST_TRUE(runner, S_fetch_by_key_is((Searcher*)ix_searcher, "5", true),
+              "Fetch_By_Key in segment without a filter");
+    TEST_TRUE(runner, S_fetch_by_key_gets((Searcher*)ix_searcher, "7", "7c"),
+              "IndexSearcher Fetch_By_Key returns the newest doc");
+    TEST_TRUE(runner,
+              S_fetch_by_key_gets((Searcher*)poly_searcher, "7", "7c"),
+              "Searcher Fetch_By_Key returns the newest doc");
+
+    DECREF(poly_searcher);
+    DECREF(searchers);
+    DECREF(ix_searcher);
+    DECREF(folder);
+    DECREF(keyed);
+    DECREF(plain);
+}
+
+void
+TestBloom_Run_IMP(TestBloomFilter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 17);
+    test_membership(runner);
+    test_primary_key(runner);
+    test_enable_primary_key(runner);
+}
+
+
@@ -0,0 +1,272 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Util/TestMetaFile.h"
+#include "Lucy/Util/IndexFileNames.h"
+#include "Lucy/Util/Json.h"
+#include "Lucy/Util/MetaFile.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexManager.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestMetaFile*
+TestMetaFile_new() {
+    return (TestMetaFile*)Class_Make_Obj(TESTMETAFILE);
+}
+
+// Create a test data structure with one of each supported type.
+static Obj*
+S_make_dump() {
+    Hash   *dump  = Hash_new(0);
+    Vector *array = Vec_new(0);
+    Hash_Store_Utf8(dump, "name", 4, (Obj*)Str_newf("seg_\xE2\x98\x83"));
+    Hash_Store_Utf8(dump, "count", 5, (Obj*)Int_new(-12345678901LL));
+    Hash_Store_Utf8(dump, "boost", 5, (Obj*)Float_new(1.5));
+    Hash_Store_Utf8(dump, "indexed", 7, (Obj*)CFISH_TRUE);
+    Hash_Store_Utf8(dump, "stored", 6, (Obj*)CFISH_FALSE);
+    Vec_Push(array, (Obj*)Str_newf("a"));
+    Vec_Push(array, (Obj*)Hash_new(0));
+    Hash_Store_Utf8(dump, "stuff", 5, (Obj*)array);
+    return (Obj*)dump;
+}
+
+static void
+test_round_trip(TestBatchRunner *runner) {
+    Obj *dump = S_make_dump();
+    ByteBuf *encoded = MetaFile_to_binary(dump);
+    TEST_TRUE(runner, encoded != NULL, "to_binary");
+    TEST_TRUE(runner, MetaFile_is_binary(BB_Get_Buf(encoded),
+                                         BB_Get_Size(encoded)),
+              "is_binary");
+    Obj *decoded = MetaFile_from_binary(BB_Get_Buf(encoded),
+                                        BB_Get_Size(encoded));
+    TEST_TRUE(runner, decoded && Obj_Equals(dump, decoded),
+              "Round trip through binary");
+    Obj *count = Hash_Fetch_Utf8((Hash*)decoded, "count", 5);
+    TEST_TRUE(runner, count && Obj_is_a(count, INTEGER),
+              "Integers keep their type");
+
+    // Identical data always produces identical bytes.
+    ByteBuf *again = MetaFile_to_binary(decoded);
+    TEST_TRUE(runner, BB_Equals(encoded, (Obj*)again),
+              "Encoding is deterministic");
+
+    DECREF(again);
+    DECREF(decoded);
+    DECREF(encoded);
+    DECREF(dump);
+
+    Vector *with_null = Vec_new(2);
+    Vec_Store(with_null, 1, (Obj*)Str_newf("b"));
+    encoded = MetaFile_to_binary((Obj*)with_null);
+    Vector *got = (Vector*)MetaFile_from_binary(BB_Get_Buf(encoded),
+                                                BB_Get_Size(encoded));
+    TEST_TRUE(runner, got && Vec_Get_Size(got) == 2
+                      && Vec_Fetch(got, 0) == NULL
+                      && Vec_Fetch(got, 1) != NULL,
+              "Round trip null");
+    DECREF(got);
+    DECREF(encoded);
+    DECREF(with_null);
+
+    String *scalar = Str_newf("scalar");
+    Err_set_error(NULL);
+    TEST_TRUE(runner, MetaFile_to_binary((Obj*)scalar) == NULL,
+              "Reject top-level scalar");
+    DECREF(scalar);
+}
+
+static void
+test_corrupt(TestBatchRunner *runner) {
+    Obj *dump = S_make_dump();
+    ByteBuf *encoded = MetaFile_to_binary(dump);
+    const char *buf  = BB_Get_Buf(encoded);
+    size_t      size = BB_Get_Size(encoded);
+    bool all_null = true;
+
+    // Every truncation must fail cleanly.
+    for (size_t len = 5; len < size; len++) {
+        Obj *decoded = MetaFile_from_binary(buf, len);
+        if (decoded) {
+            all_null = false;
+            DECREF(decoded);
+        }
+    }
+    TEST_TRUE(runner, all_null, "Truncated binary metadata rejected");
+
+    char *copy = (char*)MALLOCATE(size);
+    memcpy(copy, buf, size);
+    copy[4] = 99;
+    Err_set_error(NULL);
+    TEST_TRUE(runner, MetaFile_from_binary(copy, size) == NULL,
+              "Format too recent rejected");
+    TEST_TRUE(runner, Err_get_error() != NULL, "... and sets error");
+    copy[4] = buf[4];
+    copy[5] = 42;
+    TEST_TRUE(runner, MetaFile_from_binary(copy, size) == NULL,
+              "Unknown tag rejected");
+    FREEMEM(copy);
+
+    DECREF(encoded);
+    DECREF(dump);
+}
+
+static void
+test_spew_and_slurp(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Obj    *dump   = S_make_dump();
+    String *binary = SSTR_WRAP_C("meta.bin");
+    String *json   = SSTR_WRAP_C("meta.json");
+
+    TEST_TRUE(runner, MetaFile_spew(dump, (Folder*)folder, binary, true),
+              "spew binary");
+    InStream *instream = RAMFolder_Open_In(folder, binary);
+    TEST_TRUE(runner, MetaFile_is_binary(InStream_Buf(instream, 5), 5),
+              "Binary output when selected");
+    DECREF(instream);
+    Obj *got = MetaFile_slurp((Folder*)folder, binary);
+    TEST_TRUE(runner, got && Obj_Equals(dump, got), "slurp binary");
+    DECREF(got);
+
+    MetaFile_spew(dump, (Folder*)folder, json, false);
+    instream = RAMFolder_Open_In(folder, json);
+    const char *buf = InStream_Buf(instream, 1);
+    TEST_TRUE(runner, buf[0] == '{', "JSON output otherwise");
+    DECREF(instream);
+    got = MetaFile_slurp((Folder*)folder, json);
+    Hash *expected = (Hash*)Json_slurp_json((Folder*)folder, json);
+    TEST_TRUE(runner, got && Obj_Equals((Obj*)expected, got),
+              "slurp falls back to JSON");
+    DECREF(expected);
+    DECREF(got);
+
+    Err_set_error(NULL);
+    got = MetaFile_slurp((Folder*)folder, SSTR_WRAP_C("nope"));
+    TEST_TRUE(runner, got == NULL && Err_get_error() != NULL,
+              "slurp missing file sets error");
+
+    DECREF(dump);
+    DECREF(folder);
+}
+
+static void
+test_segment(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    Segment   *segment = Seg_new(1);
+    Segment   *got     = Seg_new(1);
+    Seg_Add_Field(segment, SSTR_WRAP_C("title"));
+    Seg_Set_Count(segment, 42);
+    RAMFolder_MkDir(folder, Seg_Get_Name(segment));
+    Seg_Set_Binary_Metadata(segment, true);
+    Seg_Write_File(segment, (Folder*)folder);
+    Seg_Read_File(got, (Folder*)folder);
+    TEST_INT_EQ(runner, Seg_Get_Count(got), 42,
+                "Segment metadata round trips through binary");
+    TEST_INT_EQ(runner, Seg_Field_Num(got, SSTR_WRAP_C("title")), 1,
+                "... including field names");
+    DECREF(got);
+    DECREF(segment);
+    DECREF(folder);
+}
+
+// Return true if the file at `path` holds binary metadata.
+static bool
+S_file_is_binary(Folder *folder, String *path) {
+    InStream *instream = Folder_Open_In(folder, path);
+    if (!instream) { return false; }
+    size_t len = (size_t)InStream_Length(instream);
+    bool is_binary = MetaFile_is_binary(InStream_Buf(instream, len), len);
+    DECREF(instream);
+    return is_binary;
+}
+
+static void
+S_index_doc(Folder *folder, IndexManager *manager) {
+    Schema *schema = Schema_new();
+    StringType *type = StringType_new();
+    Schema_Spec_Field(schema, SSTR_WRAP_C("id"), (FieldType*)type);
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, manager, 0);
+    Doc *doc = Doc_new(NULL, 0);
+    Doc_Store(doc, SSTR_WRAP_C("id"), (Obj*)SSTR_WRAP_C("a"));
+    Indexer_Add_Doc(indexer, doc, 1.0f);
+    Indexer_Commit(indexer);
+    DECREF(doc);
+    DECREF(indexer);
+    DECREF(type);
+    DECREF(schema);
+}
+
+static void
+test_index(TestBatchRunner *runner) {
+    RAMFolder    *folder  = RAMFolder_new(NULL);
+    IndexManager *manager = IxManager_new(NULL, NULL);
+    TEST_FALSE(runner, IxManager_Get_Binary_Metadata(manager),
+               "Binary metadata is off by default");
+
+    S_index_doc((Folder*)folder, manager);
+    String *snapfile = IxFileNames_latest_snapshot((Folder*)folder);
+    TEST_FALSE(runner, S_file_is_binary((Folder*)folder, snapfile)
+                       || S_file_is_binary((Folder*)folder,
+                                           SSTR_WRAP_C("seg_1/segmeta.json"))
+                       || S_file_is_binary((Folder*)folder,
+                                           SSTR_WRAP_C("seg_1/cfmeta.json")),
+               "Indexer writes JSON metadata by default");
+    DECREF(snapfile);
+
+    IxManager_Set_Binary_Metadata(manager, true);
+    S_index_doc((Folder*)folder, manager);
+    snapfile = IxFileNames_latest_snapshot((Folder*)folder);
+    TEST_TRUE(runner, S_file_is_binary((Folder*)folder, snapfile)
+                      && S_file_is_binary((Folder*)folder,
+                                          SSTR_WRAP_C("seg_2/segmeta.json"))
+                      && S_file_is_binary((Folder*)folder,
+                                          SSTR_WRAP_C("seg_2/cfmeta.json")),
+              "Indexer writes binary metadata when enabled");
+    DECREF(snapfile);
+
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    TEST_INT_EQ(runner, PolyReader_Doc_Count(reader), 2,
+                "Index with mixed metadata opens");
+    DECREF(reader);
+    DECREF(manager);
+    DECREF(folder);
+}
+
+void
+TestMetaFile_Run_IMP(TestMetaFile *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 23);
+    test_round_trip(runner);
+    test_corrupt(runner);
+    test_spew_and_slurp(runner);
+    test_segment(runner);
+    test_index(runner);
+}
+
@@ -0,0 +1,166 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_BLOOMFILTER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Util/BloomFilter.h"
+#include "Clownfish/ByteBuf.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+
+#define MAX_HASHES 30
+
+BloomFilter*
+Bloom_new(uint32_t num_keys, uint32_t bits_per_key) {
+    BloomFilter *self = (BloomFilter*)Class_Make_Obj(BLOOMFILTER);
+    return Bloom_init(self, num_keys, bits_per_key);
+}
+
+BloomFilter*
+Bloom_init(BloomFilter *self, uint32_t num_keys, uint32_t bits_per_key) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    if (bits_per_key == 0) { bits_per_key = 1; }
+
+    // Round up to whole bytes, with a floor to keep tiny filters useful.
+    uint64_t num_bits = (uint64_t)num_keys * bits_per_key;
+    if (num_bits < 64) { num_bits = 64; }
+    num_bits = (num_bits + 7) & ~(uint64_t)7;
+    if (num_bits > UINT32_MAX - 7) {
+        THROW(ERR, "Too many keys for BloomFilter: %u32", num_keys);
+    }
+
+    // The optimal number of probes is bits_per_key * ln(2).
+    uint32_t num_hashes = (uint32_t)(bits_per_key * 69 / 100);
+    if (num_hashes < 1)          { num_hashes = 1; }
+    if (num_hashes > MAX_HASHES) { num_hashes = MAX_HASHES; }
+
+    ivars->num_bits   = (uint32_t)num_bits;
+    ivars->num_hashes = num_hashes;
+    ivars->bits       = (uint8_t*)CALLOCATE(ivars->num_bits / 8, 1);
+    return self;
+}
+
+void
+Bloom_Destroy_IMP(BloomFilter *self) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    FREEMEM(ivars->bits);
+    SUPER_DESTROY(self, BLOOMFILTER);
+}
+
+uint64_t
+Bloom_hash_bytes(const void *bytes, size_t size) {
+    const uint8_t *ptr = (const uint8_t*)bytes;
+
+    // FNV-1a, followed by a finalizer so that both halves of the result are
+    // well mixed even for short keys.
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ptr[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint64_t
+Bloom_hash_term(Obj *term) {
+    // Terms arrive as ByteBufs of UTF-8 at index time.
+    if (Obj_is_a(term, BYTEBUF)) {
+        ByteBuf *bytebuf = (ByteBuf*)term;
+        return Bloom_hash_bytes(BB_Get_Buf(bytebuf), BB_Get_Size(bytebuf));
+    }
+    String *string = (String*)CERTIFY(term, STRING);
+    return Bloom_hash_bytes(Str_Get_Ptr8(string), Str_Get_Size(string));
+}
+
+void
+Bloom_Add_Hash_IMP(BloomFilter *self, uint64_t hash) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    uint64_t probe = hash & 0xFFFFFFFF;
+    uint64_t delta = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < ivars->num_hashes; i++) {
+        uint32_t tick = (uint32_t)(probe % ivars->num_bits);
+        ivars->bits[tick >> 3] |= (uint8_t)(1 << (tick & 0x7));
+        probe += delta;
+    }
+}
+
+bool
+Bloom_Might_Contain_Hash_IMP(BloomFilter *self, uint64_t hash) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    uint64_t probe = hash & 0xFFFFFFFF;
+    uint64_t delta = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < ivars->num_hashes; i++) {
+        uint32_t tick = (uint32_t)(probe % ivars->num_bits);
+        if (!(ivars->bits[tick >> 3] & (1 << (tick & 0x7)))) {
+            return false;
+        }
+        probe += delta;
+    }
+    return true;
+}
+
+void
+Bloom_Add_IMP(BloomFilter *self, Obj *term) {
+    Bloom_Add_Hash(self, Bloom_hash_term(term));
+}
+
+bool
+Bloom_Might_Contain_IMP(BloomFilter *self, Obj *term) {
+    return Bloom_Might_Contain_Hash(self, Bloom_hash_term(term));
+}
+
+uint32_t
+Bloom_Get_Num_Bits_IMP(BloomFilter *self) {
+    return Bloom_IVARS(self)->num_bits;
+}
+
+uint32_t
+Bloom_Get_Num_Hashes_IMP(BloomFilter *self) {
+    return Bloom_IVARS(self)->num_hashes;
+}
+
+void
+Bloom_Serialize_IMP(BloomFilter *self, OutStream *outstream) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    OutStream_Write_C32(outstream, ivars->num_hashes);
+    OutStream_Write_C32(outstream, ivars->num_bits);
+    OutStream_Write_Bytes(outstream, ivars->bits, ivars->num_bits / 8);
+}
+
+BloomFilter*
+Bloom_Deserialize_IMP(BloomFilter *self, InStream *instream) {
+    BloomFilterIVARS *const ivars = Bloom_IVARS(self);
+    uint32_t num_hashes = InStream_Read_C32(instream);
+    uint32_t num_bits   = InStream_Read_C32(instream);
+    if (num_hashes < 1 || num_hashes > MAX_HASHES
+        || num_bits == 0 || num_bits % 8 != 0
+       ) {
+        DECREF(self);
+        THROW(ERR, "Corrupt BloomFilter in '%o': %u32 hashes, %u32 bits",
+              InStream_Get_Filename(instream), num_hashes, num_bits);
+    }
+    ivars->num_hashes = num_hashes;
+    ivars->num_bits   = num_bits;
+    ivars->bits       = (uint8_t*)MALLOCATE(num_bits / 8);
+    InStream_Read_Bytes(instream, (char*)ivars->bits, num_bits / 8);
+    return self;
+}
+
+
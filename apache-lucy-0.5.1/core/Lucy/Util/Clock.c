@@ -0,0 +1,72 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_CLOCK
+
+#include "charmony.h"
+
+#include "Lucy/Util/Clock.h"
+
+/********************************* WINDOWS ********************************/
+#ifdef CHY_HAS_WINDOWS_H
+
+#include <windows.h>
+
+uint64_t
+lucy_Clock_microseconds() {
+    return (uint64_t)GetTickCount() * 1000;
+}
+
+uint64_t
+lucy_Clock_nanoseconds() {
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&count)) {
+        return lucy_Clock_microseconds() * 1000;
+    }
+    return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+
+/********************************* UNIXEN *********************************/
+#elif defined(CHY_HAS_SYS_TIME_H)
+
+#include <sys/time.h>
+#ifdef CHY_HAS_TIME_H
+  #include <time.h>
+#endif
+
+uint64_t
+lucy_Clock_microseconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+}
+
+uint64_t
+lucy_Clock_nanoseconds() {
+#if defined(CHY_HAS_TIME_H) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    }
+#endif
+    return lucy_Clock_microseconds() * 1000;
+}
+
+#else
+  #error "Can't find a known time API."
+#endif // OS switch.
+
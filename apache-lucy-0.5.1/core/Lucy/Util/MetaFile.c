@@ -0,0 +1,406 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_METAFILE
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Util/MetaFile.h"
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/Util/StringHelper.h"
+#include "Lucy/Store/Folder.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Json.h"
+#include "Lucy/Util/NumberUtils.h"
+
+#define MAGIC     "LMTA"
+#define MAGIC_LEN 4
+
+#define TAG_NULL    0
+#define TAG_FALSE   1
+#define TAG_TRUE    2
+#define TAG_INTEGER 3
+#define TAG_FLOAT   4
+#define TAG_STRING  5
+#define TAG_VECTOR  6
+#define TAG_HASH    7
+
+static const uint8_t MetaFile_current_file_format = 1;
+
+// Guard against runaway recursion, matching the JSON codec.
+static const int32_t MAX_DEPTH = 200;
+
+// Encode `dump` onto the end of `buf`.  On failure, sets the global error
+// object and returns false.
+static bool
+S_encode(Obj *dump, ByteBuf *buf, int32_t depth);
+
+// Decode one value, advancing `*source`.  On failure, sets the global error
+// object and returns false; `*value` receives the decoded object, which may be
+// NULL.
+static bool
+S_decode(const char **source, const char *limit, int32_t depth, Obj **value);
+
+bool
+MetaFile_spew(Obj *dump, Folder *folder, String *path, bool binary) {
+    if (!binary) {
+        bool result = Json_spew_json(dump, folder, path);
+        if (!result) { ERR_ADD_FRAME(Err_get_error()); }
+        return result;
+    }
+    ByteBuf *encoded = MetaFile_to_binary(dump);
+    if (!encoded) {
+        ERR_ADD_FRAME(Err_get_error());
+        return false;
+    }
+    OutStream *outstream = Folder_Open_Out(folder, path);
+    if (!outstream) {
+        ERR_ADD_FRAME(Err_get_error());
+        DECREF(encoded);
+        return false;
+    }
+    OutStream_Write_Bytes(outstream, BB_Get_Buf(encoded),
+                          BB_Get_Size(encoded));
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    DECREF(encoded);
+    return true;
+}
+
+Obj*
+MetaFile_slurp(Folder *folder, String *path) {
+    InStream *instream = Folder_Open_In(folder, path);
+    if (!instream) {
+        ERR_ADD_FRAME(Err_get_error());
+        return NULL;
+    }
+    size_t len = (size_t)InStream_Length(instream);
+    const char *buf = InStream_Buf(instream, len);
+    bool is_binary = MetaFile_is_binary(buf, len);
+    Obj *dump = is_binary ? MetaFile_from_binary(buf, len) : NULL;
+    InStream_Close(instream);
+    DECREF(instream);
+
+    // Anything without the binary magic is JSON.
+    if (!is_binary) {
+        dump = Json_slurp_json(folder, path);
+    }
+    if (!dump) {
+        ERR_ADD_FRAME(Err_get_error());
+    }
+    return dump;
+}
+
+bool
+MetaFile_is_binary(const char *buf, size_t size) {
+    return size >= MAGIC_LEN + 1 && memcmp(buf, MAGIC, MAGIC_LEN) == 0;
+}
+
+ByteBuf*
+MetaFile_to_binary(Obj *dump) {
+    // Only allow hashes and arrays at the top level, as with JSON.
+    if (!dump || !(Obj_is_a(dump, HASH) || Obj_is_a(dump, VECTOR))) {
+        String *class_name = dump ? Obj_get_class_name(dump) : NULL;
+        String *mess = MAKE_MESS("Illegal top-level object type: %o",
+                                 class_name);
+        Err_set_error(Err_new(mess));
+        return NULL;
+    }
+
+    ByteBuf *buf = BB_new(64);
+    char format = (char)MetaFile_current_file_format;
+    BB_Cat_Bytes(buf, MAGIC, MAGIC_LEN);
+    BB_Cat_Bytes(buf, &format, 1);
+    if (!S_encode(dump, buf, 0)) {
+        ERR_ADD_FRAME(Err_get_error());
+        DECREF(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+Obj*
+MetaFile_from_binary(const char *buf, size_t size) {
+    if (!MetaFile_is_binary(buf, size)) {
+        Err_set_error(Err_new(Str_newf("Not a binary metadata file")));
+        return NULL;
+    }
+    uint8_t format = (uint8_t)buf[MAGIC_LEN];
+    if (format > MetaFile_current_file_format) {
+        Err_set_error(Err_new(Str_newf("Binary metadata format too recent: "
+                                       "%u8", format)));
+        return NULL;
+    }
+
+    const char *source = buf + MAGIC_LEN + 1;
+    const char *limit  = buf + size;
+    Obj *dump = NULL;
+    if (!S_decode(&source, limit, 0, &dump)) {
+        ERR_ADD_FRAME(Err_get_error());
+        return NULL;
+    }
+    if (source != limit) {
+        DECREF(dump);
+        Err_set_error(Err_new(Str_newf("Trailing garbage in binary "
+                                       "metadata")));
+        return NULL;
+    }
+    if (!dump || !(Obj_is_a(dump, HASH) || Obj_is_a(dump, VECTOR))) {
+        DECREF(dump);
+        Err_set_error(Err_new(Str_newf("Illegal top-level object in binary "
+                                       "metadata")));
+        return NULL;
+    }
+    return dump;
+}
+
+/***************************************************************************/
+
+static void
+S_cat_tag(ByteBuf *buf, uint8_t tag) {
+    char byte = (char)tag;
+    BB_Cat_Bytes(buf, &byte, 1);
+}
+
+static void
+S_cat_c64(ByteBuf *buf, uint64_t value) {
+    char  scratch[10];
+    char *ptr = scratch;
+    NumUtil_encode_c64(value, &ptr);
+    BB_Cat_Bytes(buf, scratch, (size_t)(ptr - scratch));
+}
+
+static void
+S_cat_string(ByteBuf *buf, String *string) {
+    size_t size = Str_Get_Size(string);
+    S_cat_c64(buf, size);
+    BB_Cat_Bytes(buf, Str_Get_Ptr8(string), size);
+}
+
+static bool
+S_encode(Obj *dump, ByteBuf *buf, int32_t depth) {
+    if (depth > MAX_DEPTH) {
+        String *mess = MAKE_MESS("Exceeded max depth of %i32", MAX_DEPTH);
+        Err_set_error(Err_new(mess));
+        return false;
+    }
+
+    if (!dump) {
+        S_cat_tag(buf, TAG_NULL);
+    }
+    else if (dump == (Obj*)CFISH_TRUE) {
+        S_cat_tag(buf, TAG_TRUE);
+    }
+    else if (dump == (Obj*)CFISH_FALSE) {
+        S_cat_tag(buf, TAG_FALSE);
+    }
+    else if (Obj_is_a(dump, STRING)) {
+        S_cat_tag(buf, TAG_STRING);
+        S_cat_string(buf, (String*)dump);
+    }
+    else if (Obj_is_a(dump, INTEGER)) {
+        // Zigzag encode so that small negative numbers stay small.
+        int64_t  value   = Int_Get_Value((Integer*)dump);
+        uint64_t encoded = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+        S_cat_tag(buf, TAG_INTEGER);
+        S_cat_c64(buf, encoded);
+    }
+    else if (Obj_is_a(dump, FLOAT)) {
+        char  scratch[8];
+        char *ptr = scratch;
+        NumUtil_encode_bigend_f64(Float_Get_Value((Float*)dump), &ptr);
+        S_cat_tag(buf, TAG_FLOAT);
+        BB_Cat_Bytes(buf, scratch, 8);
+    }
+    else if (Obj_is_a(dump, VECTOR)) {
+        Vector *array = (Vector*)dump;
+        size_t  size  = Vec_Get_Size(array);
+        S_cat_tag(buf, TAG_VECTOR);
+        S_cat_c64(buf, size);
+        for (size_t i = 0; i < size; i++) {
+            if (!S_encode(Vec_Fetch(array, i), buf, depth + 1)) {
+                return false;
+            }
+        }
+    }
+    else if (Obj_is_a(dump, HASH)) {
+        Hash   *hash = (Hash*)dump;
+        Vector *keys = Hash_Keys(hash);
+        size_t  size = Vec_Get_Size(keys);
+
+        // Sort keys so that the output is deterministic.
+        Vec_Sort(keys);
+        S_cat_tag(buf, TAG_HASH);
+        S_cat_c64(buf, size);
+        for (size_t i = 0; i < size; i++) {
+            String *key = (String*)Vec_Fetch(keys, i);
+            S_cat_string(buf, key);
+            if (!S_encode(Hash_Fetch(hash, key), buf, depth + 1)) {
+                DECREF(keys);
+                return false;
+            }
+        }
+        DECREF(keys);
+    }
+    else {
+        String *mess = MAKE_MESS("Can't encode object of type %o",
+                                 Obj_get_class_name(dump));
+        Err_set_error(Err_new(mess));
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+S_set_corrupt(const char *what) {
+    Err_set_error(Err_new(Str_newf("Corrupt binary metadata: %s", what)));
+    return false;
+}
+
+// Decode a C64, refusing to read past `limit`.
+static bool
+S_read_c64(const char **source, const char *limit, uint64_t *value) {
+    const uint8_t *ptr = (const uint8_t*)*source;
+    const uint8_t *end = (const uint8_t*)limit;
+    uint64_t decoded = 0;
+    for (int i = 0; i < 10; i++) {
+        if (ptr >= end) { return S_set_corrupt("truncated integer"); }
+        decoded = (decoded << 7) | (*ptr & 0x7f);
+        if (!(*ptr++ & 0x80)) {
+            *source = (const char*)ptr;
+            *value  = decoded;
+            return true;
+        }
+    }
+    return S_set_corrupt("overlong integer");
+}
+
+// Read the length and location of a string, validating its UTF-8.
+static bool
+S_read_string(const char **source, const char *limit, const char **ptr,
+              size_t *size) {
+    uint64_t len;
+    if (!S_read_c64(source, limit, &len)) { return false; }
+    if (len > (uint64_t)(limit - *source)) {
+        return S_set_corrupt("truncated string");
+    }
+    if (!StrHelp_utf8_valid(*source, (size_t)len)) {
+        return S_set_corrupt("invalid UTF-8");
+    }
+    *ptr    = *source;
+    *size   = (size_t)len;
+    *source += len;
+    return true;
+}
+
+static bool
+S_decode(const char **source, const char *limit, int32_t depth,
+         Obj **value) {
+    *value = NULL;
+    if (depth > MAX_DEPTH) {
+        return S_set_corrupt("nested too deeply");
+    }
+    if (*source >= limit) {
+        return S_set_corrupt("truncated value");
+    }
+
+    uint8_t tag = (uint8_t)*(*source)++;
+    switch (tag) {
+        case TAG_NULL:
+            return true;
+        case TAG_FALSE:
+            *value = (Obj*)CFISH_FALSE;
+            return true;
+        case TAG_TRUE:
+            *value = (Obj*)CFISH_TRUE;
+            return true;
+        case TAG_INTEGER: {
+                uint64_t encoded;
+                if (!S_read_c64(source, limit, &encoded)) { return false; }
+                int64_t decoded = (int64_t)(encoded >> 1)
+                                  ^ -(int64_t)(encoded & 1);
+                *value = (Obj*)Int_new(decoded);
+                return true;
+            }
+        case TAG_FLOAT: {
+                if (limit - *source < 8) {
+                    return S_set_corrupt("truncated float");
+                }
+                *value = (Obj*)Float_new(NumUtil_decode_bigend_f64(*source));
+                *source += 8;
+                return true;
+            }
+        case TAG_STRING: {
+                const char *ptr;
+                size_t      size;
+                if (!S_read_string(source, limit, &ptr, &size)) {
+                    return false;
+                }
+                *value = (Obj*)Str_new_from_trusted_utf8(ptr, size);
+                return true;
+            }
+        case TAG_VECTOR: {
+                uint64_t size;
+                if (!S_read_c64(source, limit, &size)) { return false; }
+                // Each element takes at least one byte.
+                if (size > (uint64_t)(limit - *source)) {
+                    return S_set_corrupt("bad array size");
+                }
+                Vector *array = Vec_new((size_t)size);
+                for (uint64_t i = 0; i < size; i++) {
+                    Obj *elem;
+                    if (!S_decode(source, limit, depth + 1, &elem)) {
+                        DECREF(array);
+                        return false;
+                    }
+                    Vec_Push(array, elem);
+                }
+                *value = (Obj*)array;
+                return true;
+            }
+        case TAG_HASH: {
+                uint64_t size;
+                if (!S_read_c64(source, limit, &size)) { return false; }
+                // Each pair takes at least two bytes.
+                if (size > (uint64_t)(limit - *source) / 2) {
+                    return S_set_corrupt("bad hash size");
+                }
+                Hash *hash = Hash_new((size_t)size);
+                for (uint64_t i = 0; i < size; i++) {
+                    const char *key;
+                    size_t      key_len;
+                    Obj        *elem;
+                    if (!S_read_string(source, limit, &key, &key_len)
+                        || !S_decode(source, limit, depth + 1, &elem)
+                       ) {
+                        DECREF(hash);
+                        return false;
+                    }
+                    Hash_Store_Utf8(hash, key, key_len, elem);
+                }
+                *value = (Obj*)hash;
+                return true;
+            }
+        default:
+            return S_set_corrupt("unknown type tag");
+    }
+}
+
@@ -0,0 +1,165 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_WORKERTHREAD
+#include "Lucy/Util/ToolSet.h"
+
+#include "charmony.h"
+
+#include "Lucy/Util/WorkerThread.h"
+
+/********************************* WINDOWS ********************************/
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
+
+#include <windows.h>
+
+typedef struct WorkerThread {
+    WorkerThread_Routine_t  routine;
+    void                   *arg;
+    HANDLE                  handle;
+} WorkerThread;
+
+static DWORD __stdcall
+S_thread(void *arg) {
+    WorkerThread *thread = (WorkerThread*)arg;
+    thread->routine(thread->arg);
+    return 0;
+}
+
+bool
+WorkerThread_enabled() {
+    return true;
+}
+
+void*
+WorkerThread_start(WorkerThread_Routine_t routine, void *arg) {
+    WorkerThread *thread = (WorkerThread*)MALLOCATE(sizeof(WorkerThread));
+    thread->routine = routine;
+    thread->arg     = arg;
+    thread->handle  = CreateThread(NULL, 0, S_thread, thread, 0, NULL);
+    if (thread->handle == NULL) {
+        FREEMEM(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+bool
+WorkerThread_done(void *vthread) {
+    WorkerThread *thread = (WorkerThread*)vthread;
+    return WaitForSingleObject(thread->handle, 0) == WAIT_OBJECT_0;
+}
+
+void
+WorkerThread_join(void *vthread) {
+    WorkerThread *thread = (WorkerThread*)vthread;
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    FREEMEM(thread);
+}
+
+/******************************** pthreads *********************************/
+#elif !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+
+#include <pthread.h>
+
+typedef struct WorkerThread {
+    WorkerThread_Routine_t  routine;
+    void                   *arg;
+    bool                    done;
+    pthread_mutex_t         mutex;
+    pthread_t               pthread;
+} WorkerThread;
+
+static void*
+S_thread(void *arg) {
+    WorkerThread *thread = (WorkerThread*)arg;
+    thread->routine(thread->arg);
+    pthread_mutex_lock(&thread->mutex);
+    thread->done = true;
+    pthread_mutex_unlock(&thread->mutex);
+    return NULL;
+}
+
+bool
+WorkerThread_enabled() {
+    return true;
+}
+
+void*
+WorkerThread_start(WorkerThread_Routine_t routine, void *arg) {
+    WorkerThread *thread = (WorkerThread*)MALLOCATE(sizeof(WorkerThread));
+    thread->routine = routine;
+    thread->arg     = arg;
+    thread->done    = false;
+    if (pthread_mutex_init(&thread->mutex, NULL) != 0) {
+        FREEMEM(thread);
+        return NULL;
+    }
+    if (pthread_create(&thread->pthread, NULL, S_thread, thread) != 0) {
+        pthread_mutex_destroy(&thread->mutex);
+        FREEMEM(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+bool
+WorkerThread_done(void *vthread) {
+    WorkerThread *thread = (WorkerThread*)vthread;
+    pthread_mutex_lock(&thread->mutex);
+    bool done = thread->done;
+    pthread_mutex_unlock(&thread->mutex);
+    return done;
+}
+
+void
+WorkerThread_join(void *vthread) {
+    WorkerThread *thread = (WorkerThread*)vthread;
+    pthread_join(thread->pthread, NULL);
+    pthread_mutex_destroy(&thread->mutex);
+    FREEMEM(thread);
+}
+
+/****************************** No threads ********************************/
+#else
+
+bool
+WorkerThread_enabled() {
+    return false;
+}
+
+void*
+WorkerThread_start(WorkerThread_Routine_t routine, void *arg) {
+    UNUSED_VAR(routine);
+    UNUSED_VAR(arg);
+    return NULL;
+}
+
+bool
+WorkerThread_done(void *thread) {
+    UNUSED_VAR(thread);
+    return true;
+}
+
+void
+WorkerThread_join(void *thread) {
+    UNUSED_VAR(thread);
+}
+
+#endif // Thread API switch.
+
+
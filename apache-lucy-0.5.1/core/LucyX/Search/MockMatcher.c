@@ -77,4 +77,8 @@ MockMatcher_Get_Doc_ID_IMP(MockMatcher* self) {
     return I32Arr_Get(ivars->doc_ids, ivars->tick);
 }
 
+int32_t
+MockMatcher_Estimate_Cost_IMP(MockMatcher* self) {
+    return (int32_t)MockMatcher_IVARS(self)->size;
+}
 
@@ -28,6 +28,7 @@ sub bind_all {
     $class->bind_normalizer;
     $class->bind_polyanalyzer;
     $class->bind_regextokenizer;
+    $class->bind_shinglefilter;
     $class->bind_snowballstemmer;
     $class->bind_snowballstopfilter;
     $class->bind_standardtokenizer;
@@ -272,6 +273,29 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_shinglefilter {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $shingler = Lucy::Analysis::ShingleFilter->new;
+    my $polyanalyzer = Lucy::Analysis::PolyAnalyzer->new(
+        analyzers => [ $tokenizer, $normalizer, $shingler ],
+    );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $shingler = Lucy::Analysis::ShingleFilter->new;
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor );
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Analysis::ShingleFilter",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_snowballstemmer {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
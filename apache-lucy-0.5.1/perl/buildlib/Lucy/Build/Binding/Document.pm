@@ -22,6 +22,7 @@ $VERSION = eval $VERSION;
 sub bind_all {
     my $class = shift;
     $class->bind_doc;
+    $class->bind_docbuilder;
     $class->bind_hitdoc;
 }
 
@@ -163,6 +164,31 @@ END_XS_CODE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_docbuilder {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $builder = $indexer->make_doc_builder;
+    my $title_slot   = $builder->add_field('title');
+    my $content_slot = $builder->add_field('content');
+    for my $article (@articles) {
+        $builder->clear;
+        $builder->set_value( slot => $title_slot,   value => $article->{title} );
+        $builder->set_value( slot => $content_slot, value => $article->{body} );
+        $indexer->add_built_doc( builder => $builder );
+    }
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Document::DocBuilder",
+    );
+    $binding->set_pod_spec($pod_spec);
+    $binding->exclude_constructor;
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_hitdoc {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
@@ -31,6 +31,7 @@ sub bind_all {
     $class->bind_indexer;
     $class->bind_lexicon;
     $class->bind_lexiconreader;
+    $class->bind_memorybudget;
     $class->bind_polyreader;
     $class->bind_scoreposting;
     $class->bind_postinglist;
@@ -532,6 +533,26 @@ END_SYNOPSIS
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_memorybudget {
+    my $xs_code = <<'END_XS';
+MODULE = Lucy    PACKAGE = Lucy::Index::MemoryBudget
+
+void
+set_default_limit(limit)
+    size_t limit;
+PPCODE:
+    lucy_MemBudget_set_default_limit(limit);
+END_XS
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Index::MemoryBudget",
+    );
+    $binding->append_xs($xs_code);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_polyreader {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
@@ -40,6 +40,7 @@ sub bind_all {
     $class->bind_polysearcher;
     $class->bind_query;
     $class->bind_queryparser;
+    $class->bind_queryprofile;
     $class->bind_rangequery;
     $class->bind_requiredoptionalquery;
     $class->bind_searcher;
@@ -833,6 +834,28 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_queryprofile {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $top_docs = $searcher->profile_top_docs(
+        query      => $query,
+        num_wanted => 10,
+    );
+    my $profile = $top_docs->get_profile;
+    print $profile->to_string;
+    printf( "%d postings decoded\n", $profile->get_postings_decoded );
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::QueryProfile",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_span {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
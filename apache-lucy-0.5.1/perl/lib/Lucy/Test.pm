@@ -18,8 +18,9 @@ use Lucy;
 our $VERSION = '0.005001';
 $VERSION = eval $VERSION;
 
-# Set the default memory threshold for PostingListWriter to a low number so
-# that we simulate large indexes by performing a lot of PostingPool flushes.
+# Set the default indexing memory budget to a low number so that we simulate
+# large indexes by performing a lot of PostingPool flushes.
+Lucy::Index::MemoryBudget::set_default_limit(0x1000);
 Lucy::Index::PostingListWriter::set_default_mem_thresh(0x1000);
 
 1;
@@ -32,7 +32,7 @@ sub recycle {
 
 package main;
 
-use Test::More tests => 16;
+use Test::More tests => 17;
 use Lucy::Test;
 
 my $folder = Lucy::Store::RAMFolder->new;
@@ -92,6 +92,7 @@ my $seg_readers = $manager->recycle(
     reader     => $polyreader,
     cutoff     => 19,
     del_writer => $deletions_writer,
+    optimize   => 1,
 );
 is( scalar @$seg_readers, 1, "cutoff" );
 
@@ -100,8 +101,9 @@ $seg_readers = $manager->recycle(
     cutoff     => 0,
     del_writer => $deletions_writer,
 );
-is( scalar @$seg_readers,
-    18, "recycle lots of small segs but leave big ones alone" );
+is( scalar @$seg_readers, 10, "recycle a tier of small segs" );
+ok( !( grep { $_->doc_max > 1 } @$seg_readers ),
+    "leave big ones alone" );
 
 $manager->set_write_lock_timeout(1);
 is( $manager->get_write_lock_timeout, 1, "set/get write lock timeout" );
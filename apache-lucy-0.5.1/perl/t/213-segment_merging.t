@@ -172,14 +172,14 @@ is( num_segmeta($index_loc), 1, "merged segment files successfully deleted" );
         schema => $schema,
     );
     $indexer->delete_by_term( field => 'content', term => $_ )
-        for ( 3, 103..113 );
+        for ( 3, 103..127 );
     $indexer->commit;
 
     ok( $folder->exists("seg_1/segmeta.json"),
-        "Segment with under 10% deletions preserved"
+        "Segment with few deletions preserved"
     );
     ok( !$folder->exists("seg_2/segmeta.json"),
-        "Segment with over 10% deletions merged away"
+        "Segment with over 20% deletions merged away"
     );
 }
 
@@ -21,6 +21,10 @@ package NoMergeManager;
 use base qw( Lucy::Index::IndexManager );
 sub recycle { [] }
 
+package MergeAllManager;
+use base qw( Lucy::Index::IndexManager );
+sub recycle { shift->SUPER::recycle( @_, optimize => 1 ) }
+
 package main;
 use Test::More tests => 15;
 use Lucy::Test;
@@ -37,7 +41,10 @@ for my $letter (qw( a b c )) {
     $indexer->add_doc( { content => $letter } );
     $indexer->commit;
 }
-my $bg_merger = Lucy::Index::BackgroundMerger->new( index => $folder );
+my $bg_merger = Lucy::Index::BackgroundMerger->new(
+    index   => $folder,
+    manager => MergeAllManager->new,
+);
 
 my $indexer = Lucy::Index::Indexer->new( index => $folder );
 $indexer->add_doc( { content => 'd' } );
@@ -46,7 +53,10 @@ $indexer->commit;
 is( count_segs($folder), 4,
     "BackgroundMerger prevents Indexer from merging claimed segments" );
 
-$indexer = Lucy::Index::Indexer->new( index => $folder );
+$indexer = Lucy::Index::Indexer->new(
+    index   => $folder,
+    manager => MergeAllManager->new,
+);
 $indexer->add_doc( { content => 'e' } );
 $indexer->delete_by_term( field => 'content', term => 'b' );
 $indexer->commit;